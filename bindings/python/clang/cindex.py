@@ -2248,6 +2248,14 @@ class TranslationUnit(ClangObject):
     # into the set of code completions returned from this translation unit.
     PARSE_INCLUDE_BRIEF_COMMENTS_IN_CODE_COMPLETION = 128
 
+    # Rebuild an out-of-date precompiled preamble on a background thread,
+    # reusing the old one until the new one is ready.
+    PARSE_BUILD_PREAMBLE_IN_BACKGROUND = 256
+
+    # Split the precompiled preamble into two chained parts, so that changing
+    # only its last directives rebuilds just the second part.
+    PARSE_CHAINED_PREAMBLE = 512
+
     @classmethod
     def from_source(cls, filename, args=None, unsaved_files=None, options=0,
                     index=None):
@@ -32,7 +32,7 @@
  * compatible, thus CINDEX_VERSION_MAJOR is expected to remain stable.
  */
 #define CINDEX_VERSION_MAJOR 0
-#define CINDEX_VERSION_MINOR 30
+#define CINDEX_VERSION_MINOR 35
 
 #define CINDEX_VERSION_ENCODE(major, minor) ( \
       ((major) * 10000)                       \
@@ -1202,7 +1202,33 @@ enum CXTranslationUnit_Flags {
    * included into the set of code completions returned from this translation
    * unit.
    */
-  CXTranslationUnit_IncludeBriefCommentsInCodeCompletion = 0x80
+  CXTranslationUnit_IncludeBriefCommentsInCodeCompletion = 0x80,
+
+  /**
+   * \brief Used to indicate that an out-of-date precompiled preamble should
+   * be rebuilt on a background thread.
+   *
+   * When one of the headers included by the preamble changes, reparsing and
+   * code completion keep using the old precompiled preamble until the new one
+   * is ready, instead of waiting for it to be rebuilt. The new preamble is
+   * used from the first reparse after it has been built. This option only has
+   * an effect together with \c CXTranslationUnit_PrecompiledPreamble.
+   */
+  CXTranslationUnit_BuildPreambleInBackground = 0x100,
+
+  /**
+   * \brief Used to indicate that the precompiled preamble should be split
+   * into two chained parts, so that changing only the last directives of
+   * the preamble doesn't require precompiling all of it again.
+   *
+   * Everything before the last \#include (or other preprocessor directive)
+   * of the preamble is precompiled on its own, and the rest is precompiled
+   * on top of it. When a reparse finds that only directives after that
+   * point have been added or changed, only the second part is rebuilt. This
+   * option only has an effect together with
+   * \c CXTranslationUnit_PrecompiledPreamble.
+   */
+  CXTranslationUnit_ChainedPreamble = 0x200
 };
 
 /**
@@ -1391,7 +1417,17 @@ enum CXReparse_Flags {
   /**
    * \brief Used to indicate that no special reparsing options are needed.
    */
-  CXReparse_None = 0x0
+  CXReparse_None = 0x0,
+
+  /**
+   * \brief Used to indicate that the reparse should first wait for the
+   * precompiled preamble being rebuilt on a background thread, if any, so
+   * that it is used by this reparse.
+   *
+   * This option only has an effect for translation units parsed with
+   * \c CXTranslationUnit_BuildPreambleInBackground.
+   */
+  CXReparse_WaitForBackgroundPreamble = 0x1
 };
  
 /**
@@ -5205,6 +5241,12 @@ typedef struct {
    * import.
    */
   int isModuleImport;
+  /**
+   * \brief Non-zero if the declarations and references in the file will not
+   * be reported, because it was already indexed in the same context; see
+   * #CXIndexOpt_SkipIndexedHeaders.
+   */
+  int isAlreadyIndexed;
 } CXIdxIncludedFileInfo;
 
 /**
@@ -5581,6 +5623,25 @@ CINDEX_LINKAGE CXIndexAction clang_IndexAction_create(CXIndex CIdx);
  */
 CINDEX_LINKAGE void clang_IndexAction_dispose(CXIndexAction);
 
+/**
+ * \brief Share the record of the headers indexed with
+ * #CXIndexOpt_SkipIndexedHeaders through the file \p path, so that headers
+ * indexed by earlier index actions, including those of other processes, are
+ * skipped as well.
+ *
+ * The file need not exist. The headers this index action indexes are merged
+ * into it as each translation unit is finished. Since the file is only a
+ * cache, it may lose entries written concurrently by several processes.
+ */
+CINDEX_LINKAGE void clang_IndexAction_setIndexedHeadersFile(CXIndexAction,
+                                                            const char *path);
+
+/**
+ * \brief Retrieve the number of times a header was skipped by this index
+ * action because of #CXIndexOpt_SkipIndexedHeaders.
+ */
+CINDEX_LINKAGE unsigned clang_IndexAction_getNumSkippedHeaders(CXIndexAction);
+
 typedef enum {
   /**
    * \brief Used to indicate that no special indexing options are needed.
@@ -5616,7 +5677,27 @@ typedef enum {
    * indexing session associated with a \c CXIndexAction object.
    * Bodies in system headers are always skipped.
    */
-  CXIndexOpt_SkipParsedBodiesInSession = 0x10
+  CXIndexOpt_SkipParsedBodiesInSession = 0x10,
+
+  /**
+   * \brief Do not report the declarations and references in a header that
+   * was already indexed, in the same context, during the indexing session
+   * associated with a \c CXIndexAction object, or by the index actions
+   * sharing its file of indexed headers.
+   *
+   * Only headers protected by an include guard or \#pragma once are skipped,
+   * and only while they keep the size and modification time they had when
+   * they were indexed. The context of a header is given by the predefined
+   * and command-line macros, the header search paths, the indexing options
+   * and the definitions, at the point of inclusion, of the macros the header
+   * tests or expands. Declarations in files included from the middle of a
+   * declaration in a skipped header are skipped along with it.
+   *
+   * The header is still reported through IndexerCallbacks#ppIncludedFile,
+   * with CXIdxIncludedFileInfo#isAlreadyIndexed set. This applies to
+   * #clang_indexSourceFile only.
+   */
+  CXIndexOpt_SkipIndexedHeaders = 0x20
 
 } CXIndexOptFlags;
 
@@ -5702,6 +5783,161 @@ CINDEX_LINKAGE void clang_indexLoc_getFileLocation(CXIdxLoc loc,
 CINDEX_LINKAGE
 CXSourceLocation clang_indexLoc_getCXSourceLocation(CXIdxLoc loc);
 
+/**
+ * \brief An on-disk index of the occurrences of symbols, keyed by their
+ * USRs, that clients can build from the indexing callbacks and query without
+ * parsing again.
+ *
+ * The index keeps the occurrences of each file in a segment of their own.
+ * Updating the index replaces the segments of the files indexed again and
+ * keeps the others. The file is memory-mapped when it is opened, and looking
+ * up a USR reads only the parts of it that are needed.
+ */
+typedef struct CXSymbolIndexImpl *CXSymbolIndex;
+
+/**
+ * \brief Collects occurrences of symbols to be written to a
+ * \c CXSymbolIndex file.
+ */
+typedef struct CXSymbolIndexBuilderImpl *CXSymbolIndexBuilder;
+
+/**
+ * \brief The ways a symbol can occur in a \c CXSymbolIndex.
+ */
+typedef enum {
+  CXSymbolIndexRole_Declaration = 0x1,
+  CXSymbolIndexRole_Definition = 0x2,
+  CXSymbolIndexRole_Reference = 0x4
+} CXSymbolIndexRole;
+
+/**
+ * \brief An occurrence of a symbol, as read from a \c CXSymbolIndex.
+ *
+ * The strings belong to the index and remain valid until it is disposed.
+ */
+typedef struct {
+  const char *usr;
+  const char *filename;
+  unsigned line;
+  unsigned column;
+  /**
+   * \brief A mask of \c CXSymbolIndexRole values.
+   */
+  unsigned roles;
+} CXSymbolOccurrence;
+
+/**
+ * \brief Create a \c CXSymbolIndexBuilder object.
+ * Must be disposed with \c clang_SymbolIndexBuilder_dispose().
+ *
+ * \param options is reserved, always pass 0.
+ */
+CINDEX_LINKAGE CXSymbolIndexBuilder
+clang_SymbolIndexBuilder_create(unsigned options);
+
+/**
+ * \brief Start recording the occurrences in the file \p filename. When the
+ * index is written, they replace all the occurrences the index has for that
+ * file, even if none are recorded.
+ *
+ * This is typically called from IndexerCallbacks#enteredMainFile and, for
+ * files that are not already indexed, IndexerCallbacks#ppIncludedFile.
+ * Files should be named by absolute paths if the index is shared by
+ * translation units built in different directories.
+ *
+ * \returns 0 for success, non-zero to indicate an error.
+ */
+CINDEX_LINKAGE enum CXErrorCode
+clang_SymbolIndexBuilder_beginFile(CXSymbolIndexBuilder,
+                                   const char *filename);
+
+/**
+ * \brief Record an occurrence of the symbol \p usr in the file \p filename,
+ * which is begun if it was not already.
+ *
+ * \param roles a mask of \c CXSymbolIndexRole values. Recording the same
+ * occurrence again, such as from a header included by several translation
+ * units, merges the roles.
+ *
+ * \returns 0 for success, non-zero to indicate an error.
+ */
+CINDEX_LINKAGE enum CXErrorCode
+clang_SymbolIndexBuilder_addOccurrence(CXSymbolIndexBuilder,
+                                       const char *usr,
+                                       const char *filename,
+                                       unsigned line, unsigned column,
+                                       unsigned roles);
+
+/**
+ * \brief Write the occurrences recorded to the symbol index file \p path,
+ * which is created if it does not exist.
+ *
+ * The index is replaced atomically, so that readers never see a partial
+ * index, and the segments of the files not begun by this builder are those
+ * of the index at the time of the call.
+ *
+ * \returns 0 for success, non-zero to indicate an error.
+ */
+CINDEX_LINKAGE enum CXErrorCode
+clang_SymbolIndexBuilder_write(CXSymbolIndexBuilder, const char *path);
+
+/**
+ * \brief Dispose a \c CXSymbolIndexBuilder object.
+ */
+CINDEX_LINKAGE void clang_SymbolIndexBuilder_dispose(CXSymbolIndexBuilder);
+
+/**
+ * \brief Open the symbol index file \p path.
+ *
+ * \returns the index, which must be disposed with
+ * \c clang_SymbolIndex_dispose(), or NULL if the file could not be read or
+ * is not a symbol index.
+ */
+CINDEX_LINKAGE CXSymbolIndex clang_SymbolIndex_load(const char *path);
+
+/**
+ * \brief Retrieve the number of files, symbols or occurrences in a
+ * \c CXSymbolIndex.
+ */
+CINDEX_LINKAGE unsigned clang_SymbolIndex_getNumFiles(CXSymbolIndex);
+CINDEX_LINKAGE unsigned clang_SymbolIndex_getNumSymbols(CXSymbolIndex);
+CINDEX_LINKAGE unsigned clang_SymbolIndex_getNumOccurrences(CXSymbolIndex);
+
+/**
+ * \brief Visitor invoked for each occurrence found in a \c CXSymbolIndex.
+ */
+typedef enum CXVisitorResult
+(*CXSymbolOccurrenceVisitor)(void *context, const CXSymbolOccurrence *);
+
+/**
+ * \brief Visit the occurrences of the symbol \p usr, in the order of their
+ * file names and positions.
+ *
+ * \returns a non-zero value if the traversal was terminated prematurely by
+ * the visitor returning \c CXVisit_Break.
+ */
+CINDEX_LINKAGE unsigned
+clang_SymbolIndex_findOccurrences(CXSymbolIndex, const char *usr,
+                                  CXSymbolOccurrenceVisitor visitor,
+                                  void *context);
+
+/**
+ * \brief Visit the occurrences in the file \p filename, in the order of
+ * their positions.
+ *
+ * \returns a non-zero value if the traversal was terminated prematurely by
+ * the visitor returning \c CXVisit_Break.
+ */
+CINDEX_LINKAGE unsigned
+clang_SymbolIndex_findOccurrencesInFile(CXSymbolIndex, const char *filename,
+                                        CXSymbolOccurrenceVisitor visitor,
+                                        void *context);
+
+/**
+ * \brief Dispose a \c CXSymbolIndex object.
+ */
+CINDEX_LINKAGE void clang_SymbolIndex_dispose(CXSymbolIndex);
+
 /**
  * \brief Visitor invoked for each field found by a traversal.
  *
@@ -51,6 +51,8 @@ namespace clang {
   class ASTRecordLayout;
   class BlockExpr;
   class CharUnits;
+  class ConstexprCallCache;
+  class ConstexprInterpreter;
   class DiagnosticsEngine;
   class Expr;
   class ASTMutationListener;
@@ -413,6 +415,14 @@ private:
   /// AST objects will be released when the ASTContext itself is destroyed.
   mutable llvm::BumpPtrAllocator BumpAlloc;
 
+  /// \brief The number of objects allocated with the placement new below,
+  /// while CountNodesAllocated is set.
+  mutable unsigned NumNodesAllocated;
+
+  /// \brief Whether to count the objects allocated with the placement new
+  /// below, which only the template instantiation report needs.
+  bool CountNodesAllocated;
+
   /// \brief Allocator for partial diagnostics.
   PartialDiagnostic::StorageAllocator DiagAllocator;
 
@@ -502,6 +512,13 @@ public:
     return BumpAlloc.Allocate(Size, Align);
   }
   void Deallocate(void *Ptr) const { }
+
+  /// \brief Return the number of AST nodes (declarations, statements, types,
+  /// attributes, ...) allocated so far, if they are being counted.
+  unsigned getNumNodesAllocated() const { return NumNodesAllocated; }
+  bool isCountingNodesAllocated() const { return CountNodesAllocated; }
+  void setCountNodesAllocated(bool Count) { CountNodesAllocated = Count; }
+  void noteNodeAllocated() const { ++NumNodesAllocated; }
   
   /// Return the total amount of physical memory allocated for representing
   /// AST nodes and type information.
@@ -1831,6 +1848,14 @@ public:
 
   VTableContextBase *getVTableContext();
 
+  /// \brief Returns the table of memoized constexpr function calls, or null
+  /// if constexpr calls are not memoized.
+  ConstexprCallCache *getConstexprCallCache();
+
+  /// \brief Returns the bytecode interpreter for constexpr function calls, or
+  /// null if the tree-walking evaluator is to be used for all calls.
+  ConstexprInterpreter *getConstexprInterpreter();
+
   MangleContext *createMangleContext();
   
   void DeepCollectObjCIvars(const ObjCInterfaceDecl *OI, bool leafClass,
@@ -2447,6 +2472,10 @@ private:
 
   std::unique_ptr<VTableContextBase> VTContext;
 
+  std::unique_ptr<ConstexprCallCache> ConstexprCalls;
+
+  std::unique_ptr<ConstexprInterpreter> ConstexprInterp;
+
 public:
   enum PragmaSectionFlag : unsigned {
     PSF_None = 0,
@@ -2519,6 +2548,8 @@ static inline Selector GetUnarySelector(StringRef name, ASTContext& Ctx) {
 /// @return The allocated memory. Could be NULL.
 inline void *operator new(size_t Bytes, const clang::ASTContext &C,
                           size_t Alignment) {
+  if (C.isCountingNodesAllocated())
+    C.noteNodeAllocated();
   return C.Allocate(Bytes, Alignment);
 }
 /// @brief Placement delete companion to the new above.
@@ -0,0 +1,90 @@
+//===--- ConstexprCallCache.h - Memoized constexpr calls --------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines the ConstexprCallCache class, which remembers the results
+//  of constexpr function calls so that the constant evaluator need not
+//  evaluate the same call twice.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_AST_CONSTEXPRCALLCACHE_H
+#define LLVM_CLANG_AST_CONSTEXPRCALLCACHE_H
+
+#include "clang/AST/APValue.h"
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/StringMap.h"
+
+namespace clang {
+
+class FunctionDecl;
+
+/// \brief A table of the results of the constexpr function calls evaluated so
+/// far, keyed on the callee and the values of its arguments.
+///
+/// Only calls whose arguments and result are self-contained values (that is,
+/// which contain no lvalues or member pointers) are recorded, since those are
+/// the only calls whose result cannot depend on the state of the evaluation
+/// that made them. Along with the result, each entry records the call depth
+/// and the number of evaluation steps the call needed, so that a cached call
+/// is subject to the same limits as one evaluated from scratch.
+///
+/// Once the table holds the maximum number of entries, it is flushed.
+class ConstexprCallCache {
+public:
+  struct Entry {
+    APValue Result;
+
+    /// \brief The depth of the deepest call made while evaluating the call,
+    /// relative to the depth of the call itself.
+    unsigned Depth;
+
+    /// \brief The number of evaluation steps the call took.
+    unsigned Steps;
+
+    Entry() : Depth(0), Steps(0) {}
+  };
+
+private:
+  llvm::StringMap<Entry> Entries;
+  unsigned MaxEntries;
+
+  // Statistics.
+  unsigned NumHits, NumMisses, NumInsertions, NumFlushes;
+
+public:
+  explicit ConstexprCallCache(unsigned MaxEntries)
+      : MaxEntries(MaxEntries), NumHits(0), NumMisses(0), NumInsertions(0),
+        NumFlushes(0) {}
+
+  /// \brief Determine whether \p Value can be used as an argument or result
+  /// of a cached call.
+  static bool isCacheableValue(const APValue &Value);
+
+  /// \brief Compute the key for a call to \p Callee with the argument values
+  /// \p Args, evaluated in mode \p EvalMode.
+  ///
+  /// All of \p Args must be cacheable values.
+  static void getKey(const FunctionDecl *Callee, unsigned EvalMode,
+                     ArrayRef<APValue> Args, SmallVectorImpl<char> &Key);
+
+  /// \brief Find the result of the call with key \p Key, if it was cached.
+  const Entry *lookup(StringRef Key);
+
+  /// \brief Record the result of the call with key \p Key.
+  void insert(StringRef Key, const APValue &Result, unsigned Depth,
+              unsigned Steps);
+
+  unsigned size() const { return Entries.size(); }
+
+  void PrintStats() const;
+};
+
+} // end namespace clang
+
+#endif
@@ -43,6 +43,7 @@
 
 #include "clang/ASTMatchers/ASTMatchers.h"
 #include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Mutex.h"
 #include "llvm/Support/Timer.h"
 
 namespace clang {
@@ -132,6 +133,16 @@ public:
     ///
     /// It prints a report after match.
     llvm::Optional<Profiling> CheckProfiling;
+
+    /// \brief If set, every \c MatchCallback::run,
+    /// \c onStartOfTranslationUnit and \c onEndOfTranslationUnit call is made
+    /// while holding this lock, and the profiling records of the translation
+    /// units are added up under it.
+    ///
+    /// This allows callbacks that collect results into shared state (e.g.
+    /// \c RefactoringCallback) to be used while several translation units
+    /// are matched concurrently, see \c ClangTool::setNumThreads.
+    llvm::sys::Mutex *CallbackLock = nullptr;
   };
 
   MatchFinder(MatchFinderOptions Options = MatchFinderOptions());
@@ -20,6 +20,7 @@
 #include "clang/Basic/VirtualFileSystem.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/IntrusiveRefCntPtr.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
@@ -34,6 +35,7 @@ class MemoryBuffer;
 namespace clang {
 class FileManager;
 class FileSystemStatCache;
+class SharedFileSystemStatCache;
 
 /// \brief Cached information about one directory (either on disk or in
 /// the virtual file system).
@@ -163,6 +165,10 @@ class FileManager : public RefCountedBase<FileManager> {
   // Caching.
   std::unique_ptr<FileSystemStatCache> StatCache;
 
+  /// \brief The stat cache shared with other FileManagers, consulted when no
+  /// FileSystemStatCache is installed.
+  IntrusiveRefCntPtr<SharedFileSystemStatCache> SharedStatCache;
+
   bool getStatValue(const char *Path, FileData &Data, bool isFile,
                     std::unique_ptr<vfs::File> *F);
 
@@ -195,6 +201,18 @@ public:
   /// \brief Removes all FileSystemStatCache objects from the manager.
   void clearStatCaches();
 
+  /// \brief Use \p Cache, which may be shared with other FileManagers, for
+  /// stat queries not answered by an installed FileSystemStatCache.
+  ///
+  /// By default, the cache set by \c SharedFileSystemStatCache::setDefault
+  /// (if any) is used. Unlike the FileSystemStatCache chain, the shared cache
+  /// is not removed by \c clearStatCaches().
+  void setSharedStatCache(IntrusiveRefCntPtr<SharedFileSystemStatCache> Cache);
+
+  SharedFileSystemStatCache *getSharedStatCache() const {
+    return SharedStatCache.get();
+  }
+
   /// \brief Lookup, cache, and verify the specified directory (real or
   /// virtual).
   ///
@@ -217,6 +235,11 @@ public:
   const FileEntry *getFile(StringRef Filename, bool OpenFile = false,
                            bool CacheFailure = true);
 
+  /// \brief Determine whether getFile() has already found \p Filename, or
+  /// it names a virtual file, so that looking it up again will not consult
+  /// the file system.
+  bool hasSeenFile(StringRef Filename) const;
+
   /// \brief Returns the current file system options
   const FileSystemOptions &getFileSystemOptions() { return FileSystemOpts; }
 
@@ -279,6 +302,16 @@ public:
   void PrintStats() const;
 };
 
+/// \brief Write the file at \p Path with \p Write, under a temporary name
+/// in the same directory that is then renamed into place, so that readers
+/// never see a partial file.
+///
+/// \returns an error code if the temporary file could not be created,
+/// written or renamed; the temporary file is removed in that case.
+std::error_code
+writeFileAtomically(StringRef Path,
+                    llvm::function_ref<void(raw_ostream &)> Write);
+
 }  // end namespace clang
 
 #endif
@@ -16,8 +16,10 @@
 #define LLVM_CLANG_BASIC_FILESYSTEMSTATCACHE_H
 
 #include "clang/Basic/LLVM.h"
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Mutex.h"
 #include <memory>
 
 namespace clang {
@@ -126,6 +128,80 @@ public:
                        vfs::FileSystem &FS) override;
 };
 
+/// \brief A thread-safe cache of 'stat' results on the real file system,
+/// which can be shared by any number of FileManagers.
+///
+/// Unlike a \c FileSystemStatCache, which belongs to a single FileManager
+/// and lives as long as one compilation, this cache is meant to be shared by
+/// all the translation units processed by a tool or a libclang process, so
+/// that common headers are only stat'ed once. Only absolute paths on the real
+/// file system are cached. Cached entries stay valid until \c revalidate()
+/// notices that the file's size or modification time changed.
+class SharedFileSystemStatCache
+    : public llvm::ThreadSafeRefCountedBase<SharedFileSystemStatCache> {
+  struct Entry {
+    FileData Data;
+    bool Exists;
+    /// \brief The generation in which the entry was last checked against
+    /// the file system.
+    unsigned Generation;
+  };
+
+  mutable llvm::sys::Mutex Lock;
+  llvm::StringMap<Entry> Entries;
+
+  /// \brief The current generation. Entries from older generations are
+  /// checked against the file system again on their next lookup.
+  unsigned Generation;
+
+  /// \brief Whether failed lookups are cached as well.
+  bool CacheMissingFiles;
+
+  // Statistics.
+  unsigned NumHits, NumMisses, NumInvalidated;
+
+public:
+  /// \param CacheMissingFiles Whether to remember paths that do not exist.
+  /// This avoids repeated failed probes during header search, but files
+  /// created later (e.g. generated headers) are only noticed after
+  /// \c revalidate().
+  explicit SharedFileSystemStatCache(bool CacheMissingFiles = false);
+
+  /// \brief Get the 'stat' information for the specified path, consulting
+  /// the shared cache first.
+  ///
+  /// This has the same contract as \c FileSystemStatCache::get: it returns
+  /// \c true if the path does not exist or is not of the requested kind.
+  /// \p F is only filled in when the file system is actually consulted.
+  bool get(const char *Path, FileData &Data, bool isFile,
+           std::unique_ptr<vfs::File> *F, vfs::FileSystem &FS);
+
+  /// \brief Start a new generation, so that each cached path is stat'ed
+  /// again on its next lookup and its entry updated if the file changed.
+  ///
+  /// This does not touch the file system; only the paths that are looked up
+  /// afterwards are checked, each once per generation.
+  void revalidate();
+
+  /// \brief Drop all cached entries.
+  void clear();
+
+  unsigned size() const;
+  unsigned getNumHits() const;
+  unsigned getNumMisses() const;
+  unsigned getNumInvalidated() const;
+
+  void PrintStats() const;
+
+  /// \brief Returns the cache installed in every newly created FileManager,
+  /// if any.
+  static IntrusiveRefCntPtr<SharedFileSystemStatCache> getDefault();
+
+  /// \brief Sets the cache installed in every FileManager created from now
+  /// on. Pass null to stop sharing.
+  static void setDefault(IntrusiveRefCntPtr<SharedFileSystemStatCache> Cache);
+};
+
 } // end namespace clang
 
 #endif
@@ -0,0 +1,99 @@
+//===--- TimeTrace.h - Hierarchical compilation time tracing ----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines a profiler that records the time spent in nested regions of
+/// a compilation (entering a header, parsing a declaration, instantiating a
+/// template, running the optimizer, ...) and writes them out in the Chrome
+/// trace event format, which can be viewed in chrome://tracing.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_BASIC_TIMETRACE_H
+#define LLVM_CLANG_BASIC_TIMETRACE_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringRef.h"
+#include <string>
+
+namespace clang {
+
+class TimeTraceProfiler;
+
+/// \brief The profiler regions are recorded into, or null when time tracing
+/// is off.
+extern TimeTraceProfiler *TimeTraceProfilerInstance;
+
+/// \brief Start recording time trace regions.
+///
+/// Regions shorter than \p GranularityInMicroseconds are dropped from the
+/// trace, but still count towards the per-name totals. The profiler is not
+/// thread-safe: regions must all be recorded on the same thread.
+void timeTraceProfilerInitialize(unsigned GranularityInMicroseconds);
+
+/// \brief Stop recording time trace regions and discard those recorded.
+void timeTraceProfilerCleanup();
+
+/// \brief Whether time trace regions are being recorded.
+inline bool timeTraceProfilerEnabled() {
+  return TimeTraceProfilerInstance != nullptr;
+}
+
+/// \brief Write the regions recorded so far to \p OS as a Chrome trace,
+/// followed by the total time spent in the regions of each name.
+void timeTraceProfilerWrite(raw_ostream &OS);
+
+/// \brief Write \p Str to \p OS as a quoted, escaped JSON string.
+void writeJSONString(raw_ostream &OS, StringRef Str);
+
+/// \brief Open a region called \p Name.
+///
+/// \p Detail is called to further identify the region, e.g. by the header
+/// or the declaration it covers; this way, callers need not compute the
+/// description unless tracing is on.
+///
+/// \returns the handle to pass to \c timeTraceProfilerEnd(), or 0 if time
+/// tracing is off.
+unsigned timeTraceProfilerBegin(StringRef Name,
+                                llvm::function_ref<std::string()> Detail);
+
+/// \brief Close the region \p Region.
+///
+/// Regions need not be closed in the reverse order they were opened in: a
+/// header may be entered while parsing a declaration and left after it.
+void timeTraceProfilerEnd(unsigned Region);
+
+/// \brief Records a region covering the lifetime of this object, if time
+/// tracing is on when it is created.
+class TimeTraceScope {
+  unsigned Region;
+
+  TimeTraceScope(const TimeTraceScope &) = delete;
+  void operator=(const TimeTraceScope &) = delete;
+
+public:
+  explicit TimeTraceScope(StringRef Name) : Region(0) {
+    if (timeTraceProfilerEnabled())
+      Region = timeTraceProfilerBegin(Name, [] { return std::string(); });
+  }
+  TimeTraceScope(StringRef Name, llvm::function_ref<std::string()> Detail)
+      : Region(0) {
+    if (timeTraceProfilerEnabled())
+      Region = timeTraceProfilerBegin(Name, Detail);
+  }
+  ~TimeTraceScope() {
+    if (Region)
+      timeTraceProfilerEnd(Region);
+  }
+};
+
+} // end namespace clang
+
+#endif
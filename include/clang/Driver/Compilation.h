@@ -72,6 +72,24 @@ class Compilation {
   /// Whether we're compiling for diagnostic purposes.
   bool ForDiagnostics;
 
+  /// The maximum number of independent jobs to run concurrently.
+  unsigned MaxParallelJobs;
+
+  /// PrintCommand - Print the command line for \p C if -v or CC_PRINT_OPTIONS
+  /// was requested.
+  ///
+  /// \return False if the CC_PRINT_OPTIONS log could not be opened.
+  bool PrintCommand(const Command &C) const;
+
+  /// ExecuteJobsInParallel - Execute the jobs in \p Jobs using up to
+  /// MaxParallelJobs concurrent subprocesses, respecting the dependencies
+  /// between their source actions. Output of each job is buffered and
+  /// replayed in job order, so diagnostics are emitted exactly as they would
+  /// be by a serial run.
+  void ExecuteJobsInParallel(
+      const JobList &Jobs,
+      SmallVectorImpl<std::pair<int, const Command *>> &FailingCommands) const;
+
 public:
   Compilation(const Driver &D, const ToolChain &DefaultToolChain,
               llvm::opt::InputArgList *Args,
@@ -107,6 +125,12 @@ public:
   /// Returns the sysroot path.
   StringRef getSysRoot() const;
 
+  /// Returns the maximum number of jobs which may be executed concurrently.
+  unsigned getMaxParallelJobs() const { return MaxParallelJobs; }
+
+  /// Set the maximum number of jobs which may be executed concurrently (-j).
+  void setMaxParallelJobs(unsigned N) { MaxParallelJobs = N ? N : 1; }
+
   /// getArgsForToolChain - Return the derived argument list for the
   /// tool chain \p TC (or the default tool chain, if TC is not specified).
   ///
@@ -165,7 +189,9 @@ public:
   /// \return The result code of the subprocess.
   int ExecuteCommand(const Command &C, const Command *&FailingCommand) const;
 
-  /// ExecuteJob - Execute a single job.
+  /// ExecuteJobs - Execute the jobs in \p Jobs, skipping any job whose inputs
+  /// failed to build. If more than one parallel job was requested, independent
+  /// jobs are executed concurrently.
   ///
   /// \param FailingCommands - For non-zero results, this will be a vector of
   /// failing commands and their associated result code.
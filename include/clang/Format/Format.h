@@ -302,6 +302,14 @@ struct FormatStyle {
   /// \brief The maximum number of consecutive empty lines to keep.
   unsigned MaxEmptyLinesToKeep;
 
+  /// \brief The maximum number of states to analyze while looking for the
+  /// best line breaks in a single unwrapped line, or 0 for no limit.
+  ///
+  /// Once the limit is reached, the cheapest partial solution found so far
+  /// is completed greedily. This bounds the time spent on pathological lines
+  /// such as long, deeply nested initializer lists.
+  unsigned MaxLineBreakingStates;
+
   /// \brief Different ways to indent namespace contents.
   enum NamespaceIndentationKind {
     /// Don't indent in namespaces.
@@ -491,6 +499,7 @@ struct FormatStyle {
            MacroBlockBegin == R.MacroBlockBegin &&
            MacroBlockEnd == R.MacroBlockEnd &&
            MaxEmptyLinesToKeep == R.MaxEmptyLinesToKeep &&
+           MaxLineBreakingStates == R.MaxLineBreakingStates &&
            NamespaceIndentation == R.NamespaceIndentation &&
            ObjCBlockIndentWidth == R.ObjCBlockIndentWidth &&
            ObjCSpaceAfterProperty == R.ObjCSpaceAfterProperty &&
@@ -569,6 +578,19 @@ std::error_code parseConfiguration(StringRef Text, FormatStyle *Style);
 /// \brief Gets configuration in a YAML string.
 std::string configurationAsText(const FormatStyle &Style);
 
+/// \brief How much work finding the line breaks of one unwrapped line took.
+struct LineBreakingStats {
+  /// \brief The location of the first token of the line.
+  SourceLocation Loc;
+
+  /// \brief The number of states of the line that were analyzed.
+  unsigned States;
+
+  /// \brief Whether \c FormatStyle::MaxLineBreakingStates was reached, and
+  /// the line was completed greedily.
+  bool Greedy;
+};
+
 /// \brief Reformats the given \p Ranges in the file \p ID.
 ///
 /// Each range is extended on either end to its next bigger logic unit, i.e.
@@ -581,10 +603,14 @@ std::string configurationAsText(const FormatStyle &Style);
 /// If \c IncompleteFormat is non-null, its value will be set to true if any
 /// of the affected ranges were not formatted due to a non-recoverable syntax
 /// error.
+///
+/// If \c Stats is non-null, an entry is added to it for each line whose line
+/// breaks had to be searched for.
 tooling::Replacements reformat(const FormatStyle &Style,
                                SourceManager &SourceMgr, FileID ID,
                                ArrayRef<CharSourceRange> Ranges,
-                               bool *IncompleteFormat = nullptr);
+                               bool *IncompleteFormat = nullptr,
+                               std::vector<LineBreakingStats> *Stats = nullptr);
 
 /// \brief Reformats the given \p Ranges in \p Code.
 ///
@@ -626,6 +652,11 @@ extern const char *StyleOptionHelpDescription;
 FormatStyle getStyle(StringRef StyleName, StringRef FileName,
                      StringRef FallbackStyle);
 
+/// \brief Same as above, but writes the problems found with the style to
+/// \p Errs instead of to stderr.
+FormatStyle getStyle(StringRef StyleName, StringRef FileName,
+                     StringRef FallbackStyle, raw_ostream &Errs);
+
 } // end namespace format
 } // end namespace clang
 
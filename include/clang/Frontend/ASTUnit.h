@@ -57,6 +57,7 @@ class FileManager;
 class HeaderSearch;
 class Preprocessor;
 class PCHContainerOperations;
+class PreambleCache;
 class SourceManager;
 class TargetInfo;
 class ASTFrontendAction;
@@ -291,6 +292,10 @@ private:
   /// \brief A list of the serialization ID numbers for each of the top-level
   /// declarations parsed within the precompiled preamble.
   std::vector<serialization::DeclID> TopLevelDeclsInPreamble;
+
+  /// \brief The on-disk cache consulted before precompiling a preamble, and
+  /// updated afterwards, if any.
+  IntrusiveRefCntPtr<PreambleCache> SharedPreambleCache;
   
   /// \brief Whether we should be caching code-completion results.
   bool ShouldCacheCodeCompletionResults : 1;
@@ -302,6 +307,25 @@ private:
   /// \brief True if non-system source files should be treated as volatile
   /// (likely to change while trying to use them).
   bool UserFilesAreVolatile : 1;
+
+  /// \brief Whether an out-of-date precompiled preamble is rebuilt on a
+  /// background thread instead of before reparsing.
+  bool BuildPreambleInBackground : 1;
+
+  /// \brief Whether the precompiled preamble is split into a base and a
+  /// suffix chained onto it, so that only the suffix is rebuilt when just the
+  /// last directives of the preamble change.
+  bool ChainPreambles : 1;
+
+  struct PreambleBuild;
+
+  /// \brief The precompiled preamble being built on a background thread, if
+  /// any.
+  std::unique_ptr<PreambleBuild> BackgroundPreamble;
+
+  /// \brief When chaining preambles, the precompiled base of the current
+  /// preamble, if any.
+  std::unique_ptr<PreambleBuild> ChainedPreambleBase;
  
   /// \brief The language options used when we load an AST file.
   LangOptions ASTFileLangOpts;
@@ -447,6 +471,26 @@ private:
       std::shared_ptr<PCHContainerOperations> PCHContainerOps,
       const CompilerInvocation &PreambleInvocationIn, bool AllowRebuild = true,
       unsigned MaxLines = 0);
+  void startBackgroundPreambleBuild(
+      std::shared_ptr<PCHContainerOperations> PCHContainerOps,
+      const CompilerInvocation &PreambleInvocation,
+      const ComputedPreamble &NewPreamble);
+  void adoptBackgroundPreamble(const ComputedPreamble &NewPreamble);
+  void discardBackgroundPreamble();
+  std::unique_ptr<PreambleBuild>
+  createPreambleBuild(std::shared_ptr<PCHContainerOperations> PCHContainerOps,
+                      const CompilerInvocation &PreambleInvocation,
+                      const llvm::MemoryBuffer &MainBuffer, unsigned Size,
+                      bool EndsAtStartOfLine, StringRef PCHPath);
+  void buildChainedPreambleBase(
+      std::shared_ptr<PCHContainerOperations> PCHContainerOps,
+      const CompilerInvocation &PreambleInvocation,
+      const ComputedPreamble &NewPreamble, unsigned BaseSize);
+  void clearChainedPreambleBase();
+  FileID getPreambleBaseFileID() const;
+  std::unique_ptr<llvm::MemoryBuffer>
+  loadPreambleFromCache(StringRef Key, const ComputedPreamble &NewPreamble,
+                        const CompilerInvocation &PreambleInvocation);
   void RealizeTopLevelDeclsFromPreamble();
 
   /// \brief Transfers ownership of the objects (like SourceManager) from
@@ -543,6 +587,40 @@ public:
   bool getOwnsRemappedFileBuffers() const { return OwnsRemappedFileBuffers; }
   void setOwnsRemappedFileBuffers(bool val) { OwnsRemappedFileBuffers = val; }
 
+  /// \brief Set the on-disk cache used to share precompiled preambles with
+  /// other ASTUnits and other processes. Defaults to
+  /// \c PreambleCache::getDefault().
+  void setPreambleCache(IntrusiveRefCntPtr<PreambleCache> Cache);
+  PreambleCache *getPreambleCache() const;
+
+  /// \brief Rebuild out-of-date precompiled preambles on a background thread.
+  ///
+  /// When a file included by the preamble changes, reparsing and code
+  /// completion keep using the old precompiled preamble, without validating
+  /// it, until the new one has been built; it is swapped in by the first
+  /// reparse after that. When the preamble itself changes, the old
+  /// precompiled preamble keeps being used if it is a prefix of the new one;
+  /// otherwise the main file is parsed without a preamble in the meantime.
+  void setBuildPreambleInBackground(bool Value) {
+    BuildPreambleInBackground = Value;
+  }
+  bool getBuildPreambleInBackground() const {
+    return BuildPreambleInBackground;
+  }
+
+  /// \brief Split the precompiled preamble at its last top-level directive.
+  ///
+  /// The part before that directive is precompiled on its own and the rest
+  /// is precompiled as a PCH chained onto it. While the base stays the same
+  /// and none of the files it includes change, only the suffix is rebuilt;
+  /// this makes adding or editing the last few \#includes cheap.
+  void setChainPreambles(bool Value) { ChainPreambles = Value; }
+  bool getChainPreambles() const { return ChainPreambles; }
+
+  /// \brief Block until the precompiled preamble being built in the
+  /// background, if any, is ready to be swapped in.
+  void waitForBackgroundPreamble();
+
   StringRef getMainFileName() const;
 
   /// \brief If this ASTUnit came from an AST file, returns the filename for it.
@@ -128,6 +128,8 @@ public:
   unsigned ShowTimers : 1;                 ///< Show timers for individual
                                            /// actions.
   unsigned ShowVersion : 1;                ///< Show the -version text.
+  unsigned TimeTrace : 1;                  ///< Write a time trace of the
+                                           /// compilation.
   unsigned FixWhatYouCan : 1;              ///< Apply fixes even if there are
                                            /// unfixable errors.
   unsigned FixOnlyWarnings : 1;            ///< Apply fixes only for warnings.
@@ -148,6 +150,10 @@ public:
   unsigned ASTDumpLookups : 1;             ///< Whether we include lookup table
                                            ///< dumps in AST dumps.
 
+  /// \brief The minimum duration, in microseconds, of the regions written to
+  /// the time trace.
+  unsigned TimeTraceGranularity;
+
   CodeCompleteOptions CodeCompleteOpts;
 
   enum {
@@ -207,6 +213,10 @@ public:
   /// The output file, if any.
   std::string OutputFile;
 
+  /// \brief The file to write the cost of each template instantiation to, if
+  /// any.
+  std::string TemplateInstantiationReport;
+
   /// If given, the new suffix for fix-it rewritten files.
   std::string FixItSuffix;
 
@@ -255,11 +265,12 @@ public:
 public:
   FrontendOptions() :
     DisableFree(false), RelocatablePCH(false), ShowHelp(false),
-    ShowStats(false), ShowTimers(false), ShowVersion(false),
+    ShowStats(false), ShowTimers(false), ShowVersion(false), TimeTrace(false),
     FixWhatYouCan(false), FixOnlyWarnings(false), FixAndRecompile(false),
     FixToTemporaries(false), ARCMTMigrateEmitARCErrors(false),
     SkipFunctionBodies(false), UseGlobalModuleIndex(true),
     GenerateGlobalModuleIndex(true), ASTDumpDecls(false), ASTDumpLookups(false),
+    TimeTraceGranularity(500),
     ARCMTAction(ARCMT_None), ObjCMTAction(ObjCMT_None),
     ProgramAction(frontend::ParseSyntaxOnly)
   {}
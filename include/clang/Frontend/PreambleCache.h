@@ -0,0 +1,121 @@
+//===--- PreambleCache.h - Persistent preamble cache ------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Defines the PreambleCache class, an on-disk cache of precompiled preambles
+// shared by all the ASTUnits of all the processes that point at the same
+// directory.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_FRONTEND_PREAMBLECACHE_H
+#define LLVM_CLANG_FRONTEND_PREAMBLECACHE_H
+
+#include "clang/Basic/LLVM.h"
+#include "clang/Frontend/ASTUnit.h"
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Mutex.h"
+#include <string>
+#include <vector>
+
+namespace clang {
+
+class CompilerInvocation;
+
+/// \brief A content-addressed, on-disk cache of precompiled preambles.
+///
+/// Each entry is keyed by a hash of everything that determines the contents
+/// of the precompiled preamble except the headers it includes: the compiler
+/// version, the compiler invocation and the text of the preamble itself. An
+/// entry consists of the PCH file (\c <key>.pch) and a small metadata file
+/// (\c <key>.meta) that records the state \c ASTUnit keeps alongside the
+/// preamble, including the size and modification time of every file the
+/// preamble depends on. Those are checked when the entry is reused, exactly
+/// as they are for an in-memory preamble.
+///
+/// Entries are written to temporary files and renamed into place, so several
+/// processes may share a cache directory. Once the directory grows beyond the
+/// size limit, the least recently used entries are removed.
+class PreambleCache : public llvm::ThreadSafeRefCountedBase<PreambleCache> {
+public:
+  /// \brief The state of an \c ASTUnit that is saved with a preamble.
+  struct Entry {
+    unsigned NumWarnings;
+    unsigned TopLevelHashValue;
+    llvm::StringMap<ASTUnit::PreambleFileHash> Files;
+    std::vector<serialization::DeclID> TopLevelDecls;
+    std::vector<ASTUnit::StandaloneDiagnostic> Diagnostics;
+
+    Entry() : NumWarnings(0), TopLevelHashValue(0) {}
+  };
+
+private:
+  std::string Directory;
+  uint64_t MaxSize;
+
+  mutable llvm::sys::Mutex Lock;
+
+  // Statistics.
+  unsigned NumHits, NumMisses, NumStores;
+
+  std::string getEntryPath(StringRef Key, StringRef Extension) const;
+
+public:
+  /// \param Directory The directory holding the cache entries. It is created
+  /// when the first entry is stored.
+  ///
+  /// \param MaxSize The size, in bytes, the cache directory is pruned down to
+  /// after storing an entry. Zero means no limit.
+  PreambleCache(StringRef Directory, uint64_t MaxSize);
+
+  StringRef getDirectory() const { return Directory; }
+
+  /// \brief Compute the cache key for the preamble \p PreambleText of
+  /// \p MainFilename when compiled with \p Invocation.
+  static std::string getKey(const CompilerInvocation &Invocation,
+                            StringRef MainFilename, StringRef PreambleText,
+                            bool PreambleEndsAtStartOfLine);
+
+  /// \brief Look up the entry for \p Key and mark it as recently used.
+  ///
+  /// \returns true and fills in \p Result if a complete entry was found.
+  bool lookup(StringRef Key, Entry &Result);
+
+  /// \brief Copy the precompiled preamble stored for \p Key to \p DestPath.
+  ///
+  /// \returns true on success.
+  bool retrievePCH(StringRef Key, StringRef DestPath);
+
+  /// \brief Store the precompiled preamble \p PCHPath and its associated
+  /// state under \p Key, then prune the cache.
+  ///
+  /// Failures are silently ignored; the cache is only an optimization.
+  void store(StringRef Key, const Entry &E, StringRef PCHPath);
+
+  /// \brief Remove the least recently used entries until the cache directory
+  /// is no larger than the size limit.
+  ///
+  /// \returns the number of entries removed.
+  unsigned prune();
+
+  unsigned getNumHits() const;
+  unsigned getNumMisses() const;
+  unsigned getNumStores() const;
+
+  /// \brief Returns the cache used by every newly created ASTUnit, if any.
+  static IntrusiveRefCntPtr<PreambleCache> getDefault();
+
+  /// \brief Sets the cache used by every ASTUnit created from now on. Pass
+  /// null to stop caching preambles on disk.
+  static void setDefault(IntrusiveRefCntPtr<PreambleCache> Cache);
+};
+
+} // end namespace clang
+
+#endif
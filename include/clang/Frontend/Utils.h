@@ -160,6 +160,10 @@ void AttachHeaderIncludeGen(Preprocessor &PP, bool ShowAllHeaders = false,
                             StringRef OutputPath = "",
                             bool ShowDepth = true, bool MSStyle = false);
 
+/// AttachTimeTraceCallbacks - Record the time spent in each file included by
+/// the given preprocessor in the time trace.
+void AttachTimeTraceCallbacks(Preprocessor &PP);
+
 /// Cache tokens for use with PCH. Note that this requires a seekable stream.
 void CacheTokens(Preprocessor &PP, raw_pwrite_stream *OS);
 
@@ -0,0 +1,167 @@
+//===--- SymbolIndex.h - On-disk index of symbol occurrences ----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines the SymbolIndex and SymbolIndexBuilder classes, which read
+/// and write a compact on-disk index of the occurrences of symbols, keyed by
+/// USR.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_INDEX_SYMBOLINDEX_H
+#define LLVM_CLANG_INDEX_SYMBOLINDEX_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringSet.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace llvm {
+class MemoryBuffer;
+}
+
+namespace clang {
+namespace index {
+
+/// \brief The ways a symbol can occur at a location. These match
+/// CXSymbolIndexRole.
+enum SymbolRole {
+  SymbolRole_Declaration = 0x1,
+  SymbolRole_Definition = 0x2,
+  SymbolRole_Reference = 0x4
+};
+
+/// \brief An occurrence of a symbol, as read from a SymbolIndex.
+///
+/// The strings point into the index and are null-terminated.
+struct SymbolOccurrence {
+  StringRef USR;
+  StringRef FilePath;
+  unsigned Line;
+  unsigned Column;
+  /// \brief A mask of SymbolRole values.
+  unsigned Roles;
+};
+
+/// \brief A read-only view of a symbol index file, which is memory-mapped
+/// rather than read when it is large enough.
+///
+/// The file holds a string table with the USRs and file paths, the
+/// occurrences grouped by file into one segment per file, and a table of
+/// symbols sorted by USR, each with the list of its occurrences. Looking up
+/// a USR is a binary search that touches only the pages it needs, so a
+/// large index can be queried without being read in full.
+class SymbolIndex {
+  std::unique_ptr<llvm::MemoryBuffer> Buffer;
+  const unsigned char *Files;
+  const unsigned char *Symbols;
+  const unsigned char *SymbolOccurrences;
+  const unsigned char *Occurrences;
+  StringRef Strings;
+  unsigned NumFiles;
+  unsigned NumSymbols;
+  unsigned NumOccurrences;
+
+  explicit SymbolIndex(std::unique_ptr<llvm::MemoryBuffer> Buffer);
+
+  StringRef getString(uint32_t Offset) const;
+  bool getOccurrence(unsigned I, SymbolOccurrence &Occurrence) const;
+  bool findFile(StringRef FilePath, unsigned &I) const;
+
+public:
+  ~SymbolIndex();
+
+  /// \brief Open the symbol index in the file \p Path.
+  ///
+  /// \returns the index, or null with a description of the problem in
+  /// \p Error.
+  static std::unique_ptr<SymbolIndex> load(StringRef Path, std::string &Error);
+
+  unsigned getNumFiles() const { return NumFiles; }
+  unsigned getNumSymbols() const { return NumSymbols; }
+  unsigned getNumOccurrences() const { return NumOccurrences; }
+
+  /// \brief Return the path of the \p I'th file, in the order of their paths.
+  StringRef getFilePath(unsigned I) const;
+
+  /// \brief Call \p Receiver on each occurrence of the symbol \p USR, in the
+  /// order of their file paths and positions, until it returns false.
+  ///
+  /// \returns false if \p Receiver stopped the walk.
+  bool forEachOccurrence(
+      StringRef USR,
+      llvm::function_ref<bool(const SymbolOccurrence &)> Receiver) const;
+
+  /// \brief Call \p Receiver on each occurrence in the file \p FilePath, in
+  /// the order of their positions, until it returns false.
+  ///
+  /// \returns false if \p Receiver stopped the walk.
+  bool forEachOccurrenceInFile(
+      StringRef FilePath,
+      llvm::function_ref<bool(const SymbolOccurrence &)> Receiver) const;
+};
+
+/// \brief Collects the occurrences of symbols reported by indexing and
+/// writes them to a symbol index file, replacing the segments of the files
+/// they are in.
+///
+/// A file's segment is replaced as a whole: once beginFile() was called for
+/// a file, the occurrences recorded for it here take the place of all those
+/// in the index. The segments of the other files are kept, so only the
+/// files that changed need to be indexed again.
+class SymbolIndexBuilder {
+  struct Occurrence {
+    StringRef USR;
+    unsigned Line;
+    unsigned Column;
+    unsigned Roles;
+  };
+
+  /// \brief The USRs recorded, which own the strings the occurrences refer
+  /// to.
+  llvm::StringSet<> USRs;
+
+  /// \brief The occurrences recorded for each file begun.
+  llvm::StringMap<std::vector<Occurrence>> Segments;
+
+  static void sortAndUnique(std::vector<Occurrence> &Segment);
+
+public:
+  /// \brief Start recording the occurrences in the file \p FilePath,
+  /// dropping those the index has for it. Does nothing if the file was
+  /// already begun.
+  void beginFile(StringRef FilePath);
+
+  /// \brief Record an occurrence of the symbol \p USR in the file
+  /// \p FilePath, which is begun if it was not already.
+  ///
+  /// \param Roles a mask of SymbolRole values. Recording the same occurrence
+  /// again merges the roles.
+  void addOccurrence(StringRef USR, StringRef FilePath, unsigned Line,
+                     unsigned Column, unsigned Roles);
+
+  /// \brief Write the index to the file \p Path, which is created if it does
+  /// not exist, keeping the segments of the files not begun here.
+  ///
+  /// The index is written under a temporary name and renamed into place, so
+  /// readers never see a partial index, and the segments written by others
+  /// since the last write are kept.
+  ///
+  /// \returns true on success, or false with a description of the problem
+  /// in \p Error.
+  bool write(StringRef Path, std::string &Error) const;
+};
+
+} // namespace index
+} // namespace clang
+
+#endif // LLVM_CLANG_INDEX_SYMBOLINDEX_H
@@ -30,8 +30,10 @@ class DiagnosticsEngine;
 class ExternalPreprocessorSource;
 class FileEntry;
 class FileManager;
+class HeaderSearchIndex;
 class HeaderSearchOptions;
 class IdentifierInfo;
+class IncludeGuardDatabase;
 class Preprocessor;
 
 /// \brief The preprocessor keeps track of this information for each
@@ -165,6 +167,7 @@ class HeaderSearch {
 
   DiagnosticsEngine &Diags;
   FileManager &FileMgr;
+  SourceManager &SourceMgr;
   /// \#include search path information.  Requests for \#include "x" search the
   /// directory of the \#including file first, then each directory in SearchDirs
   /// consecutively. Requests for <x> search the current dir first, then each
@@ -249,10 +252,19 @@ class HeaderSearch {
 
   /// \brief Entity used to look up stored header file information.
   ExternalHeaderFileInfoSource *ExternalSource;
+
+  /// \brief The include guards recorded by earlier compilations, if
+  /// -finclude-guard-database was given.
+  std::unique_ptr<IncludeGuardDatabase> GuardDB;
+
+  /// \brief Snapshots of the search directories, if -fheader-search-index
+  /// was given.
+  std::unique_ptr<HeaderSearchIndex> SearchIndex;
   
   // Various statistics we track for performance analysis.
   unsigned NumIncluded;
   unsigned NumMultiIncludeFileOptzn;
+  unsigned NumIncludeGuardDatabaseHits;
   unsigned NumFrameworkLookups, NumSubFrameworkLookups;
 
   const LangOptions &LangOpts;
@@ -261,6 +273,8 @@ class HeaderSearch {
   HeaderSearch(const HeaderSearch&) = delete;
   void operator=(const HeaderSearch&) = delete;
 
+  std::string getIncludeGuardDatabasePath(const FileEntry *File);
+
   friend class DirectoryLookup;
   
 public:
@@ -461,9 +475,15 @@ public:
   /// This is used by the multiple-include optimization to eliminate
   /// no-op \#includes.
   void SetFileControllingMacro(const FileEntry *File,
-                               const IdentifierInfo *ControllingMacro) {
-    getFileInfo(File).ControllingMacro = ControllingMacro;
-  }
+                               const IdentifierInfo *ControllingMacro);
+
+  /// \brief Write the include guards learned by this compilation to the
+  /// include guard database, if there is one.
+  void saveIncludeGuardDatabase();
+
+  /// \brief Write the snapshots of search directories taken by this
+  /// compilation to the header search index, if there is one.
+  void saveHeaderSearchIndex();
 
   /// \brief Return true if this is the first time encountering this header.
   bool FirstTimeLexingFile(const FileEntry *File) {
@@ -0,0 +1,98 @@
+//===--- HeaderSearchIndex.h - Snapshots of search directories --*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines the HeaderSearchIndex class, which lets header search rule
+/// out directories without probing the file system, for
+/// -fheader-search-index.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LEX_HEADERSEARCHINDEX_H
+#define LLVM_CLANG_LEX_HEADERSEARCHINDEX_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringSet.h"
+#include <ctime>
+#include <string>
+
+namespace clang {
+
+class DirectoryEntry;
+class FileManager;
+
+/// \brief An on-disk collection of snapshots of the entries of header search
+/// directories.
+///
+/// Resolving an \#include probes each search directory in turn, and with a
+/// long search path most of those probes fail. Given a snapshot of the names
+/// in a directory, a probe for a file whose first path component is not
+/// among them can be answered without asking the file system.
+///
+/// A snapshot applies only while its directory keeps the modification time
+/// it had when the snapshot was taken, which changes whenever an entry is
+/// added to or removed from the directory; so using an index costs one stat
+/// per directory per compilation, rather than one per directory per
+/// \#include. Snapshots taken while a directory could still change within
+/// the same second as its modification time are used, but not saved.
+///
+/// The index is a text file shared by many compilations, each of which
+/// merges the snapshots it had to retake into it as it finishes.
+class HeaderSearchIndex {
+  struct Snapshot {
+    /// \brief The modification time of the directory, and the time the
+    /// snapshot was taken.
+    time_t ModTime, Taken;
+
+    /// \brief The names of the entries of the directory, in lower case, so
+    /// that the snapshot is conservative on case-insensitive file systems.
+    llvm::StringSet<> Names;
+  };
+
+  std::string Path;
+  FileManager &FileMgr;
+
+  /// \brief The snapshots, keyed on absolute directory path.
+  llvm::StringMap<Snapshot> Snapshots;
+
+  /// \brief The directories whose snapshots this compilation retook, and
+  /// which should be saved.
+  llvm::StringSet<> Retaken;
+
+  /// \brief The snapshot that applies to each directory searched so far, or
+  /// null if there is none.
+  llvm::DenseMap<const DirectoryEntry *, const Snapshot *> Current;
+
+  unsigned NumSnapshotsReused, NumSnapshotsTaken, NumProbesAvoided;
+
+  const Snapshot *getSnapshot(const DirectoryEntry *Dir);
+
+public:
+  /// \brief Load the index in the file \p Path, which need not exist.
+  HeaderSearchIndex(StringRef Path, FileManager &FileMgr);
+
+  /// \brief Determine whether the directory \p Dir might contain
+  /// \p Filename, which is relative to it.
+  ///
+  /// \returns false only if \p Filename certainly does not exist.
+  bool mayContain(const DirectoryEntry *Dir, StringRef Filename);
+
+  /// \brief Merge the snapshots this compilation retook into the index file.
+  ///
+  /// \returns true on success, or if there was nothing to write.
+  bool save();
+
+  void PrintStats() const;
+};
+
+} // end namespace clang
+
+#endif
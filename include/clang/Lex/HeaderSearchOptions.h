@@ -92,6 +92,14 @@ public:
   /// \brief The directory used for a user build.
   std::string ModuleUserBuildPath;
 
+  /// \brief The file recording the include guards of headers across
+  /// compilations, if any.
+  std::string IncludeGuardDatabasePath;
+
+  /// \brief The file holding snapshots of the header search directories,
+  /// if any.
+  std::string HeaderSearchIndexPath;
+
   /// \brief Whether we should disable the use of the hash string within the
   /// module cache.
   ///
@@ -129,6 +137,15 @@ public:
   /// regenerated often.
   unsigned ModuleCachePruneAfter;
 
+  /// \brief The maximum number of modules to build at the same time.
+  ///
+  /// When a module has to be built, the modules it, or the translation unit,
+  /// depends on whose module files are missing are first built on this many
+  /// threads, as their own dependencies allow. The dependencies are the
+  /// modules named by 'use' declarations and those the headers include or
+  /// import.
+  unsigned ModulesBuildJobs;
+
   /// \brief The time in seconds when the build session started.
   ///
   /// This time is used by other optimizations in header search and module
@@ -165,18 +182,29 @@ public:
   /// \brief Whether to validate system input files when a module is loaded.
   unsigned ModulesValidateSystemHeaders : 1;
 
+  /// \brief If true, validate each input file of a module or PCH file when
+  /// its contents are first needed, rather than all of them when the file is
+  /// loaded.
+  unsigned ModulesValidateInputFilesLazily : 1;
+
+  /// \brief Whether to compress the source buffers and the large lexical and
+  /// visible declaration tables stored in module and PCH files.
+  unsigned ModulesCompressBuffers : 1;
+
 public:
   HeaderSearchOptions(StringRef _Sysroot = "/")
     : Sysroot(_Sysroot), DisableModuleHash(0), ImplicitModuleMaps(0),
       ModuleMapFileHomeIsCwd(0),
       ModuleCachePruneInterval(7*24*60*60),
       ModuleCachePruneAfter(31*24*60*60),
+      ModulesBuildJobs(1),
       BuildSessionTimestamp(0),
       UseBuiltinIncludes(true),
       UseStandardSystemIncludes(true), UseStandardCXXIncludes(true),
       UseLibcxx(false), Verbose(false),
       ModulesValidateOncePerBuildSession(false),
-      ModulesValidateSystemHeaders(false) {}
+      ModulesValidateSystemHeaders(false),
+      ModulesValidateInputFilesLazily(false), ModulesCompressBuffers(false) {}
 
   /// AddPath - Add the \p Path path to the specified \p Group list.
   void AddPath(StringRef Path, frontend::IncludeDirGroup Group,
@@ -0,0 +1,84 @@
+//===--- IncludeGuardDatabase.h - Include guards across compiles -*- C++ -*-==//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines the IncludeGuardDatabase class, which remembers the
+/// controlling macros of headers from one compilation to the next, for
+/// -finclude-guard-database.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LEX_INCLUDEGUARDDATABASE_H
+#define LLVM_CLANG_LEX_INCLUDEGUARDDATABASE_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/StringMap.h"
+#include <ctime>
+#include <string>
+
+namespace clang {
+
+/// \brief An on-disk record of the headers that earlier compilations found
+/// to be wrapped entirely in an include guard, and of the macro guarding
+/// each one.
+///
+/// Within a single compilation, the multiple-include optimization only
+/// learns a header's controlling macro after lexing the header once. With
+/// the database, a header whose guard macro is already defined the first
+/// time it is included need not be opened at all.
+///
+/// Each entry is keyed on the absolute path of the header, and only applies
+/// while the header keeps the size and modification time it had when the
+/// entry was recorded. The database is a text file with one
+/// "<size> <mtime> <macro> <path>" line per header. Compilations sharing it
+/// merge their entries into it as they finish; since it is only a cache,
+/// entries lost to a concurrent update, or a database that cannot be read
+/// or written, merely cost the header being lexed again.
+class IncludeGuardDatabase {
+  struct Entry {
+    uint64_t Size;
+    time_t ModTime;
+    std::string Macro;
+  };
+
+  std::string Path;
+
+  /// \brief The entries read from the database.
+  llvm::StringMap<Entry> Entries;
+
+  /// \brief The entries learned by this compilation, not yet written.
+  llvm::StringMap<Entry> NewEntries;
+
+  static void read(StringRef Path, llvm::StringMap<Entry> &Entries);
+
+public:
+  /// \brief Load the database in the file \p Path, which need not exist.
+  explicit IncludeGuardDatabase(StringRef Path);
+
+  /// \brief Return the controlling macro recorded for the header
+  /// \p FilePath with the given size and modification time, or an empty
+  /// string if there is none.
+  StringRef getControllingMacro(StringRef FilePath, uint64_t Size,
+                                time_t ModTime) const;
+
+  /// \brief Record that the header \p FilePath, with the given size and
+  /// modification time, is guarded by \p Macro.
+  void setControllingMacro(StringRef FilePath, uint64_t Size, time_t ModTime,
+                           StringRef Macro);
+
+  /// \brief Merge the entries recorded by this compilation into the
+  /// database file.
+  ///
+  /// \returns true on success, or if there was nothing to write.
+  bool save();
+};
+
+} // end namespace clang
+
+#endif
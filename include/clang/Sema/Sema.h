@@ -161,6 +161,7 @@ namespace clang {
   class TemplateArgumentList;
   class TemplateArgumentLoc;
   class TemplateDecl;
+  class TemplateInstantiationStats;
   class TemplateParameterList;
   class TemplatePartialOrderingContext;
   class TemplateTemplateParmDecl;
@@ -932,6 +933,24 @@ public:
   /// \brief The number of SFINAE diagnostics that have been trapped.
   unsigned NumSFINAEErrors;
 
+  /// \brief The overload candidates considered, and the ones of those found
+  /// to be viable, by every overload resolution in the translation unit.
+  unsigned NumOverloadCandidates, NumViableOverloadCandidates;
+
+  /// \brief Identifies an attempt to initialize a parameter of an overload
+  /// candidate from an argument: the canonical argument and parameter types,
+  /// the value kind of the argument and the conversions that were allowed.
+  typedef std::pair<std::pair<void *, void *>, unsigned> ArgumentConversionKey;
+
+  /// \brief The argument conversions that overload resolution has already
+  /// found to be impossible, with how each failed, so that candidates that
+  /// need them can be rejected without trying again.
+  llvm::DenseMap<ArgumentConversionKey, unsigned> NonViableConversions;
+
+  /// \brief The number of times a candidate was rejected because of a
+  /// conversion in NonViableConversions.
+  unsigned NumNonViableConversionsReused;
+
   typedef llvm::DenseMap<ParmVarDecl *, llvm::TinyPtrVector<ParmVarDecl *>>
     UnparsedDefaultArgInstantiationsMap;
 
@@ -6532,6 +6551,10 @@ public:
   SmallVector<ActiveTemplateInstantiation, 16>
     ActiveTemplateInstantiations;
 
+  /// \brief The cost of each template instantiation, if it is being recorded
+  /// for -ftemplate-instantiation-report.
+  std::unique_ptr<TemplateInstantiationStats> TemplateInstStats;
+
   /// \brief Extra modules inspected when performing a lookup during a template
   /// instantiation. Computed lazily.
   SmallVector<Module*, 16> ActiveTemplateInstantiationLookupModules;
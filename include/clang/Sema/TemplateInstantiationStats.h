@@ -0,0 +1,122 @@
+//===--- TemplateInstantiationStats.h - Cost of instantiations --*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines the TemplateInstantiationStats class, which records what
+/// each template specialization instantiated in a translation unit cost, for
+/// -ftemplate-instantiation-report.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_SEMA_TEMPLATEINSTANTIATIONSTATS_H
+#define LLVM_CLANG_SEMA_TEMPLATEINSTANTIATIONSTATS_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/DenseMap.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace clang {
+
+class ASTContext;
+class Decl;
+class NamedDecl;
+
+/// \brief Records the time spent, and the number of AST nodes created, while
+/// instantiating the definition of each class, function and variable
+/// template specialization (including members of class template
+/// specializations).
+///
+/// Both are recorded including and excluding the instantiations nested
+/// within each instantiation, so that the cost of a specialization can be
+/// told apart from the cost of the specializations it happens to trigger
+/// first.
+class TemplateInstantiationStats {
+public:
+  enum InstantiationKind {
+    IK_Class,
+    IK_Function,
+    IK_Variable
+  };
+
+private:
+  typedef std::chrono::steady_clock Clock;
+
+  struct Specialization {
+    std::string Name;
+    InstantiationKind Kind;
+
+    /// \brief The location of the definition it was instantiated from, as
+    /// "file:line".
+    std::string PatternLoc;
+
+    /// \brief The deepest instantiation depth it was instantiated at.
+    unsigned Depth;
+
+    /// \brief The time taken, in microseconds, with and without the nested
+    /// instantiations.
+    uint64_t Time, SelfTime;
+
+    /// \brief The AST nodes created, with and without the nested
+    /// instantiations.
+    unsigned Nodes, SelfNodes;
+  };
+
+  /// \brief An instantiation in progress.
+  struct ActiveInstantiation {
+    unsigned Index;
+    Clock::time_point Start;
+    unsigned StartNodes;
+    Clock::duration NestedTime;
+    unsigned NestedNodes;
+  };
+
+  ASTContext &Ctx;
+  std::vector<Specialization> Specializations;
+  llvm::DenseMap<const Decl *, unsigned> SpecializationIndex;
+  std::vector<ActiveInstantiation> Active;
+
+public:
+  explicit TemplateInstantiationStats(ASTContext &Ctx);
+
+  /// \brief Note that we started instantiating the definition of
+  /// \p Instantiation from \p Pattern, at instantiation depth \p Depth.
+  void begin(InstantiationKind Kind, const NamedDecl *Instantiation,
+             const Decl *Pattern, unsigned Depth);
+
+  /// \brief Note that we finished the most recently started instantiation.
+  void end();
+
+  /// \brief Write the statistics of each specialization instantiated in the
+  /// translation unit \p MainFile to \p OS as JSON, most expensive first.
+  void write(raw_ostream &OS, StringRef MainFile) const;
+
+  /// \brief Records an instantiation for as long as it is in scope, if
+  /// statistics are being recorded at all.
+  class Scope {
+    TemplateInstantiationStats *Stats;
+
+  public:
+    Scope(TemplateInstantiationStats *Stats, InstantiationKind Kind,
+          const NamedDecl *Instantiation, const Decl *Pattern, unsigned Depth)
+        : Stats(Stats) {
+      if (Stats)
+        Stats->begin(Kind, Instantiation, Pattern, Depth);
+    }
+    ~Scope() {
+      if (Stats)
+        Stats->end();
+    }
+  };
+};
+
+} // end namespace clang
+
+#endif
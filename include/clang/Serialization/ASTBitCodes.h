@@ -45,7 +45,7 @@ namespace clang {
     /// for the previous version could still support reading the new
     /// version by ignoring new kinds of subblocks), this number
     /// should be increased.
-    const unsigned VERSION_MINOR = 0;
+    const unsigned VERSION_MINOR = 1;
 
     /// \brief An ID number that refers to an identifier in an AST file.
     /// 
@@ -581,7 +581,11 @@ namespace clang {
       SM_SLOC_BUFFER_BLOB = 3,
       /// \brief Describes a source location entry (SLocEntry) for a
       /// macro expansion.
-      SM_SLOC_EXPANSION_ENTRY = 4
+      SM_SLOC_EXPANSION_ENTRY = 4,
+      /// \brief Describes a zlib-compressed blob that contains the data for
+      /// a buffer entry, in place of a SM_SLOC_BUFFER_BLOB record, along
+      /// with its uncompressed size.
+      SM_SLOC_BUFFER_BLOB_COMPRESSED = 5
     };
 
     /// \brief Record types used within a preprocessor block.
@@ -1108,6 +1112,12 @@ namespace clang {
       DECL_EMPTY,
       /// \brief An ObjCTypeParamDecl record.
       DECL_OBJC_TYPE_PARAM,
+      /// \brief A zlib-compressed DECL_CONTEXT_LEXICAL record, along with
+      /// the size of its uncompressed blob.
+      DECL_CONTEXT_LEXICAL_COMPRESSED,
+      /// \brief A zlib-compressed DECL_CONTEXT_VISIBLE record, along with
+      /// its bucket offset and the size of its uncompressed blob.
+      DECL_CONTEXT_VISIBLE_COMPRESSED,
     };
 
     /// \brief Record codes for each kind of statement or expression.
@@ -384,6 +384,10 @@ private:
   /// \brief A timer used to track the time spent deserializing.
   std::unique_ptr<llvm::Timer> ReadTimer;
 
+  /// \brief Whether to time input file validation and decompression, for
+  /// PrintStats.
+  bool TimeStats;
+
   /// \brief The location where the module file will be considered as
   /// imported from. For non-module AST types it should be invalid.
   SourceLocation CurrentImportLoc;
@@ -524,6 +528,11 @@ private:
   /// performed deduplication.
   llvm::SetVector<NamedDecl*> PendingMergedDefinitionsToDeduplicate;
 
+  /// \brief Inflate the compressed blob of a declaration context record,
+  /// replacing \p Blob with the inflated contents owned by \p M.
+  bool InflateDeclContextBlob(ModuleFile &M, StringRef &Blob,
+                              uint64_t UncompressedSize);
+
   /// \brief Read the records that describe the contents of declcontexts.
   bool ReadDeclContextStorage(ModuleFile &M,
                               llvm::BitstreamCursor &Cursor,
@@ -826,6 +835,35 @@ private:
   /// \brief The number of source location entries in the chain.
   unsigned TotalNumSLocEntries;
 
+  /// \brief The number of input files looked up and validated.
+  unsigned NumInputFilesValidated;
+
+  /// \brief The time spent looking up and validating input files.
+  llvm::TimeRecord InputFileValidationTime;
+
+  /// \brief The number of compressed source manager buffers inflated.
+  unsigned NumCompressedBuffersRead;
+
+  /// \brief The total size of the compressed buffers inflated, before and
+  /// after inflating them.
+  uint64_t CompressedBufferBytesRead;
+  uint64_t UncompressedBufferBytesRead;
+
+  /// \brief The time spent inflating compressed buffers.
+  llvm::TimeRecord BufferDecompressionTime;
+
+  /// \brief The number of compressed lexical and visible declaration blobs
+  /// inflated.
+  unsigned NumCompressedDeclContextsRead;
+
+  /// \brief The total size of the compressed declaration blobs inflated,
+  /// before and after inflating them.
+  uint64_t CompressedDeclContextBytesRead;
+  uint64_t UncompressedDeclContextBytesRead;
+
+  /// \brief The time spent inflating compressed declaration blobs.
+  llvm::TimeRecord DeclContextDecompressionTime;
+
   /// \brief The number of statements (and expressions) de-serialized
   /// from the chain.
   unsigned NumStatementsRead;
@@ -1056,6 +1094,11 @@ private:
   serialization::InputFile getInputFile(ModuleFile &F, unsigned ID,
                                         bool Complain = true);
 
+  /// \brief Read the blob record holding the contents of a buffer, which
+  /// follows its source location entry, and inflate it if it is compressed.
+  std::unique_ptr<llvm::MemoryBuffer>
+  ReadSLocBufferBlob(llvm::BitstreamCursor &SLocEntryCursor, StringRef Name);
+
 public:
   void ResolveImportedPath(ModuleFile &M, std::string &Filename);
   static void ResolveImportedPath(std::string &Filename, StringRef Prefix);
@@ -1401,6 +1444,10 @@ public:
     }
   };
 
+  /// \brief Set whether to time input file validation and decompression,
+  /// which PrintStats reports. This costs two clock reads per input file.
+  void setTimeStats(bool Time) { TimeStats = Time; }
+
   /// \brief Set the AST deserialization listener.
   void setDeserializationListener(ASTDeserializationListener *Listener,
                                   bool TakeOwnership = false);
@@ -523,6 +523,8 @@ private:
                                    llvm::SmallVectorImpl<char> &LookupTable);
   uint64_t WriteDeclContextLexicalBlock(ASTContext &Context, DeclContext *DC);
   uint64_t WriteDeclContextVisibleBlock(ASTContext &Context, DeclContext *DC);
+  bool CompressDeclContextBlob(StringRef Blob,
+                               SmallVectorImpl<char> &Compressed);
   void WriteTypeDeclOffsets();
   void WriteFileDeclIDsMap();
   void WriteComments();
@@ -544,6 +546,8 @@ private:
   unsigned DeclParmVarAbbrev;
   unsigned DeclContextLexicalAbbrev;
   unsigned DeclContextVisibleLookupAbbrev;
+  unsigned DeclContextLexicalCompressedAbbrev;
+  unsigned DeclContextVisibleLookupCompressedAbbrev;
   unsigned UpdateVisibleAbbrev;
   unsigned DeclRecordAbbrev;
   unsigned DeclTypedefAbbrev;
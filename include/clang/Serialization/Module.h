@@ -419,6 +419,10 @@ public:
   /// for each DeclContext.
   DeclContextInfosMap DeclContextInfos;
 
+  /// \brief The inflated contents of the compressed lexical and visible
+  /// declaration blobs read so far, which DeclContextInfos point into.
+  std::vector<std::unique_ptr<llvm::MemoryBuffer>> InflatedDeclContextBlobs;
+
   /// \brief Array of file-level DeclIDs sorted by file.
   const serialization::DeclID *FileSortedDecls;
   unsigned NumFileSortedDecls;
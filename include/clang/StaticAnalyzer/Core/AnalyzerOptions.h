@@ -121,6 +121,26 @@ enum IPAKind {
   IPAK_DynamicDispatchBifurcate = 5
 };
 
+/// \brief Describes the order in which the path-sensitive engine explores
+/// the exploded graph.
+enum ExplorationStrategyKind {
+  ESK_NotSet = 0,
+
+  /// Depth-first search.
+  ESK_DFS = 1,
+
+  /// Breadth-first search.
+  ESK_BFS = 2,
+
+  /// Breadth-first search across basic blocks, depth-first within a block.
+  ESK_BFSBlockDFSContents = 3,
+
+  /// Prefer paths entering CFG blocks that have not been visited yet, then
+  /// paths that can still reach unvisited blocks, so that more of a function
+  /// is covered before the node budget runs out.
+  ESK_UnexploredFirst = 4
+};
+
 class AnalyzerOptions : public RefCountedBase<AnalyzerOptions> {
 public:
   typedef llvm::StringMap<std::string> ConfigTable;
@@ -200,6 +220,9 @@ private:
 
   /// Controls which C++ member functions will be considered for inlining.
   CXXInlineableMemberKind CXXMemberInliningMode;
+
+  /// \sa getExplorationStrategy
+  ExplorationStrategyKind ExplorationStrategy;
   
   /// \sa includeTemporaryDtorsInCFG
   Optional<bool> IncludeTemporaryDtorsInCFG;
@@ -250,12 +273,21 @@ private:
   /// \sa getGraphTrimInterval
   Optional<unsigned> GraphTrimInterval;
 
+  /// \sa shouldTrimGraphAggressively
+  Optional<bool> AggressiveGraphTrimming;
+
   /// \sa getMaxTimesInlineLarge
   Optional<unsigned> MaxTimesInlineLarge;
 
   /// \sa getMaxNodesPerTopLevelFunction
   Optional<unsigned> MaxNodesPerTopLevelFunction;
 
+  /// \sa getAnalysisShardCount
+  Optional<unsigned> AnalysisShardCount;
+
+  /// \sa getAnalysisShardIndex
+  Optional<unsigned> AnalysisShardIndex;
+
   /// A helper function that retrieves option for a given full-qualified
   /// checker name.
   /// Options for checkers can be specified via 'analyzer-config' command-line
@@ -361,6 +393,13 @@ public:
   /// \brief Returns the inter-procedural analysis mode.
   IPAKind getIPAMode();
 
+  /// \brief Returns the order in which the exploded graph is explored.
+  ///
+  /// This is controlled by the 'exploration-strategy' config option, which
+  /// accepts "dfs" (the default), "bfs", "bfs-block-dfs-contents" and
+  /// "unexplored-first".
+  ExplorationStrategyKind getExplorationStrategy();
+
   /// Returns the option controlling which C++ member functions will be
   /// considered for inlining.
   ///
@@ -497,6 +536,14 @@ public:
   /// node reclamation, set the option to "0".
   unsigned getGraphTrimInterval();
 
+  /// Returns true if node reclamation should also collapse nodes that record
+  /// a purge of dead symbols which did not change the program state.
+  ///
+  /// This is controlled by the 'aggressive-graph-trimming' config option,
+  /// which accepts the values "true" and "false". It has no effect if node
+  /// reclamation is disabled.
+  bool shouldTrimGraphAggressively();
+
   /// Returns the maximum times a large function could be inlined.
   ///
   /// This is controlled by the 'max-times-inline-large' config option.
@@ -509,6 +556,24 @@ public:
   /// This is controlled by the 'max-nodes' config option.
   unsigned getMaxNodesPerTopLevelFunction();
 
+  /// Returns the number of shards the path-sensitive analysis of a
+  /// translation unit is split into. 1 (the default) disables sharding.
+  ///
+  /// Each analyzer process only analyzes the functions of its own shard (see
+  /// getAnalysisShardIndex()), so that the functions of one large translation
+  /// unit can be analyzed by several processes in parallel. Each shard must
+  /// be given its own output file.
+  ///
+  /// This is controlled by the 'shard-count' config option.
+  unsigned getAnalysisShardCount();
+
+  /// Returns which of the getAnalysisShardCount() shards this process
+  /// analyzes. Shard 0 also runs the AST-based checks. The frontend rejects
+  /// an index that is not less than the shard count.
+  ///
+  /// This is controlled by the 'shard-index' config option.
+  unsigned getAnalysisShardIndex();
+
 public:
   AnalyzerOptions() :
     AnalysisStoreOpt(RegionStoreModel),
@@ -532,7 +597,8 @@ public:
     InliningMode(NoRedundancy),
     UserMode(UMK_NotSet),
     IPAMode(IPAK_NotSet),
-    CXXMemberInliningMode() {}
+    CXXMemberInliningMode(),
+    ExplorationStrategy(ESK_NotSet) {}
 
 };
   
@@ -285,6 +285,23 @@ protected:
   /// Counter to determine when to reclaim nodes.
   unsigned ReclaimCounter;
 
+  /// If non-null, nodes carrying this tag that merely record an ineffective
+  /// purge of dead symbols are reclaimed as well.
+  ///
+  /// \sa enableAggressiveNodeReclamation
+  const ProgramPointTag *CleanupTag;
+
+  /// Out-of-line NodeGroup storage that can be reused, indexed by the log2
+  /// of its capacity.
+  std::vector<std::vector<void *> > FreeGroupStorage;
+
+  /// NodeGroup storage abandoned since the last reclamation point. Group
+  /// iterators may still refer to it until then.
+  std::vector<std::pair<void *, unsigned> > PendingGroupStorage;
+
+  /// The number of bytes allocated for out-of-line NodeGroup storage.
+  size_t GroupStorageBytes;
+
 public:
 
   /// \brief Retrieve the node associated with a (Location,State) pair,
@@ -381,17 +398,41 @@ public:
     ReclaimCounter = ReclaimNodeInterval = Interval;
   }
 
+  /// Additionally reclaim nodes that ExprEngine generates when purging dead
+  /// symbols, if the purge left the state unchanged.
+  ///
+  /// \param Tag The tag ExprEngine attaches to such nodes. Nodes with any
+  ///            other tag are kept, as checkers may report bugs at them.
+  void enableAggressiveNodeReclamation(const ProgramPointTag *Tag) {
+    CleanupTag = Tag;
+  }
+
   /// Reclaim "uninteresting" nodes created since the last time this method
   /// was called.
   void reclaimRecentlyAllocatedNodes();
 
+  /// Returns the number of bytes allocated for nodes, including the nodes
+  /// that were reclaimed, and for their predecessor and successor lists.
+  size_t getNodeBytesAllocated() const {
+    return (NumNodes + FreeNodes.size()) * sizeof(ExplodedNode) +
+           GroupStorageBytes;
+  }
+
   /// \brief Returns true if nodes for the given expression kind are always
   ///        kept around.
   static bool isInterestingLValueExpr(const Expr *Ex);
 
 private:
+  friend class ExplodedNode;
+
   bool shouldCollect(const ExplodedNode *node);
+  bool isIneffectivePurge(const ExplodedNode *node, const ExplodedNode *pred,
+                          const ExplodedNode *succ) const;
+  static bool isCallPoint(const ProgramPoint &Loc);
   void collectNode(ExplodedNode *node);
+
+  void *allocateGroupStorage(unsigned SizeClass);
+  void releaseGroupStorage(void *Storage, unsigned SizeClass);
 };
 
 class ExplodedNodeSet {
@@ -497,6 +497,12 @@ public:
 
   llvm::BumpPtrAllocator& getAllocator() { return Alloc; }
 
+  /// Returns the number of bytes allocated for ProgramState objects, not
+  /// counting the stores, environments and GDMs they refer to.
+  size_t getStateBytesAllocated() const {
+    return (StateSet.size() + freeStates.size()) * sizeof(ProgramState);
+  }
+
   MemRegionManager& getRegionManager() {
     return svalBuilder->getRegionManager();
   }
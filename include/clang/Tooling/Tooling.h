@@ -34,6 +34,7 @@
 #include "clang/Frontend/PCHContainerOperations.h"
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/FileManager.h"
+#include "clang/Basic/FileSystemStatCache.h"
 #include "clang/Basic/LLVM.h"
 #include "clang/Driver/Util.h"
 #include "clang/Frontend/FrontendAction.h"
@@ -312,6 +313,22 @@ class ClangTool {
   /// \brief Clear the command line arguments adjuster chain.
   void clearArgumentsAdjusters();
 
+  /// \brief Set the number of compile commands to process concurrently.
+  ///
+  /// With more than one thread, each compile command gets its own
+  /// \c FileManager and is run relative to its directory via
+  /// -working-directory instead of changing the process working directory.
+  /// Calls into the \c DiagnosticConsumer set by \c setDiagnosticConsumer are
+  /// serialized. The \c ToolAction itself must be safe to run concurrently;
+  /// match callbacks can be serialized with
+  /// \c MatchFinder::MatchFinderOptions::CallbackLock.
+  void setNumThreads(unsigned N) { NumThreads = N; }
+
+  /// \brief Share \p Cache between the file managers of all translation
+  /// units processed by this tool, so that common headers are stat'ed only
+  /// once.
+  void setSharedStatCache(IntrusiveRefCntPtr<SharedFileSystemStatCache> Cache);
+
   /// Runs an action over all files specified in the command line.
   ///
   /// \param Action Tool action.
@@ -323,10 +340,15 @@ class ClangTool {
 
   /// \brief Returns the file manager used in the tool.
   ///
-  /// The file manager is shared between all translation units.
+  /// The file manager is shared between all translation units, unless the
+  /// tool runs on more than one thread.
   FileManager &getFiles() { return *Files; }
 
  private:
+  /// \brief Runs \p Action over all compile commands using \c NumThreads
+  /// worker threads.
+  int runInParallel(ToolAction *Action, const std::string &MainExecutable);
+
   const CompilationDatabase &Compilations;
   std::vector<std::string> SourcePaths;
   std::shared_ptr<PCHContainerOperations> PCHContainerOps;
@@ -338,6 +360,14 @@ class ClangTool {
   ArgumentsAdjuster ArgsAdjuster;
 
   DiagnosticConsumer *DiagConsumer;
+
+  /// \brief Serializes calls into DiagConsumer when running on several
+  /// threads.
+  std::unique_ptr<DiagnosticConsumer> LockedDiagConsumer;
+
+  IntrusiveRefCntPtr<SharedFileSystemStatCache> SharedStatCache;
+
+  unsigned NumThreads;
 };
 
 template <typename T>
@@ -13,11 +13,13 @@
 
 #include "clang/AST/ASTContext.h"
 #include "CXXABI.h"
+#include "ConstexprInterpreter.h"
 #include "clang/AST/ASTMutationListener.h"
 #include "clang/AST/Attr.h"
 #include "clang/AST/CharUnits.h"
 #include "clang/AST/Comment.h"
 #include "clang/AST/CommentCommandTraits.h"
+#include "clang/AST/ConstexprCallCache.h"
 #include "clang/AST/DeclCXX.h"
 #include "clang/AST/DeclObjC.h"
 #include "clang/AST/DeclTemplate.h"
@@ -741,7 +743,8 @@ ASTContext::ASTContext(LangOptions &LOpts, SourceManager &SM,
       FirstLocalImport(), LastLocalImport(), ExternCContext(nullptr),
       SourceMgr(SM), LangOpts(LOpts),
       SanitizerBL(new SanitizerBlacklist(LangOpts.SanitizerBlacklistFiles, SM)),
-      AddrSpaceMap(nullptr), Target(nullptr), PrintingPolicy(LOpts),
+      NumNodesAllocated(0), CountNodesAllocated(false), AddrSpaceMap(nullptr), Target(nullptr),
+      PrintingPolicy(LOpts),
       Idents(idents), Selectors(sels), BuiltinInfo(builtins),
       DeclarationNames(*this), ExternalSource(nullptr), Listener(nullptr),
       Comments(SM), CommentsLoaded(false),
@@ -863,6 +866,12 @@ void ASTContext::PrintStats() const {
     ExternalSource->PrintStats();
   }
 
+  if (ConstexprCalls)
+    ConstexprCalls->PrintStats();
+
+  if (ConstexprInterp)
+    ConstexprInterp->PrintStats();
+
   BumpAlloc.PrintStats();
 }
 
@@ -8418,6 +8427,18 @@ VTableContextBase *ASTContext::getVTableContext() {
   return VTContext.get();
 }
 
+ConstexprCallCache *ASTContext::getConstexprCallCache() {
+  if (!ConstexprCalls && LangOpts.ConstexprCacheSize)
+    ConstexprCalls.reset(new ConstexprCallCache(LangOpts.ConstexprCacheSize));
+  return ConstexprCalls.get();
+}
+
+ConstexprInterpreter *ASTContext::getConstexprInterpreter() {
+  if (!ConstexprInterp && LangOpts.EnableNewConstInterp)
+    ConstexprInterp.reset(new ConstexprInterpreter(*this));
+  return ConstexprInterp.get();
+}
+
 MangleContext *ASTContext::createMangleContext() {
   switch (Target->getCXXABI().getKind()) {
   case TargetCXXABI::GenericAArch64:
@@ -0,0 +1,189 @@
+//===--- ConstexprCallCache.cpp - Memoized constexpr calls ----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the ConstexprCallCache class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/AST/ConstexprCallCache.h"
+#include "llvm/Support/raw_ostream.h"
+using namespace clang;
+
+bool ConstexprCallCache::isCacheableValue(const APValue &Value) {
+  switch (Value.getKind()) {
+  case APValue::Uninitialized:
+  case APValue::Int:
+  case APValue::Float:
+  case APValue::ComplexInt:
+  case APValue::ComplexFloat:
+    return true;
+
+  case APValue::Vector:
+    for (unsigned I = 0, N = Value.getVectorLength(); I != N; ++I)
+      if (!isCacheableValue(Value.getVectorElt(I)))
+        return false;
+    return true;
+
+  case APValue::Array:
+    for (unsigned I = 0, N = Value.getArrayInitializedElts(); I != N; ++I)
+      if (!isCacheableValue(Value.getArrayInitializedElt(I)))
+        return false;
+    return !Value.hasArrayFiller() || isCacheableValue(Value.getArrayFiller());
+
+  case APValue::Struct:
+    for (unsigned I = 0, N = Value.getStructNumBases(); I != N; ++I)
+      if (!isCacheableValue(Value.getStructBase(I)))
+        return false;
+    for (unsigned I = 0, N = Value.getStructNumFields(); I != N; ++I)
+      if (!isCacheableValue(Value.getStructField(I)))
+        return false;
+    return true;
+
+  case APValue::Union:
+    return isCacheableValue(Value.getUnionValue());
+
+  // An lvalue may refer to a temporary or a parameter of the evaluation that
+  // created it, and so may a member pointer's path; neither is meaningful to
+  // any other evaluation.
+  case APValue::LValue:
+  case APValue::MemberPointer:
+  case APValue::AddrLabelDiff:
+    return false;
+  }
+  llvm_unreachable("Unknown APValue kind!");
+}
+
+template <typename T>
+static void addToKey(SmallVectorImpl<char> &Key, const T &Value) {
+  const char *Bytes = reinterpret_cast<const char *>(&Value);
+  Key.append(Bytes, Bytes + sizeof(T));
+}
+
+static void addToKey(SmallVectorImpl<char> &Key, const llvm::APInt &Value) {
+  addToKey(Key, Value.getBitWidth());
+  const char *Bytes = reinterpret_cast<const char *>(Value.getRawData());
+  Key.append(Bytes, Bytes + Value.getNumWords() * sizeof(uint64_t));
+}
+
+static void addToKey(SmallVectorImpl<char> &Key, const llvm::APSInt &Value) {
+  addToKey(Key, Value.isUnsigned());
+  addToKey(Key, static_cast<const llvm::APInt &>(Value));
+}
+
+static void addToKey(SmallVectorImpl<char> &Key, const llvm::APFloat &Value) {
+  addToKey(Key, &Value.getSemantics());
+  addToKey(Key, Value.bitcastToAPInt());
+}
+
+static void addToKey(SmallVectorImpl<char> &Key, const APValue &Value) {
+  addToKey(Key, static_cast<unsigned char>(Value.getKind()));
+  switch (Value.getKind()) {
+  case APValue::Uninitialized:
+    return;
+
+  case APValue::Int:
+    addToKey(Key, Value.getInt());
+    return;
+
+  case APValue::Float:
+    addToKey(Key, Value.getFloat());
+    return;
+
+  case APValue::ComplexInt:
+    addToKey(Key, Value.getComplexIntReal());
+    addToKey(Key, Value.getComplexIntImag());
+    return;
+
+  case APValue::ComplexFloat:
+    addToKey(Key, Value.getComplexFloatReal());
+    addToKey(Key, Value.getComplexFloatImag());
+    return;
+
+  case APValue::Vector:
+    addToKey(Key, Value.getVectorLength());
+    for (unsigned I = 0, N = Value.getVectorLength(); I != N; ++I)
+      addToKey(Key, Value.getVectorElt(I));
+    return;
+
+  case APValue::Array:
+    addToKey(Key, Value.getArraySize());
+    addToKey(Key, Value.getArrayInitializedElts());
+    for (unsigned I = 0, N = Value.getArrayInitializedElts(); I != N; ++I)
+      addToKey(Key, Value.getArrayInitializedElt(I));
+    if (Value.hasArrayFiller())
+      addToKey(Key, Value.getArrayFiller());
+    return;
+
+  case APValue::Struct:
+    addToKey(Key, Value.getStructNumBases());
+    addToKey(Key, Value.getStructNumFields());
+    for (unsigned I = 0, N = Value.getStructNumBases(); I != N; ++I)
+      addToKey(Key, Value.getStructBase(I));
+    for (unsigned I = 0, N = Value.getStructNumFields(); I != N; ++I)
+      addToKey(Key, Value.getStructField(I));
+    return;
+
+  case APValue::Union:
+    addToKey(Key, Value.getUnionField());
+    addToKey(Key, Value.getUnionValue());
+    return;
+
+  case APValue::LValue:
+  case APValue::MemberPointer:
+  case APValue::AddrLabelDiff:
+    llvm_unreachable("value cannot be part of a cache key");
+  }
+  llvm_unreachable("Unknown APValue kind!");
+}
+
+void ConstexprCallCache::getKey(const FunctionDecl *Callee, unsigned EvalMode,
+                                ArrayRef<APValue> Args,
+                                SmallVectorImpl<char> &Key) {
+  Key.clear();
+  addToKey(Key, Callee);
+  addToKey(Key, EvalMode);
+  for (const APValue &Arg : Args)
+    addToKey(Key, Arg);
+}
+
+const ConstexprCallCache::Entry *ConstexprCallCache::lookup(StringRef Key) {
+  llvm::StringMap<Entry>::iterator I = Entries.find(Key);
+  if (I == Entries.end()) {
+    ++NumMisses;
+    return nullptr;
+  }
+  ++NumHits;
+  return &I->second;
+}
+
+void ConstexprCallCache::insert(StringRef Key, const APValue &Result,
+                                unsigned Depth, unsigned Steps) {
+  if (!MaxEntries)
+    return;
+  if (Entries.size() >= MaxEntries) {
+    Entries.clear();
+    ++NumFlushes;
+  }
+
+  Entry &E = Entries[Key];
+  E.Result = Result;
+  E.Depth = Depth;
+  E.Steps = Steps;
+  ++NumInsertions;
+}
+
+void ConstexprCallCache::PrintStats() const {
+  llvm::errs() << "\n*** Constexpr Call Cache Stats:\n";
+  llvm::errs() << "  " << NumHits << "/" << (NumHits + NumMisses)
+               << " lookups hit the cache\n";
+  llvm::errs() << "  " << NumInsertions << " calls cached, "
+               << Entries.size() << " currently in the cache (limit "
+               << MaxEntries << ")\n";
+  llvm::errs() << "  " << NumFlushes << " cache flushes\n";
+}
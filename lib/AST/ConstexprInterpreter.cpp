@@ -0,0 +1,1075 @@
+//===--- ConstexprInterpreter.cpp - Bytecode constexpr evaluation ---------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the ConstexprInterpreter class, which compiles the
+// bodies of constexpr functions to a stack-based bytecode and interprets it.
+//
+// Integer values are held in 64 bits, sign-extended from the width of their
+// type if the type is signed and zero-extended otherwise. Every operation
+// carries the width and signedness of the type it operates on.
+//
+//===----------------------------------------------------------------------===//
+
+#include "ConstexprInterpreter.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/DeclCXX.h"
+#include "clang/AST/Expr.h"
+#include "clang/AST/ExprCXX.h"
+#include "clang/AST/Stmt.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <vector>
+
+using namespace clang;
+
+namespace {
+enum Opcode : unsigned char {
+  /// Consume an evaluation step.
+  OP_Step,
+  /// Push the constant Operand.
+  OP_Const,
+  /// Push the value of local variable Operand.
+  OP_Load,
+  /// Pop a value and store it to local variable Operand.
+  OP_Store,
+  /// Pop a value and discard it.
+  OP_Pop,
+  /// Convert the value on top of the stack to the given type.
+  OP_Cast,
+  OP_ToBool,
+  OP_LNot,
+  OP_Not,
+  OP_Neg,
+  // Binary operations pop the right-hand side, then the left-hand side, and
+  // push the result.
+  OP_Add,
+  OP_Sub,
+  OP_Mul,
+  OP_Div,
+  OP_Rem,
+  OP_Shl,
+  OP_Shr,
+  OP_And,
+  OP_Or,
+  OP_Xor,
+  OP_LT,
+  OP_GT,
+  OP_LE,
+  OP_GE,
+  OP_EQ,
+  OP_NE,
+  /// Continue at instruction Operand.
+  OP_Jump,
+  /// Pop a value and continue at instruction Operand if it is zero.
+  OP_JumpIfFalse,
+  /// Pop a value and continue at instruction Operand if it is nonzero.
+  OP_JumpIfTrue,
+  /// Pop the arguments, call the FunctionDecl Operand, and push its result.
+  OP_Call,
+  /// Pop a value and return it.
+  OP_Ret,
+  /// Give up on the call; the tree-walking evaluator will diagnose it.
+  OP_Fail
+};
+
+enum OperationFlags {
+  /// The operation is performed on a signed type.
+  OF_Signed = 1,
+  /// Signed overflow makes the expression non-constant.
+  OF_Checked = 2,
+  /// The right-hand side of a shift is of a signed type.
+  OF_RHSSigned = 4
+};
+
+struct Instruction {
+  Opcode Op;
+  /// The width of the type the operation is performed on.
+  unsigned char Width;
+  unsigned char Flags;
+  uint64_t Operand;
+};
+} // end anonymous namespace
+
+class ConstexprInterpreter::Function {
+public:
+  std::vector<Instruction> Code;
+
+  /// The parameters occupy the first NumParams local variables.
+  unsigned NumParams;
+  unsigned NumLocals;
+
+  unsigned ResultWidth;
+  bool ResultSigned;
+
+  /// Set when the function turns out to call a function which can't be
+  /// compiled, in which case there's no point in interpreting it.
+  bool CallsUncompilable;
+
+  Function()
+      : NumParams(0), NumLocals(0), ResultWidth(0), ResultSigned(false),
+        CallsUncompilable(false) {}
+};
+
+struct ConstexprInterpreter::State {
+  unsigned StepsLeft;
+  unsigned MaxDepth;
+  unsigned DepthLimit;
+};
+
+/// Determine the width and signedness of \p T, if it is an integer type the
+/// interpreter supports.
+static bool getIntegerType(const ASTContext &Ctx, QualType T, unsigned &Width,
+                           bool &Signed) {
+  if (T.isVolatileQualified() || !T->isIntegralOrEnumerationType())
+    return false;
+  Width = Ctx.getIntWidth(T);
+  Signed = T->isSignedIntegerOrEnumerationType();
+  return Width <= 64;
+}
+
+/// Truncate \p Value to \p Width bits and extend it back to 64 bits.
+static uint64_t canonicalize(uint64_t Value, unsigned Width, bool Signed) {
+  if (Width == 64)
+    return Value;
+  uint64_t Mask = (uint64_t(1) << Width) - 1;
+  Value &= Mask;
+  if (Signed && (Value >> (Width - 1)))
+    Value |= ~Mask;
+  return Value;
+}
+
+static uint64_t toCanonical(const llvm::APSInt &Value) {
+  return Value.isSigned() ? Value.getSExtValue() : Value.getZExtValue();
+}
+
+namespace {
+/// Compiles the body of a constexpr function to bytecode.
+class FunctionCompiler {
+  ASTContext &Ctx;
+  ConstexprInterpreter::Function &F;
+
+  /// The local variable holding each parameter and variable in scope.
+  llvm::DenseMap<const VarDecl *, unsigned> Locals;
+
+  /// The jumps out of the innermost enclosing loop.
+  struct LoopJumps {
+    SmallVector<unsigned, 4> Breaks;
+    SmallVector<unsigned, 4> Continues;
+  };
+  LoopJumps *CurLoop;
+
+  unsigned emit(Opcode Op, uint64_t Operand = 0, unsigned Width = 0,
+                unsigned Flags = 0) {
+    Instruction I = { Op, static_cast<unsigned char>(Width),
+                      static_cast<unsigned char>(Flags), Operand };
+    F.Code.push_back(I);
+    return F.Code.size() - 1;
+  }
+  unsigned here() const { return F.Code.size(); }
+  void patch(unsigned Jump, unsigned Target) { F.Code[Jump].Operand = Target; }
+  void patchAll(ArrayRef<unsigned> Jumps, unsigned Target) {
+    for (unsigned Jump : Jumps)
+      patch(Jump, Target);
+  }
+
+  bool compileStmt(const Stmt *S);
+  bool compileLoopBody(const Stmt *Body, LoopJumps &Jumps);
+  bool compileDecl(const Decl *D);
+  bool compileCondition(const Expr *E);
+  bool compileExpr(const Expr *E);
+  bool compileDiscarded(const Expr *E);
+  bool compileCast(const CastExpr *E, unsigned Width, bool Signed);
+  bool compileLoad(const Expr *E);
+  bool compileGlobalLoad(const VarDecl *VD);
+  bool compileLValue(const Expr *E, unsigned &Slot);
+  bool compileAssignment(const BinaryOperator *E, unsigned &Slot);
+  bool compileIncDec(const UnaryOperator *E, bool PushOldValue,
+                     unsigned &Slot);
+  bool compileCall(const CallExpr *E);
+  bool emitBinaryOp(BinaryOperatorKind Opc, QualType LHSType,
+                    QualType RHSType);
+
+public:
+  FunctionCompiler(ASTContext &Ctx, ConstexprInterpreter::Function &F)
+      : Ctx(Ctx), F(F), CurLoop(nullptr) {}
+
+  bool compile(const FunctionDecl *FD);
+};
+} // end anonymous namespace
+
+bool FunctionCompiler::compile(const FunctionDecl *FD) {
+  if (FD->isInvalidDecl() || FD->isVariadic())
+    return false;
+  if (const CXXMethodDecl *MD = dyn_cast<CXXMethodDecl>(FD))
+    if (!MD->isStatic() || MD->getParent()->isLambda())
+      return false;
+
+  unsigned Width;
+  bool Signed;
+  if (!getIntegerType(Ctx, FD->getReturnType(), Width, Signed))
+    return false;
+  F.ResultWidth = Width;
+  F.ResultSigned = Signed;
+
+  for (const ParmVarDecl *PVD : FD->params()) {
+    if (!getIntegerType(Ctx, PVD->getType(), Width, Signed))
+      return false;
+    Locals[PVD] = F.NumLocals++;
+  }
+  F.NumParams = F.NumLocals;
+
+  const Stmt *Body = FD->getBody();
+  if (!Body || !compileStmt(Body))
+    return false;
+
+  // Flowing off the end of a function with a non-void return type.
+  emit(OP_Fail);
+  return true;
+}
+
+// The statements consume evaluation steps exactly where the tree-walking
+// evaluator does: once each time a statement is executed.
+bool FunctionCompiler::compileStmt(const Stmt *S) {
+  emit(OP_Step);
+
+  switch (S->getStmtClass()) {
+  default:
+    if (const Expr *E = dyn_cast<Expr>(S))
+      return compileDiscarded(E);
+    return false;
+
+  case Stmt::NullStmtClass:
+    return true;
+
+  case Stmt::CompoundStmtClass:
+    for (const auto *Sub : cast<CompoundStmt>(S)->body())
+      if (!compileStmt(Sub))
+        return false;
+    return true;
+
+  case Stmt::DeclStmtClass:
+    for (const auto *D : cast<DeclStmt>(S)->decls())
+      if (!compileDecl(D))
+        return false;
+    return true;
+
+  case Stmt::ReturnStmtClass: {
+    const Expr *RetExpr = cast<ReturnStmt>(S)->getRetValue();
+    if (!RetExpr || !compileExpr(RetExpr))
+      return false;
+    emit(OP_Ret);
+    return true;
+  }
+
+  case Stmt::IfStmtClass: {
+    const IfStmt *IS = cast<IfStmt>(S);
+    if (IS->getConditionVariable() || !compileCondition(IS->getCond()))
+      return false;
+    unsigned ToElse = emit(OP_JumpIfFalse);
+    if (!compileStmt(IS->getThen()))
+      return false;
+    if (const Stmt *Else = IS->getElse()) {
+      unsigned ToEnd = emit(OP_Jump);
+      patch(ToElse, here());
+      if (!compileStmt(Else))
+        return false;
+      patch(ToEnd, here());
+    } else {
+      patch(ToElse, here());
+    }
+    return true;
+  }
+
+  case Stmt::WhileStmtClass: {
+    const WhileStmt *WS = cast<WhileStmt>(S);
+    if (WS->getConditionVariable())
+      return false;
+    unsigned Start = here();
+    if (!compileCondition(WS->getCond()))
+      return false;
+    unsigned ToEnd = emit(OP_JumpIfFalse);
+    LoopJumps Jumps;
+    if (!compileLoopBody(WS->getBody(), Jumps))
+      return false;
+    emit(OP_Jump, Start);
+    patch(ToEnd, here());
+    patchAll(Jumps.Breaks, here());
+    patchAll(Jumps.Continues, Start);
+    return true;
+  }
+
+  case Stmt::DoStmtClass: {
+    const DoStmt *DS = cast<DoStmt>(S);
+    unsigned Start = here();
+    LoopJumps Jumps;
+    if (!compileLoopBody(DS->getBody(), Jumps))
+      return false;
+    patchAll(Jumps.Continues, here());
+    if (!compileCondition(DS->getCond()))
+      return false;
+    emit(OP_JumpIfTrue, Start);
+    patchAll(Jumps.Breaks, here());
+    return true;
+  }
+
+  case Stmt::ForStmtClass: {
+    const ForStmt *FS = cast<ForStmt>(S);
+    if (FS->getConditionVariable())
+      return false;
+    if (FS->getInit() && !compileStmt(FS->getInit()))
+      return false;
+    unsigned Start = here();
+    unsigned ToEnd = 0;
+    if (const Expr *Cond = FS->getCond()) {
+      if (!compileCondition(Cond))
+        return false;
+      ToEnd = emit(OP_JumpIfFalse);
+    }
+    LoopJumps Jumps;
+    if (!compileLoopBody(FS->getBody(), Jumps))
+      return false;
+    patchAll(Jumps.Continues, here());
+    if (FS->getInc() && !compileDiscarded(FS->getInc()))
+      return false;
+    emit(OP_Jump, Start);
+    if (FS->getCond())
+      patch(ToEnd, here());
+    patchAll(Jumps.Breaks, here());
+    return true;
+  }
+
+  case Stmt::BreakStmtClass:
+    if (!CurLoop)
+      return false;
+    CurLoop->Breaks.push_back(emit(OP_Jump));
+    return true;
+
+  case Stmt::ContinueStmtClass:
+    if (!CurLoop)
+      return false;
+    CurLoop->Continues.push_back(emit(OP_Jump));
+    return true;
+  }
+}
+
+bool FunctionCompiler::compileLoopBody(const Stmt *Body, LoopJumps &Jumps) {
+  LoopJumps *OldLoop = CurLoop;
+  CurLoop = &Jumps;
+  bool Success = compileStmt(Body);
+  CurLoop = OldLoop;
+  return Success;
+}
+
+bool FunctionCompiler::compileDecl(const Decl *D) {
+  // Other declarations have no effect on the evaluation.
+  const VarDecl *VD = dyn_cast<VarDecl>(D);
+  if (!VD)
+    return true;
+
+  unsigned Width;
+  bool Signed;
+  if (!VD->hasLocalStorage() ||
+      !getIntegerType(Ctx, VD->getType(), Width, Signed))
+    return false;
+
+  // The variable is not in scope until after its initializer.
+  const Expr *Init = VD->getInit();
+  if (!Init || !compileExpr(Init))
+    return false;
+  unsigned Slot = F.NumLocals++;
+  Locals[VD] = Slot;
+  emit(OP_Store, Slot);
+  return true;
+}
+
+bool FunctionCompiler::compileCondition(const Expr *E) {
+  return E->getType()->isBooleanType() && compileExpr(E);
+}
+
+/// Compile an expression whose value is discarded.
+bool FunctionCompiler::compileDiscarded(const Expr *E) {
+  E = E->IgnoreParens();
+  unsigned Slot;
+
+  if (const BinaryOperator *BO = dyn_cast<BinaryOperator>(E)) {
+    if (BO->isAssignmentOp())
+      return compileAssignment(BO, Slot);
+    if (BO->getOpcode() == BO_Comma)
+      return compileDiscarded(BO->getLHS()) && compileDiscarded(BO->getRHS());
+  }
+
+  if (const UnaryOperator *UO = dyn_cast<UnaryOperator>(E))
+    if (UO->isIncrementDecrementOp())
+      return compileIncDec(UO, /*PushOldValue=*/false, Slot);
+
+  if (const CastExpr *CE = dyn_cast<CastExpr>(E))
+    if (CE->getCastKind() == CK_ToVoid)
+      return compileDiscarded(CE->getSubExpr());
+
+  if (!compileExpr(E))
+    return false;
+  emit(OP_Pop);
+  return true;
+}
+
+/// Compile an integer prvalue, pushing its value.
+bool FunctionCompiler::compileExpr(const Expr *E) {
+  unsigned Width;
+  bool Signed;
+  if (E->isValueDependent() || !E->isRValue() ||
+      !getIntegerType(Ctx, E->getType(), Width, Signed))
+    return false;
+  unsigned Flags = Signed ? OF_Signed : 0;
+
+  if (const IntegerLiteral *IL = dyn_cast<IntegerLiteral>(E)) {
+    emit(OP_Const, canonicalize(IL->getValue().getZExtValue(), Width, Signed));
+    return true;
+  }
+  if (const CharacterLiteral *CL = dyn_cast<CharacterLiteral>(E)) {
+    emit(OP_Const, canonicalize(CL->getValue(), Width, Signed));
+    return true;
+  }
+  if (const CXXBoolLiteralExpr *BL = dyn_cast<CXXBoolLiteralExpr>(E)) {
+    emit(OP_Const, BL->getValue());
+    return true;
+  }
+  if (const DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(E)) {
+    const EnumConstantDecl *ECD = dyn_cast<EnumConstantDecl>(DRE->getDecl());
+    if (!ECD)
+      return false;
+    emit(OP_Const, canonicalize(toCanonical(ECD->getInitVal()), Width, Signed));
+    return true;
+  }
+  if (const UnaryExprOrTypeTraitExpr *UE =
+          dyn_cast<UnaryExprOrTypeTraitExpr>(E)) {
+    llvm::APSInt Value;
+    if (!UE->EvaluateAsInt(Value, Ctx))
+      return false;
+    emit(OP_Const, canonicalize(toCanonical(Value), Width, Signed));
+    return true;
+  }
+
+  if (const ParenExpr *PE = dyn_cast<ParenExpr>(E))
+    return compileExpr(PE->getSubExpr());
+  if (const CXXDefaultArgExpr *DAE = dyn_cast<CXXDefaultArgExpr>(E))
+    return compileExpr(DAE->getExpr());
+  if (const SubstNonTypeTemplateParmExpr *SE =
+          dyn_cast<SubstNonTypeTemplateParmExpr>(E))
+    return compileExpr(SE->getReplacement());
+  if (const InitListExpr *ILE = dyn_cast<InitListExpr>(E)) {
+    if (ILE->getNumInits() > 1)
+      return false;
+    if (ILE->getNumInits() == 1)
+      return compileExpr(ILE->getInit(0));
+    emit(OP_Const, 0);
+    return true;
+  }
+  if (const CastExpr *CE = dyn_cast<CastExpr>(E))
+    return compileCast(CE, Width, Signed);
+  if (const CallExpr *CE = dyn_cast<CallExpr>(E))
+    return compileCall(CE);
+
+  if (const UnaryOperator *UO = dyn_cast<UnaryOperator>(E)) {
+    unsigned Slot;
+    switch (UO->getOpcode()) {
+    case UO_PostInc:
+    case UO_PostDec:
+      return compileIncDec(UO, /*PushOldValue=*/true, Slot);
+    case UO_Plus:
+    case UO_Extension:
+      return compileExpr(UO->getSubExpr());
+    case UO_Minus:
+      if (!compileExpr(UO->getSubExpr()))
+        return false;
+      emit(OP_Neg, 0, Width, Signed ? OF_Signed | OF_Checked : 0);
+      return true;
+    case UO_Not:
+      if (!compileExpr(UO->getSubExpr()))
+        return false;
+      emit(OP_Not, 0, Width, Flags);
+      return true;
+    case UO_LNot:
+      if (!compileCondition(UO->getSubExpr()))
+        return false;
+      emit(OP_LNot);
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  if (const BinaryOperator *BO = dyn_cast<BinaryOperator>(E)) {
+    switch (BO->getOpcode()) {
+    case BO_Comma:
+      return compileDiscarded(BO->getLHS()) && compileExpr(BO->getRHS());
+
+    case BO_LAnd:
+    case BO_LOr: {
+      bool IsAnd = BO->getOpcode() == BO_LAnd;
+      if (!compileCondition(BO->getLHS()))
+        return false;
+      unsigned ToShortCircuit = emit(IsAnd ? OP_JumpIfFalse : OP_JumpIfTrue);
+      if (!compileCondition(BO->getRHS()))
+        return false;
+      unsigned ToEnd = emit(OP_Jump);
+      patch(ToShortCircuit, here());
+      emit(OP_Const, IsAnd ? 0 : 1);
+      patch(ToEnd, here());
+      return true;
+    }
+
+    default:
+      if (BO->isAssignmentOp() || BO->isPtrMemOp())
+        return false;
+      return compileExpr(BO->getLHS()) && compileExpr(BO->getRHS()) &&
+             emitBinaryOp(BO->getOpcode(), BO->getLHS()->getType(),
+                          BO->getRHS()->getType());
+    }
+  }
+
+  if (const ConditionalOperator *CO = dyn_cast<ConditionalOperator>(E)) {
+    if (!compileCondition(CO->getCond()))
+      return false;
+    unsigned ToFalse = emit(OP_JumpIfFalse);
+    if (!compileExpr(CO->getTrueExpr()))
+      return false;
+    unsigned ToEnd = emit(OP_Jump);
+    patch(ToFalse, here());
+    if (!compileExpr(CO->getFalseExpr()))
+      return false;
+    patch(ToEnd, here());
+    return true;
+  }
+
+  return false;
+}
+
+bool FunctionCompiler::compileCast(const CastExpr *E, unsigned Width,
+                                   bool Signed) {
+  const Expr *Sub = E->getSubExpr();
+  switch (E->getCastKind()) {
+  case CK_LValueToRValue:
+    return compileLoad(Sub);
+
+  case CK_NoOp:
+    return compileExpr(Sub);
+
+  case CK_IntegralCast:
+    if (!compileExpr(Sub))
+      return false;
+    emit(OP_Cast, 0, Width, Signed ? OF_Signed : 0);
+    return true;
+
+  case CK_IntegralToBoolean:
+    if (!compileExpr(Sub))
+      return false;
+    emit(OP_ToBool);
+    return true;
+
+  default:
+    return false;
+  }
+}
+
+/// Compile an lvalue-to-rvalue conversion of \p E.
+bool FunctionCompiler::compileLoad(const Expr *E) {
+  if (E->getType().isVolatileQualified())
+    return false;
+
+  if (const DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(E->IgnoreParens()))
+    if (const VarDecl *VD = dyn_cast<VarDecl>(DRE->getDecl()))
+      if (!VD->hasLocalStorage())
+        return compileGlobalLoad(VD);
+
+  unsigned Slot;
+  if (!compileLValue(E, Slot))
+    return false;
+  emit(OP_Load, Slot);
+  return true;
+}
+
+/// Compile a read of a constant variable by folding it to its value. The
+/// conditions under which this is allowed mirror those of the tree-walking
+/// evaluator; in all other cases we let it produce the diagnostic.
+bool FunctionCompiler::compileGlobalLoad(const VarDecl *VD) {
+  if (const VarDecl *Def = VD->getDefinition(Ctx))
+    VD = Def;
+  if (VD->isInvalidDecl() || VD->isWeak() ||
+      VD->getType().isVolatileQualified())
+    return false;
+  if (!VD->isConstexpr() && !VD->getType().isConstQualified())
+    return false;
+
+  const VarDecl *InitDecl = VD;
+  const Expr *Init = VD->getAnyInitializer(InitDecl);
+  if (!Init || Init->isValueDependent())
+    return false;
+
+  const APValue *Value = InitDecl->evaluateValue();
+  if (!Value || !Value->isInt() || !InitDecl->checkInitIsICE())
+    return false;
+  emit(OP_Const, toCanonical(Value->getInt()));
+  return true;
+}
+
+/// Compile an lvalue referring to a local variable, emitting its side-effects
+/// and setting \p Slot to the variable.
+bool FunctionCompiler::compileLValue(const Expr *E, unsigned &Slot) {
+  E = E->IgnoreParens();
+
+  if (const DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(E)) {
+    const VarDecl *VD = dyn_cast<VarDecl>(DRE->getDecl());
+    llvm::DenseMap<const VarDecl *, unsigned>::iterator Known =
+        VD ? Locals.find(VD) : Locals.end();
+    if (Known == Locals.end())
+      return false;
+    Slot = Known->second;
+    return true;
+  }
+
+  if (const BinaryOperator *BO = dyn_cast<BinaryOperator>(E))
+    if (BO->isAssignmentOp())
+      return compileAssignment(BO, Slot);
+
+  if (const UnaryOperator *UO = dyn_cast<UnaryOperator>(E))
+    if (UO->isPrefix() && UO->isIncrementDecrementOp())
+      return compileIncDec(UO, /*PushOldValue=*/false, Slot);
+
+  return false;
+}
+
+/// Determine whether a local variable of type \p T may be modified.
+static bool isModifiable(const ASTContext &Ctx, QualType T) {
+  // Modifying objects within a constant expression is new in C++14.
+  return Ctx.getLangOpts().CPlusPlus14 && !T.isConstQualified() &&
+         T->isIntegerType();
+}
+
+bool FunctionCompiler::compileAssignment(const BinaryOperator *E,
+                                         unsigned &Slot) {
+  QualType LHSType = E->getLHS()->getType();
+  unsigned Width;
+  bool Signed;
+  if (!isModifiable(Ctx, LHSType) ||
+      !getIntegerType(Ctx, LHSType, Width, Signed) ||
+      !compileLValue(E->getLHS(), Slot))
+    return false;
+
+  if (E->getOpcode() == BO_Assign) {
+    if (!compileExpr(E->getRHS()))
+      return false;
+    emit(OP_Store, Slot);
+    return true;
+  }
+
+  // The tree-walking evaluator reads the left-hand side after evaluating the
+  // right-hand side; so do we.
+  const CompoundAssignOperator *CAO = cast<CompoundAssignOperator>(E);
+  unsigned ComputationWidth;
+  bool ComputationSigned;
+  if (!getIntegerType(Ctx, CAO->getComputationLHSType(), ComputationWidth,
+                      ComputationSigned) ||
+      !compileExpr(CAO->getRHS()))
+    return false;
+  unsigned RHSSlot = F.NumLocals++;
+  emit(OP_Store, RHSSlot);
+  emit(OP_Load, Slot);
+  emit(OP_Cast, 0, ComputationWidth, ComputationSigned ? OF_Signed : 0);
+  emit(OP_Load, RHSSlot);
+  if (!emitBinaryOp(
+          BinaryOperator::getOpForCompoundAssignment(CAO->getOpcode()),
+          CAO->getComputationLHSType(), CAO->getRHS()->getType()))
+    return false;
+  emit(OP_Cast, 0, Width, Signed ? OF_Signed : 0);
+  emit(OP_Store, Slot);
+  return true;
+}
+
+bool FunctionCompiler::compileIncDec(const UnaryOperator *E, bool PushOldValue,
+                                     unsigned &Slot) {
+  QualType Type = E->getSubExpr()->getType();
+  unsigned Width;
+  bool Signed;
+  if (!isModifiable(Ctx, Type) || Type->isBooleanType() ||
+      !getIntegerType(Ctx, Type, Width, Signed) ||
+      !compileLValue(E->getSubExpr(), Slot))
+    return false;
+
+  // Increments and decrements of types narrower than int wrap around.
+  unsigned Flags = 0;
+  if (Signed) {
+    Flags |= OF_Signed;
+    if (Width >= Ctx.getIntWidth(Ctx.IntTy))
+      Flags |= OF_Checked;
+  }
+
+  emit(OP_Load, Slot);
+  if (PushOldValue)
+    emit(OP_Load, Slot);
+  emit(OP_Const, 1);
+  emit(E->isIncrementOp() ? OP_Add : OP_Sub, 0, Width, Flags);
+  emit(OP_Store, Slot);
+  return true;
+}
+
+bool FunctionCompiler::compileCall(const CallExpr *E) {
+  // Only plain calls to named functions; member calls and overloaded
+  // operators have their own expression classes.
+  if (E->getStmtClass() != Stmt::CallExprClass ||
+      !isa<DeclRefExpr>(E->getCallee()->IgnoreParenImpCasts()))
+    return false;
+  const FunctionDecl *FD = E->getDirectCallee();
+  if (!FD || FD->getBuiltinID() || FD->isVariadic() ||
+      E->getNumArgs() != FD->getNumParams())
+    return false;
+
+  for (const Expr *Arg : E->arguments())
+    if (!compileExpr(Arg))
+      return false;
+  emit(OP_Call, reinterpret_cast<uintptr_t>(FD));
+  return true;
+}
+
+bool FunctionCompiler::emitBinaryOp(BinaryOperatorKind Opc, QualType LHSType,
+                                    QualType RHSType) {
+  unsigned Width, RHSWidth;
+  bool Signed, RHSSigned;
+  if (!getIntegerType(Ctx, LHSType, Width, Signed) ||
+      !getIntegerType(Ctx, RHSType, RHSWidth, RHSSigned))
+    return false;
+  unsigned Flags = Signed ? OF_Signed : 0;
+
+  Opcode Op;
+  switch (Opc) {
+  case BO_Shl:
+  case BO_Shr:
+    emit(Opc == BO_Shl ? OP_Shl : OP_Shr, 0, Width,
+         Flags | (RHSSigned ? OF_RHSSigned : 0));
+    return true;
+
+  case BO_Mul: Op = OP_Mul; Flags |= Signed ? OF_Checked : 0; break;
+  case BO_Add: Op = OP_Add; Flags |= Signed ? OF_Checked : 0; break;
+  case BO_Sub: Op = OP_Sub; Flags |= Signed ? OF_Checked : 0; break;
+  case BO_Div: Op = OP_Div; break;
+  case BO_Rem: Op = OP_Rem; break;
+  case BO_And: Op = OP_And; break;
+  case BO_Or:  Op = OP_Or;  break;
+  case BO_Xor: Op = OP_Xor; break;
+  case BO_LT:  Op = OP_LT;  break;
+  case BO_GT:  Op = OP_GT;  break;
+  case BO_LE:  Op = OP_LE;  break;
+  case BO_GE:  Op = OP_GE;  break;
+  case BO_EQ:  Op = OP_EQ;  break;
+  case BO_NE:  Op = OP_NE;  break;
+  default:
+    return false;
+  }
+
+  // Apart from shifts, both operands have been converted to a common type.
+  if (Width != RHSWidth || Signed != RHSSigned)
+    return false;
+  emit(Op, 0, Width, Flags);
+  return true;
+}
+
+/// Apply the binary operation \p I to \p LHS and \p RHS, storing the result
+/// in \p LHS. Returns false if the tree-walking evaluator would have produced
+/// a diagnostic.
+static bool evaluateBinaryOp(const Instruction &I, uint64_t &LHS,
+                             uint64_t RHS) {
+  unsigned Width = I.Width;
+  bool Signed = I.Flags & OF_Signed;
+  bool Checked = I.Flags & OF_Checked;
+  int64_t SignedLHS = LHS, SignedRHS = RHS;
+  uint64_t MinSigned = canonicalize(uint64_t(1) << (Width - 1), Width, true);
+
+  switch (I.Op) {
+  case OP_Add:
+  case OP_Sub: {
+    bool IsAdd = I.Op == OP_Add;
+    if (!Checked) {
+      LHS = canonicalize(IsAdd ? LHS + RHS : LHS - RHS, Width, Signed);
+      return true;
+    }
+    if (Width < 64) {
+      // Neither of these can overflow 64 bits.
+      int64_t Result = IsAdd ? SignedLHS + SignedRHS : SignedLHS - SignedRHS;
+      if (canonicalize(Result, Width, true) != uint64_t(Result))
+        return false;
+      LHS = Result;
+      return true;
+    }
+    uint64_t Result = IsAdd ? LHS + RHS : LHS - RHS;
+    bool Overflow = IsAdd ? ((LHS ^ Result) & (RHS ^ Result)) >> 63
+                          : ((LHS ^ RHS) & (LHS ^ Result)) >> 63;
+    if (Overflow)
+      return false;
+    LHS = Result;
+    return true;
+  }
+
+  case OP_Mul:
+    if (!Checked) {
+      LHS = canonicalize(LHS * RHS, Width, Signed);
+      return true;
+    }
+    if (Width <= 32) {
+      int64_t Result = SignedLHS * SignedRHS;
+      if (canonicalize(Result, Width, true) != uint64_t(Result))
+        return false;
+      LHS = Result;
+    } else {
+      bool Overflow;
+      llvm::APInt Result = llvm::APInt(Width, LHS, true)
+                               .smul_ov(llvm::APInt(Width, RHS, true),
+                                        Overflow);
+      if (Overflow)
+        return false;
+      LHS = Result.getSExtValue();
+    }
+    return true;
+
+  case OP_Div:
+  case OP_Rem:
+    if (!RHS)
+      return false;
+    if (Signed) {
+      if (SignedRHS == -1 && LHS == MinSigned)
+        return false;
+      LHS = I.Op == OP_Div ? SignedLHS / SignedRHS : SignedLHS % SignedRHS;
+    } else {
+      LHS = I.Op == OP_Div ? LHS / RHS : LHS % RHS;
+    }
+    return true;
+
+  case OP_Shl:
+  case OP_Shr: {
+    if (((I.Flags & OF_RHSSigned) && SignedRHS < 0) || RHS >= Width)
+      return false;
+    unsigned Amount = RHS;
+    if (I.Op == OP_Shl) {
+      // A signed left shift must not shift a bit out of the corresponding
+      // unsigned type.
+      if (Signed && (SignedLHS < 0 || (Amount && (LHS >> (Width - Amount)))))
+        return false;
+      LHS = canonicalize(LHS << Amount, Width, Signed);
+    } else if (Signed && SignedLHS < 0) {
+      LHS = ~(~LHS >> Amount);
+    } else {
+      LHS >>= Amount;
+    }
+    return true;
+  }
+
+  case OP_And: LHS &= RHS; return true;
+  case OP_Or:  LHS |= RHS; return true;
+  case OP_Xor: LHS ^= RHS; return true;
+
+  case OP_LT:
+    LHS = Signed ? SignedLHS < SignedRHS : LHS < RHS;
+    return true;
+  case OP_GT:
+    LHS = Signed ? SignedLHS > SignedRHS : LHS > RHS;
+    return true;
+  case OP_LE:
+    LHS = Signed ? SignedLHS <= SignedRHS : LHS <= RHS;
+    return true;
+  case OP_GE:
+    LHS = Signed ? SignedLHS >= SignedRHS : LHS >= RHS;
+    return true;
+  case OP_EQ: LHS = LHS == RHS; return true;
+  case OP_NE: LHS = LHS != RHS; return true;
+
+  default:
+    llvm_unreachable("not a binary operation");
+  }
+}
+
+ConstexprInterpreter::ConstexprInterpreter(ASTContext &Ctx)
+    : Ctx(Ctx), NumFunctionsCompiled(0), NumFunctionsRejected(0),
+      NumCallsInterpreted(0), NumCallsAbandoned(0) {}
+
+ConstexprInterpreter::~ConstexprInterpreter() {
+  llvm::DeleteContainerSeconds(Functions);
+}
+
+ConstexprInterpreter::Function *
+ConstexprInterpreter::getFunction(const FunctionDecl *FD) {
+  llvm::DenseMap<const FunctionDecl *, Function *>::iterator Known =
+      Functions.find(FD);
+  if (Known != Functions.end())
+    return Known->second;
+
+  // Compiling a function may require evaluating the initializer of a
+  // variable it reads, which may in turn call the function. Treat the
+  // function as uncompilable in the meantime.
+  Functions[FD] = nullptr;
+
+  Function *F = new Function;
+  if (FunctionCompiler(Ctx, *F).compile(FD)) {
+    ++NumFunctionsCompiled;
+  } else {
+    ++NumFunctionsRejected;
+    delete F;
+    F = nullptr;
+  }
+  Functions[FD] = F;
+  return F;
+}
+
+bool ConstexprInterpreter::run(Function &F, const uint64_t *Args,
+                               unsigned Depth, State &S, uint64_t &Result) {
+  SmallVector<uint64_t, 16> Locals(F.NumLocals);
+  std::copy(Args, Args + F.NumParams, Locals.begin());
+  SmallVector<uint64_t, 16> Stack;
+
+  const Instruction *Code = F.Code.data();
+  for (unsigned PC = 0;;) {
+    const Instruction &I = Code[PC++];
+    switch (I.Op) {
+    case OP_Step:
+      if (!S.StepsLeft)
+        return false;
+      --S.StepsLeft;
+      break;
+
+    case OP_Const:
+      Stack.push_back(I.Operand);
+      break;
+    case OP_Load:
+      Stack.push_back(Locals[I.Operand]);
+      break;
+    case OP_Store:
+      Locals[I.Operand] = Stack.pop_back_val();
+      break;
+    case OP_Pop:
+      Stack.pop_back();
+      break;
+
+    case OP_Cast:
+      Stack.back() = canonicalize(Stack.back(), I.Width, I.Flags & OF_Signed);
+      break;
+    case OP_ToBool:
+      Stack.back() = Stack.back() != 0;
+      break;
+    case OP_LNot:
+      Stack.back() = Stack.back() == 0;
+      break;
+    case OP_Not:
+      Stack.back() = canonicalize(~Stack.back(), I.Width, I.Flags & OF_Signed);
+      break;
+    case OP_Neg:
+      if ((I.Flags & OF_Checked) &&
+          Stack.back() == canonicalize(uint64_t(1) << (I.Width - 1), I.Width,
+                                       true))
+        return false;
+      Stack.back() =
+          canonicalize(0 - Stack.back(), I.Width, I.Flags & OF_Signed);
+      break;
+
+    case OP_Jump:
+      PC = I.Operand;
+      break;
+    case OP_JumpIfFalse:
+      if (!Stack.pop_back_val())
+        PC = I.Operand;
+      break;
+    case OP_JumpIfTrue:
+      if (Stack.pop_back_val())
+        PC = I.Operand;
+      break;
+
+    case OP_Call: {
+      const FunctionDecl *Callee =
+          reinterpret_cast<const FunctionDecl *>(I.Operand);
+      const FunctionDecl *Definition = nullptr;
+      Callee->getBody(Definition);
+      if (Callee->isInvalidDecl() || !Definition ||
+          !Definition->isConstexpr() || Definition->isInvalidDecl())
+        return false;
+      if (Depth > S.DepthLimit)
+        return false;
+      S.MaxDepth = std::max(S.MaxDepth, Depth);
+
+      Function *G = getFunction(Definition);
+      if (!G) {
+        F.CallsUncompilable = true;
+        return false;
+      }
+      uint64_t CallResult;
+      if (!run(*G, Stack.end() - G->NumParams, Depth + 1, S, CallResult))
+        return false;
+      Stack.resize(Stack.size() - G->NumParams);
+      Stack.push_back(CallResult);
+      break;
+    }
+
+    case OP_Ret:
+      Result = Stack.pop_back_val();
+      return true;
+
+    case OP_Fail:
+      return false;
+
+    default: {
+      uint64_t RHS = Stack.pop_back_val();
+      if (!evaluateBinaryOp(I, Stack.back(), RHS))
+        return false;
+      break;
+    }
+    }
+  }
+}
+
+bool ConstexprInterpreter::evaluateCall(const FunctionDecl *Callee,
+                                        ArrayRef<APValue> Args,
+                                        unsigned Depth, unsigned &StepsLeft,
+                                        unsigned &MaxDepth, APValue &Result,
+                                        bool &Abandoned) {
+  Abandoned = false;
+  Function *F = getFunction(Callee);
+  if (!F || F->CallsUncompilable || Args.size() != F->NumParams)
+    return false;
+
+  SmallVector<uint64_t, 8> ArgValues;
+  for (const APValue &Arg : Args) {
+    if (!Arg.isInt())
+      return false;
+    ArgValues.push_back(toCanonical(Arg.getInt()));
+  }
+
+  State S;
+  S.StepsLeft = StepsLeft;
+  S.MaxDepth = MaxDepth;
+  S.DepthLimit = Ctx.getLangOpts().ConstexprCallDepth;
+  uint64_t Value;
+  if (!run(*F, ArgValues.data(), Depth, S, Value)) {
+    ++NumCallsAbandoned;
+    Abandoned = true;
+    return false;
+  }
+  ++NumCallsInterpreted;
+
+  StepsLeft = S.StepsLeft;
+  MaxDepth = S.MaxDepth;
+  Result = APValue(
+      llvm::APSInt(llvm::APInt(F->ResultWidth, Value), !F->ResultSigned));
+  return true;
+}
+
+void ConstexprInterpreter::PrintStats() const {
+  llvm::errs() << "\n*** Constexpr Interpreter Stats:\n";
+  llvm::errs() << "  " << NumFunctionsCompiled
+               << " functions compiled to bytecode, " << NumFunctionsRejected
+               << " left to the evaluator\n";
+  llvm::errs() << "  " << NumCallsInterpreted << " calls interpreted, "
+               << NumCallsAbandoned << " abandoned\n";
+}
@@ -0,0 +1,99 @@
+//===--- ConstexprInterpreter.h - Bytecode constexpr evaluation -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This provides an alternative to the tree-walking constant evaluator for
+// calls to constexpr functions: the body of each function is compiled to a
+// compact bytecode the first time it is called, and the bytecode is then
+// interpreted on every call.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LIB_AST_CONSTEXPRINTERPRETER_H
+#define LLVM_CLANG_LIB_AST_CONSTEXPRINTERPRETER_H
+
+#include "clang/AST/APValue.h"
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/DenseMap.h"
+
+namespace clang {
+
+class ASTContext;
+class FunctionDecl;
+
+/// \brief Evaluates calls to constexpr functions by interpreting bytecode
+/// compiled from their bodies.
+///
+/// Only functions which compute with integers (including enumerations and
+/// bool) are handled: their parameters and return type must be integers, and
+/// their bodies may only declare and modify local integer variables, call
+/// other such functions, and use the usual statements of C++14 constexpr
+/// functions other than 'switch'. Anything else is left to the tree-walking
+/// evaluator.
+///
+/// The interpreter never diagnoses anything. Whenever the tree-walking
+/// evaluator would produce a note (on integer overflow, division by zero, an
+/// out-of-range shift, exceeding the call depth or step limit, ...), the
+/// interpreter gives up on the call instead, so that the call is evaluated
+/// again by the tree-walking evaluator, which produces the diagnostic. The
+/// interpreter consumes evaluation steps exactly as the tree-walking
+/// evaluator would, so the choice of evaluator never affects whether a
+/// program is accepted.
+class ConstexprInterpreter {
+public:
+  class Function;
+
+private:
+  ASTContext &Ctx;
+
+  /// \brief The compiled form of each function we tried to compile, or null
+  /// if it can't be compiled.
+  llvm::DenseMap<const FunctionDecl *, Function *> Functions;
+
+  // Statistics.
+  unsigned NumFunctionsCompiled, NumFunctionsRejected;
+  unsigned NumCallsInterpreted, NumCallsAbandoned;
+
+  struct State;
+
+  Function *getFunction(const FunctionDecl *FD);
+  bool run(Function &F, const uint64_t *Args, unsigned Depth, State &S,
+           uint64_t &Result);
+
+public:
+  explicit ConstexprInterpreter(ASTContext &Ctx);
+  ~ConstexprInterpreter();
+
+  /// \brief Evaluate a call to the definition \p Callee with the argument
+  /// values \p Args.
+  ///
+  /// \param Depth The depth of the callee's stack frame. The calls it makes
+  /// are checked against the call depth limit at this depth.
+  ///
+  /// \param StepsLeft The number of evaluation steps left; updated on
+  /// success.
+  ///
+  /// \param MaxDepth The largest depth at which a call has been made;
+  /// updated on success.
+  ///
+  /// \param Abandoned Set to true if the call was run but failed, e.g. on
+  /// reaching a limit or overflowing. The calls it makes then fail the same
+  /// way, so there is no point in interpreting them either.
+  ///
+  /// \returns true and sets \p Result on success, or false, having changed
+  /// nothing, if the call must be evaluated by the tree-walking evaluator.
+  bool evaluateCall(const FunctionDecl *Callee, ArrayRef<APValue> Args,
+                    unsigned Depth, unsigned &StepsLeft, unsigned &MaxDepth,
+                    APValue &Result, bool &Abandoned);
+
+  void PrintStats() const;
+};
+
+} // end namespace clang
+
+#endif
@@ -33,10 +33,12 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "ConstexprInterpreter.h"
 #include "clang/AST/APValue.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/ASTDiagnostic.h"
 #include "clang/AST/CharUnits.h"
+#include "clang/AST/ConstexprCallCache.h"
 #include "clang/AST/Expr.h"
 #include "clang/AST/RecordLayout.h"
 #include "clang/AST/StmtVisitor.h"
@@ -44,6 +46,7 @@
 #include "clang/Basic/Builtins.h"
 #include "clang/Basic/TargetInfo.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/Support/SaveAndRestore.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cstring>
 #include <functional>
@@ -426,6 +429,11 @@ namespace {
     /// CallStackDepth - The number of calls in the call stack right now.
     unsigned CallStackDepth;
 
+    /// MaxCallStackDepth - The largest call stack depth at which a call has
+    /// been made since this was last reset. Used to determine how deep a call
+    /// whose result is memoized went.
+    unsigned MaxCallStackDepth;
+
     /// NextCallIndex - The next call index to assign.
     unsigned NextCallIndex;
 
@@ -454,6 +462,11 @@ namespace {
     /// notes attached to it will also be stored, otherwise they will not be.
     bool HasActiveDiagnostic;
 
+    /// InAbandonedInterpretedCall - Are we evaluating the body of a call that
+    /// the bytecode interpreter ran and gave up on? The calls it makes would
+    /// fail in the interpreter too, so they are not handed to it again.
+    bool InAbandonedInterpretedCall;
+
     enum EvaluationMode {
       /// Evaluate as a constant expression. Stop if we find that the expression
       /// is not a constant expression.
@@ -509,12 +522,12 @@ namespace {
 
     EvalInfo(const ASTContext &C, Expr::EvalStatus &S, EvaluationMode Mode)
       : Ctx(const_cast<ASTContext &>(C)), EvalStatus(S), CurrentCall(nullptr),
-        CallStackDepth(0), NextCallIndex(1),
+        CallStackDepth(0), MaxCallStackDepth(0), NextCallIndex(1),
         StepsLeft(getLangOpts().ConstexprStepLimit),
         BottomFrame(*this, SourceLocation(), nullptr, nullptr, nullptr),
         EvaluatingDecl((const ValueDecl *)nullptr),
         EvaluatingDeclValue(nullptr), HasActiveDiagnostic(false),
-        EvalMode(Mode) {}
+        InAbandonedInterpretedCall(false), EvalMode(Mode) {}
 
     void setEvaluatingDecl(APValue::LValueBase Base, APValue &Value) {
       EvaluatingDecl = Base;
@@ -533,8 +546,10 @@ namespace {
         Diag(Loc, diag::note_constexpr_call_limit_exceeded);
         return false;
       }
-      if (CallStackDepth <= getLangOpts().ConstexprCallDepth)
+      if (CallStackDepth <= getLangOpts().ConstexprCallDepth) {
+        MaxCallStackDepth = std::max(MaxCallStackDepth, CallStackDepth);
         return true;
+      }
       Diag(Loc, diag::note_constexpr_depth_limit_exceeded)
         << getLangOpts().ConstexprCallDepth;
       return false;
@@ -3706,18 +3721,13 @@ static bool EvaluateArgs(ArrayRef<const Expr*> Args, ArgVector &ArgValues,
   return Success;
 }
 
-/// Evaluate a function call.
-static bool HandleFunctionCall(SourceLocation CallLoc,
+/// Evaluate the body of a function call, once its arguments have been
+/// evaluated.
+static bool HandleFunctionBody(SourceLocation CallLoc,
                                const FunctionDecl *Callee, const LValue *This,
-                               ArrayRef<const Expr*> Args, const Stmt *Body,
-                               EvalInfo &Info, APValue &Result) {
-  ArgVector ArgValues(Args.size());
-  if (!EvaluateArgs(Args, ArgValues, Info))
-    return false;
-
-  if (!Info.CheckCallLimit(CallLoc))
-    return false;
-
+                               ArrayRef<const Expr*> Args, ArgVector &ArgValues,
+                               const Stmt *Body, EvalInfo &Info,
+                               APValue &Result) {
   CallStackFrame Frame(Info, CallLoc, Callee, This, ArgValues.data());
 
   // For a trivial copy or move assignment, perform an APValue copy. This is
@@ -3745,6 +3755,21 @@ static bool HandleFunctionCall(SourceLocation CallLoc,
     return true;
   }
 
+  // Calls which only compute on integers can be run by the bytecode
+  // interpreter. If it gives up on the call, evaluate the body here instead;
+  // that produces whatever diagnostic made the interpreter give up.
+  bool Abandoned = false;
+  if (!This && !Info.checkingPotentialConstantExpression() &&
+      !Info.InAbandonedInterpretedCall)
+    if (ConstexprInterpreter *Interp = Info.Ctx.getConstexprInterpreter())
+      if (Interp->evaluateCall(Callee, ArgValues, Info.CallStackDepth,
+                               Info.StepsLeft, Info.MaxCallStackDepth, Result,
+                               Abandoned))
+        return true;
+
+  llvm::SaveAndRestore<bool> InAbandoned(Info.InAbandonedInterpretedCall,
+                                         Info.InAbandonedInterpretedCall ||
+                                             Abandoned);
   EvalStmtResult ESR = EvaluateStmt(Result, Info, Body);
   if (ESR == ESR_Succeeded) {
     if (Callee->getReturnType()->isVoidType())
@@ -3754,6 +3779,89 @@ static bool HandleFunctionCall(SourceLocation CallLoc,
   return ESR == ESR_Returned;
 }
 
+/// Get the table in which the result of a call with the given 'this' and
+/// arguments can be looked up, if there is one.
+static ConstexprCallCache *getCallCache(EvalInfo &Info, const LValue *This,
+                                        ArrayRef<APValue> ArgValues) {
+  // A member function call depends on the object it is called on, which may
+  // well be modified between calls.
+  if (This)
+    return nullptr;
+
+  // When checking a potential constant expression or looking for overflow,
+  // we want to visit the function body itself.
+  if (Info.checkingPotentialConstantExpression() ||
+      Info.checkingForOverflow())
+    return nullptr;
+
+  ConstexprCallCache *Cache = Info.Ctx.getConstexprCallCache();
+  if (!Cache)
+    return nullptr;
+
+  for (const APValue &Arg : ArgValues)
+    if (!ConstexprCallCache::isCacheableValue(Arg))
+      return nullptr;
+  return Cache;
+}
+
+/// Evaluate a function call.
+static bool HandleFunctionCall(SourceLocation CallLoc,
+                               const FunctionDecl *Callee, const LValue *This,
+                               ArrayRef<const Expr*> Args, const Stmt *Body,
+                               EvalInfo &Info, APValue &Result) {
+  ArgVector ArgValues(Args.size());
+  if (!EvaluateArgs(Args, ArgValues, Info))
+    return false;
+
+  if (!Info.CheckCallLimit(CallLoc))
+    return false;
+
+  ConstexprCallCache *Cache = getCallCache(Info, This, ArgValues);
+  if (!Cache)
+    return HandleFunctionBody(CallLoc, Callee, This, Args, ArgValues, Body,
+                              Info, Result);
+
+  // The call may modify its parameters, so compute the key up front.
+  SmallString<128> Key;
+  ConstexprCallCache::getKey(Callee, Info.EvalMode, ArgValues, Key);
+  if (const ConstexprCallCache::Entry *Cached = Cache->lookup(Key)) {
+    // Evaluating the call here might exceed the depth or step limit, in which
+    // case we want to produce the same diagnostic we would have without the
+    // cache.
+    if (Info.CallStackDepth + Cached->Depth <=
+            Info.getLangOpts().ConstexprCallDepth &&
+        Cached->Steps <= Info.StepsLeft) {
+      Info.StepsLeft -= Cached->Steps;
+      // Account for the depth of the call in the enclosing calls, in case
+      // their results are remembered too.
+      Info.MaxCallStackDepth = std::max(Info.MaxCallStackDepth,
+                                        Info.CallStackDepth + Cached->Depth);
+      Result = Cached->Result;
+      return true;
+    }
+  }
+
+  // Only remember the result if the call produced no diagnostics and no
+  // side-effects; if we already have either, we can't tell whether it did.
+  bool CanRemember = Info.EvalStatus.Diag && Info.EvalStatus.Diag->empty() &&
+                     !Info.EvalStatus.HasSideEffects;
+
+  unsigned OldMaxCallStackDepth = Info.MaxCallStackDepth;
+  unsigned OldStepsLeft = Info.StepsLeft;
+  Info.MaxCallStackDepth = Info.CallStackDepth;
+  bool Success = HandleFunctionBody(CallLoc, Callee, This, Args, ArgValues,
+                                    Body, Info, Result);
+  unsigned Depth = Info.MaxCallStackDepth - Info.CallStackDepth;
+  Info.MaxCallStackDepth =
+      std::max(OldMaxCallStackDepth, Info.MaxCallStackDepth);
+
+  if (Success && CanRemember && Info.EvalStatus.Diag->empty() &&
+      !Info.EvalStatus.HasSideEffects &&
+      ConstexprCallCache::isCacheableValue(Result))
+    Cache->insert(Key, Result, Depth, OldStepsLeft - Info.StepsLeft);
+  return Success;
+}
+
 /// Evaluate a constructor call.
 static bool HandleConstructorCall(SourceLocation CallLoc, const LValue &This,
                                   ArrayRef<const Expr*> Args,
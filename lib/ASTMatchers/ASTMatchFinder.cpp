@@ -22,6 +22,7 @@
 #include "clang/AST/RecursiveASTVisitor.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/StringMap.h"
+#include "llvm/Support/MutexGuard.h"
 #include "llvm/Support/Timer.h"
 #include <deque>
 #include <memory>
@@ -302,28 +303,50 @@ public:
 
   ~MatchASTVisitor() override {
     if (Options.CheckProfiling) {
-      Options.CheckProfiling->Records = std::move(TimeByBucket);
+      withCallbackLock([this] {
+        llvm::StringMap<llvm::TimeRecord> &Records =
+            Options.CheckProfiling->Records;
+        // Translation units matched concurrently add up their times.
+        if (!Options.CallbackLock) {
+          Records = std::move(TimeByBucket);
+          return;
+        }
+        for (const auto &Bucket : TimeByBucket)
+          Records[Bucket.getKey()] += Bucket.getValue();
+      });
     }
   }
 
   void onStartOfTranslationUnit() {
-    const bool EnableCheckProfiling = Options.CheckProfiling.hasValue();
-    TimeBucketRegion Timer;
-    for (MatchCallback *MC : Matchers->AllCallbacks) {
-      if (EnableCheckProfiling)
-        Timer.setBucket(&TimeByBucket[MC->getID()]);
-      MC->onStartOfTranslationUnit();
-    }
+    withCallbackLock([this] {
+      const bool EnableCheckProfiling = Options.CheckProfiling.hasValue();
+      TimeBucketRegion Timer;
+      for (MatchCallback *MC : Matchers->AllCallbacks) {
+        if (EnableCheckProfiling)
+          Timer.setBucket(&TimeByBucket[MC->getID()]);
+        MC->onStartOfTranslationUnit();
+      }
+    });
   }
 
   void onEndOfTranslationUnit() {
-    const bool EnableCheckProfiling = Options.CheckProfiling.hasValue();
-    TimeBucketRegion Timer;
-    for (MatchCallback *MC : Matchers->AllCallbacks) {
-      if (EnableCheckProfiling)
-        Timer.setBucket(&TimeByBucket[MC->getID()]);
-      MC->onEndOfTranslationUnit();
-    }
+    withCallbackLock([this] {
+      const bool EnableCheckProfiling = Options.CheckProfiling.hasValue();
+      TimeBucketRegion Timer;
+      for (MatchCallback *MC : Matchers->AllCallbacks) {
+        if (EnableCheckProfiling)
+          Timer.setBucket(&TimeByBucket[MC->getID()]);
+        MC->onEndOfTranslationUnit();
+      }
+    });
+  }
+
+  /// \brief Call \p Fn while holding the callback lock, if there is one.
+  template <typename FnT> void withCallbackLock(FnT Fn) {
+    if (!Options.CallbackLock)
+      return Fn();
+    llvm::MutexGuard Guard(*Options.CallbackLock);
+    Fn();
   }
 
   void set_active_ast_context(ASTContext *NewActiveASTContext) {
@@ -532,7 +555,8 @@ private:
         Timer.setBucket(&TimeByBucket[MP.second->getID()]);
       BoundNodesTreeBuilder Builder;
       if (MP.first.matches(Node, this, &Builder)) {
-        MatchVisitor Visitor(ActiveASTContext, MP.second);
+        MatchVisitor Visitor(ActiveASTContext, MP.second,
+                             Options.CallbackLock);
         Builder.visitMatches(&Visitor);
       }
     }
@@ -556,7 +580,8 @@ private:
         Timer.setBucket(&TimeByBucket[MP.second->getID()]);
       BoundNodesTreeBuilder Builder;
       if (MP.first.matchesNoKindCheck(DynNode, this, &Builder)) {
-        MatchVisitor Visitor(ActiveASTContext, MP.second);
+        MatchVisitor Visitor(ActiveASTContext, MP.second,
+                             Options.CallbackLock);
         Builder.visitMatches(&Visitor);
       }
     }
@@ -695,17 +720,25 @@ private:
   class MatchVisitor : public BoundNodesTreeBuilder::Visitor {
   public:
     MatchVisitor(ASTContext* Context,
-                 MatchFinder::MatchCallback* Callback)
+                 MatchFinder::MatchCallback* Callback,
+                 llvm::sys::Mutex *CallbackLock)
       : Context(Context),
-        Callback(Callback) {}
+        Callback(Callback),
+        CallbackLock(CallbackLock) {}
 
     void visitMatch(const BoundNodes& BoundNodesView) override {
+      if (CallbackLock) {
+        llvm::MutexGuard Guard(*CallbackLock);
+        Callback->run(MatchFinder::MatchResult(BoundNodesView, Context));
+        return;
+      }
       Callback->run(MatchFinder::MatchResult(BoundNodesView, Context));
     }
 
   private:
     ASTContext* Context;
     MatchFinder::MatchCallback* Callback;
+    llvm::sys::Mutex *CallbackLock;
   };
 
   // Returns true if 'TypeNode' has an alias that matches the given matcher.
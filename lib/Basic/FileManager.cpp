@@ -56,6 +56,8 @@ FileManager::FileManager(const FileSystemOptions &FSO,
   // file system.
   if (!FS)
     this->FS = vfs::getRealFileSystem();
+
+  SharedStatCache = SharedFileSystemStatCache::getDefault();
 }
 
 FileManager::~FileManager() {
@@ -104,6 +106,11 @@ void FileManager::clearStatCaches() {
   StatCache.reset();
 }
 
+void FileManager::setSharedStatCache(
+    IntrusiveRefCntPtr<SharedFileSystemStatCache> Cache) {
+  SharedStatCache = Cache;
+}
+
 /// \brief Retrieve the directory that the given file name resides in.
 /// Filename can point to either a real file or a virtual file.
 static const DirectoryEntry *getDirectoryFromFile(FileManager &FileMgr,
@@ -320,6 +327,11 @@ const FileEntry *FileManager::getFile(StringRef Filename, bool openFile,
   return &UFE;
 }
 
+bool FileManager::hasSeenFile(StringRef Filename) const {
+  FileEntry *Entry = SeenFileEntries.lookup(Filename);
+  return Entry && Entry != NON_EXISTENT_FILE;
+}
+
 const FileEntry *
 FileManager::getVirtualFile(StringRef Filename, off_t Size,
                             time_t ModificationTime) {
@@ -454,14 +466,17 @@ bool FileManager::getStatValue(const char *Path, FileData &Data, bool isFile,
                                std::unique_ptr<vfs::File> *F) {
   // FIXME: FileSystemOpts shouldn't be passed in here, all paths should be
   // absolute!
-  if (FileSystemOpts.WorkingDir.empty())
-    return FileSystemStatCache::get(Path, Data, isFile, F,StatCache.get(), *FS);
+  SmallString<128> FilePath;
+  if (!FileSystemOpts.WorkingDir.empty()) {
+    FilePath = Path;
+    FixupRelativePath(FilePath);
+    Path = FilePath.c_str();
+  }
 
-  SmallString<128> FilePath(Path);
-  FixupRelativePath(FilePath);
+  if (!StatCache && SharedStatCache)
+    return SharedStatCache->get(Path, Data, isFile, F, *FS);
 
-  return FileSystemStatCache::get(FilePath.c_str(), Data, isFile, F,
-                                  StatCache.get(), *FS);
+  return FileSystemStatCache::get(Path, Data, isFile, F, StatCache.get(), *FS);
 }
 
 bool FileManager::getNoncachedStatValue(StringRef Path,
@@ -583,8 +598,37 @@ void FileManager::PrintStats() const {
                << NumDirCacheMisses << " dir cache misses.\n";
   llvm::errs() << NumFileLookups << " file lookups, "
                << NumFileCacheMisses << " file cache misses.\n";
+  if (SharedStatCache)
+    SharedStatCache->PrintStats();
 
   //llvm::errs() << PagesMapped << BytesOfPagesMapped << FSLookups;
 }
 
+std::error_code
+clang::writeFileAtomically(StringRef Path,
+                           llvm::function_ref<void(raw_ostream &)> Write) {
+  SmallString<256> TempPath;
+  int FD;
+  if (std::error_code EC =
+          llvm::sys::fs::createUniqueFile(Path + "-%%%%%%%%", FD, TempPath))
+    return EC;
+
+  {
+    llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    Write(OS);
+    OS.close();
+    if (OS.has_error()) {
+      OS.clear_error();
+      llvm::sys::fs::remove(TempPath);
+      return std::make_error_code(std::errc::io_error);
+    }
+  }
+
+  if (std::error_code EC = llvm::sys::fs::rename(TempPath, Path)) {
+    llvm::sys::fs::remove(TempPath);
+    return EC;
+  }
+  return std::error_code();
+}
+
 PCHContainerOperations::~PCHContainerOperations() {}
@@ -13,7 +13,10 @@
 
 #include "clang/Basic/FileSystemStatCache.h"
 #include "clang/Basic/VirtualFileSystem.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MutexGuard.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
 
 using namespace clang;
 
@@ -31,6 +34,51 @@ static void copyStatusToFileData(const vfs::Status &Status,
   Data.IsVFSMapped = Status.IsVFSMapped;
 }
 
+/// Query the file system for the 'stat' information of \p Path, opening the
+/// file if \p F is non-null and the path is a file.
+static FileSystemStatCache::LookupResult
+statFileSystem(const char *Path, FileData &Data, bool isFile,
+               std::unique_ptr<vfs::File> *F, vfs::FileSystem &FS) {
+  bool isForDir = !isFile;
+
+  if (isForDir || !F) {
+    // If this is a directory or a file descriptor is not needed, just go to
+    // the file system.
+    llvm::ErrorOr<vfs::Status> Status = FS.status(Path);
+    if (!Status)
+      return FileSystemStatCache::CacheMissing;
+    copyStatusToFileData(*Status, Data);
+    return FileSystemStatCache::CacheExists;
+  }
+
+  // Otherwise, we have to go to the filesystem.  We can always just use
+  // 'stat' here, but (for files) the client is asking whether the file exists
+  // because it wants to turn around and *open* it.  It is more efficient to
+  // do "open+fstat" on success than it is to do "stat+open".
+  //
+  // Because of this, check to see if the file exists with 'open'.  If the
+  // open succeeds, use fstat to get the stat info.
+  auto OwnedFile = FS.openFileForRead(Path);
+
+  // If the open fails, our "stat" fails.
+  if (!OwnedFile)
+    return FileSystemStatCache::CacheMissing;
+
+  // Otherwise, the open succeeded.  Do an fstat to get the information
+  // about the file.  We'll end up returning the open file descriptor to the
+  // client to do what they please with it.
+  llvm::ErrorOr<vfs::Status> Status = (*OwnedFile)->status();
+  if (!Status) {
+    // fstat rarely fails.  If it does, claim the initial open didn't
+    // succeed.
+    *F = nullptr;
+    return FileSystemStatCache::CacheMissing;
+  }
+  copyStatusToFileData(*Status, Data);
+  *F = std::move(*OwnedFile);
+  return FileSystemStatCache::CacheExists;
+}
+
 /// FileSystemStatCache::get - Get the 'stat' information for the specified
 /// path, using the cache to accelerate it if possible.  This returns true if
 /// the path does not exist or false if it exists.
@@ -49,46 +97,8 @@ bool FileSystemStatCache::get(const char *Path, FileData &Data, bool isFile,
   // If we have a cache, use it to resolve the stat query.
   if (Cache)
     R = Cache->getStat(Path, Data, isFile, F, FS);
-  else if (isForDir || !F) {
-    // If this is a directory or a file descriptor is not needed and we have
-    // no cache, just go to the file system.
-    llvm::ErrorOr<vfs::Status> Status = FS.status(Path);
-    if (!Status) {
-      R = CacheMissing;
-    } else {
-      R = CacheExists;
-      copyStatusToFileData(*Status, Data);
-    }
-  } else {
-    // Otherwise, we have to go to the filesystem.  We can always just use
-    // 'stat' here, but (for files) the client is asking whether the file exists
-    // because it wants to turn around and *open* it.  It is more efficient to
-    // do "open+fstat" on success than it is to do "stat+open".
-    //
-    // Because of this, check to see if the file exists with 'open'.  If the
-    // open succeeds, use fstat to get the stat info.
-    auto OwnedFile = FS.openFileForRead(Path);
-
-    if (!OwnedFile) {
-      // If the open fails, our "stat" fails.
-      R = CacheMissing;
-    } else {
-      // Otherwise, the open succeeded.  Do an fstat to get the information
-      // about the file.  We'll end up returning the open file descriptor to the
-      // client to do what they please with it.
-      llvm::ErrorOr<vfs::Status> Status = (*OwnedFile)->status();
-      if (Status) {
-        R = CacheExists;
-        copyStatusToFileData(*Status, Data);
-        *F = std::move(*OwnedFile);
-      } else {
-        // fstat rarely fails.  If it does, claim the initial open didn't
-        // succeed.
-        R = CacheMissing;
-        *F = nullptr;
-      }
-    }
-  }
+  else
+    R = statFileSystem(Path, Data, isFile, F, FS);
 
   // If the path doesn't exist, return failure.
   if (R == CacheMissing) return true;
@@ -124,3 +134,141 @@ MemorizeStatCalls::getStat(const char *Path, FileData &Data, bool isFile,
 
   return Result;
 }
+
+//===----------------------------------------------------------------------===//
+// SharedFileSystemStatCache
+//===----------------------------------------------------------------------===//
+
+namespace {
+struct DefaultSharedStatCache {
+  llvm::sys::Mutex Lock;
+  IntrusiveRefCntPtr<SharedFileSystemStatCache> Cache;
+};
+}
+
+static llvm::ManagedStatic<DefaultSharedStatCache> DefaultStatCache;
+
+SharedFileSystemStatCache::SharedFileSystemStatCache(bool CacheMissingFiles)
+    : Generation(0), CacheMissingFiles(CacheMissingFiles), NumHits(0),
+      NumMisses(0), NumInvalidated(0) {}
+
+bool SharedFileSystemStatCache::get(const char *Path, FileData &Data,
+                                    bool isFile, std::unique_ptr<vfs::File> *F,
+                                    vfs::FileSystem &FS) {
+  bool isForDir = !isFile;
+
+  // Relative paths depend on the working directory, and overlay file systems
+  // on the client, so only absolute paths on the real file system are shared.
+  bool Cacheable = llvm::sys::path::is_absolute(Path) &&
+                   &FS == vfs::getRealFileSystem().get();
+
+  // An entry from an older generation is checked against the file system
+  // again, and replaced if the file changed.
+  Entry Stale;
+  bool IsStale = false;
+  unsigned LookupGeneration = 0;
+  if (Cacheable) {
+    llvm::MutexGuard Guard(Lock);
+    LookupGeneration = Generation;
+    llvm::StringMap<Entry>::const_iterator I = Entries.find(Path);
+    if (I != Entries.end() && I->second.Generation == Generation) {
+      ++NumHits;
+      if (!I->second.Exists)
+        return true;
+      Data = I->second.Data;
+      return Data.IsDirectory != isForDir;
+    }
+    if (I != Entries.end()) {
+      Stale = I->second;
+      IsStale = true;
+    }
+    ++NumMisses;
+  }
+
+  // Don't hold the lock while talking to the file system; on a networked
+  // file system that is exactly the latency other threads want to avoid.
+  LookupResult R = statFileSystem(Path, Data, isFile, F, FS);
+
+  if (Cacheable) {
+    bool Exists = R == CacheExists;
+    llvm::MutexGuard Guard(Lock);
+    if (IsStale &&
+        (Stale.Exists != Exists ||
+         (Exists && (Stale.Data.Size != Data.Size ||
+                     Stale.Data.ModTime != Data.ModTime ||
+                     Stale.Data.UniqueID != Data.UniqueID))))
+      ++NumInvalidated;
+
+    if (Exists || CacheMissingFiles) {
+      Entry &E = Entries[Path];
+      E.Exists = Exists;
+      if (Exists)
+        E.Data = Data;
+      E.Generation = LookupGeneration;
+    } else if (IsStale) {
+      Entries.erase(Path);
+    }
+  }
+
+  if (R == CacheMissing)
+    return true;
+
+  if (Data.IsDirectory != isForDir) {
+    if (F)
+      *F = nullptr;
+    return true;
+  }
+
+  return false;
+}
+
+void SharedFileSystemStatCache::revalidate() {
+  llvm::MutexGuard Guard(Lock);
+  ++Generation;
+}
+
+void SharedFileSystemStatCache::clear() {
+  llvm::MutexGuard Guard(Lock);
+  Entries.clear();
+}
+
+unsigned SharedFileSystemStatCache::size() const {
+  llvm::MutexGuard Guard(Lock);
+  return Entries.size();
+}
+
+unsigned SharedFileSystemStatCache::getNumHits() const {
+  llvm::MutexGuard Guard(Lock);
+  return NumHits;
+}
+
+unsigned SharedFileSystemStatCache::getNumMisses() const {
+  llvm::MutexGuard Guard(Lock);
+  return NumMisses;
+}
+
+unsigned SharedFileSystemStatCache::getNumInvalidated() const {
+  llvm::MutexGuard Guard(Lock);
+  return NumInvalidated;
+}
+
+void SharedFileSystemStatCache::PrintStats() const {
+  llvm::MutexGuard Guard(Lock);
+  llvm::errs() << "\n*** Shared Stat Cache Stats:\n";
+  llvm::errs() << Entries.size() << " entries, "
+               << NumHits << " hits, "
+               << NumMisses << " misses, "
+               << NumInvalidated << " invalidated.\n";
+}
+
+IntrusiveRefCntPtr<SharedFileSystemStatCache>
+SharedFileSystemStatCache::getDefault() {
+  llvm::MutexGuard Guard(DefaultStatCache->Lock);
+  return DefaultStatCache->Cache;
+}
+
+void SharedFileSystemStatCache::setDefault(
+    IntrusiveRefCntPtr<SharedFileSystemStatCache> Cache) {
+  llvm::MutexGuard Guard(DefaultStatCache->Lock);
+  DefaultStatCache->Cache = Cache;
+}
@@ -0,0 +1,197 @@
+//===--- TimeTrace.cpp - Hierarchical compilation time tracing ------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the time trace profiler behind -ftime-trace.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Basic/TimeTrace.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <iterator>
+#include <vector>
+
+using namespace clang;
+
+typedef std::chrono::steady_clock Clock;
+typedef std::chrono::microseconds Microseconds;
+
+namespace clang {
+
+TimeTraceProfiler *TimeTraceProfilerInstance = nullptr;
+
+class TimeTraceProfiler {
+  struct Entry {
+    unsigned ID;
+    Clock::time_point Start;
+    Microseconds Duration;
+    std::string Name;
+    std::string Detail;
+  };
+
+  /// \brief The open regions, most recently opened last.
+  std::vector<Entry> Stack;
+  unsigned NextID;
+
+  /// \brief The closed regions that are long enough to be written out.
+  std::vector<Entry> Entries;
+
+  struct Total {
+    unsigned Count;
+    Microseconds Duration;
+
+    Total() : Count(0), Duration(0) {}
+  };
+
+  /// \brief The number of regions of each name and the time spent in them,
+  /// not counting regions nested within a region of the same name.
+  llvm::StringMap<Total> Totals;
+
+  Clock::time_point StartTime;
+  Microseconds Granularity;
+
+  void writeEvent(raw_ostream &OS, StringRef Name, Microseconds Start,
+                  Microseconds Duration, StringRef ArgName, StringRef Arg);
+
+public:
+  explicit TimeTraceProfiler(unsigned GranularityInMicroseconds)
+      : NextID(1), StartTime(Clock::now()),
+        Granularity(GranularityInMicroseconds) {}
+
+  unsigned begin(StringRef Name, llvm::function_ref<std::string()> Detail) {
+    Entry E;
+    E.ID = NextID++;
+    E.Start = Clock::now();
+    E.Name = Name;
+    E.Detail = Detail();
+    Stack.push_back(std::move(E));
+    return Stack.back().ID;
+  }
+
+  void end(unsigned ID) {
+    auto I = std::find_if(Stack.rbegin(), Stack.rend(),
+                          [&](const Entry &E) { return E.ID == ID; });
+    if (I == Stack.rend())
+      return;
+    Entry E = std::move(*I);
+    Stack.erase(std::next(I).base());
+    E.Duration =
+        std::chrono::duration_cast<Microseconds>(Clock::now() - E.Start);
+
+    // Don't count recursive regions twice.
+    if (std::none_of(Stack.begin(), Stack.end(), [&](const Entry &Outer) {
+          return Outer.Name == E.Name;
+        })) {
+      Total &T = Totals[E.Name];
+      ++T.Count;
+      T.Duration += E.Duration;
+    }
+
+    if (E.Duration >= Granularity)
+      Entries.push_back(std::move(E));
+  }
+
+  void write(raw_ostream &OS);
+};
+
+} // end namespace clang
+
+void clang::writeJSONString(raw_ostream &OS, StringRef Str) {
+  OS << '"';
+  for (unsigned char C : Str) {
+    if (C == '"' || C == '\\')
+      OS << '\\' << C;
+    else if (C < 0x20)
+      OS << "\\u" << llvm::format("%04x", C);
+    else
+      OS << C;
+  }
+  OS << '"';
+}
+
+void TimeTraceProfiler::writeEvent(raw_ostream &OS, StringRef Name,
+                                   Microseconds Start, Microseconds Duration,
+                                   StringRef ArgName, StringRef Arg) {
+  OS << "{\"pid\":1,\"tid\":0,\"ph\":\"X\",\"ts\":" << Start.count()
+     << ",\"dur\":" << Duration.count() << ",\"name\":";
+  writeJSONString(OS, Name);
+  if (!Arg.empty()) {
+    OS << ",\"args\":{";
+    writeJSONString(OS, ArgName);
+    OS << ':';
+    writeJSONString(OS, Arg);
+    OS << '}';
+  }
+  OS << "},\n";
+}
+
+void TimeTraceProfiler::write(raw_ostream &OS) {
+  OS << "{\"traceEvents\":[\n";
+
+  for (const Entry &E : Entries)
+    writeEvent(OS, E.Name,
+               std::chrono::duration_cast<Microseconds>(E.Start - StartTime),
+               E.Duration, "detail", E.Detail);
+
+  // Emit the totals as consecutive regions, longest first, so that they
+  // show up as a separate bar chart in the viewer.
+  std::vector<const llvm::StringMapEntry<Total> *> SortedTotals;
+  for (const auto &T : Totals)
+    SortedTotals.push_back(&T);
+  std::sort(SortedTotals.begin(), SortedTotals.end(),
+            [](const llvm::StringMapEntry<Total> *A,
+               const llvm::StringMapEntry<Total> *B) {
+              if (A->second.Duration != B->second.Duration)
+                return A->second.Duration > B->second.Duration;
+              return A->first() < B->first();
+            });
+  Microseconds TotalStart(0);
+  for (const llvm::StringMapEntry<Total> *T : SortedTotals) {
+    writeEvent(OS, "Total " + T->first().str(), TotalStart, T->second.Duration,
+               "count", llvm::utostr(T->second.Count));
+    TotalStart += T->second.Duration;
+  }
+
+  OS << "{\"pid\":1,\"tid\":0,\"ph\":\"M\",\"ts\":0,\"name\":\"process_name\","
+        "\"args\":{\"name\":\"clang\"}}\n";
+  OS << "]}\n";
+}
+
+void clang::timeTraceProfilerInitialize(unsigned GranularityInMicroseconds) {
+  assert(!TimeTraceProfilerInstance && "time trace profiler already running");
+  TimeTraceProfilerInstance = new TimeTraceProfiler(GranularityInMicroseconds);
+}
+
+void clang::timeTraceProfilerCleanup() {
+  delete TimeTraceProfilerInstance;
+  TimeTraceProfilerInstance = nullptr;
+}
+
+void clang::timeTraceProfilerWrite(raw_ostream &OS) {
+  assert(TimeTraceProfilerInstance && "time trace profiler not running");
+  TimeTraceProfilerInstance->write(OS);
+}
+
+unsigned
+clang::timeTraceProfilerBegin(StringRef Name,
+                              llvm::function_ref<std::string()> Detail) {
+  if (!TimeTraceProfilerInstance)
+    return 0;
+  return TimeTraceProfilerInstance->begin(Name, Detail);
+}
+
+void clang::timeTraceProfilerEnd(unsigned Region) {
+  if (TimeTraceProfilerInstance)
+    TimeTraceProfilerInstance->end(Region);
+}
@@ -11,6 +11,7 @@
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/LangOptions.h"
 #include "clang/Basic/TargetOptions.h"
+#include "clang/Basic/TimeTrace.h"
 #include "clang/Frontend/CodeGenOptions.h"
 #include "clang/Frontend/FrontendDiagnostic.h"
 #include "clang/Frontend/Utils.h"
@@ -595,6 +596,7 @@ bool EmitAssemblyHelper::AddEmitPasses(BackendAction Action,
 void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
                                       raw_pwrite_stream *OS) {
   TimeRegion Region(llvm::TimePassesIsEnabled ? &CodeGenerationTime : nullptr);
+  TimeTraceScope TimeScope("Backend");
 
   bool UsesCodeGen = (Action != Backend_EmitNothing &&
                       Action != Backend_EmitBC &&
@@ -635,21 +637,27 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
 
   if (PerFunctionPasses) {
     PrettyStackTraceString CrashInfo("Per-function optimization");
+    TimeTraceScope TimeScope("PerFunctionPasses");
 
     PerFunctionPasses->doInitialization();
     for (Function &F : *TheModule)
-      if (!F.isDeclaration())
+      if (!F.isDeclaration()) {
+        TimeTraceScope FunctionTimeScope("OptFunction",
+                                         [&] { return F.getName().str(); });
         PerFunctionPasses->run(F);
+      }
     PerFunctionPasses->doFinalization();
   }
 
   if (PerModulePasses) {
     PrettyStackTraceString CrashInfo("Per-module optimization passes");
+    TimeTraceScope TimeScope("PerModulePasses");
     PerModulePasses->run(*TheModule);
   }
 
   if (CodeGenPasses) {
     PrettyStackTraceString CrashInfo("Code generation");
+    TimeTraceScope TimeScope("CodeGenPasses");
     CodeGenPasses->run(*TheModule);
   }
 }
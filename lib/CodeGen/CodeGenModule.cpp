@@ -38,6 +38,7 @@
 #include "clang/Basic/Module.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Basic/TargetInfo.h"
+#include "clang/Basic/TimeTrace.h"
 #include "clang/Basic/Version.h"
 #include "clang/Frontend/CodeGenOptions.h"
 #include "clang/Sema/SemaDiagnostic.h"
@@ -339,6 +340,7 @@ void InstrProfStats::reportDiagnostics(DiagnosticsEngine &Diags,
 }
 
 void CodeGenModule::Release() {
+  TimeTraceScope TimeScope("CodeGenModule::Release");
   EmitDeferred();
   applyReplacements();
   checkAliases();
@@ -3230,6 +3232,12 @@ void CodeGenModule::EmitTopLevelDecl(Decl *D) {
   if (D->getDeclContext() && D->getDeclContext()->isDependentContext())
     return;
 
+  TimeTraceScope TimeScope("EmitTopLevelDecl", [&]() -> std::string {
+    if (const auto *ND = dyn_cast<NamedDecl>(D))
+      return ND->getQualifiedNameAsString();
+    return std::string(D->getDeclKindName());
+  });
+
   switch (D->getKind()) {
   case Decl::CXXConversion:
   case Decl::CXXMethod:
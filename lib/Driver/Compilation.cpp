@@ -14,9 +14,18 @@
 #include "clang/Driver/Options.h"
 #include "clang/Driver/ToolChain.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/Option/ArgList.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
+#if LLVM_ENABLE_THREADS
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
 
 using namespace clang::driver;
 using namespace clang;
@@ -26,7 +35,7 @@ Compilation::Compilation(const Driver &D, const ToolChain &_DefaultToolChain,
                          InputArgList *_Args, DerivedArgList *_TranslatedArgs)
     : TheDriver(D), DefaultToolChain(_DefaultToolChain), Args(_Args),
       TranslatedArgs(_TranslatedArgs), Redirects(nullptr),
-      ForDiagnostics(false) {}
+      ForDiagnostics(false), MaxParallelJobs(1) {}
 
 Compilation::~Compilation() {
   delete TranslatedArgs;
@@ -122,8 +131,7 @@ bool Compilation::CleanupFileMap(const ArgStringMap &Files,
   return Success;
 }
 
-int Compilation::ExecuteCommand(const Command &C,
-                                const Command *&FailingCommand) const {
+bool Compilation::PrintCommand(const Command &C) const {
   if ((getDriver().CCPrintOptions ||
        getArgs().hasArg(options::OPT_v)) && !getDriver().CCGenDiagnostics) {
     raw_ostream *OS = &llvm::errs();
@@ -138,9 +146,8 @@ int Compilation::ExecuteCommand(const Command &C,
       if (EC) {
         getDriver().Diag(clang::diag::err_drv_cc_print_options_failure)
             << EC.message();
-        FailingCommand = &C;
         delete OS;
-        return 1;
+        return false;
       }
     }
 
@@ -153,6 +160,16 @@ int Compilation::ExecuteCommand(const Command &C,
       delete OS;
   }
 
+  return true;
+}
+
+int Compilation::ExecuteCommand(const Command &C,
+                                const Command *&FailingCommand) const {
+  if (!PrintCommand(C)) {
+    FailingCommand = &C;
+    return 1;
+  }
+
   std::string Error;
   bool ExecutionFailed;
   int Res = C.Execute(Redirects, &Error, &ExecutionFailed);
@@ -194,6 +211,194 @@ static bool InputsOk(const Command &C,
 
 void Compilation::ExecuteJobs(const JobList &Jobs,
                               FailingCommandList &FailingCommands) const {
+  // Output redirection is only used when regenerating a crashed compilation
+  // for diagnostics; keep that path serial.
+  if (MaxParallelJobs > 1 && Jobs.size() > 1 && !Redirects) {
+    ExecuteJobsInParallel(Jobs, FailingCommands);
+    return;
+  }
+
+  for (const auto &Job : Jobs) {
+    if (!InputsOk(Job, FailingCommands))
+      continue;
+    const Command *FailingCommand = nullptr;
+    if (int Res = ExecuteCommand(Job, FailingCommand))
+      FailingCommands.push_back(std::make_pair(Res, FailingCommand));
+  }
+}
+
+#if LLVM_ENABLE_THREADS
+namespace {
+/// ParallelJob - Bookkeeping for one command run by the parallel scheduler.
+struct ParallelJob {
+  enum StateKind { Pending, Running, Finished, Skipped };
+
+  const Command *Cmd;
+  StateKind State;
+
+  /// Indices of the jobs producing (transitive) inputs of this job.
+  SmallVector<unsigned, 4> Deps;
+
+  /// Temporary files capturing the job's stdout and stderr, if any.
+  SmallString<128> OutPath, ErrPath;
+
+  /// The result of executing the command.
+  int Res;
+  std::string Error;
+  bool ExecutionFailed;
+
+  explicit ParallelJob(const Command *Cmd)
+      : Cmd(Cmd), State(Pending), Res(0), ExecutionFailed(false) {}
+};
+}
+
+/// Collect the jobs which produce any of the (transitive) inputs of \p A.
+static void
+CollectJobDeps(const Action *A,
+               const llvm::DenseMap<const Action *, unsigned> &JobFor,
+               llvm::SmallPtrSetImpl<const Action *> &Visited,
+               SmallVectorImpl<unsigned> &Deps) {
+  for (const Action *Input : *A) {
+    if (!Visited.insert(Input).second)
+      continue;
+    auto It = JobFor.find(Input);
+    if (It != JobFor.end())
+      Deps.push_back(It->second);
+    CollectJobDeps(Input, JobFor, Visited, Deps);
+  }
+}
+
+/// Copy the contents of \p Path to \p OS and remove the file.
+static void ReplayOutputFile(StringRef Path, raw_ostream &OS) {
+  if (Path.empty())
+    return;
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer =
+      llvm::MemoryBuffer::getFile(Path);
+  if (Buffer) {
+    OS << (*Buffer)->getBuffer();
+    OS.flush();
+  }
+  llvm::sys::fs::remove(Path);
+}
+#endif
+
+void Compilation::ExecuteJobsInParallel(
+    const JobList &Jobs, FailingCommandList &FailingCommands) const {
+#if LLVM_ENABLE_THREADS
+  std::vector<ParallelJob> Work;
+  llvm::DenseMap<const Action *, unsigned> JobFor;
+  for (const auto &Job : Jobs) {
+    JobFor[&Job.getSource()] = Work.size();
+    Work.push_back(ParallelJob(&Job));
+  }
+
+  // Compute the dependencies between jobs from the action graph. BuildJobs
+  // emits the jobs producing an action's inputs before the action itself, so
+  // a job only ever depends on jobs with a smaller index.
+  for (ParallelJob &J : Work) {
+    llvm::SmallPtrSet<const Action *, 16> Visited;
+    CollectJobDeps(&J.Cmd->getSource(), JobFor, Visited, J.Deps);
+  }
+
+  std::mutex Lock;
+  std::condition_variable JobFinished;
+  std::vector<std::thread> Threads(Work.size());
+  unsigned NumRunning = 0, NumCompleted = 0;
+  unsigned NextToReport = 0;
+
+  std::unique_lock<std::mutex> Guard(Lock);
+  while (NextToReport != Work.size()) {
+    unsigned SeenCompleted = NumCompleted;
+
+    // Start every job whose inputs are available, up to the job limit.
+    for (unsigned I = NextToReport, E = Work.size();
+         I != E && NumRunning < MaxParallelJobs; ++I) {
+      ParallelJob &J = Work[I];
+      if (J.State != ParallelJob::Pending)
+        continue;
+
+      bool Ready = true, InputFailed = false;
+      for (unsigned Dep : J.Deps) {
+        const ParallelJob &D = Work[Dep];
+        if (D.State == ParallelJob::Skipped ||
+            (D.State == ParallelJob::Finished && D.Res))
+          InputFailed = true;
+        else if (D.State != ParallelJob::Finished)
+          Ready = false;
+      }
+      if (InputFailed) {
+        J.State = ParallelJob::Skipped;
+        continue;
+      }
+      if (!Ready)
+        continue;
+
+      // Capture the job's output so it can be replayed in order. If the
+      // temporary files cannot be created, let the job write directly.
+      if (llvm::sys::fs::createTemporaryFile("clang-job", "out", J.OutPath) ||
+          llvm::sys::fs::createTemporaryFile("clang-job", "err", J.ErrPath)) {
+        if (!J.OutPath.empty())
+          llvm::sys::fs::remove(J.OutPath.str());
+        J.OutPath.clear();
+        J.ErrPath.clear();
+      }
+
+      J.State = ParallelJob::Running;
+      ++NumRunning;
+      Threads[I] = std::thread([&, I] {
+        ParallelJob &J = Work[I];
+        StringRef OutFile = J.OutPath, ErrFile = J.ErrPath;
+        const StringRef *JobRedirects[3] = { nullptr, nullptr, nullptr };
+        if (!ErrFile.empty()) {
+          JobRedirects[1] = &OutFile;
+          JobRedirects[2] = &ErrFile;
+        }
+
+        std::string Error;
+        bool ExecutionFailed = false;
+        int Res = J.Cmd->Execute(JobRedirects, &Error, &ExecutionFailed);
+
+        std::lock_guard<std::mutex> JobGuard(Lock);
+        J.Res = Res;
+        J.Error = std::move(Error);
+        J.ExecutionFailed = ExecutionFailed;
+        J.State = ParallelJob::Finished;
+        --NumRunning;
+        ++NumCompleted;
+        JobFinished.notify_one();
+      });
+    }
+
+    // Report completed jobs in job order, so that command lines and
+    // diagnostics appear exactly as they would for a serial build.
+    while (NextToReport != Work.size() &&
+           (Work[NextToReport].State == ParallelJob::Finished ||
+            Work[NextToReport].State == ParallelJob::Skipped)) {
+      unsigned I = NextToReport++;
+      ParallelJob &J = Work[I];
+      if (J.State == ParallelJob::Skipped)
+        continue;
+
+      Guard.unlock();
+      Threads[I].join();
+      PrintCommand(*J.Cmd);
+      ReplayOutputFile(J.OutPath, llvm::outs());
+      ReplayOutputFile(J.ErrPath, llvm::errs());
+      if (!J.Error.empty()) {
+        assert(J.Res && "Error string set with 0 result code!");
+        getDriver().Diag(clang::diag::err_drv_command_failure) << J.Error;
+      }
+      if (J.Res)
+        FailingCommands.push_back(
+            std::make_pair(J.ExecutionFailed ? 1 : J.Res, J.Cmd));
+      Guard.lock();
+    }
+
+    // Wait for a running job to finish before scheduling more work.
+    if (NextToReport != Work.size() && NumRunning)
+      JobFinished.wait(Guard, [&] { return NumCompleted != SeenCompleted; });
+  }
+#else
   for (const auto &Job : Jobs) {
     if (!InputsOk(Job, FailingCommands))
       continue;
@@ -201,6 +406,7 @@ void Compilation::ExecuteJobs(const JobList &Jobs,
     if (int Res = ExecuteCommand(Job, FailingCommand))
       FailingCommands.push_back(std::make_pair(Res, FailingCommand));
   }
+#endif
 }
 
 void Compilation::initCompilationForDiagnostics() {
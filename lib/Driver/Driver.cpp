@@ -455,6 +455,16 @@ Compilation *Driver::BuildCompilation(ArrayRef<const char *> ArgList) {
   if (!HandleImmediateArgs(*C))
     return C;
 
+  if (const Arg *A = C->getArgs().getLastArg(options::OPT_j)) {
+    StringRef Value = A->getValue();
+    unsigned NumJobs;
+    if (Value.getAsInteger(10, NumJobs) || NumJobs == 0)
+      Diag(clang::diag::err_drv_invalid_int_value)
+          << A->getAsString(C->getArgs()) << Value;
+    else
+      C->setMaxParallelJobs(NumJobs);
+  }
+
   // Construct the list of inputs.
   InputList Inputs;
   BuildInputs(C->getDefaultToolChain(), *TranslatedArgs, Inputs);
@@ -249,6 +249,7 @@ template <> struct MappingTraits<FormatStyle> {
     IO.mapOptional("MacroBlockBegin", Style.MacroBlockBegin);
     IO.mapOptional("MacroBlockEnd", Style.MacroBlockEnd);
     IO.mapOptional("MaxEmptyLinesToKeep", Style.MaxEmptyLinesToKeep);
+    IO.mapOptional("MaxLineBreakingStates", Style.MaxLineBreakingStates);
     IO.mapOptional("NamespaceIndentation", Style.NamespaceIndentation);
     IO.mapOptional("ObjCBlockIndentWidth", Style.ObjCBlockIndentWidth);
     IO.mapOptional("ObjCSpaceAfterProperty", Style.ObjCSpaceAfterProperty);
@@ -379,6 +380,7 @@ FormatStyle getLLVMStyle() {
   LLVMStyle.IndentWidth = 2;
   LLVMStyle.TabWidth = 8;
   LLVMStyle.MaxEmptyLinesToKeep = 1;
+  LLVMStyle.MaxLineBreakingStates = 0;
   LLVMStyle.KeepEmptyLinesAtTheStartOfBlocks = true;
   LLVMStyle.NamespaceIndentation = FormatStyle::NI_None;
   LLVMStyle.ObjCBlockIndentWidth = 2;
@@ -1290,7 +1292,8 @@ public:
                        << "\n");
   }
 
-  tooling::Replacements format(bool *IncompleteFormat) {
+  tooling::Replacements format(bool *IncompleteFormat,
+                               std::vector<LineBreakingStats> *Stats) {
     tooling::Replacements Result;
     FormatTokenLexer Tokens(SourceMgr, ID, Style, Encoding);
 
@@ -1305,8 +1308,12 @@ public:
       for (unsigned i = 0, e = UnwrappedLines[Run].size(); i != e; ++i) {
         AnnotatedLines.push_back(new AnnotatedLine(UnwrappedLines[Run][i]));
       }
+      // Tokens outside preprocessor branches are shared between the runs,
+      // and a run does not touch those an earlier run already formatted. So
+      // with several runs, every line is formatted to keep that consistent.
       tooling::Replacements RunResult =
-          format(AnnotatedLines, Tokens, IncompleteFormat);
+          format(AnnotatedLines, Tokens, IncompleteFormat, Stats,
+                 /*FormatAllLines=*/RunE > 2);
       DEBUG({
         llvm::dbgs() << "Replacements for run " << Run << ":\n";
         for (tooling::Replacements::iterator I = RunResult.begin(),
@@ -1326,28 +1333,98 @@ public:
 
   tooling::Replacements format(SmallVectorImpl<AnnotatedLine *> &AnnotatedLines,
                                FormatTokenLexer &Tokens,
-                               bool *IncompleteFormat) {
+                               bool *IncompleteFormat,
+                               std::vector<LineBreakingStats> *Stats,
+                               bool FormatAllLines) {
+    computeAffectedLines(AnnotatedLines.begin(), AnnotatedLines.end());
+    SmallVector<AnnotatedLine *, 16> Lines;
+    if (FormatAllLines)
+      Lines.append(AnnotatedLines.begin(), AnnotatedLines.end());
+    else
+      collectLinesToFormat(AnnotatedLines, Lines);
+
+    // Parts of the style may be derived from the whole file, in which case
+    // every line has to be annotated; otherwise only those being formatted.
+    bool DeriveFromAllLines = Style.DerivePointerAlignment ||
+                              Style.Standard == FormatStyle::LS_Auto ||
+                              Style.ExperimentalAutoDetectBinPacking;
+    SmallVectorImpl<AnnotatedLine *> &LinesToAnnotate =
+        DeriveFromAllLines ? AnnotatedLines : Lines;
     TokenAnnotator Annotator(Style, Tokens.getKeywords());
-    for (unsigned i = 0, e = AnnotatedLines.size(); i != e; ++i) {
-      Annotator.annotate(*AnnotatedLines[i]);
+    for (unsigned i = 0, e = LinesToAnnotate.size(); i != e; ++i) {
+      Annotator.annotate(*LinesToAnnotate[i]);
     }
-    deriveLocalStyle(AnnotatedLines);
-    for (unsigned i = 0, e = AnnotatedLines.size(); i != e; ++i) {
-      Annotator.calculateFormattingInformation(*AnnotatedLines[i]);
+    deriveLocalStyle(LinesToAnnotate);
+    if (Lines.empty())
+      return tooling::Replacements();
+    for (unsigned i = 0, e = Lines.size(); i != e; ++i) {
+      Annotator.calculateFormattingInformation(*Lines[i]);
     }
-    computeAffectedLines(AnnotatedLines.begin(), AnnotatedLines.end());
 
-    Annotator.setCommentLineLevels(AnnotatedLines);
+    Annotator.setCommentLineLevels(Lines);
     ContinuationIndenter Indenter(Style, Tokens.getKeywords(), SourceMgr,
                                   Whitespaces, Encoding,
                                   BinPackInconclusiveFunctions);
     UnwrappedLineFormatter(&Indenter, &Whitespaces, Style, Tokens.getKeywords(),
-                           IncompleteFormat)
-        .format(AnnotatedLines);
+                           IncompleteFormat, Stats)
+        .format(Lines);
     return Whitespaces.generateReplacements();
   }
 
 private:
+  // Collects into 'Lines' the lines of 'AnnotatedLines' that have to be
+  // formatted so that the affected ones come out exactly as if all of them
+  // were: everything from the last line before the first affected one at
+  // which formatting can start afresh, up to the first such line after the
+  // last affected one. This keeps formatting a few lines of a large file
+  // cheap. 'Lines' is left empty if nothing is affected.
+  void
+  collectLinesToFormat(const SmallVectorImpl<AnnotatedLine *> &AnnotatedLines,
+                       SmallVectorImpl<AnnotatedLine *> &Lines) {
+    unsigned Begin = AnnotatedLines.size(), End = 0;
+    for (unsigned i = 0, e = AnnotatedLines.size(); i != e; ++i) {
+      const AnnotatedLine *Line = AnnotatedLines[i];
+      if (Line->Affected || Line->ChildrenAffected ||
+          Line->LeadingEmptyLinesAffected) {
+        Begin = std::min(Begin, i);
+        End = i + 1;
+      }
+    }
+    if (Begin == AnnotatedLines.size())
+      return;
+
+    while (Begin > 0 && !startsIndependentBlock(AnnotatedLines, Begin))
+      --Begin;
+    // The line after the last affected one may have its leading whitespace
+    // reformatted, so always keep it.
+    while (End + 1 < AnnotatedLines.size() &&
+           !startsIndependentBlock(AnnotatedLines, End))
+      ++End;
+    End = std::min<unsigned>(End + 1, AnnotatedLines.size());
+    Lines.append(AnnotatedLines.begin() + Begin, AnnotatedLines.begin() + End);
+  }
+
+  // Returns true if nothing before AnnotatedLines[i] influences how it and
+  // the lines after it are formatted, as long as it is not affected itself.
+  //
+  // Such a line is at the outermost level, so it sets the indent of the lines
+  // after it unless they are affected. It follows an empty line, which ends
+  // any sequence of aligned comments or assignments, and the end of a
+  // statement, declaration or preprocessor directive, so it cannot be merged
+  // with the line before.
+  bool startsIndependentBlock(const SmallVectorImpl<AnnotatedLine *> &Lines,
+                              unsigned i) {
+    const AnnotatedLine *Line = Lines[i];
+    if (Line->Affected || Line->ChildrenAffected ||
+        Line->LeadingEmptyLinesAffected || Line->Level != 0 ||
+        Line->InPPDirective || Line->First->NewlinesBefore < 2 ||
+        Line->First->isOneOf(tok::comment, tok::r_brace))
+      return false;
+    const AnnotatedLine *Previous = Lines[i - 1];
+    return Previous->InPPDirective ||
+           Previous->Last->isOneOf(tok::semi, tok::r_brace);
+  }
+
   // Determines which lines are affected by the SourceRanges given as input.
   // Returns \c true if at least one line between I and E or one of their
   // children is affected.
@@ -1563,11 +1640,12 @@ private:
 tooling::Replacements reformat(const FormatStyle &Style,
                                SourceManager &SourceMgr, FileID ID,
                                ArrayRef<CharSourceRange> Ranges,
-                               bool *IncompleteFormat) {
+                               bool *IncompleteFormat,
+                               std::vector<LineBreakingStats> *Stats) {
   if (Style.DisableFormat)
     return tooling::Replacements();
   Formatter formatter(Style, SourceMgr, ID, Ranges);
-  return formatter.format(IncompleteFormat);
+  return formatter.format(IncompleteFormat, Stats);
 }
 
 tooling::Replacements reformat(const FormatStyle &Style, StringRef Code,
@@ -1639,27 +1717,32 @@ static FormatStyle::LanguageKind getLanguageByFileName(StringRef FileName) {
 
 FormatStyle getStyle(StringRef StyleName, StringRef FileName,
                      StringRef FallbackStyle) {
+  return getStyle(StyleName, FileName, FallbackStyle, llvm::errs());
+}
+
+FormatStyle getStyle(StringRef StyleName, StringRef FileName,
+                     StringRef FallbackStyle, raw_ostream &Errs) {
   FormatStyle Style = getLLVMStyle();
   Style.Language = getLanguageByFileName(FileName);
   if (!getPredefinedStyle(FallbackStyle, Style.Language, &Style)) {
-    llvm::errs() << "Invalid fallback style \"" << FallbackStyle
-                 << "\" using LLVM style\n";
+    Errs << "Invalid fallback style \"" << FallbackStyle
+         << "\" using LLVM style\n";
     return Style;
   }
 
   if (StyleName.startswith("{")) {
     // Parse YAML/JSON style from the command line.
     if (std::error_code ec = parseConfiguration(StyleName, &Style)) {
-      llvm::errs() << "Error parsing -style: " << ec.message() << ", using "
-                   << FallbackStyle << " style\n";
+      Errs << "Error parsing -style: " << ec.message() << ", using "
+           << FallbackStyle << " style\n";
     }
     return Style;
   }
 
   if (!StyleName.equals_lower("file")) {
     if (!getPredefinedStyle(StyleName, Style.Language, &Style))
-      llvm::errs() << "Invalid value for -style, using " << FallbackStyle
-                   << " style\n";
+      Errs << "Invalid value for -style, using " << FallbackStyle
+           << " style\n";
     return Style;
   }
 
@@ -1692,7 +1775,7 @@ FormatStyle getStyle(StringRef StyleName, StringRef FileName,
       llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Text =
           llvm::MemoryBuffer::getFile(ConfigFile.c_str());
       if (std::error_code EC = Text.getError()) {
-        llvm::errs() << EC.message() << "\n";
+        Errs << EC.message() << "\n";
         break;
       }
       if (std::error_code ec =
@@ -1703,8 +1786,7 @@ FormatStyle getStyle(StringRef StyleName, StringRef FileName,
           UnsuitableConfigFiles.append(ConfigFile);
           continue;
         }
-        llvm::errs() << "Error reading " << ConfigFile << ": " << ec.message()
-                     << "\n";
+        Errs << "Error reading " << ConfigFile << ": " << ec.message() << "\n";
         break;
       }
       DEBUG(llvm::dbgs() << "Using configuration file " << ConfigFile << "\n");
@@ -1712,9 +1794,9 @@ FormatStyle getStyle(StringRef StyleName, StringRef FileName,
     }
   }
   if (!UnsuitableConfigFiles.empty()) {
-    llvm::errs() << "Configuration file(s) do(es) not support "
-                 << getLanguageName(Style.Language) << ": "
-                 << UnsuitableConfigFiles << "\n";
+    Errs << "Configuration file(s) do(es) not support "
+         << getLanguageName(Style.Language) << ": " << UnsuitableConfigFiles
+         << "\n";
   }
   return Style;
 }
@@ -623,8 +623,10 @@ public:
   OptimizingLineFormatter(ContinuationIndenter *Indenter,
                           WhitespaceManager *Whitespaces,
                           const FormatStyle &Style,
-                          UnwrappedLineFormatter *BlockFormatter)
-      : LineFormatter(Indenter, Whitespaces, Style, BlockFormatter) {}
+                          UnwrappedLineFormatter *BlockFormatter,
+                          std::vector<LineBreakingStats> *Stats)
+      : LineFormatter(Indenter, Whitespaces, Style, BlockFormatter),
+        Stats(Stats) {}
 
   /// \brief Formats the line by finding the best line breaks with line lengths
   /// below the column limit.
@@ -696,6 +698,8 @@ private:
     ++Count;
 
     unsigned Penalty = 0;
+    StateNode *Best = nullptr;
+    bool Greedy = false;
 
     // While not empty, take first element and follow edges.
     while (!Queue.empty()) {
@@ -703,6 +707,7 @@ private:
       StateNode *Node = Queue.top().second;
       if (!Node->State.NextToken) {
         DEBUG(llvm::dbgs() << "\n---\nPenalty for line: " << Penalty << "\n");
+        Best = Node;
         break;
       }
       Queue.pop();
@@ -716,6 +721,19 @@ private:
         // State already examined with lower penalty.
         continue;
 
+      // Past the limit, settle for the cheapest partial solution that can be
+      // completed greedily.
+      if (Style.MaxLineBreakingStates && Count >= Style.MaxLineBreakingStates) {
+        Best = completeGreedily(Node, Penalty);
+        if (Best) {
+          DEBUG(llvm::dbgs() << "\n---\nPenalty for greedily completed line: "
+                             << Penalty << "\n");
+          Greedy = true;
+          break;
+        }
+        continue;
+      }
+
       FormatDecision LastFormat = Node->State.NextToken->Decision;
       if (LastFormat == FD_Unformatted || LastFormat == FD_Continue)
         addNextStateToQueue(Penalty, Node, /*NewLine=*/false, &Count, &Queue);
@@ -723,7 +741,13 @@ private:
         addNextStateToQueue(Penalty, Node, /*NewLine=*/true, &Count, &Queue);
     }
 
-    if (Queue.empty()) {
+    if (!DryRun && Stats) {
+      LineBreakingStats LineStats = {
+          InitialState.Line->First->Tok.getLocation(), Count, Greedy};
+      Stats->push_back(LineStats);
+    }
+
+    if (!Best) {
       // We were unable to find a solution, do nothing.
       // FIXME: Add diagnostic?
       DEBUG(llvm::dbgs() << "Could not find a solution.\n");
@@ -732,7 +756,7 @@ private:
 
     // Reconstruct the solution.
     if (!DryRun)
-      reconstructPath(InitialState, Queue.top().second);
+      reconstructPath(InitialState, Best);
 
     DEBUG(llvm::dbgs() << "Total number of analyzed states: " << Count << "\n");
     DEBUG(llvm::dbgs() << "---\n");
@@ -740,26 +764,66 @@ private:
     return Penalty;
   }
 
+  /// \brief Completes the partial solution \p Node, which has the penalty
+  /// \p Penalty, by taking the cheaper of breaking and not breaking before
+  /// each of the remaining tokens in turn.
+  ///
+  /// Returns the final state and updates \p Penalty, or returns null if this
+  /// runs into a state from which the line cannot be completed.
+  StateNode *completeGreedily(StateNode *Node, unsigned &Penalty) {
+    while (Node->State.NextToken) {
+      FormatDecision LastFormat = Node->State.NextToken->Decision;
+      unsigned ContinuePenalty = Penalty, BreakPenalty = Penalty;
+      StateNode *Continue = nullptr, *Break = nullptr;
+      if (LastFormat == FD_Unformatted || LastFormat == FD_Continue)
+        Continue = getNextState(Node, /*NewLine=*/false, ContinuePenalty);
+      if (LastFormat == FD_Unformatted || LastFormat == FD_Break)
+        Break = getNextState(Node, /*NewLine=*/true, BreakPenalty);
+      if (Continue && (!Break || ContinuePenalty <= BreakPenalty)) {
+        Node = Continue;
+        Penalty = ContinuePenalty;
+      } else if (Break) {
+        Node = Break;
+        Penalty = BreakPenalty;
+      } else {
+        return nullptr;
+      }
+    }
+    return Node;
+  }
+
   /// \brief Add the following state to the analysis queue \c Queue.
   ///
   /// Assume the current state is \p PreviousNode and has been reached with a
   /// penalty of \p Penalty. Insert a line break if \p NewLine is \c true.
   void addNextStateToQueue(unsigned Penalty, StateNode *PreviousNode,
                            bool NewLine, unsigned *Count, QueueType *Queue) {
-    if (NewLine && !Indenter->canBreak(PreviousNode->State))
+    StateNode *Node = getNextState(PreviousNode, NewLine, Penalty);
+    if (!Node)
       return;
+
+    Queue->push(QueueItem(OrderedPenalty(Penalty, *Count), Node));
+    ++(*Count);
+  }
+
+  /// \brief Creates the state following \p PreviousNode, inserting a line
+  /// break if \p NewLine is \c true, and adds its cost to \p Penalty.
+  ///
+  /// Returns null if the token cannot be placed that way.
+  StateNode *getNextState(StateNode *PreviousNode, bool NewLine,
+                          unsigned &Penalty) {
+    if (NewLine && !Indenter->canBreak(PreviousNode->State))
+      return nullptr;
     if (!NewLine && Indenter->mustBreak(PreviousNode->State))
-      return;
+      return nullptr;
 
     StateNode *Node = new (Allocator.Allocate())
         StateNode(PreviousNode->State, NewLine, PreviousNode);
     if (!formatChildren(Node->State, NewLine, /*DryRun=*/true, Penalty))
-      return;
+      return nullptr;
 
     Penalty += Indenter->addTokenToState(Node->State, NewLine, true);
-
-    Queue->push(QueueItem(OrderedPenalty(Penalty, *Count), Node));
-    ++(*Count);
+    return Node;
   }
 
   /// \brief Applies the best formatting by reconstructing the path in the
@@ -789,6 +853,7 @@ private:
   }
 
   llvm::SpecificBumpPtrAllocator<StateNode> Allocator;
+  std::vector<LineBreakingStats> *Stats;
 };
 
 } // namespace
@@ -843,7 +908,8 @@ UnwrappedLineFormatter::format(const SmallVectorImpl<AnnotatedLine *> &Lines,
         Penalty += NoLineBreakFormatter(Indenter, Whitespaces, Style, this)
                        .formatLine(TheLine, Indent, DryRun);
       else
-        Penalty += OptimizingLineFormatter(Indenter, Whitespaces, Style, this)
+        Penalty += OptimizingLineFormatter(Indenter, Whitespaces, Style, this,
+                                           Stats)
                        .formatLine(TheLine, Indent, DryRun);
     } else {
       // If no token in the current line is affected, we still need to format
@@ -21,6 +21,7 @@
 #include <map>
 #include <queue>
 #include <string>
+#include <vector>
 
 namespace clang {
 namespace format {
@@ -34,9 +35,10 @@ public:
                          WhitespaceManager *Whitespaces,
                          const FormatStyle &Style,
                          const AdditionalKeywords &Keywords,
-                         bool *IncompleteFormat)
+                         bool *IncompleteFormat,
+                         std::vector<LineBreakingStats> *Stats = nullptr)
       : Indenter(Indenter), Whitespaces(Whitespaces), Style(Style),
-        Keywords(Keywords), IncompleteFormat(IncompleteFormat) {}
+        Keywords(Keywords), IncompleteFormat(IncompleteFormat), Stats(Stats) {}
 
   /// \brief Format the current block and return the penalty.
   unsigned format(const SmallVectorImpl<AnnotatedLine *> &Lines,
@@ -66,6 +68,10 @@ private:
   const FormatStyle &Style;
   const AdditionalKeywords &Keywords;
   bool *IncompleteFormat;
+
+  /// \brief Where to record the cost of searching for line breaks, if
+  /// anywhere.
+  std::vector<LineBreakingStats> *Stats;
 };
 } // end namespace format
 } // end namespace clang
@@ -65,6 +65,8 @@ public:
     TokenSource = this;
     Line.Level = 0;
     Line.InPPDirective = true;
+    FakeEOF.Tok.startToken();
+    FakeEOF.Tok.setKind(tok::eof);
   }
 
   ~ScopedMacroState() override {
@@ -94,16 +96,7 @@ public:
 private:
   bool eof() { return Token && Token->HasUnescapedNewline; }
 
-  FormatToken *getFakeEOF() {
-    static bool EOFInitialized = false;
-    static FormatToken FormatTok;
-    if (!EOFInitialized) {
-      FormatTok.Tok.startToken();
-      FormatTok.Tok.setKind(tok::eof);
-      EOFInitialized = true;
-    }
-    return &FormatTok;
-  }
+  FormatToken *getFakeEOF() { return &FakeEOF; }
 
   UnwrappedLine &Line;
   FormatTokenSource *&TokenSource;
@@ -112,6 +105,9 @@ private:
   FormatTokenSource *PreviousTokenSource;
 
   FormatToken *Token;
+
+  // Not shared between instances, so that several threads can format at once.
+  FormatToken FakeEOF;
 };
 
 } // end anonymous namespace
@@ -26,6 +26,7 @@
 #include "clang/Frontend/FrontendDiagnostic.h"
 #include "clang/Frontend/FrontendOptions.h"
 #include "clang/Frontend/MultiplexConsumer.h"
+#include "clang/Frontend/PreambleCache.h"
 #include "clang/Frontend/Utils.h"
 #include "clang/Lex/HeaderSearch.h"
 #include "clang/Lex/Preprocessor.h"
@@ -34,8 +35,10 @@
 #include "clang/Serialization/ASTReader.h"
 #include "clang/Serialization/ASTWriter.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringSet.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/Support/CrashRecoveryContext.h"
 #include "llvm/Support/Host.h"
 #include "llvm/Support/MemoryBuffer.h"
@@ -47,6 +50,9 @@
 #include <atomic>
 #include <cstdio>
 #include <cstdlib>
+#if LLVM_ENABLE_THREADS
+#include <thread>
+#endif
 using namespace clang;
 
 using llvm::TimeRecord;
@@ -220,8 +226,10 @@ ASTUnit::ASTUnit(bool _MainFileIsAST)
     NumStoredDiagnosticsFromDriver(0),
     PreambleRebuildCounter(0),
     NumWarningsInPreamble(0),
+    SharedPreambleCache(PreambleCache::getDefault()),
     ShouldCacheCodeCompletionResults(false),
     IncludeBriefCommentsInCodeCompletion(false), UserFilesAreVolatile(false),
+    BuildPreambleInBackground(false), ChainPreambles(false),
     CompletionCacheTopLevelHashValue(0),
     PreambleTopLevelHashValue(0),
     CurrentTopLevelHashValue(0),
@@ -238,6 +246,10 @@ ASTUnit::~ASTUnit() {
 
   clearFileLevelDecls();
 
+  // Don't leave a preamble build running behind us.
+  discardBackgroundPreamble();
+  clearChainedPreambleBase();
+
   // Clean up the temporary files and the preamble file.
   removeOnDiskEntry(this);
 
@@ -896,12 +908,19 @@ public:
 };
 
 class PrecompilePreambleAction : public ASTFrontendAction {
-  ASTUnit &Unit;
+  unsigned &Hash;
+  std::vector<serialization::DeclID> &TopLevelDeclIDs;
   bool HasEmittedPreamblePCH;
 
 public:
-  explicit PrecompilePreambleAction(ASTUnit &Unit)
-      : Unit(Unit), HasEmittedPreamblePCH(false) {}
+  /// \param Hash Receives the hash of the top-level declarations and macro
+  /// definitions in the preamble.
+  /// \param TopLevelDeclIDs Receives the IDs of the top-level declarations
+  /// in the precompiled preamble.
+  PrecompilePreambleAction(unsigned &Hash,
+                           std::vector<serialization::DeclID> &TopLevelDeclIDs)
+      : Hash(Hash), TopLevelDeclIDs(TopLevelDeclIDs),
+        HasEmittedPreamblePCH(false) {}
 
   std::unique_ptr<ASTConsumer> CreateASTConsumer(CompilerInstance &CI,
                                                  StringRef InFile) override;
@@ -915,19 +934,20 @@ public:
 };
 
 class PrecompilePreambleConsumer : public PCHGenerator {
-  ASTUnit &Unit;
   unsigned &Hash;
+  std::vector<serialization::DeclID> &TopLevelDeclIDs;
   std::vector<Decl *> TopLevelDecls;
   PrecompilePreambleAction *Action;
   raw_ostream *Out;
 
 public:
-  PrecompilePreambleConsumer(ASTUnit &Unit, PrecompilePreambleAction *Action,
-                             const Preprocessor &PP, StringRef isysroot,
-                             raw_ostream *Out)
+  PrecompilePreambleConsumer(
+      unsigned &Hash, std::vector<serialization::DeclID> &TopLevelDeclIDs,
+      PrecompilePreambleAction *Action, const Preprocessor &PP,
+      StringRef isysroot, raw_ostream *Out)
       : PCHGenerator(PP, "", nullptr, isysroot, std::make_shared<PCHBuffer>(),
                      /*AllowASTWithErrors=*/true),
-        Unit(Unit), Hash(Unit.getCurrentTopLevelHashValue()), Action(Action),
+        Hash(Hash), TopLevelDeclIDs(TopLevelDeclIDs), Action(Action),
         Out(Out) {
     Hash = 0;
   }
@@ -965,7 +985,7 @@ public:
         // Invalid top-level decls may not have been serialized.
         if (D->isInvalidDecl())
           continue;
-        Unit.addTopLevelDeclFromPreamble(getWriter().getDeclID(D));
+        TopLevelDeclIDs.push_back(getWriter().getDeclID(D));
       }
 
       Action->setHasEmittedPreamblePCH();
@@ -989,10 +1009,9 @@ PrecompilePreambleAction::CreateASTConsumer(CompilerInstance &CI,
     Sysroot.clear();
 
   CI.getPreprocessor().addPPCallbacks(
-      llvm::make_unique<MacroDefinitionTrackerPPCallbacks>(
-                                           Unit.getCurrentTopLevelHashValue()));
+      llvm::make_unique<MacroDefinitionTrackerPPCallbacks>(Hash));
   return llvm::make_unique<PrecompilePreambleConsumer>(
-      Unit, this, CI.getPreprocessor(), Sysroot, OS);
+      Hash, TopLevelDeclIDs, this, CI.getPreprocessor(), Sysroot, OS);
 }
 
 static bool isNonDriverDiag(const StoredDiagnostic &StoredDiag) {
@@ -1317,6 +1336,192 @@ makeStandaloneDiagnostic(const LangOptions &LangOpts,
   return OutDiag;
 }
 
+/// \brief Determine whether any of the files a precompiled preamble was built
+/// from has changed since, either on disk or through file remapping.
+static bool anyPreambleFileChanged(
+    FileManager &FileMgr, const PreprocessorOptions &PreprocessorOpts,
+    const llvm::StringMap<ASTUnit::PreambleFileHash> &FilesInPreamble) {
+  // First, make a record of those files that have been overridden via
+  // remapping or unsaved_files.
+  llvm::StringMap<ASTUnit::PreambleFileHash> OverriddenFiles;
+  for (const auto &R : PreprocessorOpts.RemappedFiles) {
+    vfs::Status Status;
+    if (FileMgr.getNoncachedStatValue(R.second, Status)) {
+      // If we can't stat the file we're remapping to, assume that something
+      // horrible happened.
+      return true;
+    }
+
+    OverriddenFiles[R.first] = ASTUnit::PreambleFileHash::createForFile(
+        Status.getSize(), Status.getLastModificationTime().toEpochTime());
+  }
+
+  for (const auto &RB : PreprocessorOpts.RemappedFileBuffers)
+    OverriddenFiles[RB.first] =
+        ASTUnit::PreambleFileHash::createForMemoryBuffer(RB.second);
+
+  // Check whether anything has changed.
+  for (const auto &F : FilesInPreamble) {
+    llvm::StringMap<ASTUnit::PreambleFileHash>::iterator Overridden
+      = OverriddenFiles.find(F.first());
+    if (Overridden != OverriddenFiles.end()) {
+      // This file was remapped; check whether the newly-mapped file 
+      // matches up with the previous mapping.
+      if (Overridden->second != F.second)
+        return true;
+      continue;
+    }
+
+    // The file was not remapped; check whether it has changed on disk.
+    vfs::Status Status;
+    if (FileMgr.getNoncachedStatValue(F.first(), Status)) {
+      // If we can't stat the file, assume that something horrible happened.
+      return true;
+    }
+    if (Status.getSize() != uint64_t(F.second.Size) ||
+        Status.getLastModificationTime().toEpochTime() !=
+            uint64_t(F.second.ModTime))
+      return true;
+  }
+
+  return false;
+}
+
+/// \brief Record the size and modification time, or the contents hash for
+/// remapped buffers, of every file the preamble just built by \p Clang
+/// depends on.
+static void collectPreambleDependencies(
+    CompilerInstance &Clang, const DependencyCollector &DepCollector,
+    llvm::StringMap<ASTUnit::PreambleFileHash> &FilesInPreamble) {
+  SourceManager &SourceMgr = Clang.getSourceManager();
+  for (auto &Filename : DepCollector.getDependencies()) {
+    const FileEntry *File = Clang.getFileManager().getFile(Filename);
+    if (!File || File == SourceMgr.getFileEntryForID(SourceMgr.getMainFileID()))
+      continue;
+    if (time_t ModTime = File->getModificationTime()) {
+      FilesInPreamble[File->getName()] =
+          ASTUnit::PreambleFileHash::createForFile(File->getSize(), ModTime);
+    } else {
+      llvm::MemoryBuffer *Buffer = SourceMgr.getMemoryBufferForFile(File);
+      FilesInPreamble[File->getName()] =
+          ASTUnit::PreambleFileHash::createForMemoryBuffer(Buffer);
+    }
+  }
+}
+
+/// \brief A precompiled preamble built apart from the ASTUnit's own state:
+/// either on a background thread, or as the base of a chained preamble.
+///
+/// The build owns copies of everything it reads, since the ASTUnit may be
+/// reparsed with different remapped files in the meantime, and only touches
+/// the ASTUnit once it is swapped in by \c adoptBackgroundPreamble().
+struct ASTUnit::PreambleBuild {
+  IntrusiveRefCntPtr<CompilerInvocation> Invocation;
+  std::shared_ptr<PCHContainerOperations> PCHContainerOps;
+  std::vector<char> PreambleText;
+  bool PreambleEndsAtStartOfLine;
+  std::unique_ptr<llvm::MemoryBuffer> PreambleBuffer;
+  std::vector<std::unique_ptr<llvm::MemoryBuffer>> RemappedBuffers;
+  IntrusiveRefCntPtr<PreambleCache> Cache;
+  std::string CacheKey;
+  bool WantTiming;
+
+  /// \brief Set by the background thread once the results below are valid.
+  std::atomic<bool> Finished;
+  bool Succeeded;
+  unsigned NumWarnings;
+  unsigned TopLevelHashValue;
+  llvm::StringMap<PreambleFileHash> FilesInPreamble;
+  std::vector<serialization::DeclID> TopLevelDecls;
+  std::vector<StandaloneDiagnostic> Diagnostics;
+
+#if LLVM_ENABLE_THREADS
+  std::thread Thread;
+#endif
+
+  PreambleBuild()
+      : PreambleEndsAtStartOfLine(false), WantTiming(false), Finished(false),
+        Succeeded(false), NumWarnings(0), TopLevelHashValue(0) {}
+
+  StringRef getPCHPath() const {
+    return Invocation->getFrontendOpts().OutputFile;
+  }
+
+  /// \brief Whether this build is for the preamble \p Preamble.
+  bool matches(const ComputedPreamble &Preamble) const {
+    return PreambleText.size() == Preamble.Size &&
+           PreambleEndsAtStartOfLine == Preamble.PreambleEndsAtStartOfLine &&
+           memcmp(PreambleText.data(), Preamble.Buffer->getBufferStart(),
+                  Preamble.Size) == 0;
+  }
+
+  /// \brief Whether this build covers a proper prefix of \p Preamble.
+  bool isPrefixOf(const ComputedPreamble &Preamble) const {
+    return PreambleText.size() < Preamble.Size &&
+           memcmp(PreambleText.data(), Preamble.Buffer->getBufferStart(),
+                  PreambleText.size()) == 0;
+  }
+
+  void run();
+
+  void wait() {
+#if LLVM_ENABLE_THREADS
+    if (Thread.joinable())
+      Thread.join();
+#endif
+  }
+};
+
+/// \brief Find where to split the first \p Size bytes of \p Buffer, a
+/// preamble, into the base and the suffix of a chained preamble.
+///
+/// The split goes at the start of the line holding the last preprocessor
+/// directive that is not nested within a conditional, so that both parts
+/// are self-contained.
+///
+/// \returns the offset of the split, or 0 if the preamble holds fewer than
+/// two such directives.
+static unsigned findChainedPreambleSplit(const llvm::MemoryBuffer &Buffer,
+                                         unsigned Size,
+                                         const LangOptions &LangOpts) {
+  Lexer TheLexer(SourceLocation(), LangOpts, Buffer.getBufferStart(),
+                 Buffer.getBufferStart(), Buffer.getBufferEnd());
+  unsigned Split = 0;
+  bool SeenDirective = false;
+  unsigned IfCount = 0;
+  Token Tok;
+  while (true) {
+    TheLexer.LexFromRawLexer(Tok);
+    if (Tok.is(tok::eof))
+      break;
+    unsigned Offset = Tok.getLocation().getRawEncoding();
+    if (Offset >= Size)
+      break;
+    if (Tok.isNot(tok::hash) || !Tok.isAtStartOfLine())
+      continue;
+
+    if (IfCount == 0) {
+      if (SeenDirective) {
+        Split = Offset;
+        while (Split > 0 && (Buffer.getBufferStart()[Split - 1] == ' ' ||
+                             Buffer.getBufferStart()[Split - 1] == '\t'))
+          --Split;
+      }
+      SeenDirective = true;
+    }
+
+    TheLexer.LexFromRawLexer(Tok);
+    if (Tok.isNot(tok::raw_identifier))
+      continue;
+    StringRef Keyword = Tok.getRawIdentifier();
+    if (Keyword == "if" || Keyword == "ifdef" || Keyword == "ifndef")
+      ++IfCount;
+    else if (Keyword == "endif" && IfCount > 0)
+      --IfCount;
+  }
+  return Split;
+}
+
 /// \brief Attempt to build or re-use a precompiled preamble when (re-)parsing
 /// the source file.
 ///
@@ -1356,12 +1561,18 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
     // preamble, if we have one. It's obviously no good any more.
     Preamble.clear();
     erasePreambleFile(this);
+    clearChainedPreambleBase();
 
     // The next time we actually see a preamble, precompile it.
     PreambleRebuildCounter = 1;
     return nullptr;
   }
-  
+
+  // Swap in a preamble that has finished building in the background. Code
+  // completion runs against the current AST, so only do this when reparsing.
+  if (AllowRebuild && BackgroundPreamble && BackgroundPreamble->Finished)
+    adoptBackgroundPreamble(NewPreamble);
+
   if (!Preamble.empty()) {
     // We've previously computed a preamble. Check whether we have the same
     // preamble now that we did before, and that there's enough space in
@@ -1375,61 +1586,8 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
       // preamble.
 
       // Check that none of the files used by the preamble have changed.
-      bool AnyFileChanged = false;
-          
-      // First, make a record of those files that have been overridden via
-      // remapping or unsaved_files.
-      llvm::StringMap<PreambleFileHash> OverriddenFiles;
-      for (const auto &R : PreprocessorOpts.RemappedFiles) {
-        if (AnyFileChanged)
-          break;
-
-        vfs::Status Status;
-        if (FileMgr->getNoncachedStatValue(R.second, Status)) {
-          // If we can't stat the file we're remapping to, assume that something
-          // horrible happened.
-          AnyFileChanged = true;
-          break;
-        }
-
-        OverriddenFiles[R.first] = PreambleFileHash::createForFile(
-            Status.getSize(), Status.getLastModificationTime().toEpochTime());
-      }
-
-      for (const auto &RB : PreprocessorOpts.RemappedFileBuffers) {
-        if (AnyFileChanged)
-          break;
-        OverriddenFiles[RB.first] =
-            PreambleFileHash::createForMemoryBuffer(RB.second);
-      }
-       
-      // Check whether anything has changed.
-      for (llvm::StringMap<PreambleFileHash>::iterator 
-             F = FilesInPreamble.begin(), FEnd = FilesInPreamble.end();
-           !AnyFileChanged && F != FEnd; 
-           ++F) {
-        llvm::StringMap<PreambleFileHash>::iterator Overridden
-          = OverriddenFiles.find(F->first());
-        if (Overridden != OverriddenFiles.end()) {
-          // This file was remapped; check whether the newly-mapped file 
-          // matches up with the previous mapping.
-          if (Overridden->second != F->second)
-            AnyFileChanged = true;
-          continue;
-        }
-        
-        // The file was not remapped; check whether it has changed on disk.
-        vfs::Status Status;
-        if (FileMgr->getNoncachedStatValue(F->first(), Status)) {
-          // If we can't stat the file, assume that something horrible happened.
-          AnyFileChanged = true;
-        } else if (Status.getSize() != uint64_t(F->second.Size) ||
-                   Status.getLastModificationTime().toEpochTime() !=
-                       uint64_t(F->second.ModTime))
-          AnyFileChanged = true;
-      }
-          
-      if (!AnyFileChanged) {
+      if (!anyPreambleFileChanged(*FileMgr, PreprocessorOpts,
+                                  FilesInPreamble)) {
         // Okay! We can re-use the precompiled preamble.
 
         // Set the state of the diagnostic object to mimic its state
@@ -1442,6 +1600,24 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
         return llvm::MemoryBuffer::getMemBufferCopy(
             NewPreamble.Buffer->getBuffer(), FrontendOpts.Inputs[0].getFile());
       }
+
+      if (BuildPreambleInBackground) {
+        // Some header included by the preamble has changed. Keep using the
+        // old precompiled preamble, which the main file still matches, until
+        // a new one has been built. Its PCH is not validated when loaded.
+        if (AllowRebuild && !(BackgroundPreamble &&
+                              BackgroundPreamble->matches(NewPreamble)))
+          startBackgroundPreambleBuild(PCHContainerOps, *PreambleInvocation,
+                                       NewPreamble);
+
+        getDiagnostics().Reset();
+        ProcessWarningOptions(getDiagnostics(), 
+                              PreambleInvocation->getDiagnosticOpts());
+        getDiagnostics().setNumWarnings(NumWarningsInPreamble);
+
+        return llvm::MemoryBuffer::getMemBufferCopy(
+            NewPreamble.Buffer->getBuffer(), FrontendOpts.Inputs[0].getFile());
+      }
     }
 
     // If we aren't allowed to rebuild the precompiled preamble, just
@@ -1449,6 +1625,35 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
     if (!AllowRebuild)
       return nullptr;
 
+    if (BuildPreambleInBackground) {
+      // The preamble itself has changed; build the new one in the background.
+      if (!(BackgroundPreamble && BackgroundPreamble->matches(NewPreamble)))
+        startBackgroundPreambleBuild(PCHContainerOps, *PreambleInvocation,
+                                     NewPreamble);
+
+      // If the old preamble is still a prefix of the new one, for instance
+      // because an #include was added after it, keep using its precompiled
+      // preamble for that prefix and parse the rest of the main file.
+      if (PreambleEndsAtStartOfLine && Preamble.size() < NewPreamble.Size &&
+          memcmp(Preamble.getBufferStart(),
+                 NewPreamble.Buffer->getBufferStart(), Preamble.size()) == 0) {
+        getDiagnostics().Reset();
+        ProcessWarningOptions(getDiagnostics(), 
+                              PreambleInvocation->getDiagnosticOpts());
+        getDiagnostics().setNumWarnings(NumWarningsInPreamble);
+
+        return llvm::MemoryBuffer::getMemBufferCopy(
+            NewPreamble.Buffer->getBuffer(), FrontendOpts.Inputs[0].getFile());
+      }
+
+      // Otherwise the old precompiled preamble is of no use. Parse without
+      // one until the new one has been built.
+      Preamble.clear();
+      PreambleDiagnostics.clear();
+      erasePreambleFile(this);
+      return nullptr;
+    }
+
     // We can't reuse the previously-computed preamble. Build a new one.
     Preamble.clear();
     PreambleDiagnostics.clear();
@@ -1458,6 +1663,26 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
     // We aren't allowed to rebuild the precompiled preamble; just
     // return now.
     return nullptr;
+  } else if (BuildPreambleInBackground && BackgroundPreamble) {
+    // A preamble is already being built in the background. Parse without
+    // one until it is ready instead of building another one here.
+    if (!BackgroundPreamble->matches(NewPreamble))
+      startBackgroundPreambleBuild(PCHContainerOps, *PreambleInvocation,
+                                   NewPreamble);
+    return nullptr;
+  }
+
+  // Another ASTUnit, possibly in another process, may already have
+  // precompiled this preamble.
+  std::string PreambleCacheKey;
+  if (SharedPreambleCache) {
+    PreambleCacheKey = PreambleCache::getKey(
+        *PreambleInvocation, FrontendOpts.Inputs[0].getFile(),
+        NewPreamble.Buffer->getBuffer().slice(0, NewPreamble.Size),
+        NewPreamble.PreambleEndsAtStartOfLine);
+    if (std::unique_ptr<llvm::MemoryBuffer> Buffer = loadPreambleFromCache(
+            PreambleCacheKey, NewPreamble, *PreambleInvocation))
+      return Buffer;
   }
 
   // If the preamble rebuild counter > 1, it's because we previously
@@ -1481,6 +1706,25 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
   SimpleTimer PreambleTimer(WantTiming);
   PreambleTimer.setOutput("Precompiling preamble");
 
+  // When chaining preambles, everything before the last top-level directive
+  // of the preamble is precompiled separately, and the precompiled preamble
+  // built below only covers the rest. The base can be reused as long as it
+  // is still a prefix of the preamble and none of its files have changed.
+  if (ChainedPreambleBase &&
+      (!ChainPreambles || !ChainedPreambleBase->isPrefixOf(NewPreamble) ||
+       anyPreambleFileChanged(*FileMgr, PreprocessorOpts,
+                              ChainedPreambleBase->FilesInPreamble)))
+    clearChainedPreambleBase();
+  if (ChainedPreambleBase) {
+    PreambleTimer.setOutput("Precompiling preamble suffix");
+  } else if (ChainPreambles) {
+    if (unsigned BaseSize = findChainedPreambleSplit(
+            *NewPreamble.Buffer, NewPreamble.Size,
+            PreambleInvocation->getLangOpts()))
+      buildChainedPreambleBase(PCHContainerOps, *PreambleInvocation,
+                               NewPreamble, BaseSize);
+  }
+
   // Save the preamble text for later; we'll need to compare against it for
   // subsequent reparses.
   StringRef MainFilename = FrontendOpts.Inputs[0].getFile();
@@ -1500,8 +1744,17 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
   FrontendOpts.ProgramAction = frontend::GeneratePCH;
   // FIXME: Generate the precompiled header into memory?
   FrontendOpts.OutputFile = PreamblePCHPath;
-  PreprocessorOpts.PrecompiledPreambleBytes.first = 0;
-  PreprocessorOpts.PrecompiledPreambleBytes.second = false;
+  if (ChainedPreambleBase) {
+    // Chain onto the base, skipping the part of the preamble it covers.
+    PreprocessorOpts.PrecompiledPreambleBytes.first =
+        ChainedPreambleBase->PreambleText.size();
+    PreprocessorOpts.PrecompiledPreambleBytes.second = true;
+    PreprocessorOpts.ImplicitPCHInclude = ChainedPreambleBase->getPCHPath();
+    PreprocessorOpts.DisablePCHValidation = true;
+  } else {
+    PreprocessorOpts.PrecompiledPreambleBytes.first = 0;
+    PreprocessorOpts.PrecompiledPreambleBytes.second = false;
+  }
   
   // Create the compiler instance to use for building the precompiled preamble.
   std::unique_ptr<CompilerInstance> Clang(
@@ -1565,7 +1818,8 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
   Clang->addDependencyCollector(PreambleDepCollector);
 
   std::unique_ptr<PrecompilePreambleAction> Act;
-  Act.reset(new PrecompilePreambleAction(*this));
+  Act.reset(new PrecompilePreambleAction(CurrentTopLevelHashValue,
+                                         TopLevelDeclsInPreamble));
   if (!Act->BeginSourceFile(*Clang.get(), Clang->getFrontendOpts().Inputs[0])) {
     llvm::sys::fs::remove(FrontendOpts.OutputFile);
     Preamble.clear();
@@ -1607,24 +1861,40 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
   // Keep track of all of the files that the source manager knows about,
   // so we can verify whether they have changed or not.
   FilesInPreamble.clear();
-  SourceManager &SourceMgr = Clang->getSourceManager();
-  for (auto &Filename : PreambleDepCollector->getDependencies()) {
-    const FileEntry *File = Clang->getFileManager().getFile(Filename);
-    if (!File || File == SourceMgr.getFileEntryForID(SourceMgr.getMainFileID()))
-      continue;
-    if (time_t ModTime = File->getModificationTime()) {
-      FilesInPreamble[File->getName()] = PreambleFileHash::createForFile(
-          File->getSize(), ModTime);
-    } else {
-      llvm::MemoryBuffer *Buffer = SourceMgr.getMemoryBufferForFile(File);
-      FilesInPreamble[File->getName()] =
-          PreambleFileHash::createForMemoryBuffer(Buffer);
-    }
-  }
+  collectPreambleDependencies(*Clang, *PreambleDepCollector, FilesInPreamble);
 
   PreambleRebuildCounter = 1;
   PreprocessorOpts.RemappedFileBuffers.pop_back();
 
+  if (ChainedPreambleBase) {
+    // The precompiled preamble also provides everything in its base.
+    for (const auto &F : ChainedPreambleBase->FilesInPreamble)
+      FilesInPreamble[F.first()] = F.second;
+    TopLevelDeclsInPreamble.insert(TopLevelDeclsInPreamble.begin(),
+                                   ChainedPreambleBase->TopLevelDecls.begin(),
+                                   ChainedPreambleBase->TopLevelDecls.end());
+    PreambleDiagnostics.insert(PreambleDiagnostics.begin(),
+                               ChainedPreambleBase->Diagnostics.begin(),
+                               ChainedPreambleBase->Diagnostics.end());
+    NumWarningsInPreamble += ChainedPreambleBase->NumWarnings;
+    CurrentTopLevelHashValue = llvm::hash_combine(
+        ChainedPreambleBase->TopLevelHashValue, CurrentTopLevelHashValue);
+  }
+
+  // A chained preamble refers to its base by path, so it can't be shared.
+  if (SharedPreambleCache && !ChainedPreambleBase) {
+    PreambleCache::Entry CacheEntry;
+    CacheEntry.NumWarnings = NumWarningsInPreamble;
+    CacheEntry.TopLevelHashValue = CurrentTopLevelHashValue;
+    for (const auto &F : FilesInPreamble)
+      CacheEntry.Files[F.first()] = F.second;
+    CacheEntry.TopLevelDecls = TopLevelDeclsInPreamble;
+    CacheEntry.Diagnostics.assign(PreambleDiagnostics.begin(),
+                                  PreambleDiagnostics.end());
+    SharedPreambleCache->store(PreambleCacheKey, CacheEntry,
+                               FrontendOpts.OutputFile);
+  }
+
   // If the hash of top-level entities differs from the hash of the top-level
   // entities the last time we rebuilt the preamble, clear out the completion
   // cache.
@@ -1637,6 +1907,354 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
                                               MainFilename);
 }
 
+/// \brief Try to satisfy a preamble rebuild from the on-disk preamble cache.
+///
+/// \returns the main-file buffer to parse with the cached preamble, or null
+/// if the cache has no usable entry for \p Key.
+std::unique_ptr<llvm::MemoryBuffer>
+ASTUnit::loadPreambleFromCache(StringRef Key,
+                               const ComputedPreamble &NewPreamble,
+                               const CompilerInvocation &PreambleInvocation) {
+  PreambleCache::Entry Cached;
+  if (!SharedPreambleCache->lookup(Key, Cached))
+    return nullptr;
+
+  // The cache key does not cover the headers the preamble includes; make sure
+  // none of them has changed since the entry was stored.
+  if (anyPreambleFileChanged(*FileMgr, PreambleInvocation.getPreprocessorOpts(),
+                             Cached.Files))
+    return nullptr;
+
+  std::string PreamblePCHPath = GetPreamblePCHPath();
+  if (PreamblePCHPath.empty())
+    return nullptr;
+
+  SimpleTimer PreambleTimer(WantTiming);
+  PreambleTimer.setOutput("Loading cached preamble");
+
+  if (!SharedPreambleCache->retrievePCH(Key, PreamblePCHPath)) {
+    llvm::sys::fs::remove(PreamblePCHPath);
+    return nullptr;
+  }
+
+  StringRef MainFilename =
+      PreambleInvocation.getFrontendOpts().Inputs[0].getFile();
+  Preamble.assign(FileMgr->getFile(MainFilename),
+                  NewPreamble.Buffer->getBufferStart(),
+                  NewPreamble.Buffer->getBufferStart() + NewPreamble.Size);
+  PreambleEndsAtStartOfLine = NewPreamble.PreambleEndsAtStartOfLine;
+  PreambleBuffer = llvm::MemoryBuffer::getMemBufferCopy(
+      NewPreamble.Buffer->getBuffer().slice(0, Preamble.size()), MainFilename);
+  OriginalSourceFile = MainFilename;
+  setPreambleFile(this, PreamblePCHPath);
+  clearChainedPreambleBase();
+
+  // Restore the state we would have after precompiling the preamble.
+  checkAndRemoveNonDriverDiags(StoredDiagnostics);
+  TopLevelDecls.clear();
+  TopLevelDeclsInPreamble = std::move(Cached.TopLevelDecls);
+  PreambleDiagnostics.assign(Cached.Diagnostics.begin(),
+                             Cached.Diagnostics.end());
+  FilesInPreamble.clear();
+  for (const auto &F : Cached.Files)
+    FilesInPreamble[F.first()] = F.second;
+
+  NumWarningsInPreamble = Cached.NumWarnings;
+  getDiagnostics().Reset();
+  ProcessWarningOptions(getDiagnostics(),
+                        PreambleInvocation.getDiagnosticOpts());
+  getDiagnostics().setNumWarnings(NumWarningsInPreamble);
+
+  PreambleRebuildCounter = 1;
+
+  CurrentTopLevelHashValue = Cached.TopLevelHashValue;
+  if (CurrentTopLevelHashValue != PreambleTopLevelHashValue) {
+    CompletionCacheTopLevelHashValue = 0;
+    PreambleTopLevelHashValue = CurrentTopLevelHashValue;
+  }
+
+  return llvm::MemoryBuffer::getMemBufferCopy(NewPreamble.Buffer->getBuffer(),
+                                              MainFilename);
+}
+
+void ASTUnit::PreambleBuild::run() {
+  SimpleTimer PreambleTimer(WantTiming);
+  PreambleTimer.setOutput("Precompiling preamble in the background");
+
+  std::unique_ptr<CompilerInstance> Clang(
+      new CompilerInstance(PCHContainerOps));
+  Clang->setInvocation(&*Invocation);
+
+  // Capture the diagnostics separately from the ASTUnit's.
+  SmallVector<StoredDiagnostic, 4> StoredDiags;
+  Clang->createDiagnostics(new StoredDiagnosticConsumer(StoredDiags));
+
+  Clang->setTarget(TargetInfo::CreateTargetInfo(
+      Clang->getDiagnostics(), Clang->getInvocation().TargetOpts));
+  IntrusiveRefCntPtr<vfs::FileSystem> VFS;
+  if (Clang->hasTarget()) {
+    Clang->getTarget().adjust(Clang->getLangOpts());
+    VFS = createVFSFromCompilerInvocation(Clang->getInvocation(),
+                                          Clang->getDiagnostics());
+  }
+  if (!VFS) {
+    llvm::sys::fs::remove(getPCHPath());
+    Finished = true;
+    return;
+  }
+
+  Clang->setFileManager(new FileManager(Clang->getFileSystemOpts(), VFS));
+  Clang->setSourceManager(new SourceManager(Clang->getDiagnostics(),
+                                            Clang->getFileManager()));
+
+  auto PreambleDepCollector = std::make_shared<DependencyCollector>();
+  Clang->addDependencyCollector(PreambleDepCollector);
+
+  PrecompilePreambleAction Act(TopLevelHashValue, TopLevelDecls);
+  if (!Act.BeginSourceFile(*Clang, Clang->getFrontendOpts().Inputs[0])) {
+    llvm::sys::fs::remove(getPCHPath());
+    Finished = true;
+    return;
+  }
+
+  Act.Execute();
+  for (const StoredDiagnostic &D : StoredDiags)
+    Diagnostics.push_back(makeStandaloneDiagnostic(Clang->getLangOpts(), D));
+  Act.EndSourceFile();
+
+  if (!Act.hasEmittedPreamblePCH()) {
+    llvm::sys::fs::remove(getPCHPath());
+    Finished = true;
+    return;
+  }
+
+  NumWarnings = Clang->getDiagnostics().getNumWarnings();
+  collectPreambleDependencies(*Clang, *PreambleDepCollector, FilesInPreamble);
+
+  if (Cache) {
+    PreambleCache::Entry CacheEntry;
+    CacheEntry.NumWarnings = NumWarnings;
+    CacheEntry.TopLevelHashValue = TopLevelHashValue;
+    for (const auto &F : FilesInPreamble)
+      CacheEntry.Files[F.first()] = F.second;
+    CacheEntry.TopLevelDecls = TopLevelDecls;
+    CacheEntry.Diagnostics = Diagnostics;
+    Cache->store(CacheKey, CacheEntry, getPCHPath());
+  }
+
+  Succeeded = true;
+  Finished = true;
+}
+
+/// \brief Set up a build of the preamble made of the first \p Size bytes of
+/// \p MainBuffer into the PCH file \p PCHPath.
+std::unique_ptr<ASTUnit::PreambleBuild> ASTUnit::createPreambleBuild(
+    std::shared_ptr<PCHContainerOperations> PCHContainerOps,
+    const CompilerInvocation &PreambleInvocation,
+    const llvm::MemoryBuffer &MainBuffer, unsigned Size,
+    bool EndsAtStartOfLine, StringRef PCHPath) {
+  std::unique_ptr<PreambleBuild> Build(new PreambleBuild);
+  Build->Invocation = new CompilerInvocation(PreambleInvocation);
+  Build->PCHContainerOps = PCHContainerOps;
+  Build->PreambleText.assign(MainBuffer.getBufferStart(),
+                             MainBuffer.getBufferStart() + Size);
+  Build->PreambleEndsAtStartOfLine = EndsAtStartOfLine;
+
+  FrontendOptions &FrontendOpts = Build->Invocation->getFrontendOpts();
+  PreprocessorOptions &PreprocessorOpts =
+      Build->Invocation->getPreprocessorOpts();
+  StringRef MainFilePath = FrontendOpts.Inputs[0].getFile();
+
+  // The remapped buffers belong to the ASTUnit, which frees them on the next
+  // reparse; give the build its own copies.
+  for (auto &RB : PreprocessorOpts.RemappedFileBuffers) {
+    Build->RemappedBuffers.push_back(llvm::MemoryBuffer::getMemBufferCopy(
+        RB.second->getBuffer(), RB.second->getBufferIdentifier()));
+    RB.second = Build->RemappedBuffers.back().get();
+  }
+  PreprocessorOpts.RetainRemappedFileBuffers = true;
+
+  // Remap the main source file to the preamble buffer.
+  Build->PreambleBuffer = llvm::MemoryBuffer::getMemBufferCopy(
+      MainBuffer.getBuffer().slice(0, Size), MainFilePath);
+  PreprocessorOpts.addRemappedFile(MainFilePath, Build->PreambleBuffer.get());
+
+  // Tell the compiler invocation to generate a temporary precompiled header.
+  FrontendOpts.ProgramAction = frontend::GeneratePCH;
+  FrontendOpts.OutputFile = PCHPath;
+  PreprocessorOpts.PrecompiledPreambleBytes.first = 0;
+  PreprocessorOpts.PrecompiledPreambleBytes.second = false;
+
+  return Build;
+}
+
+void ASTUnit::startBackgroundPreambleBuild(
+    std::shared_ptr<PCHContainerOperations> PCHContainerOps,
+    const CompilerInvocation &PreambleInvocation,
+    const ComputedPreamble &NewPreamble) {
+  if (BackgroundPreamble) {
+    // Don't wait for an outdated build to finish; start over on a later
+    // reparse instead.
+    if (!BackgroundPreamble->Finished)
+      return;
+    discardBackgroundPreamble();
+  }
+
+  // If a preamble build failed recently, don't try again right away.
+  if (PreambleRebuildCounter > 1) {
+    --PreambleRebuildCounter;
+    return;
+  }
+
+  std::string PreamblePCHPath = GetPreamblePCHPath();
+  if (PreamblePCHPath.empty())
+    return;
+
+  std::unique_ptr<PreambleBuild> Build = createPreambleBuild(
+      PCHContainerOps, PreambleInvocation, *NewPreamble.Buffer,
+      NewPreamble.Size, NewPreamble.PreambleEndsAtStartOfLine,
+      PreamblePCHPath);
+  Build->WantTiming = WantTiming;
+
+  if (SharedPreambleCache) {
+    Build->Cache = SharedPreambleCache;
+    Build->CacheKey = PreambleCache::getKey(
+        PreambleInvocation,
+        PreambleInvocation.getFrontendOpts().Inputs[0].getFile(),
+        NewPreamble.Buffer->getBuffer().slice(0, NewPreamble.Size),
+        NewPreamble.PreambleEndsAtStartOfLine);
+  }
+
+  BackgroundPreamble = std::move(Build);
+#if LLVM_ENABLE_THREADS
+  PreambleBuild *B = BackgroundPreamble.get();
+  BackgroundPreamble->Thread = std::thread([B] {
+    llvm::CrashRecoveryContext CRC;
+    if (!CRC.RunSafely([B] { B->run(); })) {
+      llvm::sys::fs::remove(B->getPCHPath());
+      B->Succeeded = false;
+      B->Finished = true;
+    }
+  });
+#else
+  // Without threads, build the preamble now; it is swapped in by the next
+  // reparse.
+  BackgroundPreamble->run();
+#endif
+}
+
+void ASTUnit::adoptBackgroundPreamble(const ComputedPreamble &NewPreamble) {
+  std::unique_ptr<PreambleBuild> Build =
+      std::move(BackgroundPreamble);
+  Build->wait();
+
+  if (!Build->Succeeded) {
+    PreambleRebuildCounter = DefaultPreambleRebuildInterval;
+    return;
+  }
+
+  // The main file may have changed again while the preamble was being built.
+  if (!Build->matches(NewPreamble)) {
+    llvm::sys::fs::remove(Build->getPCHPath());
+    return;
+  }
+
+  SimpleTimer PreambleTimer(WantTiming);
+  PreambleTimer.setOutput("Swapping in background preamble");
+
+  erasePreambleFile(this);
+  StringRef MainFilename = Build->Invocation->getFrontendOpts().Inputs[0]
+                               .getFile();
+  Preamble.assign(FileMgr->getFile(MainFilename),
+                  Build->PreambleText.data(),
+                  Build->PreambleText.data() + Build->PreambleText.size());
+  PreambleEndsAtStartOfLine = Build->PreambleEndsAtStartOfLine;
+  PreambleBuffer = std::move(Build->PreambleBuffer);
+  OriginalSourceFile = MainFilename;
+  setPreambleFile(this, Build->getPCHPath());
+  clearChainedPreambleBase();
+
+  checkAndRemoveNonDriverDiags(StoredDiagnostics);
+  TopLevelDecls.clear();
+  TopLevelDeclsInPreamble = std::move(Build->TopLevelDecls);
+  PreambleDiagnostics.assign(Build->Diagnostics.begin(),
+                             Build->Diagnostics.end());
+  FilesInPreamble.clear();
+  for (const auto &F : Build->FilesInPreamble)
+    FilesInPreamble[F.first()] = F.second;
+  NumWarningsInPreamble = Build->NumWarnings;
+  PreambleRebuildCounter = 1;
+
+  CurrentTopLevelHashValue = Build->TopLevelHashValue;
+  if (CurrentTopLevelHashValue != PreambleTopLevelHashValue) {
+    CompletionCacheTopLevelHashValue = 0;
+    PreambleTopLevelHashValue = CurrentTopLevelHashValue;
+  }
+}
+
+void ASTUnit::discardBackgroundPreamble() {
+  if (!BackgroundPreamble)
+    return;
+  BackgroundPreamble->wait();
+  if (BackgroundPreamble->Succeeded)
+    llvm::sys::fs::remove(BackgroundPreamble->getPCHPath());
+  BackgroundPreamble.reset();
+}
+
+/// \brief Precompile the first \p BaseSize bytes of \p NewPreamble as the
+/// base that the rest of the preamble is chained onto.
+void ASTUnit::buildChainedPreambleBase(
+    std::shared_ptr<PCHContainerOperations> PCHContainerOps,
+    const CompilerInvocation &PreambleInvocation,
+    const ComputedPreamble &NewPreamble, unsigned BaseSize) {
+  std::string BasePCHPath = GetPreamblePCHPath();
+  if (BasePCHPath.empty())
+    return;
+
+  std::unique_ptr<PreambleBuild> Build = createPreambleBuild(
+      PCHContainerOps, PreambleInvocation, *NewPreamble.Buffer, BaseSize,
+      /*EndsAtStartOfLine=*/true, BasePCHPath);
+  Build->run();
+  if (Build->Succeeded)
+    ChainedPreambleBase = std::move(Build);
+}
+
+void ASTUnit::clearChainedPreambleBase() {
+  if (!ChainedPreambleBase)
+    return;
+  llvm::sys::fs::remove(ChainedPreambleBase->getPCHPath());
+  ChainedPreambleBase.reset();
+}
+
+/// \brief Returns the file ID of the main file as loaded from the base of a
+/// chained preamble, or an invalid file ID if the preamble is not chained.
+FileID ASTUnit::getPreambleBaseFileID() const {
+  if (!ChainedPreambleBase || !Reader)
+    return FileID();
+
+  serialization::ModuleFile *Primary =
+      &Reader->getModuleManager().getPrimaryModule();
+  for (serialization::ModuleFile *M : Reader->getModuleManager()) {
+    if (M != Primary && M->Kind == serialization::MK_Preamble &&
+        M->FileName == ChainedPreambleBase->getPCHPath())
+      return M->OriginalSourceFileID;
+  }
+  return FileID();
+}
+
+void ASTUnit::waitForBackgroundPreamble() {
+  if (BackgroundPreamble)
+    BackgroundPreamble->wait();
+}
+
+void ASTUnit::setPreambleCache(IntrusiveRefCntPtr<PreambleCache> Cache) {
+  SharedPreambleCache = Cache;
+}
+
+PreambleCache *ASTUnit::getPreambleCache() const {
+  return SharedPreambleCache.get();
+}
+
 void ASTUnit::RealizeTopLevelDeclsFromPreamble() {
   std::vector<Decl *> Resolved;
   Resolved.reserve(TopLevelDeclsInPreamble.size());
@@ -2670,8 +3288,11 @@ SourceLocation ASTUnit::mapLocationFromPreamble(SourceLocation Loc) {
   if (Loc.isInvalid() || Preamble.empty() || PreambleID.isInvalid())
     return Loc;
 
+  FileID BaseID = getPreambleBaseFileID();
   unsigned Offs;
-  if (SourceMgr->isInFileID(Loc, PreambleID, &Offs) && Offs < Preamble.size()) {
+  if ((SourceMgr->isInFileID(Loc, PreambleID, &Offs) ||
+       (BaseID.isValid() && SourceMgr->isInFileID(Loc, BaseID, &Offs))) &&
+      Offs < Preamble.size()) {
     SourceLocation FileLoc
         = SourceMgr->getLocForStartOfFile(SourceMgr->getMainFileID());
     return FileLoc.getLocWithOffset(Offs);
@@ -2694,6 +3315,11 @@ SourceLocation ASTUnit::mapLocationToPreamble(SourceLocation Loc) {
   unsigned Offs;
   if (SourceMgr->isInFileID(Loc, SourceMgr->getMainFileID(), &Offs) &&
       Offs < Preamble.size()) {
+    // The part of a chained preamble covered by its base was lexed from the
+    // main file as loaded from the base.
+    FileID BaseID = getPreambleBaseFileID();
+    if (BaseID.isValid() && Offs < ChainedPreambleBase->PreambleText.size())
+      PreambleID = BaseID;
     SourceLocation FileLoc = SourceMgr->getLocForStartOfFile(PreambleID);
     return FileLoc.getLocWithOffset(Offs);
   }
@@ -2709,7 +3335,12 @@ bool ASTUnit::isInPreambleFileID(SourceLocation Loc) {
   if (Loc.isInvalid() || FID.isInvalid())
     return false;
   
-  return SourceMgr->isInFileID(Loc, FID);
+  if (SourceMgr->isInFileID(Loc, FID))
+    return true;
+
+  // The start of a chained preamble was loaded from its base.
+  FileID BaseID = getPreambleBaseFileID();
+  return BaseID.isValid() && SourceMgr->isInFileID(Loc, BaseID);
 }
 
 bool ASTUnit::isInMainFileID(SourceLocation Loc) {
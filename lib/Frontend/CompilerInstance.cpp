@@ -15,6 +15,7 @@
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Basic/TargetInfo.h"
+#include "clang/Basic/TimeTrace.h"
 #include "clang/Basic/Version.h"
 #include "clang/Config/config.h"
 #include "clang/Frontend/ChainedDiagnosticConsumer.h"
@@ -27,13 +28,17 @@
 #include "clang/Frontend/Utils.h"
 #include "clang/Frontend/VerifyDiagnosticConsumer.h"
 #include "clang/Lex/HeaderSearch.h"
+#include "clang/Lex/Lexer.h"
 #include "clang/Lex/PTHManager.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Sema/CodeCompleteConsumer.h"
 #include "clang/Sema/Sema.h"
+#include "clang/Sema/TemplateInstantiationStats.h"
 #include "clang/Serialization/ASTReader.h"
 #include "clang/Serialization/GlobalModuleIndex.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/Statistic.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/Support/CrashRecoveryContext.h"
 #include "llvm/Support/Errc.h"
 #include "llvm/Support/FileSystem.h"
@@ -48,6 +53,11 @@
 #include <sys/stat.h>
 #include <system_error>
 #include <time.h>
+#if LLVM_ENABLE_THREADS
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
 
 using namespace clang;
 
@@ -367,6 +377,9 @@ void CompilerInstance::createPreprocessor(TranslationUnitKind TUKind) {
     AttachHeaderIncludeGen(*PP, /*ShowAllHeaders=*/false, /*OutputPath=*/"",
                            /*ShowDepth=*/true, /*MSStyle=*/true);
   }
+
+  if (timeTraceProfilerEnabled())
+    AttachTimeTraceCallbacks(*PP);
 }
 
 std::string CompilerInstance::getSpecificModuleCachePath() {
@@ -401,7 +414,7 @@ void CompilerInstance::createPCHExternalASTSource(
       AllowPCHWithCompilerErrors, getPreprocessor(), getASTContext(),
       *getPCHContainerOperations(), DeserializationListener,
       OwnDeserializationListener, Preamble,
-      getFrontendOpts().UseGlobalModuleIndex);
+      getFrontendOpts().UseGlobalModuleIndex, getFrontendOpts().ShowStats);
 }
 
 IntrusiveRefCntPtr<ASTReader> CompilerInstance::createPCHExternalASTSource(
@@ -409,7 +422,7 @@ IntrusiveRefCntPtr<ASTReader> CompilerInstance::createPCHExternalASTSource(
     bool AllowPCHWithCompilerErrors, Preprocessor &PP, ASTContext &Context,
     const PCHContainerOperations &PCHContainerOps,
     void *DeserializationListener, bool OwnDeserializationListener,
-    bool Preamble, bool UseGlobalModuleIndex) {
+    bool Preamble, bool UseGlobalModuleIndex, bool TimeStats) {
   HeaderSearchOptions &HSOpts = PP.getHeaderSearchInfo().getHeaderSearchOpts();
 
   IntrusiveRefCntPtr<ASTReader> Reader(new ASTReader(
@@ -417,6 +430,7 @@ IntrusiveRefCntPtr<ASTReader> CompilerInstance::createPCHExternalASTSource(
       DisablePCHValidation, AllowPCHWithCompilerErrors,
       /*AllowConfigurationMismatch*/ false, HSOpts.ModulesValidateSystemHeaders,
       UseGlobalModuleIndex));
+  Reader->setTimeStats(TimeStats);
 
   // We need the external source to be set up before we read the AST, because
   // eagerly-deserialized declarations may use it.
@@ -520,6 +534,9 @@ void CompilerInstance::createSema(TranslationUnitKind TUKind,
                                   CodeCompleteConsumer *CompletionConsumer) {
   TheSema.reset(new Sema(getPreprocessor(), getASTContext(), getASTConsumer(),
                          TUKind, CompletionConsumer));
+  if (!getFrontendOpts().TemplateInstantiationReport.empty())
+    TheSema->TemplateInstStats.reset(
+        new TemplateInstantiationStats(getASTContext()));
 }
 
 // Output Files
@@ -861,19 +878,19 @@ static InputKind getSourceInputKindFromOptions(const LangOptions &LangOpts) {
   return LangOpts.CPlusPlus? IK_CXX : IK_C;
 }
 
-/// \brief Compile a module file for the given module, using the options 
-/// provided by the importing compiler instance. Returns true if the module
-/// was built without errors.
-static bool compileModuleImpl(CompilerInstance &ImportingInstance,
-                              SourceLocation ImportLoc,
-                              Module *Module,
-                              StringRef ModuleFileName) {
-  ModuleMap &ModMap 
-    = ImportingInstance.getPreprocessor().getHeaderSearchInfo().getModuleMap();
-    
+/// \brief The stack size of the threads modules are built on.
+static const unsigned ModuleBuildThreadStackSize = 8 << 20;
+
+/// \brief Create the invocation that builds \p Module into \p ModuleFileName
+/// from the module map \p ModuleMapFileName, using the options of the
+/// importing invocation.
+static IntrusiveRefCntPtr<CompilerInvocation>
+createModuleBuildInvocation(CompilerInvocation &ImportingInvocation,
+                            Module *Module, StringRef ModuleFileName,
+                            StringRef ModuleMapFileName) {
   // Construct a compiler invocation for creating this module.
   IntrusiveRefCntPtr<CompilerInvocation> Invocation
-    (new CompilerInvocation(ImportingInstance.getInvocation()));
+    (new CompilerInvocation(ImportingInvocation));
 
   PreprocessorOptions &PPOpts = Invocation->getPreprocessorOpts();
   
@@ -896,32 +913,92 @@ static bool compileModuleImpl(CompilerInstance &ImportingInstance,
   // Note the name of the module we're building.
   Invocation->getLangOpts()->CurrentModule = Module->getTopLevelModuleName();
 
-  // Make sure that the failed-module structure has been allocated in
-  // the importing instance, and propagate the pointer to the newly-created
-  // instance.
-  PreprocessorOptions &ImportingPPOpts
-    = ImportingInstance.getInvocation().getPreprocessorOpts();
-  if (!ImportingPPOpts.FailedModules)
-    ImportingPPOpts.FailedModules = new PreprocessorOptions::FailedModulesSet;
-  PPOpts.FailedModules = ImportingPPOpts.FailedModules;
+  // The modules this module depends on are scheduled by the importer, if at
+  // all.
+  Invocation->getHeaderSearchOpts().ModulesBuildJobs = 1;
 
-  // If there is a module map file, build the module using the module map.
-  // Set up the inputs/outputs so that we build the module from its umbrella
-  // header.
+  // Set up the inputs/outputs so that we build the module from its module
+  // map.
   FrontendOptions &FrontendOpts = Invocation->getFrontendOpts();
   FrontendOpts.OutputFile = ModuleFileName.str();
   FrontendOpts.DisableFree = false;
   FrontendOpts.GenerateGlobalModuleIndex = false;
   FrontendOpts.Inputs.clear();
   InputKind IK = getSourceInputKindFromOptions(*Invocation->getLangOpts());
+  FrontendOpts.Inputs.emplace_back(ModuleMapFileName, IK);
 
   // Don't free the remapped file buffers; they are owned by our caller.
   PPOpts.RetainRemappedFileBuffers = true;
     
   Invocation->getDiagnosticOpts().VerifyDiagnostics = 0;
-  assert(ImportingInstance.getInvocation().getModuleHash() ==
+  assert(ImportingInvocation.getModuleHash() ==
          Invocation->getModuleHash() && "Module hash mismatch!");
-  
+  return Invocation;
+}
+
+/// \brief Determine the module map file to build \p Module from.
+///
+/// If the module was inferred, it has no module map of its own: return the
+/// name of a module map file to fake instead, and its contents in
+/// \p InferredModuleMapContent.
+static std::string getModuleMapInputFile(ModuleMap &ModMap, Module *Module,
+                                         std::string &InferredModuleMapContent) {
+  if (const FileEntry *ModuleMapFile =
+          ModMap.getContainingModuleMapFile(Module)) {
+    // Use the module map where this module resides.
+    return ModuleMapFile->getName();
+  }
+
+  SmallString<128> FakeModuleMapFile(Module->Directory->getName());
+  llvm::sys::path::append(FakeModuleMapFile, "__inferred_module.map");
+
+  llvm::raw_string_ostream OS(InferredModuleMapContent);
+  Module->print(OS);
+  OS.flush();
+  return FakeModuleMapFile.str();
+}
+
+/// \brief Make the fake module map file \p FileName, with the contents
+/// \p Content, available to \p Instance.
+static void addInferredModuleMap(CompilerInstance &Instance, StringRef FileName,
+                                 StringRef Content) {
+  std::unique_ptr<llvm::MemoryBuffer> ModuleMapBuffer =
+      llvm::MemoryBuffer::getMemBuffer(Content);
+  const FileEntry *ModuleMapFile = Instance.getFileManager().getVirtualFile(
+      FileName, Content.size(), 0);
+  Instance.getSourceManager().overrideFileContents(ModuleMapFile,
+                                                   std::move(ModuleMapBuffer));
+}
+
+/// \brief Compile a module file for the given module, using the options 
+/// provided by the importing compiler instance. Returns true if the module
+/// was built without errors.
+static bool compileModuleImpl(CompilerInstance &ImportingInstance,
+                              SourceLocation ImportLoc,
+                              Module *Module,
+                              StringRef ModuleFileName) {
+  ModuleMap &ModMap 
+    = ImportingInstance.getPreprocessor().getHeaderSearchInfo().getModuleMap();
+
+  // Get or create the module map that we'll use to build this module.
+  std::string InferredModuleMapContent;
+  std::string ModuleMapFileName =
+      getModuleMapInputFile(ModMap, Module, InferredModuleMapContent);
+
+  IntrusiveRefCntPtr<CompilerInvocation> Invocation =
+      createModuleBuildInvocation(ImportingInstance.getInvocation(), Module,
+                                  ModuleFileName, ModuleMapFileName);
+
+  // Make sure that the failed-module structure has been allocated in
+  // the importing instance, and propagate the pointer to the newly-created
+  // instance.
+  PreprocessorOptions &ImportingPPOpts
+    = ImportingInstance.getInvocation().getPreprocessorOpts();
+  if (!ImportingPPOpts.FailedModules)
+    ImportingPPOpts.FailedModules = new PreprocessorOptions::FailedModulesSet;
+  Invocation->getPreprocessorOpts().FailedModules =
+      ImportingPPOpts.FailedModules;
+
   // Construct a compiler instance that will be used to actually create the
   // module.
   CompilerInstance Instance(ImportingInstance.getPCHContainerOperations(),
@@ -948,27 +1025,8 @@ static bool compileModuleImpl(CompilerInstance &ImportingInstance,
   // between all of the module CompilerInstances.
   Instance.setModuleDepCollector(ImportingInstance.getModuleDepCollector());
 
-  // Get or create the module map that we'll use to build this module.
-  std::string InferredModuleMapContent;
-  if (const FileEntry *ModuleMapFile =
-          ModMap.getContainingModuleMapFile(Module)) {
-    // Use the module map where this module resides.
-    FrontendOpts.Inputs.emplace_back(ModuleMapFile->getName(), IK);
-  } else {
-    SmallString<128> FakeModuleMapFile(Module->Directory->getName());
-    llvm::sys::path::append(FakeModuleMapFile, "__inferred_module.map");
-    FrontendOpts.Inputs.emplace_back(FakeModuleMapFile, IK);
-
-    llvm::raw_string_ostream OS(InferredModuleMapContent);
-    Module->print(OS);
-    OS.flush();
-
-    std::unique_ptr<llvm::MemoryBuffer> ModuleMapBuffer =
-        llvm::MemoryBuffer::getMemBuffer(InferredModuleMapContent);
-    ModuleMapFile = Instance.getFileManager().getVirtualFile(
-        FakeModuleMapFile, InferredModuleMapContent.size(), 0);
-    SourceMgr.overrideFileContents(ModuleMapFile, std::move(ModuleMapBuffer));
-  }
+  if (!InferredModuleMapContent.empty())
+    addInferredModuleMap(Instance, ModuleMapFileName, InferredModuleMapContent);
 
   // Construct a module-generating action. Passing through the module map is
   // safe because the FileManager is shared between the compiler instances.
@@ -981,10 +1039,9 @@ static bool compileModuleImpl(CompilerInstance &ImportingInstance,
 
   // Execute the action to actually build the module in-place. Use a separate
   // thread so that we get a stack large enough.
-  const unsigned ThreadStackSize = 8 << 20;
   llvm::CrashRecoveryContext CRC;
   CRC.RunSafelyOnThread([&]() { Instance.ExecuteAction(CreateModuleAction); },
-                        ThreadStackSize);
+                        ModuleBuildThreadStackSize);
 
   ImportingInstance.getDiagnostics().Report(ImportLoc,
                                             diag::remark_module_build_done)
@@ -1081,6 +1138,418 @@ static bool compileAndLoadModule(CompilerInstance &ImportingInstance,
   }
 }
 
+namespace {
+/// \brief A module that the importer builds ahead of importing it, on a
+/// thread of its own.
+struct ScheduledModuleBuild {
+  enum StateKind { Pending, Running, Finished, Skipped };
+
+  std::string Name;
+  std::string ModuleFileName;
+
+  /// \brief The module map the module is uniqued by.
+  std::string UniquingModuleMapFileName;
+
+  /// \brief The contents of the module map to build the module from, if it
+  /// was inferred.
+  std::string InferredModuleMapContent;
+
+  bool IsSystem;
+  IntrusiveRefCntPtr<CompilerInvocation> Invocation;
+
+  /// \brief Indices of the builds of the modules this module uses, directly
+  /// or through modules that need no building.
+  SmallVector<unsigned, 4> Deps;
+
+  StateKind State;
+  bool Succeeded;
+
+  ScheduledModuleBuild()
+      : IsSystem(false), State(Pending), Succeeded(false) {}
+};
+}
+
+/// \brief Add to \p Used the top-level modules that \p File includes or
+/// imports, found by raw-lexing its \#include, \#import, \#include_next and
+/// \@import directives.
+///
+/// Conditional directives are not evaluated, so this can find modules that
+/// are never imported; that only costs a build that was not needed.
+static void collectModulesIncludedBy(CompilerInstance &CI,
+                                     const FileEntry *File,
+                                     llvm::SmallPtrSetImpl<Module *> &Seen,
+                                     SmallVectorImpl<Module *> &Used) {
+  auto Buffer = CI.getFileManager().getBufferForFile(File);
+  if (!Buffer)
+    return;
+
+  HeaderSearch &HS = CI.getPreprocessor().getHeaderSearchInfo();
+  auto AddUse = [&](Module *M) {
+    if (M && Seen.insert(M->getTopLevelModule()).second)
+      Used.push_back(M->getTopLevelModule());
+  };
+
+  StringRef Contents = (*Buffer)->getBuffer();
+  Lexer L(SourceLocation(), CI.getLangOpts(), Contents.begin(),
+          Contents.begin(), Contents.end());
+  Token Tok;
+  L.LexFromRawLexer(Tok);
+  while (Tok.isNot(tok::eof)) {
+    if (Tok.is(tok::at)) {
+      L.LexFromRawLexer(Tok);
+      if (Tok.is(tok::raw_identifier) && Tok.getRawIdentifier() == "import") {
+        L.LexFromRawLexer(Tok);
+        if (Tok.is(tok::raw_identifier))
+          AddUse(HS.lookupModule(Tok.getRawIdentifier()));
+      }
+      continue;
+    }
+
+    if (Tok.isNot(tok::hash) || !Tok.isAtStartOfLine()) {
+      L.LexFromRawLexer(Tok);
+      continue;
+    }
+
+    L.LexFromRawLexer(Tok);
+    if (Tok.isNot(tok::raw_identifier) || Tok.isAtStartOfLine())
+      continue;
+    StringRef Directive = Tok.getRawIdentifier();
+    if (Directive != "include" && Directive != "import" &&
+        Directive != "include_next")
+      continue;
+
+    // The raw lexer does not lex an angled file name as one token, so take
+    // the file name from the rest of the line.
+    const char *Ptr = L.getBufferLocation();
+    StringRef Rest(Ptr, Contents.end() - Ptr);
+    Rest = Rest.substr(0, Rest.find_first_of("\r\n")).ltrim();
+    L.LexFromRawLexer(Tok);
+    if (Rest.empty() || (Rest[0] != '"' && Rest[0] != '<'))
+      continue;
+    bool IsAngled = Rest[0] == '<';
+    size_t End = Rest.find(IsAngled ? '>' : '"', 1);
+    if (End == StringRef::npos)
+      continue;
+
+    const DirectoryLookup *CurDir = nullptr;
+    ModuleMap::KnownHeader Suggested;
+    std::pair<const FileEntry *, const DirectoryEntry *> Includer(
+        File, File->getDir());
+    if (HS.LookupFile(Rest.slice(1, End), SourceLocation(), IsAngled,
+                      /*FromDir=*/nullptr, CurDir, Includer,
+                      /*SearchPath=*/nullptr, /*RelativePath=*/nullptr,
+                      &Suggested))
+      AddUse(Suggested.getModule());
+  }
+}
+
+/// \brief Collect the top-level modules that \p Mod, or one of its
+/// submodules, declares it uses in the module map, or that its headers
+/// include or import.
+///
+/// The headers under an umbrella directory are not scanned.
+static void collectUsedModules(CompilerInstance &CI, Module *Mod,
+                               llvm::SmallPtrSetImpl<Module *> &Seen,
+                               SmallVectorImpl<Module *> &Used) {
+  ModuleMap &ModMap = CI.getPreprocessor().getHeaderSearchInfo().getModuleMap();
+  Seen.insert(Mod->getTopLevelModule());
+  SmallVector<Module *, 16> Worklist(1, Mod);
+  while (!Worklist.empty()) {
+    Module *M = Worklist.pop_back_val();
+    ModMap.resolveUses(M, /*Complain=*/false);
+    for (Module *Use : M->DirectUses)
+      if (Seen.insert(Use->getTopLevelModule()).second)
+        Used.push_back(Use->getTopLevelModule());
+
+    for (auto Kind : {Module::HK_Normal, Module::HK_Textual,
+                      Module::HK_Private, Module::HK_PrivateTextual})
+      for (const Module::Header &H : M->Headers[Kind])
+        collectModulesIncludedBy(CI, H.Entry, Seen, Used);
+    if (const FileEntry *Umbrella = M->getUmbrellaHeader().Entry)
+      collectModulesIncludedBy(CI, Umbrella, Seen, Used);
+
+    Worklist.append(M->submodule_begin(), M->submodule_end());
+  }
+}
+
+/// \brief Schedule a build for each module in \p Used, and each module they
+/// use, directly or indirectly, whose module file is missing, after the
+/// builds of the modules it uses in turn. Add the builds that the modules in
+/// \p Used depend on to \p Deps.
+static void
+scheduleModuleBuilds(CompilerInstance &ImportingInstance,
+                     ArrayRef<Module *> Used,
+                     const llvm::StringMap<std::string> &ModuleFileOverrides,
+                     llvm::DenseMap<const Module *, int> &Scheduled,
+                     std::vector<ScheduledModuleBuild> &Builds,
+                     SmallVectorImpl<unsigned> &Deps) {
+  HeaderSearch &HS = ImportingInstance.getPreprocessor().getHeaderSearchInfo();
+  ModuleMap &ModMap = HS.getModuleMap();
+  const PreprocessorOptions &PPOpts = ImportingInstance.getPreprocessorOpts();
+  ModuleBuildStack BuildStack =
+      ImportingInstance.getSourceManager().getModuleBuildStack();
+
+  for (Module *Dep : Used) {
+    auto Known = Scheduled.find(Dep);
+    if (Known != Scheduled.end()) {
+      if (Known->second >= 0)
+        Deps.push_back(Known->second);
+      continue;
+    }
+
+    // Leave the modules that cannot be built here, and cycles, to the
+    // importer, which diagnoses them.
+    Scheduled[Dep] = -1;
+    if (Dep->Name == ImportingInstance.getLangOpts().CurrentModule ||
+        !Dep->isAvailable() || ModuleFileOverrides.count(Dep->Name) ||
+        (PPOpts.FailedModules &&
+         PPOpts.FailedModules->hasAlreadyFailed(Dep->Name)) ||
+        std::any_of(BuildStack.begin(), BuildStack.end(),
+                    [&](const std::pair<std::string, FullSourceLoc> &Entry) {
+                      return Entry.first == Dep->Name;
+                    }))
+      continue;
+
+    llvm::SmallPtrSet<Module *, 8> Seen;
+    SmallVector<Module *, 8> DepUsed;
+    collectUsedModules(ImportingInstance, Dep, Seen, DepUsed);
+    SmallVector<unsigned, 4> DepDeps;
+    scheduleModuleBuilds(ImportingInstance, DepUsed, ModuleFileOverrides,
+                         Scheduled, Builds, DepDeps);
+
+    // A module file that exists is either up to date, or rebuilt by the
+    // importer when it is found to be out of date; either way, its users
+    // wait for the builds it would wait for.
+    std::string ModuleFileName = HS.getModuleFileName(Dep);
+    const FileEntry *UniquingModuleMap =
+        ModMap.getModuleMapFileForUniquing(Dep);
+    if (ModuleFileName.empty() || !UniquingModuleMap ||
+        llvm::sys::fs::exists(ModuleFileName)) {
+      Deps.append(DepDeps.begin(), DepDeps.end());
+      continue;
+    }
+
+    ScheduledModuleBuild Build;
+    Build.Name = Dep->Name;
+    Build.ModuleFileName = ModuleFileName;
+    Build.UniquingModuleMapFileName = UniquingModuleMap->getName();
+    Build.IsSystem = Dep->IsSystem;
+    Build.Deps = std::move(DepDeps);
+    Build.Invocation = createModuleBuildInvocation(
+        ImportingInstance.getInvocation(), Dep, ModuleFileName,
+        getModuleMapInputFile(ModMap, Dep, Build.InferredModuleMapContent));
+
+    // The build runs alongside the importer, so it must not share anything
+    // that is not thread-safe with it, nor write to its outputs.
+    Build.Invocation->getPreprocessorOpts().FailedModules =
+        new PreprocessorOptions::FailedModulesSet;
+    Build.Invocation->getHeaderSearchOpts().Verbose = false;
+    FrontendOptions &FrontendOpts = Build.Invocation->getFrontendOpts();
+    FrontendOpts.ShowStats = false;
+    FrontendOpts.ShowTimers = false;
+    FrontendOpts.TemplateInstantiationReport.clear();
+
+    Scheduled[Dep] = Builds.size();
+    Deps.push_back(Builds.size());
+    Builds.push_back(std::move(Build));
+  }
+}
+
+/// \brief Build the module of \p Build on the current thread, unless another
+/// compiler is building it already.
+///
+/// \returns true if the module file was written, by us or by the other
+/// compiler.
+static bool
+runScheduledModuleBuild(const ScheduledModuleBuild &Build,
+                        std::shared_ptr<PCHContainerOperations> PCHContainerOps,
+                        IntrusiveRefCntPtr<vfs::FileSystem> VFS) {
+  StringRef Dir = llvm::sys::path::parent_path(Build.ModuleFileName);
+  llvm::sys::fs::create_directories(Dir);
+
+  while (1) {
+    llvm::LockFileManager Locked(Build.ModuleFileName);
+    switch (Locked) {
+    case llvm::LockFileManager::LFS_Error:
+      return false;
+
+    case llvm::LockFileManager::LFS_Owned:
+      break;
+
+    case llvm::LockFileManager::LFS_Shared:
+      switch (Locked.waitForUnlock()) {
+      case llvm::LockFileManager::Res_Success:
+        return true;
+      case llvm::LockFileManager::Res_OwnerDied:
+        continue; // try again to get the lock.
+      case llvm::LockFileManager::Res_Timeout:
+        return false;
+      }
+      break;
+    }
+
+    // The file and source managers are not thread-safe, so the build gets
+    // its own. Its diagnostics are dropped: if it fails, the importer builds
+    // the module again when it imports it, and reports them then.
+    CompilerInstance Instance(PCHContainerOps, /*BuildingModule=*/true);
+    Instance.setInvocation(Build.Invocation.get());
+    Instance.createDiagnostics(new IgnoringDiagConsumer,
+                               /*ShouldOwnClient=*/true);
+    Instance.setVirtualFileSystem(VFS);
+    Instance.createFileManager();
+    Instance.createSourceManager(Instance.getFileManager());
+    if (!Build.InferredModuleMapContent.empty())
+      addInferredModuleMap(
+          Instance, Build.Invocation->getFrontendOpts().Inputs[0].getFile(),
+          Build.InferredModuleMapContent);
+
+    GenerateModuleAction CreateModuleAction(
+        Instance.getFileManager().getFile(Build.UniquingModuleMapFileName),
+        Build.IsSystem);
+    llvm::CrashRecoveryContext CRC;
+    CRC.RunSafelyOnThread([&]() { Instance.ExecuteAction(CreateModuleAction); },
+                          ModuleBuildThreadStackSize);
+    Instance.clearOutputFiles(/*EraseFiles=*/true);
+    return !Instance.getDiagnostics().hasErrorOccurred();
+  }
+}
+
+/// \brief Build the modules that \p Module, or the translation unit that
+/// imports it, uses, directly or indirectly, and whose module files are
+/// missing, up to HeaderSearchOptions::ModulesBuildJobs of them at the same
+/// time.
+///
+/// A module uses the modules it declares with 'use' declarations and those
+/// its headers include or import. This only gets a head start on the builds
+/// that the importer does one at a time otherwise: a module that fails to
+/// build here, or that is missed, is still built by the importer when it
+/// imports it.
+static void
+buildUsedModules(CompilerInstance &ImportingInstance, SourceLocation ImportLoc,
+                 Module *Module,
+                 const llvm::StringMap<std::string> &ModuleFileOverrides) {
+#if LLVM_ENABLE_THREADS
+  unsigned MaxJobs = ImportingInstance.getHeaderSearchOpts().ModulesBuildJobs;
+  // The time trace profiler only records regions from a single thread.
+  if (MaxJobs <= 1 || timeTraceProfilerEnabled())
+    return;
+
+  // Seed the builds with the modules that the translation unit, or the
+  // module being built, imports as well, since the module being imported is
+  // rarely the only one missing.
+  llvm::SmallPtrSet<clang::Module *, 8> Seen;
+  SmallVector<clang::Module *, 8> Used;
+  collectUsedModules(ImportingInstance, Module, Seen, Used);
+  StringRef CurrentModule = ImportingInstance.getLangOpts().CurrentModule;
+  SourceManager &SourceMgr = ImportingInstance.getSourceManager();
+  if (!CurrentModule.empty()) {
+    if (clang::Module *Current = ImportingInstance.getPreprocessor()
+                                     .getHeaderSearchInfo()
+                                     .lookupModule(CurrentModule))
+      collectUsedModules(ImportingInstance, Current, Seen, Used);
+  } else if (const FileEntry *MainFile =
+                 SourceMgr.getFileEntryForID(SourceMgr.getMainFileID())) {
+    collectModulesIncludedBy(ImportingInstance, MainFile, Seen, Used);
+  }
+
+  // The builds of the modules a module uses come before its own.
+  std::vector<ScheduledModuleBuild> Builds;
+  llvm::DenseMap<const clang::Module *, int> Scheduled;
+  Scheduled[Module->getTopLevelModule()] = -1;
+  SmallVector<unsigned, 8> Roots;
+  scheduleModuleBuilds(ImportingInstance, Used, ModuleFileOverrides,
+                       Scheduled, Builds, Roots);
+  if (Builds.empty())
+    return;
+
+  DiagnosticsEngine &Diags = ImportingInstance.getDiagnostics();
+  std::shared_ptr<PCHContainerOperations> PCHContainerOps =
+      ImportingInstance.getPCHContainerOperations();
+  IntrusiveRefCntPtr<vfs::FileSystem> VFS =
+      &ImportingInstance.getVirtualFileSystem();
+
+  std::mutex Lock;
+  std::condition_variable BuildFinished;
+  std::vector<std::thread> Threads(Builds.size());
+  unsigned NumRunning = 0, NumFinished = 0, NumDone = 0;
+  bool AnySucceeded = false;
+
+  std::unique_lock<std::mutex> Guard(Lock);
+  while (1) {
+    // Collect the finished builds.
+    for (unsigned I = 0, E = Builds.size(); I != E; ++I) {
+      ScheduledModuleBuild &B = Builds[I];
+      if (B.State != ScheduledModuleBuild::Finished || !Threads[I].joinable())
+        continue;
+
+      Guard.unlock();
+      Threads[I].join();
+      if (B.Succeeded) {
+        Diags.Report(ImportLoc, diag::remark_module_build_done) << B.Name;
+        AnySucceeded = true;
+      }
+      Guard.lock();
+      ++NumDone;
+    }
+    if (NumDone == Builds.size())
+      break;
+
+    // Start every build whose dependencies were built, up to the job limit.
+    // Skip the builds that depend on a failed one.
+    unsigned SeenFinished = NumFinished;
+    for (unsigned I = 0, E = Builds.size(); I != E && NumRunning < MaxJobs;
+         ++I) {
+      ScheduledModuleBuild &B = Builds[I];
+      if (B.State != ScheduledModuleBuild::Pending)
+        continue;
+
+      bool Ready = true, DepFailed = false;
+      for (unsigned Dep : B.Deps) {
+        const ScheduledModuleBuild &D = Builds[Dep];
+        if (D.State == ScheduledModuleBuild::Skipped ||
+            (D.State == ScheduledModuleBuild::Finished && !D.Succeeded))
+          DepFailed = true;
+        else if (D.State != ScheduledModuleBuild::Finished)
+          Ready = false;
+      }
+      if (DepFailed) {
+        B.State = ScheduledModuleBuild::Skipped;
+        ++NumDone;
+        continue;
+      }
+      if (!Ready)
+        continue;
+
+      Diags.Report(ImportLoc, diag::remark_module_build)
+          << B.Name << B.ModuleFileName;
+      B.State = ScheduledModuleBuild::Running;
+      ++NumRunning;
+      Threads[I] = std::thread([&, I] {
+        ScheduledModuleBuild &B = Builds[I];
+        bool Succeeded = runScheduledModuleBuild(B, PCHContainerOps, VFS);
+
+        std::lock_guard<std::mutex> BuildGuard(Lock);
+        B.Succeeded = Succeeded;
+        B.State = ScheduledModuleBuild::Finished;
+        --NumRunning;
+        ++NumFinished;
+        BuildFinished.notify_one();
+      });
+    }
+
+    // Wait for a running build to finish before scheduling more work.
+    if (NumRunning)
+      BuildFinished.wait(Guard, [&] { return NumFinished != SeenFinished; });
+  }
+
+  // We've built modules. If we're allowed to generate or update the global
+  // module index, record that fact in the importing compiler instance.
+  if (AnySucceeded &&
+      ImportingInstance.getFrontendOpts().GenerateGlobalModuleIndex)
+    ImportingInstance.setBuildGlobalModuleIndex(true);
+#endif
+}
+
 /// \brief Diagnose differences between the current definition of the given
 /// configuration macro and the definition provided on the command line.
 static void checkConfigMacro(Preprocessor &PP, StringRef ConfigMacro,
@@ -1251,6 +1720,7 @@ void CompilerInstance::createModuleManager() {
         HSOpts.ModulesValidateSystemHeaders,
         getFrontendOpts().UseGlobalModuleIndex,
         std::move(ReadTimer));
+    ModuleManager->setTimeStats(getFrontendOpts().ShowStats);
     if (hasASTConsumer()) {
       ModuleManager->setDeserializationListener(
         getASTConsumer().GetASTDeserializationListener());
@@ -1488,6 +1958,9 @@ CompilerInstance::loadModule(SourceLocation ImportLoc,
         return ModuleLoadResult();
       }
 
+      // Build the modules it uses first, several at a time if allowed.
+      buildUsedModules(*this, ImportLoc, Module, ModuleFileOverrides);
+
       // Try to compile and then load the module.
       if (!compileAndLoadModule(*this, ImportLoc, ModuleNameLoc, Module,
                                 ModuleFileName)) {
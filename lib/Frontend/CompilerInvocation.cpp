@@ -280,6 +280,19 @@ static bool ParseAnalyzerArgs(AnalyzerOptions &Opts, ArgList &Args,
     }
   }
 
+  // A shard index outside of the shard count would silently analyze nothing.
+  unsigned ShardCount = 1, ShardIndex = 0;
+  if (Opts.Config.count("shard-count"))
+    StringRef(Opts.Config["shard-count"]).getAsInteger(10, ShardCount);
+  if (Opts.Config.count("shard-index") &&
+      !StringRef(Opts.Config["shard-index"]).getAsInteger(10, ShardIndex) &&
+      ShardIndex >= std::max(ShardCount, 1u)) {
+    Diags.Report(SourceLocation(),
+                 diag::err_analyzer_config_shard_index_out_of_range)
+      << ShardIndex << ShardCount;
+    Success = false;
+  }
+
   return Success;
 }
 
@@ -924,12 +937,17 @@ static InputKind ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
   Opts.DisableFree = Args.hasArg(OPT_disable_free);
 
   Opts.OutputFile = Args.getLastArgValue(OPT_o);
+  Opts.TemplateInstantiationReport =
+      Args.getLastArgValue(OPT_ftemplate_instantiation_report_EQ);
   Opts.Plugins = Args.getAllArgValues(OPT_load);
   Opts.RelocatablePCH = Args.hasArg(OPT_relocatable_pch);
   Opts.ShowHelp = Args.hasArg(OPT_help);
   Opts.ShowStats = Args.hasArg(OPT_print_stats);
   Opts.ShowTimers = Args.hasArg(OPT_ftime_report);
   Opts.ShowVersion = Args.hasArg(OPT_version);
+  Opts.TimeTrace = Args.hasArg(OPT_ftime_trace);
+  Opts.TimeTraceGranularity =
+      getLastArgIntValue(Args, OPT_ftime_trace_granularity_EQ, 500, Diags);
   Opts.ASTMergeFiles = Args.getAllArgValues(OPT_ast_merge);
   Opts.LLVMArgs = Args.getAllArgValues(OPT_mllvm);
   Opts.FixWhatYouCan = Args.hasArg(OPT_fix_what_you_can);
@@ -1099,6 +1117,10 @@ static void ParseHeaderSearchArgs(HeaderSearchOptions &Opts, ArgList &Args) {
   Opts.ResourceDir = Args.getLastArgValue(OPT_resource_dir);
   Opts.ModuleCachePath = Args.getLastArgValue(OPT_fmodules_cache_path);
   Opts.ModuleUserBuildPath = Args.getLastArgValue(OPT_fmodules_user_build_path);
+  Opts.IncludeGuardDatabasePath =
+      Args.getLastArgValue(OPT_finclude_guard_database_EQ);
+  Opts.HeaderSearchIndexPath =
+      Args.getLastArgValue(OPT_fheader_search_index_EQ);
   Opts.DisableModuleHash = Args.hasArg(OPT_fdisable_module_hash);
   Opts.ImplicitModuleMaps = Args.hasArg(OPT_fimplicit_module_maps);
   Opts.ModuleMapFileHomeIsCwd = Args.hasArg(OPT_fmodule_map_file_home_is_cwd);
@@ -1106,12 +1128,17 @@ static void ParseHeaderSearchArgs(HeaderSearchOptions &Opts, ArgList &Args) {
       getLastArgIntValue(Args, OPT_fmodules_prune_interval, 7 * 24 * 60 * 60);
   Opts.ModuleCachePruneAfter =
       getLastArgIntValue(Args, OPT_fmodules_prune_after, 31 * 24 * 60 * 60);
+  Opts.ModulesBuildJobs =
+      getLastArgIntValue(Args, OPT_fmodules_build_jobs_EQ, 1);
   Opts.ModulesValidateOncePerBuildSession =
       Args.hasArg(OPT_fmodules_validate_once_per_build_session);
   Opts.BuildSessionTimestamp =
       getLastArgUInt64Value(Args, OPT_fbuild_session_timestamp, 0);
   Opts.ModulesValidateSystemHeaders =
       Args.hasArg(OPT_fmodules_validate_system_headers);
+  Opts.ModulesValidateInputFilesLazily =
+      Args.hasArg(OPT_fmodules_validate_input_files_lazily);
+  Opts.ModulesCompressBuffers = Args.hasArg(OPT_fmodules_compress_buffers);
 
   for (const Arg *A : Args.filtered(OPT_fmodules_ignore_macro)) {
     StringRef MacroDef = A->getValue();
@@ -1554,6 +1581,10 @@ static void ParseLangArgs(LangOptions &Opts, ArgList &Args, InputKind IK,
       getLastArgIntValue(Args, OPT_fconstexpr_depth, 512, Diags);
   Opts.ConstexprStepLimit =
       getLastArgIntValue(Args, OPT_fconstexpr_steps, 1048576, Diags);
+  Opts.ConstexprCacheSize =
+      getLastArgIntValue(Args, OPT_fconstexpr_cache_size, 65536, Diags);
+  Opts.EnableNewConstInterp =
+      Args.hasArg(OPT_fexperimental_new_constant_interpreter);
   Opts.BracketDepth = getLastArgIntValue(Args, OPT_fbracket_depth, 256, Diags);
   Opts.DelayedTemplateParsing = Args.hasArg(OPT_fdelayed_template_parsing);
   Opts.NumLargeByValueCopy =
@@ -21,6 +21,8 @@
 #include "clang/Lex/HeaderSearch.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Parse/ParseAST.h"
+#include "clang/Sema/Sema.h"
+#include "clang/Sema/TemplateInstantiationStats.h"
 #include "clang/Serialization/ASTDeserializationListener.h"
 #include "clang/Serialization/ASTReader.h"
 #include "clang/Serialization/GlobalModuleIndex.h"
@@ -450,6 +452,21 @@ bool FrontendAction::Execute() {
   return true;
 }
 
+/// \brief Write the cost of each template instantiation in \p MainFile to the
+/// file named by -ftemplate-instantiation-report.
+static void writeTemplateInstantiationReport(CompilerInstance &CI,
+                                             StringRef MainFile) {
+  const std::string &Path = CI.getFrontendOpts().TemplateInstantiationReport;
+  std::error_code EC;
+  llvm::raw_fd_ostream OS(Path, EC, llvm::sys::fs::F_Text);
+  if (EC) {
+    CI.getDiagnostics().Report(diag::err_fe_unable_to_open_output)
+        << Path << EC.message();
+    return;
+  }
+  CI.getSema().TemplateInstStats->write(OS, MainFile);
+}
+
 void FrontendAction::EndSourceFile() {
   CompilerInstance &CI = getCompilerInstance();
 
@@ -463,6 +480,15 @@ void FrontendAction::EndSourceFile() {
   // Finalize the action.
   EndSourceFileAction();
 
+  if (CI.hasSema() && CI.getSema().TemplateInstStats)
+    writeTemplateInstantiationReport(CI, getCurrentFile());
+
+  if (CI.hasPreprocessor()) {
+    HeaderSearch &HS = CI.getPreprocessor().getHeaderSearchInfo();
+    HS.saveIncludeGuardDatabase();
+    HS.saveHeaderSearchIndex();
+  }
+
   // Sema references the ast consumer, so reset sema first.
   //
   // FIXME: There is more per-file stuff we could just drop here?
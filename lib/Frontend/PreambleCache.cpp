@@ -0,0 +1,445 @@
+//===--- PreambleCache.cpp - Persistent precompiled preamble cache --------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Implements the on-disk cache of precompiled preambles.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Frontend/PreambleCache.h"
+#include "clang/Basic/DiagnosticOptions.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/Version.h"
+#include "clang/Frontend/CompilerInvocation.h"
+#include "clang/Lex/HeaderSearchOptions.h"
+#include "clang/Lex/PreprocessorOptions.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/MutexGuard.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+
+using namespace clang;
+using namespace llvm::support;
+
+namespace {
+struct DefaultPreambleCacheHolder {
+  llvm::sys::Mutex Lock;
+  IntrusiveRefCntPtr<PreambleCache> Cache;
+};
+}
+
+static llvm::ManagedStatic<DefaultPreambleCacheHolder> DefaultPreambleCache;
+
+/// \brief Identifies a metadata file, and the version of its format.
+static const char MetadataMagic[4] = { 'C', 'P', 'R', 'E' };
+static const uint32_t MetadataVersion = 1;
+
+//===----------------------------------------------------------------------===//
+// Cache keys
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// \brief Feeds length-prefixed values into an MD5 hash, so that adjacent
+/// strings cannot run into each other.
+class KeyBuilder {
+  llvm::MD5 Hash;
+
+public:
+  void add(StringRef S) {
+    add(static_cast<uint64_t>(S.size()));
+    Hash.update(S);
+  }
+
+  void add(uint64_t V) {
+    uint8_t Bytes[8];
+    endian::write<uint64_t, little, unaligned>(Bytes, V);
+    Hash.update(Bytes);
+  }
+
+  std::string str() {
+    llvm::MD5::MD5Result Result;
+    Hash.final(Result);
+    SmallString<32> Str;
+    llvm::MD5::stringifyResult(Result, Str);
+    return Str.str();
+  }
+};
+}
+
+std::string PreambleCache::getKey(const CompilerInvocation &Invocation,
+                                  StringRef MainFilename,
+                                  StringRef PreambleText,
+                                  bool PreambleEndsAtStartOfLine) {
+  KeyBuilder Key;
+  Key.add(getClangFullRepositoryVersion());
+  Key.add(MetadataVersion);
+
+  // The module hash covers the language, target and header search options
+  // that affect the contents of an AST file.
+  Key.add(Invocation.getModuleHash());
+
+  // ... but not everything that affects a preamble.
+  const PreprocessorOptions &PPOpts = Invocation.getPreprocessorOpts();
+  for (const auto &Macro : PPOpts.Macros) {
+    Key.add(Macro.first);
+    Key.add(Macro.second);
+  }
+  for (const auto &Include : PPOpts.Includes)
+    Key.add(Include);
+  for (const auto &Include : PPOpts.MacroIncludes)
+    Key.add(Include);
+  Key.add(PPOpts.ImplicitPCHInclude);
+
+  const HeaderSearchOptions &HSOpts = Invocation.getHeaderSearchOpts();
+  for (const auto &Entry : HSOpts.UserEntries) {
+    Key.add(Entry.Path);
+    Key.add(Entry.Group);
+    Key.add(Entry.IsFramework);
+    Key.add(Entry.IgnoreSysRoot);
+  }
+  for (const auto &Prefix : HSOpts.SystemHeaderPrefixes) {
+    Key.add(Prefix.Prefix);
+    Key.add(Prefix.IsSystemHeader);
+  }
+
+  // The preamble's diagnostics are stored with it.
+  const DiagnosticOptions &DiagOpts = Invocation.getDiagnosticOpts();
+  for (const auto &Warning : DiagOpts.Warnings)
+    Key.add(Warning);
+  for (const auto &Remark : DiagOpts.Remarks)
+    Key.add(Remark);
+  Key.add(DiagOpts.IgnoreWarnings);
+  Key.add(DiagOpts.Pedantic);
+  Key.add(DiagOpts.PedanticErrors);
+
+  // Relative include paths are resolved against the working directory.
+  Key.add(Invocation.getFileSystemOpts().WorkingDir);
+  SmallString<256> CurrentPath;
+  if (!llvm::sys::fs::current_path(CurrentPath))
+    Key.add(CurrentPath);
+
+  Key.add(MainFilename);
+  Key.add(PreambleEndsAtStartOfLine);
+  Key.add(PreambleText);
+  return Key.str();
+}
+
+//===----------------------------------------------------------------------===//
+// Metadata serialization
+//===----------------------------------------------------------------------===//
+
+static void writeString(endian::Writer<little> &W, StringRef S) {
+  W.write<uint32_t>(S.size());
+  W.OS << S;
+}
+
+static void writeMetadata(raw_ostream &OS, const PreambleCache::Entry &E) {
+  endian::Writer<little> W(OS);
+  OS.write(MetadataMagic, sizeof(MetadataMagic));
+  W.write<uint32_t>(MetadataVersion);
+  W.write<uint32_t>(E.NumWarnings);
+  W.write<uint32_t>(E.TopLevelHashValue);
+
+  W.write<uint32_t>(E.Files.size());
+  for (const auto &F : E.Files) {
+    writeString(W, F.first());
+    W.write<uint64_t>(F.second.Size);
+    W.write<uint64_t>(F.second.ModTime);
+    OS.write(reinterpret_cast<const char *>(F.second.MD5),
+             sizeof(F.second.MD5));
+  }
+
+  W.write<uint32_t>(E.TopLevelDecls.size());
+  for (serialization::DeclID ID : E.TopLevelDecls)
+    W.write<uint32_t>(ID);
+
+  W.write<uint32_t>(E.Diagnostics.size());
+  for (const ASTUnit::StandaloneDiagnostic &D : E.Diagnostics) {
+    W.write<uint32_t>(D.ID);
+    W.write<uint32_t>(D.Level);
+    writeString(W, D.Message);
+    writeString(W, D.Filename);
+    W.write<uint32_t>(D.LocOffset);
+    W.write<uint32_t>(D.Ranges.size());
+    for (const auto &R : D.Ranges) {
+      W.write<uint32_t>(R.first);
+      W.write<uint32_t>(R.second);
+    }
+    W.write<uint32_t>(D.FixIts.size());
+    for (const ASTUnit::StandaloneFixIt &FixIt : D.FixIts) {
+      W.write<uint32_t>(FixIt.RemoveRange.first);
+      W.write<uint32_t>(FixIt.RemoveRange.second);
+      W.write<uint32_t>(FixIt.InsertFromRange.first);
+      W.write<uint32_t>(FixIt.InsertFromRange.second);
+      writeString(W, FixIt.CodeToInsert);
+      W.write<uint8_t>(FixIt.BeforePreviousInsertions);
+    }
+  }
+}
+
+namespace {
+/// \brief Bounds-checked reader for metadata files, which may have been
+/// truncated or written by a different version of the compiler.
+class MetadataReader {
+  const char *Ptr, *End;
+  bool Failed;
+
+  bool need(size_t N) {
+    if (Failed || size_t(End - Ptr) < N)
+      Failed = true;
+    return !Failed;
+  }
+
+public:
+  explicit MetadataReader(StringRef Data)
+      : Ptr(Data.begin()), End(Data.end()), Failed(false) {}
+
+  bool failed() const { return Failed; }
+
+  uint8_t readU8() {
+    return need(1) ? endian::readNext<uint8_t, little, unaligned>(Ptr) : 0;
+  }
+  uint32_t readU32() {
+    return need(4) ? endian::readNext<uint32_t, little, unaligned>(Ptr) : 0;
+  }
+  uint64_t readU64() {
+    return need(8) ? endian::readNext<uint64_t, little, unaligned>(Ptr) : 0;
+  }
+  StringRef readBytes(size_t N) {
+    if (!need(N))
+      return StringRef();
+    StringRef Result(Ptr, N);
+    Ptr += N;
+    return Result;
+  }
+  StringRef readString() { return readBytes(readU32()); }
+};
+}
+
+static bool readMetadata(StringRef Data, PreambleCache::Entry &E) {
+  MetadataReader R(Data);
+  if (R.readBytes(sizeof(MetadataMagic)) !=
+          StringRef(MetadataMagic, sizeof(MetadataMagic)) ||
+      R.readU32() != MetadataVersion)
+    return false;
+  E.NumWarnings = R.readU32();
+  E.TopLevelHashValue = R.readU32();
+
+  for (unsigned I = 0, N = R.readU32(); I != N && !R.failed(); ++I) {
+    StringRef Name = R.readString();
+    ASTUnit::PreambleFileHash &Hash = E.Files[Name];
+    Hash.Size = R.readU64();
+    Hash.ModTime = R.readU64();
+    StringRef MD5 = R.readBytes(sizeof(Hash.MD5));
+    if (!R.failed())
+      memcpy(Hash.MD5, MD5.data(), sizeof(Hash.MD5));
+  }
+
+  for (unsigned I = 0, N = R.readU32(); I != N && !R.failed(); ++I)
+    E.TopLevelDecls.push_back(R.readU32());
+
+  for (unsigned I = 0, N = R.readU32(); I != N && !R.failed(); ++I) {
+    E.Diagnostics.push_back(ASTUnit::StandaloneDiagnostic());
+    ASTUnit::StandaloneDiagnostic &D = E.Diagnostics.back();
+    D.ID = R.readU32();
+    D.Level = static_cast<DiagnosticsEngine::Level>(R.readU32());
+    D.Message = R.readString();
+    D.Filename = R.readString();
+    D.LocOffset = R.readU32();
+    for (unsigned J = 0, M = R.readU32(); J != M && !R.failed(); ++J) {
+      unsigned Begin = R.readU32();
+      D.Ranges.push_back(std::make_pair(Begin, R.readU32()));
+    }
+    for (unsigned J = 0, M = R.readU32(); J != M && !R.failed(); ++J) {
+      ASTUnit::StandaloneFixIt FixIt;
+      FixIt.RemoveRange.first = R.readU32();
+      FixIt.RemoveRange.second = R.readU32();
+      FixIt.InsertFromRange.first = R.readU32();
+      FixIt.InsertFromRange.second = R.readU32();
+      FixIt.CodeToInsert = R.readString();
+      FixIt.BeforePreviousInsertions = R.readU8();
+      D.FixIts.push_back(FixIt);
+    }
+  }
+
+  return !R.failed();
+}
+
+//===----------------------------------------------------------------------===//
+// PreambleCache
+//===----------------------------------------------------------------------===//
+
+PreambleCache::PreambleCache(StringRef Directory, uint64_t MaxSize)
+    : Directory(Directory), MaxSize(MaxSize), NumHits(0), NumMisses(0),
+      NumStores(0) {}
+
+std::string PreambleCache::getEntryPath(StringRef Key,
+                                        StringRef Extension) const {
+  SmallString<256> Path(Directory);
+  llvm::sys::path::append(Path, Key);
+  Path += Extension;
+  return Path.str();
+}
+
+bool PreambleCache::lookup(StringRef Key, Entry &Result) {
+  std::string MetaPath = getEntryPath(Key, ".meta");
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer =
+      llvm::MemoryBuffer::getFile(MetaPath, -1,
+                                  /*RequiresNullTerminator=*/false);
+  if (!Buffer || !readMetadata((*Buffer)->getBuffer(), Result)) {
+    llvm::MutexGuard Guard(Lock);
+    ++NumMisses;
+    return false;
+  }
+
+  // Bump the modification time of the metadata file; pruning removes the
+  // entries that were used least recently.
+  int FD;
+  if (!llvm::sys::fs::openFileForWrite(MetaPath, FD,
+                                       llvm::sys::fs::F_Append)) {
+    llvm::sys::fs::setLastModificationAndAccessTime(
+        FD, llvm::sys::TimeValue::now());
+    llvm::raw_fd_ostream Closer(FD, /*shouldClose=*/true);
+  }
+
+  llvm::MutexGuard Guard(Lock);
+  ++NumHits;
+  return true;
+}
+
+bool PreambleCache::retrievePCH(StringRef Key, StringRef DestPath) {
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer =
+      llvm::MemoryBuffer::getFile(getEntryPath(Key, ".pch"), -1,
+                                  /*RequiresNullTerminator=*/false);
+  if (!Buffer)
+    return false;
+
+  std::error_code EC;
+  llvm::raw_fd_ostream OS(DestPath, EC, llvm::sys::fs::F_None);
+  if (EC)
+    return false;
+  OS << (*Buffer)->getBuffer();
+  OS.close();
+  if (OS.has_error()) {
+    OS.clear_error();
+    return false;
+  }
+  return true;
+}
+
+void PreambleCache::store(StringRef Key, const Entry &E, StringRef PCHPath) {
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> PCH =
+      llvm::MemoryBuffer::getFile(PCHPath, -1,
+                                  /*RequiresNullTerminator=*/false);
+  if (!PCH || llvm::sys::fs::create_directories(Directory))
+    return;
+
+  // Write the PCH first: an entry is only visible once its metadata exists.
+  StringRef PCHData = (*PCH)->getBuffer();
+  if (writeFileAtomically(getEntryPath(Key, ".pch"),
+                          [&](raw_ostream &OS) { OS << PCHData; }))
+    return;
+  if (writeFileAtomically(getEntryPath(Key, ".meta"),
+                          [&](raw_ostream &OS) { writeMetadata(OS, E); })) {
+    llvm::sys::fs::remove(getEntryPath(Key, ".pch"));
+    return;
+  }
+
+  {
+    llvm::MutexGuard Guard(Lock);
+    ++NumStores;
+  }
+  prune();
+}
+
+unsigned PreambleCache::prune() {
+  if (!MaxSize)
+    return 0;
+
+  struct CachedFiles {
+    uint64_t Size;
+    llvm::sys::TimeValue LastUse;
+    CachedFiles() : Size(0), LastUse(llvm::sys::TimeValue::MinTime()) {}
+  };
+  llvm::StringMap<CachedFiles> Entries;
+  uint64_t TotalSize = 0;
+
+  std::error_code EC;
+  for (llvm::sys::fs::directory_iterator Dir(Directory, EC), DirEnd;
+       Dir != DirEnd && !EC; Dir.increment(EC)) {
+    StringRef Path = Dir->path();
+    StringRef Extension = llvm::sys::path::extension(Path);
+    if (Extension != ".pch" && Extension != ".meta")
+      continue;
+
+    llvm::sys::fs::file_status Status;
+    if (llvm::sys::fs::status(Path, Status))
+      continue;
+
+    // An entry without metadata is either incomplete or being written; it
+    // goes first.
+    CachedFiles &Files = Entries[llvm::sys::path::stem(Path)];
+    Files.Size += Status.getSize();
+    if (Extension == ".meta")
+      Files.LastUse = Status.getLastModificationTime();
+    TotalSize += Status.getSize();
+  }
+
+  if (TotalSize <= MaxSize)
+    return 0;
+
+  std::vector<std::pair<llvm::sys::TimeValue, StringRef>> ByLastUse;
+  for (const auto &E : Entries)
+    ByLastUse.push_back(std::make_pair(E.second.LastUse, E.first()));
+  std::sort(ByLastUse.begin(), ByLastUse.end());
+
+  unsigned NumRemoved = 0;
+  for (const auto &E : ByLastUse) {
+    if (TotalSize <= MaxSize)
+      break;
+    // Remove the metadata first so that the entry stops being visible.
+    llvm::sys::fs::remove(getEntryPath(E.second, ".meta"));
+    llvm::sys::fs::remove(getEntryPath(E.second, ".pch"));
+    TotalSize -= Entries[E.second].Size;
+    ++NumRemoved;
+  }
+  return NumRemoved;
+}
+
+unsigned PreambleCache::getNumHits() const {
+  llvm::MutexGuard Guard(Lock);
+  return NumHits;
+}
+
+unsigned PreambleCache::getNumMisses() const {
+  llvm::MutexGuard Guard(Lock);
+  return NumMisses;
+}
+
+unsigned PreambleCache::getNumStores() const {
+  llvm::MutexGuard Guard(Lock);
+  return NumStores;
+}
+
+IntrusiveRefCntPtr<PreambleCache> PreambleCache::getDefault() {
+  llvm::MutexGuard Guard(DefaultPreambleCache->Lock);
+  return DefaultPreambleCache->Cache;
+}
+
+void PreambleCache::setDefault(IntrusiveRefCntPtr<PreambleCache> Cache) {
+  llvm::MutexGuard Guard(DefaultPreambleCache->Lock);
+  DefaultPreambleCache->Cache = Cache;
+}
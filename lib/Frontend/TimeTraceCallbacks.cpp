@@ -0,0 +1,65 @@
+//===--- TimeTraceCallbacks.cpp - Trace time spent in each header ---------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Frontend/Utils.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Basic/TimeTrace.h"
+#include "clang/Lex/Preprocessor.h"
+using namespace clang;
+
+namespace {
+/// \brief Records a "Source" time trace region for each included file, from
+/// the point it is entered to the point it is left.
+class TimeTraceCallbacks : public PPCallbacks {
+  SourceManager &SM;
+
+  /// \brief The time trace region of each file on the include stack, or 0
+  /// for the files that aren't traced, i.e. the main file and the predefines.
+  SmallVector<unsigned, 16> Regions;
+
+public:
+  explicit TimeTraceCallbacks(SourceManager &SM) : SM(SM) {}
+
+  void FileChanged(SourceLocation Loc, FileChangeReason Reason,
+                   SrcMgr::CharacteristicKind FileType,
+                   FileID PrevFID) override;
+};
+}
+
+void TimeTraceCallbacks::FileChanged(SourceLocation Loc,
+                                     FileChangeReason Reason,
+                                     SrcMgr::CharacteristicKind FileType,
+                                     FileID PrevFID) {
+  switch (Reason) {
+  case EnterFile: {
+    unsigned Region = 0;
+    if (SM.getIncludeLoc(SM.getFileID(Loc)).isValid())
+      Region = timeTraceProfilerBegin(
+          "Source", [&] { return SM.getBufferName(Loc).str(); });
+    Regions.push_back(Region);
+    break;
+  }
+
+  case ExitFile:
+    if (Regions.empty())
+      break;
+    if (unsigned Region = Regions.pop_back_val())
+      timeTraceProfilerEnd(Region);
+    break;
+
+  case SystemHeaderPragma:
+  case RenameFile:
+    break;
+  }
+}
+
+void clang::AttachTimeTraceCallbacks(Preprocessor &PP) {
+  PP.addPPCallbacks(
+      llvm::make_unique<TimeTraceCallbacks>(PP.getSourceManager()));
+}
@@ -0,0 +1,387 @@
+//===--- SymbolIndex.cpp - On-disk index of symbol occurrences ------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the SymbolIndex and SymbolIndexBuilder classes.
+//
+//  A symbol index file is laid out as follows, all integers being 32-bit
+//  little-endian:
+//
+//    header:             magic, version, number of files, number of symbols,
+//                        number of occurrences, size of the string table
+//    files:              per file, sorted by path: path, first occurrence,
+//                        number of occurrences
+//    symbols:            per symbol, sorted by USR: USR, first entry in the
+//                        symbol occurrences, number of entries
+//    symbol occurrences: per symbol, the indices of its occurrences
+//    occurrences:        per occurrence, grouped by file and sorted by
+//                        position: symbol, file, line, column, roles
+//    strings:            the null-terminated paths and USRs, referred to by
+//                        their offsets
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Index/SymbolIndex.h"
+#include "clang/Basic/FileManager.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <tuple>
+
+using namespace clang;
+using namespace clang::index;
+using namespace llvm::support;
+
+static const char Magic[4] = { 'C', 'S', 'Y', 'M' };
+static const uint32_t Version = 1;
+
+static const unsigned HeaderSize = 24;
+static const unsigned FileRecordSize = 12;
+static const unsigned SymbolRecordSize = 12;
+static const unsigned OccurrenceRecordSize = 20;
+
+static uint32_t read32(const unsigned char *P, unsigned Field = 0) {
+  return endian::read<uint32_t, little, unaligned>(P + Field * 4);
+}
+
+//===----------------------------------------------------------------------===//
+// SymbolIndex
+//===----------------------------------------------------------------------===//
+
+SymbolIndex::SymbolIndex(std::unique_ptr<llvm::MemoryBuffer> Buffer)
+    : Buffer(std::move(Buffer)), Files(nullptr), Symbols(nullptr),
+      SymbolOccurrences(nullptr), Occurrences(nullptr), NumFiles(0),
+      NumSymbols(0), NumOccurrences(0) {}
+
+SymbolIndex::~SymbolIndex() {}
+
+std::unique_ptr<SymbolIndex> SymbolIndex::load(StringRef Path,
+                                               std::string &Error) {
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer =
+      llvm::MemoryBuffer::getFile(Path, -1, /*RequiresNullTerminator=*/false);
+  if (!Buffer) {
+    Error = "could not read '" + Path.str() + "': " +
+            Buffer.getError().message();
+    return nullptr;
+  }
+
+  StringRef Data = (*Buffer)->getBuffer();
+  const unsigned char *Start =
+      reinterpret_cast<const unsigned char *>(Data.data());
+  if (Data.size() < HeaderSize || !Data.startswith(StringRef(Magic, 4)) ||
+      read32(Start, 1) != Version) {
+    Error = "'" + Path.str() + "' is not a symbol index";
+    return nullptr;
+  }
+
+  uint64_t NumFiles = read32(Start, 2);
+  uint64_t NumSymbols = read32(Start, 3);
+  uint64_t NumOccurrences = read32(Start, 4);
+  uint64_t StringsSize = read32(Start, 5);
+  uint64_t FilesOffset = HeaderSize;
+  uint64_t SymbolsOffset = FilesOffset + NumFiles * FileRecordSize;
+  uint64_t SymbolOccurrencesOffset =
+      SymbolsOffset + NumSymbols * SymbolRecordSize;
+  uint64_t OccurrencesOffset = SymbolOccurrencesOffset + NumOccurrences * 4;
+  uint64_t StringsOffset =
+      OccurrencesOffset + NumOccurrences * OccurrenceRecordSize;
+  // Every string is null-terminated, so reading one stops within the table.
+  if (StringsOffset + StringsSize != Data.size() ||
+      (StringsSize && Data.back() != '\0')) {
+    Error = "symbol index '" + Path.str() + "' is corrupt";
+    return nullptr;
+  }
+
+  std::unique_ptr<SymbolIndex> Index(new SymbolIndex(std::move(*Buffer)));
+  Index->Files = Start + FilesOffset;
+  Index->Symbols = Start + SymbolsOffset;
+  Index->SymbolOccurrences = Start + SymbolOccurrencesOffset;
+  Index->Occurrences = Start + OccurrencesOffset;
+  Index->Strings = Data.substr(StringsOffset);
+  Index->NumFiles = NumFiles;
+  Index->NumSymbols = NumSymbols;
+  Index->NumOccurrences = NumOccurrences;
+  return Index;
+}
+
+StringRef SymbolIndex::getString(uint32_t Offset) const {
+  if (Offset >= Strings.size())
+    return StringRef();
+  return StringRef(Strings.data() + Offset);
+}
+
+StringRef SymbolIndex::getFilePath(unsigned I) const {
+  if (I >= NumFiles)
+    return StringRef();
+  return getString(read32(Files + I * FileRecordSize));
+}
+
+bool SymbolIndex::getOccurrence(unsigned I,
+                                SymbolOccurrence &Occurrence) const {
+  const unsigned char *Record = Occurrences + I * OccurrenceRecordSize;
+  uint32_t Symbol = read32(Record, 0);
+  uint32_t File = read32(Record, 1);
+  if (Symbol >= NumSymbols || File >= NumFiles)
+    return false;
+  Occurrence.USR = getString(read32(Symbols + Symbol * SymbolRecordSize));
+  Occurrence.FilePath = getFilePath(File);
+  Occurrence.Line = read32(Record, 2);
+  Occurrence.Column = read32(Record, 3);
+  Occurrence.Roles = read32(Record, 4);
+  return true;
+}
+
+bool SymbolIndex::findFile(StringRef FilePath, unsigned &I) const {
+  unsigned Low = 0, High = NumFiles;
+  while (Low < High) {
+    unsigned Mid = Low + (High - Low) / 2;
+    if (getFilePath(Mid) < FilePath)
+      Low = Mid + 1;
+    else
+      High = Mid;
+  }
+  I = Low;
+  return Low != NumFiles && getFilePath(Low) == FilePath;
+}
+
+bool SymbolIndex::forEachOccurrence(
+    StringRef USR,
+    llvm::function_ref<bool(const SymbolOccurrence &)> Receiver) const {
+  unsigned Low = 0, High = NumSymbols;
+  while (Low < High) {
+    unsigned Mid = Low + (High - Low) / 2;
+    if (getString(read32(Symbols + Mid * SymbolRecordSize)) < USR)
+      Low = Mid + 1;
+    else
+      High = Mid;
+  }
+  if (Low == NumSymbols ||
+      getString(read32(Symbols + Low * SymbolRecordSize)) != USR)
+    return true;
+
+  const unsigned char *Record = Symbols + Low * SymbolRecordSize;
+  uint64_t First = read32(Record, 1), Num = read32(Record, 2);
+  if (First + Num > NumOccurrences)
+    return true;
+  for (uint64_t I = First, E = First + Num; I != E; ++I) {
+    uint32_t OccurrenceIndex = read32(SymbolOccurrences + I * 4);
+    SymbolOccurrence Occurrence;
+    if (OccurrenceIndex >= NumOccurrences ||
+        !getOccurrence(OccurrenceIndex, Occurrence))
+      continue;
+    if (!Receiver(Occurrence))
+      return false;
+  }
+  return true;
+}
+
+bool SymbolIndex::forEachOccurrenceInFile(
+    StringRef FilePath,
+    llvm::function_ref<bool(const SymbolOccurrence &)> Receiver) const {
+  unsigned File;
+  if (!findFile(FilePath, File))
+    return true;
+
+  const unsigned char *Record = Files + File * FileRecordSize;
+  uint64_t First = read32(Record, 1), Num = read32(Record, 2);
+  if (First + Num > NumOccurrences)
+    return true;
+  for (uint64_t I = First, E = First + Num; I != E; ++I) {
+    SymbolOccurrence Occurrence;
+    if (!getOccurrence(I, Occurrence))
+      continue;
+    if (!Receiver(Occurrence))
+      return false;
+  }
+  return true;
+}
+
+//===----------------------------------------------------------------------===//
+// SymbolIndexBuilder
+//===----------------------------------------------------------------------===//
+
+void SymbolIndexBuilder::beginFile(StringRef FilePath) {
+  Segments[FilePath];
+}
+
+void SymbolIndexBuilder::addOccurrence(StringRef USR, StringRef FilePath,
+                                       unsigned Line, unsigned Column,
+                                       unsigned Roles) {
+  Occurrence O;
+  O.USR = USRs.insert(USR).first->getKey();
+  O.Line = Line;
+  O.Column = Column;
+  O.Roles = Roles;
+  Segments[FilePath].push_back(O);
+}
+
+void SymbolIndexBuilder::sortAndUnique(std::vector<Occurrence> &Segment) {
+  std::sort(Segment.begin(), Segment.end(),
+            [](const Occurrence &LHS, const Occurrence &RHS) {
+    return std::tie(LHS.Line, LHS.Column, LHS.USR) <
+           std::tie(RHS.Line, RHS.Column, RHS.USR);
+  });
+
+  // A header included by several translation units reports the same
+  // occurrences several times; keep one of each, with all their roles.
+  std::vector<Occurrence>::iterator Out = Segment.begin();
+  for (std::vector<Occurrence>::iterator I = Segment.begin(),
+                                         E = Segment.end();
+       I != E; ++I) {
+    if (Out != Segment.begin()) {
+      Occurrence &Last = *(Out - 1);
+      if (Last.Line == I->Line && Last.Column == I->Column &&
+          Last.USR == I->USR) {
+        Last.Roles |= I->Roles;
+        continue;
+      }
+    }
+    *Out++ = *I;
+  }
+  Segment.erase(Out, Segment.end());
+}
+
+bool SymbolIndexBuilder::write(StringRef Path, std::string &Error) const {
+  typedef std::pair<StringRef, std::vector<Occurrence>> Segment;
+  std::vector<Segment> AllSegments;
+
+  // Keep the segments of the other files from the index as it is now, which
+  // may include some that were written since this builder was created. An
+  // index that cannot be read is written anew.
+  std::string LoadError;
+  std::unique_ptr<SymbolIndex> Existing = SymbolIndex::load(Path, LoadError);
+  if (Existing) {
+    for (unsigned I = 0, N = Existing->getNumFiles(); I != N; ++I) {
+      StringRef FilePath = Existing->getFilePath(I);
+      if (FilePath.empty() || Segments.count(FilePath))
+        continue;
+      AllSegments.push_back(Segment(FilePath, std::vector<Occurrence>()));
+      std::vector<Occurrence> &Kept = AllSegments.back().second;
+      Existing->forEachOccurrenceInFile(FilePath,
+                                        [&](const SymbolOccurrence &SO) {
+        Occurrence O;
+        O.USR = SO.USR;
+        O.Line = SO.Line;
+        O.Column = SO.Column;
+        O.Roles = SO.Roles;
+        Kept.push_back(O);
+        return true;
+      });
+    }
+  }
+  for (llvm::StringMap<std::vector<Occurrence>>::const_iterator
+           I = Segments.begin(), E = Segments.end();
+       I != E; ++I) {
+    AllSegments.push_back(Segment(I->getKey(), I->getValue()));
+    sortAndUnique(AllSegments.back().second);
+  }
+  std::sort(AllSegments.begin(), AllSegments.end(),
+            [](const Segment &LHS, const Segment &RHS) {
+    return LHS.first < RHS.first;
+  });
+
+  // Number the symbols in the order of their USRs.
+  llvm::StringMap<uint32_t> SymbolIDs;
+  uint64_t NumOccurrences = 0;
+  for (const Segment &S : AllSegments) {
+    for (const Occurrence &O : S.second)
+      SymbolIDs.insert(std::make_pair(O.USR, 0));
+    NumOccurrences += S.second.size();
+  }
+  std::vector<StringRef> SortedUSRs;
+  SortedUSRs.reserve(SymbolIDs.size());
+  for (llvm::StringMap<uint32_t>::iterator I = SymbolIDs.begin(),
+                                           E = SymbolIDs.end();
+       I != E; ++I)
+    SortedUSRs.push_back(I->getKey());
+  std::sort(SortedUSRs.begin(), SortedUSRs.end());
+  for (unsigned I = 0, N = SortedUSRs.size(); I != N; ++I)
+    SymbolIDs[SortedUSRs[I]] = I;
+
+  std::string Strings;
+  uint64_t StringsSize = 0;
+  for (const Segment &S : AllSegments)
+    StringsSize += S.first.size() + 1;
+  for (StringRef USR : SortedUSRs)
+    StringsSize += USR.size() + 1;
+  if (NumOccurrences > UINT32_MAX || StringsSize > UINT32_MAX) {
+    Error = "symbol index '" + Path.str() + "' would be too large";
+    return false;
+  }
+  Strings.reserve(StringsSize);
+  auto addString = [&](StringRef Str) -> uint32_t {
+    uint32_t Offset = Strings.size();
+    Strings += Str;
+    Strings += '\0';
+    return Offset;
+  };
+
+  // Group the occurrences by symbol, keeping them in the order of their
+  // files and positions.
+  std::vector<uint32_t> SymbolStart(SortedUSRs.size() + 1, 0);
+  for (const Segment &S : AllSegments)
+    for (const Occurrence &O : S.second)
+      ++SymbolStart[SymbolIDs[O.USR] + 1];
+  for (unsigned I = 1, N = SymbolStart.size(); I != N; ++I)
+    SymbolStart[I] += SymbolStart[I - 1];
+  std::vector<uint32_t> SymbolOccurrences(NumOccurrences);
+  {
+    std::vector<uint32_t> Next(SymbolStart.begin(), SymbolStart.end() - 1);
+    uint32_t OccurrenceIndex = 0;
+    for (const Segment &S : AllSegments)
+      for (const Occurrence &O : S.second)
+        SymbolOccurrences[Next[SymbolIDs[O.USR]]++] = OccurrenceIndex++;
+  }
+
+  // Replace the file atomically, so that readers never see a partial index.
+  if (std::error_code EC = writeFileAtomically(Path, [&](raw_ostream &OS) {
+        endian::Writer<little> LE(OS);
+        OS.write(Magic, 4);
+        LE.write<uint32_t>(Version);
+        LE.write<uint32_t>(AllSegments.size());
+        LE.write<uint32_t>(SortedUSRs.size());
+        LE.write<uint32_t>(NumOccurrences);
+        LE.write<uint32_t>(StringsSize);
+
+        uint32_t FirstOccurrence = 0;
+        for (const Segment &S : AllSegments) {
+          LE.write<uint32_t>(addString(S.first));
+          LE.write<uint32_t>(FirstOccurrence);
+          LE.write<uint32_t>(S.second.size());
+          FirstOccurrence += S.second.size();
+        }
+        for (unsigned I = 0, N = SortedUSRs.size(); I != N; ++I) {
+          LE.write<uint32_t>(addString(SortedUSRs[I]));
+          LE.write<uint32_t>(SymbolStart[I]);
+          LE.write<uint32_t>(SymbolStart[I + 1] - SymbolStart[I]);
+        }
+        for (uint32_t OccurrenceIndex : SymbolOccurrences)
+          LE.write<uint32_t>(OccurrenceIndex);
+        for (unsigned File = 0, N = AllSegments.size(); File != N; ++File) {
+          for (const Occurrence &O : AllSegments[File].second) {
+            LE.write<uint32_t>(SymbolIDs[O.USR]);
+            LE.write<uint32_t>(File);
+            LE.write<uint32_t>(O.Line);
+            LE.write<uint32_t>(O.Column);
+            LE.write<uint32_t>(O.Roles);
+          }
+        }
+        OS << Strings;
+
+        // The existing index may be mapped; release it before the file is
+        // replaced.
+        Existing.reset();
+      })) {
+    Error = "could not write symbol index '" + Path.str() + "': " +
+            EC.message();
+    return false;
+  }
+  return true;
+}
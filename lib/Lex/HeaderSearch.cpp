@@ -16,7 +16,9 @@
 #include "clang/Basic/IdentifierTable.h"
 #include "clang/Lex/ExternalPreprocessorSource.h"
 #include "clang/Lex/HeaderMap.h"
+#include "clang/Lex/HeaderSearchIndex.h"
 #include "clang/Lex/HeaderSearchOptions.h"
+#include "clang/Lex/IncludeGuardDatabase.h"
 #include "clang/Lex/LexDiagnostic.h"
 #include "clang/Lex/Lexer.h"
 #include "clang/Lex/Preprocessor.h"
@@ -56,6 +58,7 @@ HeaderSearch::HeaderSearch(IntrusiveRefCntPtr<HeaderSearchOptions> HSOpts,
                            const LangOptions &LangOpts,
                            const TargetInfo *Target)
     : HSOpts(HSOpts), Diags(Diags), FileMgr(SourceMgr.getFileManager()),
+      SourceMgr(SourceMgr),
       FrameworkMap(64), ModMap(SourceMgr, Diags, LangOpts, Target, *this),
       LangOpts(LangOpts) {
   AngledDirIdx = 0;
@@ -66,7 +69,17 @@ HeaderSearch::HeaderSearch(IntrusiveRefCntPtr<HeaderSearchOptions> HSOpts,
   ExternalSource = nullptr;
   NumIncluded = 0;
   NumMultiIncludeFileOptzn = 0;
+  NumIncludeGuardDatabaseHits = 0;
   NumFrameworkLookups = NumSubFrameworkLookups = 0;
+
+  if (!HSOpts->IncludeGuardDatabasePath.empty())
+    GuardDB.reset(new IncludeGuardDatabase(HSOpts->IncludeGuardDatabasePath));
+
+  // Directories in a virtual file system overlay need not have modification
+  // times that change with their contents, so snapshots cannot be trusted.
+  if (!HSOpts->HeaderSearchIndexPath.empty() && HSOpts->VFSOverlayFiles.empty())
+    SearchIndex.reset(
+        new HeaderSearchIndex(HSOpts->HeaderSearchIndexPath, FileMgr));
 }
 
 HeaderSearch::~HeaderSearch() {
@@ -92,9 +105,15 @@ void HeaderSearch::PrintStats() {
   fprintf(stderr, "  %d #include/#include_next/#import.\n", NumIncluded);
   fprintf(stderr, "    %d #includes skipped due to"
           " the multi-include optimization.\n", NumMultiIncludeFileOptzn);
+  if (GuardDB)
+    fprintf(stderr, "    %d #includes skipped due to"
+            " the include guard database.\n", NumIncludeGuardDatabaseHits);
 
   fprintf(stderr, "%d framework lookups.\n", NumFrameworkLookups);
   fprintf(stderr, "%d subframework lookups.\n", NumSubFrameworkLookups);
+
+  if (SearchIndex)
+    SearchIndex->PrintStats();
 }
 
 /// CreateHeaderMap - This method returns a HeaderMap for the specified
@@ -303,6 +322,13 @@ const FileEntry *DirectoryLookup::LookupFile(
       RelativePath->append(Filename.begin(), Filename.end());
     }
 
+    // The header search index can often tell that the file is not in this
+    // directory without a probe.  Files the file manager already knows,
+    // which include any virtual files, are looked up as usual.
+    if (HS.SearchIndex && !HS.FileMgr.hasSeenFile(TmpDir) &&
+        !HS.SearchIndex->mayContain(getDir(), Filename))
+      return nullptr;
+
     return getFileAndSuggestModule(HS, TmpDir, getDir(),
                                    isSystemHeaderDirectory(),
                                    SuggestedModule);
@@ -1033,6 +1059,37 @@ void HeaderSearch::MarkFileModuleHeader(const FileEntry *FE,
   HFI.setHeaderRole(Role);
 }
 
+/// \brief Return the path identifying \p File in the include guard database,
+/// which is absolute so that compilations run from any directory share it.
+std::string HeaderSearch::getIncludeGuardDatabasePath(const FileEntry *File) {
+  SmallString<256> Path(File->getName());
+  FileMgr.FixupRelativePath(Path);
+  llvm::sys::fs::make_absolute(Path);
+  return Path.str();
+}
+
+void HeaderSearch::SetFileControllingMacro(
+    const FileEntry *File, const IdentifierInfo *ControllingMacro) {
+  getFileInfo(File).ControllingMacro = ControllingMacro;
+  if (GuardDB && !SourceMgr.isFileOverridden(File))
+    GuardDB->setControllingMacro(getIncludeGuardDatabasePath(File),
+                                 File->getSize(), File->getModificationTime(),
+                                 ControllingMacro->getName());
+}
+
+void HeaderSearch::saveIncludeGuardDatabase() {
+  // The database is only a cache, so there is nothing to be done if it
+  // cannot be written; the next compilation will just learn less from it.
+  if (GuardDB)
+    GuardDB->save();
+}
+
+void HeaderSearch::saveHeaderSearchIndex() {
+  // As with the include guard database, failing to write is harmless.
+  if (SearchIndex)
+    SearchIndex->save();
+}
+
 bool HeaderSearch::ShouldEnterIncludeFile(Preprocessor &PP,
                                           const FileEntry *File,
                                           bool isImport, Module *M) {
@@ -1068,6 +1125,18 @@ bool HeaderSearch::ShouldEnterIncludeFile(Preprocessor &PP,
       ++NumMultiIncludeFileOptzn;
       return false;
     }
+  } else if (GuardDB && !M && !FileInfo.NumIncludes &&
+             !SourceMgr.isFileOverridden(File)) {
+    // We have not seen this file before, but an earlier compilation may have
+    // recorded the macro that guards it.  If so, and if that macro is
+    // defined, we need not even open the file.
+    StringRef Macro = GuardDB->getControllingMacro(
+        getIncludeGuardDatabasePath(File), File->getSize(),
+        File->getModificationTime());
+    if (!Macro.empty() && PP.isMacroDefined(Macro)) {
+      ++NumIncludeGuardDatabaseHits;
+      return false;
+    }
   }
 
   // Increment the number of times this file has been included.
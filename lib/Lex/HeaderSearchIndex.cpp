@@ -0,0 +1,228 @@
+//===--- HeaderSearchIndex.cpp - Snapshots of search directories ----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the HeaderSearchIndex class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Lex/HeaderSearchIndex.h"
+#include "clang/Basic/CharInfo.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/VirtualFileSystem.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cstdio>
+#include <tuple>
+
+using namespace clang;
+
+/// \brief The first line of every index, naming its format.
+static const char Signature[] = "clang-header-search-index 1";
+
+/// \brief Take the next line from \p Buffer, returning false if there is no
+/// complete line left.
+static bool takeLine(StringRef &Buffer, StringRef &Line) {
+  size_t End = Buffer.find('\n');
+  if (End == StringRef::npos)
+    return false;
+  Line = Buffer.substr(0, End);
+  Buffer = Buffer.substr(End + 1);
+  return true;
+}
+
+/// \brief Parse the index in \p Buffer, calling \p Visit with each snapshot.
+///
+/// An index consists of the signature line and then, for each directory, a
+/// "<mtime> <time taken> <number of names> <path>" line followed by one line
+/// per name. Parsing stops at anything malformed.
+static void
+parseIndex(StringRef Buffer,
+           llvm::function_ref<void(StringRef Dir, time_t ModTime,
+                                   time_t Taken, ArrayRef<StringRef> Names)>
+               Visit) {
+  StringRef Line;
+  if (!takeLine(Buffer, Line) || Line != Signature)
+    return;
+
+  SmallVector<StringRef, 64> Names;
+  while (takeLine(Buffer, Line)) {
+    StringRef ModTime, Taken, Count, Dir;
+    std::tie(ModTime, Line) = Line.split(' ');
+    std::tie(Taken, Line) = Line.split(' ');
+    std::tie(Count, Dir) = Line.split(' ');
+    long long M, T;
+    unsigned N;
+    if (ModTime.getAsInteger(10, M) || Taken.getAsInteger(10, T) ||
+        Count.getAsInteger(10, N) || Dir.empty())
+      return;
+
+    Names.clear();
+    for (unsigned I = 0; I != N; ++I) {
+      if (!takeLine(Buffer, Line))
+        return;
+      Names.push_back(Line);
+    }
+    Visit(Dir, M, T, Names);
+  }
+}
+
+HeaderSearchIndex::HeaderSearchIndex(StringRef Path, FileManager &FileMgr)
+    : Path(Path), FileMgr(FileMgr), NumSnapshotsReused(0),
+      NumSnapshotsTaken(0), NumProbesAvoided(0) {
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer =
+      llvm::MemoryBuffer::getFile(Path, -1, /*RequiresNullTerminator=*/false);
+  if (!Buffer)
+    return;
+
+  parseIndex((*Buffer)->getBuffer(),
+             [&](StringRef Dir, time_t ModTime, time_t Taken,
+                 ArrayRef<StringRef> Names) {
+    // A snapshot taken within the second its directory was last modified
+    // may have missed a later change in that second.
+    if (ModTime >= Taken)
+      return;
+    Snapshot &S = Snapshots[Dir];
+    S.ModTime = ModTime;
+    S.Taken = Taken;
+    S.Names.clear();
+    for (StringRef Name : Names)
+      S.Names.insert(Name);
+  });
+}
+
+const HeaderSearchIndex::Snapshot *
+HeaderSearchIndex::getSnapshot(const DirectoryEntry *Dir) {
+  llvm::DenseMap<const DirectoryEntry *, const Snapshot *>::iterator Known =
+      Current.find(Dir);
+  if (Known != Current.end())
+    return Known->second;
+
+  // Key the snapshot on the absolute path, so that compilations run from
+  // any directory share it.
+  SmallString<256> DirPath(Dir->getName());
+  FileMgr.FixupRelativePath(DirPath);
+  llvm::sys::fs::make_absolute(DirPath);
+
+  vfs::FileSystem &FS = *FileMgr.getVirtualFileSystem();
+  llvm::ErrorOr<vfs::Status> Status = FS.status(DirPath);
+  if (!Status)
+    return Current[Dir] = nullptr;
+  time_t ModTime = Status->getLastModificationTime().toEpochTime();
+
+  llvm::StringMap<Snapshot>::iterator Existing = Snapshots.find(DirPath);
+  if (Existing != Snapshots.end() && Existing->second.ModTime == ModTime) {
+    ++NumSnapshotsReused;
+    return Current[Dir] = &Existing->second;
+  }
+
+  Snapshot &S = Snapshots[DirPath];
+  S.ModTime = ModTime;
+  S.Taken = time(nullptr);
+  S.Names.clear();
+  bool Saveable = DirPath.find('\n') == StringRef::npos;
+  std::error_code EC;
+  for (vfs::directory_iterator I = FS.dir_begin(DirPath, EC), E;
+       I != E && !EC; I.increment(EC)) {
+    StringRef Name = llvm::sys::path::filename(I->getName());
+    Saveable &= Name.find('\n') == StringRef::npos;
+    S.Names.insert(Name.lower());
+  }
+  if (EC) {
+    Snapshots.erase(DirPath);
+    Retaken.erase(DirPath);
+    return Current[Dir] = nullptr;
+  }
+
+  ++NumSnapshotsTaken;
+  if (Saveable && S.ModTime < S.Taken)
+    Retaken.insert(DirPath);
+  else
+    Retaken.erase(DirPath);
+  return Current[Dir] = &S;
+}
+
+bool HeaderSearchIndex::mayContain(const DirectoryEntry *Dir,
+                                   StringRef Filename) {
+  // Only the first component of the file name can be checked. Leave alone
+  // anything that is not simply the name of an entry, and anything a
+  // case-insensitive or name-normalizing file system might match
+  // differently.
+  if (Filename.empty() || llvm::sys::path::is_absolute(Filename))
+    return true;
+  StringRef First = *llvm::sys::path::begin(Filename);
+  if (First.empty() || First == "." || First == ".." ||
+      First.back() == '.' || First.back() == ' ')
+    return true;
+  for (char C : First)
+    if (!isASCII(C))
+      return true;
+
+  const Snapshot *S = getSnapshot(Dir);
+  if (!S || S->Names.count(First.lower()))
+    return true;
+
+  ++NumProbesAvoided;
+  return false;
+}
+
+bool HeaderSearchIndex::save() {
+  if (Retaken.empty())
+    return true;
+
+  // Keep the snapshots of other directories that are in the file now,
+  // including any that other compilations wrote after we read it.
+  std::unique_ptr<llvm::MemoryBuffer> Existing;
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer =
+      llvm::MemoryBuffer::getFile(Path, -1, /*RequiresNullTerminator=*/false);
+  if (Buffer)
+    Existing = std::move(*Buffer);
+
+  // Replace the file atomically, so that readers never see a partial index.
+  if (writeFileAtomically(Path, [&](raw_ostream &OS) {
+        OS << Signature << '\n';
+        for (llvm::StringSet<>::iterator I = Retaken.begin(),
+                                         E = Retaken.end();
+             I != E; ++I) {
+          const Snapshot &S = Snapshots[I->getKey()];
+          OS << static_cast<long long>(S.ModTime) << ' '
+             << static_cast<long long>(S.Taken) << ' ' << S.Names.size()
+             << ' ' << I->getKey() << '\n';
+          for (llvm::StringSet<>::const_iterator N = S.Names.begin(),
+                                                 NE = S.Names.end();
+               N != NE; ++N)
+            OS << N->getKey() << '\n';
+        }
+        if (Existing)
+          parseIndex(Existing->getBuffer(),
+                     [&](StringRef Dir, time_t ModTime, time_t Taken,
+                         ArrayRef<StringRef> Names) {
+            if (Retaken.count(Dir))
+              return;
+            OS << static_cast<long long>(ModTime) << ' '
+               << static_cast<long long>(Taken) << ' ' << Names.size() << ' '
+               << Dir << '\n';
+            for (StringRef Name : Names)
+              OS << Name << '\n';
+          });
+      }))
+    return false;
+
+  Retaken.clear();
+  return true;
+}
+
+void HeaderSearchIndex::PrintStats() const {
+  fprintf(stderr, "%u header search index snapshots reused, %u taken.\n",
+          NumSnapshotsReused, NumSnapshotsTaken);
+  fprintf(stderr, "  %u directory probes avoided.\n", NumProbesAvoided);
+}
@@ -0,0 +1,116 @@
+//===--- IncludeGuardDatabase.cpp - Include guards across compiles --------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the IncludeGuardDatabase class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Lex/IncludeGuardDatabase.h"
+#include "clang/Basic/FileManager.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include <tuple>
+
+using namespace clang;
+
+/// \brief The first line of every database, naming its format.
+static const char Signature[] = "clang-include-guard-database 1";
+
+IncludeGuardDatabase::IncludeGuardDatabase(StringRef Path) : Path(Path) {
+  read(Path, Entries);
+}
+
+void IncludeGuardDatabase::read(StringRef Path,
+                                llvm::StringMap<Entry> &Entries) {
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer =
+      llvm::MemoryBuffer::getFile(Path, -1, /*RequiresNullTerminator=*/false);
+  if (!Buffer)
+    return;
+
+  StringRef Line, Rest = (*Buffer)->getBuffer();
+  std::tie(Line, Rest) = Rest.split('\n');
+  if (Line != Signature)
+    return;
+
+  // Skip any line that does not parse, such as one cut short.
+  while (!Rest.empty()) {
+    std::tie(Line, Rest) = Rest.split('\n');
+    StringRef Size, ModTime, Macro, FilePath;
+    std::tie(Size, Line) = Line.split(' ');
+    std::tie(ModTime, Line) = Line.split(' ');
+    std::tie(Macro, FilePath) = Line.split(' ');
+
+    Entry E;
+    long long Time;
+    if (Size.getAsInteger(10, E.Size) || ModTime.getAsInteger(10, Time) ||
+        Macro.empty() || FilePath.empty())
+      continue;
+    E.ModTime = Time;
+    E.Macro = Macro.str();
+    Entries[FilePath] = std::move(E);
+  }
+}
+
+StringRef IncludeGuardDatabase::getControllingMacro(StringRef FilePath,
+                                                    uint64_t Size,
+                                                    time_t ModTime) const {
+  llvm::StringMap<Entry>::const_iterator Known = Entries.find(FilePath);
+  if (Known == Entries.end() || Known->second.Size != Size ||
+      Known->second.ModTime != ModTime)
+    return StringRef();
+  return Known->second.Macro;
+}
+
+void IncludeGuardDatabase::setControllingMacro(StringRef FilePath,
+                                               uint64_t Size, time_t ModTime,
+                                               StringRef Macro) {
+  if (getControllingMacro(FilePath, Size, ModTime) == Macro)
+    return;
+
+  Entry E;
+  E.Size = Size;
+  E.ModTime = ModTime;
+  E.Macro = Macro.str();
+  NewEntries[FilePath] = std::move(E);
+}
+
+bool IncludeGuardDatabase::save() {
+  if (NewEntries.empty())
+    return true;
+
+  // Start again from what is in the file now, which may include entries
+  // that other compilations wrote after we read it.
+  llvm::StringMap<Entry> Merged;
+  read(Path, Merged);
+  for (llvm::StringMap<Entry>::iterator I = NewEntries.begin(),
+                                        E = NewEntries.end();
+       I != E; ++I)
+    Merged[I->getKey()] = I->getValue();
+
+  // Replace the file atomically, so that readers never see a partial
+  // database.
+  if (writeFileAtomically(Path, [&](raw_ostream &OS) {
+        OS << Signature << '\n';
+        for (llvm::StringMap<Entry>::iterator I = Merged.begin(),
+                                              E = Merged.end();
+             I != E; ++I)
+          OS << I->getValue().Size << ' '
+             << static_cast<long long>(I->getValue().ModTime) << ' '
+             << I->getValue().Macro << ' ' << I->getKey() << '\n';
+      }))
+    return false;
+
+  for (llvm::StringMap<Entry>::iterator I = NewEntries.begin(),
+                                        E = NewEntries.end();
+       I != E; ++I)
+    Entries[I->getKey()] = I->getValue();
+  NewEntries.clear();
+  return true;
+}
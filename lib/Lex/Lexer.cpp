@@ -26,6 +26,12 @@
 #include "llvm/Support/ConvertUTF.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#elif __ALTIVEC__
+#include <altivec.h>
+#undef bool
+#endif
 using namespace clang;
 
 //===----------------------------------------------------------------------===//
@@ -1468,9 +1474,90 @@ bool Lexer::tryConsumeIdentifierUTF8Char(const char *&CurPtr) {
   return true;
 }
 
+//===----------------------------------------------------------------------===//
+// Vectorized scanning of runs of uninteresting characters.
+//===----------------------------------------------------------------------===//
+//
+// Each of these skips the characters of a kind starting at CurPtr sixteen at
+// a time, returning a pointer at or before the first character that is not of
+// that kind. They never read at or past BufferEnd, so the caller scans what
+// remains a character at a time, exactly as it would without them.
+
+#ifdef __SSE2__
+/// \brief Return a mask of the bytes of \p V in the range [\p Lo, \p Hi],
+/// none of which may be above 0x7F.
+static inline __m128i getBytesInRange(__m128i V, char Lo, char Hi) {
+  return _mm_and_si128(_mm_cmpgt_epi8(V, _mm_set1_epi8(Lo - 1)),
+                       _mm_cmplt_epi8(V, _mm_set1_epi8(Hi + 1)));
+}
+#endif
+
+/// \brief Skip characters in [_A-Za-z0-9].
+static const char *skipIdentifierBodyChars(const char *CurPtr,
+                                           const char *BufferEnd) {
+#ifdef __SSE2__
+  const __m128i CaseBit = _mm_set1_epi8(0x20);
+  const __m128i Underscores = _mm_set1_epi8('_');
+  while (CurPtr + 16 <= BufferEnd) {
+    __m128i V = _mm_loadu_si128((const __m128i *)CurPtr);
+    // Setting the case bit maps the upper case letters, and nothing else,
+    // onto the lower case ones.
+    __m128i Body = _mm_or_si128(
+        _mm_or_si128(getBytesInRange(_mm_or_si128(V, CaseBit), 'a', 'z'),
+                     getBytesInRange(V, '0', '9')),
+        _mm_cmpeq_epi8(V, Underscores));
+    unsigned Mask = _mm_movemask_epi8(Body);
+    if (Mask != 0xFFFF)
+      return CurPtr + llvm::countTrailingZeros(~Mask);
+    CurPtr += 16;
+  }
+#endif
+  return CurPtr;
+}
+
+/// \brief Skip spaces and tabs.
+static const char *skipBlankChars(const char *CurPtr, const char *BufferEnd) {
+#ifdef __SSE2__
+  const __m128i Spaces = _mm_set1_epi8(' ');
+  const __m128i Tabs = _mm_set1_epi8('\t');
+  while (CurPtr + 16 <= BufferEnd) {
+    __m128i V = _mm_loadu_si128((const __m128i *)CurPtr);
+    unsigned Mask = _mm_movemask_epi8(
+        _mm_or_si128(_mm_cmpeq_epi8(V, Spaces), _mm_cmpeq_epi8(V, Tabs)));
+    if (Mask != 0xFFFF)
+      return CurPtr + llvm::countTrailingZeros(~Mask);
+    CurPtr += 16;
+  }
+#endif
+  return CurPtr;
+}
+
+/// \brief Skip characters other than '\0', '\n' and '\r', which are the only
+/// ones that can end a line comment.
+static const char *skipLineCommentChars(const char *CurPtr,
+                                        const char *BufferEnd) {
+#ifdef __SSE2__
+  const __m128i Nuls = _mm_setzero_si128();
+  const __m128i Newlines = _mm_set1_epi8('\n');
+  const __m128i Returns = _mm_set1_epi8('\r');
+  while (CurPtr + 16 <= BufferEnd) {
+    __m128i V = _mm_loadu_si128((const __m128i *)CurPtr);
+    unsigned Mask = _mm_movemask_epi8(
+        _mm_or_si128(_mm_cmpeq_epi8(V, Nuls),
+                     _mm_or_si128(_mm_cmpeq_epi8(V, Newlines),
+                                  _mm_cmpeq_epi8(V, Returns))));
+    if (Mask != 0)
+      return CurPtr + llvm::countTrailingZeros(Mask);
+    CurPtr += 16;
+  }
+#endif
+  return CurPtr;
+}
+
 bool Lexer::LexIdentifier(Token &Result, const char *CurPtr) {
   // Match [_A-Za-z0-9]*, we have already matched [_A-Za-z$]
   unsigned Size;
+  CurPtr = skipIdentifierBodyChars(CurPtr, BufferEnd);
   unsigned char C = *CurPtr++;
   while (isIdentifierBody(C))
     C = *CurPtr++;
@@ -1957,11 +2044,13 @@ bool Lexer::SkipWhitespace(Token &Result, const char *CurPtr,
   // Whitespace - Skip it, then return the token after the whitespace.
   bool SawNewline = isVerticalWhitespace(CurPtr[-1]);
 
-  unsigned char Char = *CurPtr;
+  unsigned char Char;
 
   // Skip consecutive spaces efficiently.
   while (1) {
     // Skip horizontal whitespace very aggressively.
+    CurPtr = skipBlankChars(CurPtr, BufferEnd);
+    Char = *CurPtr;
     while (isHorizontalWhitespace(Char))
       Char = *++CurPtr;
 
@@ -1977,7 +2066,7 @@ bool Lexer::SkipWhitespace(Token &Result, const char *CurPtr,
 
     // OK, but handle newline.
     SawNewline = true;
-    Char = *++CurPtr;
+    ++CurPtr;
   }
 
   // If the client wants us to return whitespace, return it now.
@@ -2028,6 +2117,7 @@ bool Lexer::SkipLineComment(Token &Result, const char *CurPtr,
   // them.  As such, optimize for this case with the inner loop.
   char C;
   do {
+    CurPtr = skipLineCommentChars(CurPtr, BufferEnd);
     C = *CurPtr;
     // Skip over characters in the fast loop.
     while (C != 0 &&                // Potentially EOF.
@@ -2233,13 +2323,6 @@ static bool isEndOfBlockCommentWithEscapedNewLine(const char *CurPtr,
   return true;
 }
 
-#ifdef __SSE2__
-#include <emmintrin.h>
-#elif __ALTIVEC__
-#include <altivec.h>
-#undef bool
-#endif
-
 /// We have just read from input the / and * characters that started a comment.
 /// Read until we find the * and / characters that terminate the comment.
 /// Note that we don't bother decoding trigraphs or escaped newlines in block
@@ -2907,7 +2990,7 @@ LexNextToken:
 
   // Small amounts of horizontal whitespace is very common between tokens.
   if ((*CurPtr == ' ') || (*CurPtr == '\t')) {
-    ++CurPtr;
+    CurPtr = skipBlankChars(CurPtr + 1, BufferEnd);
     while ((*CurPtr == ' ') || (*CurPtr == '\t'))
       ++CurPtr;
 
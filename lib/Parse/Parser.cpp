@@ -16,6 +16,7 @@
 #include "clang/AST/ASTConsumer.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/DeclTemplate.h"
+#include "clang/Basic/TimeTrace.h"
 #include "clang/Parse/ParseDiagnostic.h"
 #include "clang/Sema/DeclSpec.h"
 #include "clang/Sema/ParsedTemplate.h"
@@ -534,6 +535,9 @@ void Parser::LateTemplateParserCleanupCallback(void *P) {
 /// action tells us to.  This returns true if the EOF was encountered.
 bool Parser::ParseTopLevelDecl(DeclGroupPtrTy &Result) {
   DestroyTemplateIdAnnotationsRAIIObj CleanupRAII(TemplateIds);
+  TimeTraceScope TimeScope("ParseTopLevelDecl", [&] {
+    return Tok.getLocation().printToString(PP.getSourceManager());
+  });
 
   // Skip over the EOF token, flagging end of previous input for incremental
   // processing
@@ -959,6 +963,9 @@ Decl *Parser::ParseFunctionDefinition(ParsingDeclarator &D,
   // Poison SEH identifiers so they are flagged as illegal in function bodies.
   PoisonSEHIdentifiersRAIIObject PoisonSEHIdentifiers(*this, true);
   const DeclaratorChunk::FunctionTypeInfo &FTI = D.getFunctionTypeInfo();
+  TimeTraceScope TimeScope("ParseFunctionDefinition", [&] {
+    return Actions.GetNameForDeclarator(D).getName().getAsString();
+  });
 
   // If this is C90 and the declspecs were completely missing, fudge in an
   // implicit int.  We do this here because this is the only place where
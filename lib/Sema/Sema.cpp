@@ -37,6 +37,7 @@
 #include "clang/Sema/ScopeInfo.h"
 #include "clang/Sema/SemaConsumer.h"
 #include "clang/Sema/TemplateDeduction.h"
+#include "clang/Sema/TemplateInstantiationStats.h"
 #include "llvm/ADT/APFloat.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallSet.h"
@@ -99,7 +100,8 @@ Sema::Sema(Preprocessor &pp, ASTContext &ctxt, ASTConsumer &consumer,
     MSAsmLabelNameCounter(0),
     GlobalNewDeleteDeclared(false),
     TUKind(TUKind),
-    NumSFINAEErrors(0),
+    NumSFINAEErrors(0), NumOverloadCandidates(0),
+    NumViableOverloadCandidates(0), NumNonViableConversionsReused(0),
     CachedFakeTopLevelModule(nullptr),
     AccessCheckingSFINAE(false), InNonInstantiationSFINAEContext(false),
     NonInstantiationEntries(0), ArgumentPackSubstitutionIndex(-1),
@@ -329,6 +331,11 @@ void Sema::addExternalSource(ExternalSemaSource *E) {
 void Sema::PrintStats() const {
   llvm::errs() << "\n*** Semantic Analysis Stats:\n";
   llvm::errs() << NumSFINAEErrors << " SFINAE diagnostics trapped.\n";
+  llvm::errs() << NumOverloadCandidates << " overload candidates considered, "
+               << NumViableOverloadCandidates << " viable.\n";
+  llvm::errs() << NumNonViableConversionsReused
+               << " candidates rejected by a known non-viable conversion, "
+               << NonViableConversions.size() << " such conversions known.\n";
 
   BumpAlloc.PrintStats();
   AnalysisWarnings.PrintStats();
@@ -4718,6 +4718,127 @@ static bool TryCopyInitialization(const CanQualType FromQTy,
   return !ICS.isBad();
 }
 
+/// \brief Determine whether conversions to and from \p T can no longer
+/// change later in the translation unit, because every class it involves
+/// is complete.
+static bool isConversionSettled(QualType T) {
+  while (true) {
+    T = T.getNonReferenceType();
+    if (const PointerType *PT = T->getAs<PointerType>()) {
+      T = PT->getPointeeType();
+    } else if (const MemberPointerType *MPT = T->getAs<MemberPointerType>()) {
+      if (!isConversionSettled(QualType(MPT->getClass(), 0)))
+        return false;
+      T = MPT->getPointeeType();
+    } else if (const ArrayType *AT = T->getAsArrayTypeUnsafe()) {
+      T = AT->getElementType();
+    } else {
+      break;
+    }
+  }
+
+  if (T->isBuiltinType())
+    return true;
+  if (const EnumType *ET = T->getAs<EnumType>())
+    return ET->getDecl()->isComplete();
+  if (const RecordType *RT = T->getAs<RecordType>()) {
+    const RecordDecl *Def = RT->getDecl()->getDefinition();
+    return Def && !Def->isBeingDefined();
+  }
+  return false;
+}
+
+/// \brief Determine whether a failure to copy-initialize \p ParamType from
+/// \p Arg during overload resolution depends on nothing but the types
+/// involved and the value kind of \p Arg, and so can be remembered for
+/// every other argument of the same type and value kind.
+static bool isCacheableArgumentConversion(Sema &S, Expr *Arg,
+                                          QualType ParamType) {
+  if (!S.getLangOpts().CPlusPlus || S.getLangOpts().ObjC1)
+    return false;
+
+  // Bit-fields, string literals and initializer lists convert differently
+  // from other expressions of the same type.
+  if (Arg->getObjectKind() != OK_Ordinary || Arg->getSourceBitField())
+    return false;
+  Expr *Bare = Arg->IgnoreParens();
+  if (isa<InitListExpr>(Bare) || isa<StringLiteral>(Bare))
+    return false;
+
+  QualType ArgType = Arg->getType();
+  if (ArgType->isPlaceholderType() || ArgType->isDependentType() ||
+      ParamType->isDependentType())
+    return false;
+
+  // An integer may be a null pointer constant, which converts to pointers
+  // and to the classes that can be constructed from them.
+  if (ArgType->isIntegralOrUnscopedEnumerationType() &&
+      !ParamType.getNonReferenceType()->isArithmeticType())
+    return false;
+
+  return isConversionSettled(ArgType) && isConversionSettled(ParamType);
+}
+
+/// \brief Try to copy-initialize the parameter of type \p ParamType of an
+/// overload candidate from the argument \p Arg, as TryCopyInitialization
+/// does, without repeating the attempt when the same conversion has already
+/// been found to be impossible.
+static ImplicitConversionSequence
+TryArgumentInitialization(Sema &S, Expr *Arg, QualType ParamType,
+                          bool SuppressUserConversions,
+                          bool AllowExplicit = false) {
+  bool Cacheable = isCacheableArgumentConversion(S, Arg, ParamType);
+  Sema::ArgumentConversionKey Key;
+  if (Cacheable) {
+    Key = std::make_pair(
+        std::make_pair(S.Context.getCanonicalType(Arg->getType())
+                           .getAsOpaquePtr(),
+                       S.Context.getCanonicalType(ParamType).getAsOpaquePtr()),
+        Arg->getValueKind() | SuppressUserConversions << 2 |
+            AllowExplicit << 3);
+
+    // Rebuild the bad conversion with this argument's own types, so that
+    // it is diagnosed exactly as the original attempt would have been.
+    llvm::DenseMap<Sema::ArgumentConversionKey, unsigned>::iterator Known =
+        S.NonViableConversions.find(Key);
+    if (Known != S.NonViableConversions.end()) {
+      ++S.NumNonViableConversionsReused;
+      BadConversionSequence::FailureKind Kind =
+          static_cast<BadConversionSequence::FailureKind>(Known->second >> 1);
+      ImplicitConversionSequence ICS;
+      if (Known->second & 1)
+        ICS.setBad(Kind, Arg, ParamType);
+      else
+        ICS.setBad(Kind, Arg->getType(), ParamType);
+      return ICS;
+    }
+  }
+
+  DiagnosticsEngine &Diags = S.getDiagnostics();
+  unsigned NumErrors = Diags.getNumErrors();
+  unsigned NumWarnings = Diags.getNumWarnings();
+  unsigned NumSFINAEErrors = S.NumSFINAEErrors;
+  ImplicitConversionSequence ICS =
+      TryCopyInitialization(S, Arg, ParamType, SuppressUserConversions,
+                            /*InOverloadResolution=*/true,
+                            /*AllowObjCWritebackConversion=*/
+                              S.getLangOpts().ObjCAutoRefCount,
+                            AllowExplicit);
+
+  // Only remember failures that said nothing along the way, since a
+  // diagnostic, or an error trapped by an enclosing SFINAE context, may not
+  // be produced the same way in another context.
+  if (Cacheable && ICS.isBad() && ICS.Bad.getFromType() == Arg->getType() &&
+      ICS.Bad.getToType() == ParamType &&
+      (!ICS.Bad.FromExpr || ICS.Bad.FromExpr == Arg) &&
+      Diags.getNumErrors() == NumErrors &&
+      Diags.getNumWarnings() == NumWarnings &&
+      S.NumSFINAEErrors == NumSFINAEErrors)
+    S.NonViableConversions[Key] =
+        ICS.Bad.Kind << 1 | (ICS.Bad.FromExpr != nullptr);
+  return ICS;
+}
+
 /// TryObjectArgumentInitialization - Try to initialize the object
 /// parameter of the given member function (@c Method) from the
 /// expression @p From.
@@ -5695,12 +5816,8 @@ Sema::AddOverloadCandidate(FunctionDecl *Function,
       // parameter of F.
       QualType ParamType = Proto->getParamType(ArgIdx);
       Candidate.Conversions[ArgIdx]
-        = TryCopyInitialization(*this, Args[ArgIdx], ParamType,
-                                SuppressUserConversions,
-                                /*InOverloadResolution=*/true,
-                                /*AllowObjCWritebackConversion=*/
-                                  getLangOpts().ObjCAutoRefCount,
-                                AllowExplicit);
+        = TryArgumentInitialization(*this, Args[ArgIdx], ParamType,
+                                    SuppressUserConversions, AllowExplicit);
       if (Candidate.Conversions[ArgIdx].isBad()) {
         Candidate.Viable = false;
         Candidate.FailureKind = ovl_fail_bad_conversion;
@@ -6056,11 +6173,8 @@ Sema::AddMethodCandidate(CXXMethodDecl *Method, DeclAccessPair FoundDecl,
       // parameter of F.
       QualType ParamType = Proto->getParamType(ArgIdx);
       Candidate.Conversions[ArgIdx + 1]
-        = TryCopyInitialization(*this, Args[ArgIdx], ParamType,
-                                SuppressUserConversions,
-                                /*InOverloadResolution=*/true,
-                                /*AllowObjCWritebackConversion=*/
-                                  getLangOpts().ObjCAutoRefCount);
+        = TryArgumentInitialization(*this, Args[ArgIdx], ParamType,
+                                    SuppressUserConversions);
       if (Candidate.Conversions[ArgIdx + 1].isBad()) {
         Candidate.Viable = false;
         Candidate.FailureKind = ovl_fail_bad_conversion;
@@ -8499,11 +8613,14 @@ OverloadCandidateSet::BestViableFunction(Sema &S, SourceLocation Loc,
                                          bool UserDefinedConversion) {
   // Find the best viable function.
   Best = end();
+  S.NumOverloadCandidates += size();
   for (iterator Cand = begin(); Cand != end(); ++Cand) {
-    if (Cand->Viable)
+    if (Cand->Viable) {
+      ++S.NumViableOverloadCandidates;
       if (Best == end() || isBetterOverloadCandidate(S, *Cand, *Best, Loc,
                                                      UserDefinedConversion))
         Best = Cand;
+    }
   }
 
   // If we didn't find any viable functions, abort.
@@ -18,11 +18,13 @@
 #include "clang/AST/DeclTemplate.h"
 #include "clang/AST/Expr.h"
 #include "clang/Basic/LangOptions.h"
+#include "clang/Basic/TimeTrace.h"
 #include "clang/Sema/DeclSpec.h"
 #include "clang/Sema/Initialization.h"
 #include "clang/Sema/Lookup.h"
 #include "clang/Sema/Template.h"
 #include "clang/Sema/TemplateDeduction.h"
+#include "clang/Sema/TemplateInstantiationStats.h"
 
 using namespace clang;
 using namespace sema;
@@ -1940,6 +1942,14 @@ Sema::InstantiateClass(SourceLocation PointOfInstantiation,
     return true;
   Pattern = PatternDef;
 
+  TimeTraceScope TimeScope("InstantiateClass", [&]() -> std::string {
+    std::string Name;
+    llvm::raw_string_ostream OS(Name);
+    Instantiation->getNameForDiagnostic(OS, getPrintingPolicy(),
+                                        /*Qualified=*/true);
+    return OS.str();
+  });
+
   // \brief Record the point of instantiation.
   if (MemberSpecializationInfo *MSInfo 
         = Instantiation->getMemberSpecializationInfo()) {
@@ -1954,6 +1964,9 @@ Sema::InstantiateClass(SourceLocation PointOfInstantiation,
   InstantiatingTemplate Inst(*this, PointOfInstantiation, Instantiation);
   if (Inst.isInvalid())
     return true;
+  TemplateInstantiationStats::Scope StatsScope(
+      TemplateInstStats.get(), TemplateInstantiationStats::IK_Class,
+      Instantiation, Pattern, ActiveTemplateInstantiations.size());
 
   // Enter the scope of this instantiation. We don't use
   // PushDeclContext because we don't have a scope.
@@ -0,0 +1,124 @@
+//===--- TemplateInstantiationStats.cpp - Cost of instantiations ----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the TemplateInstantiationStats class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Sema/TemplateInstantiationStats.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Decl.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Basic/TimeTrace.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+
+using namespace clang;
+
+TemplateInstantiationStats::TemplateInstantiationStats(ASTContext &Ctx)
+    : Ctx(Ctx) {
+  Ctx.setCountNodesAllocated(true);
+}
+
+void TemplateInstantiationStats::begin(InstantiationKind Kind,
+                                       const NamedDecl *Instantiation,
+                                       const Decl *Pattern, unsigned Depth) {
+  std::pair<llvm::DenseMap<const Decl *, unsigned>::iterator, bool> Known =
+      SpecializationIndex.insert(
+          std::make_pair(Instantiation, Specializations.size()));
+  if (Known.second) {
+    Specialization S;
+    llvm::raw_string_ostream OS(S.Name);
+    Instantiation->getNameForDiagnostic(OS, Ctx.getPrintingPolicy(),
+                                        /*Qualified=*/true);
+    OS.flush();
+    S.Kind = Kind;
+    PresumedLoc PLoc =
+        Ctx.getSourceManager().getPresumedLoc(Pattern->getLocation());
+    if (PLoc.isValid())
+      S.PatternLoc = std::string(PLoc.getFilename()) + ":" +
+                     llvm::utostr(PLoc.getLine());
+    S.Depth = 0;
+    S.Time = S.SelfTime = 0;
+    S.Nodes = S.SelfNodes = 0;
+    Specializations.push_back(std::move(S));
+  }
+
+  unsigned Index = Known.first->second;
+  Specialization &S = Specializations[Index];
+  S.Depth = std::max(S.Depth, Depth);
+
+  ActiveInstantiation A;
+  A.Index = Index;
+  A.StartNodes = Ctx.getNumNodesAllocated();
+  A.NestedTime = Clock::duration::zero();
+  A.NestedNodes = 0;
+  A.Start = Clock::now();
+  Active.push_back(A);
+}
+
+void TemplateInstantiationStats::end() {
+  assert(!Active.empty() && "no instantiation in progress");
+  ActiveInstantiation A = Active.back();
+  Active.pop_back();
+
+  Clock::duration Time = Clock::now() - A.Start;
+  unsigned Nodes = Ctx.getNumNodesAllocated() - A.StartNodes;
+  Specialization &S = Specializations[A.Index];
+  S.Time +=
+      std::chrono::duration_cast<std::chrono::microseconds>(Time).count();
+  S.SelfTime += std::chrono::duration_cast<std::chrono::microseconds>(
+                    Time - A.NestedTime).count();
+  S.Nodes += Nodes;
+  S.SelfNodes += Nodes - A.NestedNodes;
+
+  if (!Active.empty()) {
+    Active.back().NestedTime += Time;
+    Active.back().NestedNodes += Nodes;
+  }
+}
+
+static StringRef getKindName(TemplateInstantiationStats::InstantiationKind K) {
+  switch (K) {
+  case TemplateInstantiationStats::IK_Class:
+    return "class";
+  case TemplateInstantiationStats::IK_Function:
+    return "function";
+  case TemplateInstantiationStats::IK_Variable:
+    return "variable";
+  }
+  llvm_unreachable("unknown instantiation kind");
+}
+
+void TemplateInstantiationStats::write(raw_ostream &OS,
+                                       StringRef MainFile) const {
+  std::vector<const Specialization *> Sorted;
+  for (const Specialization &S : Specializations)
+    Sorted.push_back(&S);
+  std::stable_sort(Sorted.begin(), Sorted.end(),
+                   [](const Specialization *A, const Specialization *B) {
+                     return A->SelfTime > B->SelfTime;
+                   });
+
+  OS << "{\"file\":";
+  writeJSONString(OS, MainFile);
+  OS << ",\"specializations\":[";
+  for (unsigned I = 0, N = Sorted.size(); I != N; ++I) {
+    const Specialization &S = *Sorted[I];
+    OS << (I ? ",\n" : "\n") << "{\"name\":";
+    writeJSONString(OS, S.Name);
+    OS << ",\"kind\":\"" << getKindName(S.Kind) << "\",\"pattern\":";
+    writeJSONString(OS, S.PatternLoc);
+    OS << ",\"depth\":" << S.Depth << ",\"time_us\":" << S.Time
+       << ",\"self_time_us\":" << S.SelfTime << ",\"nodes\":" << S.Nodes
+       << ",\"self_nodes\":" << S.SelfNodes << "}";
+  }
+  OS << "\n]}\n";
+}
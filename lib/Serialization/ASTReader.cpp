@@ -47,6 +47,7 @@
 #include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/Bitcode/BitstreamReader.h"
+#include "llvm/Support/Compression.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
@@ -959,6 +960,33 @@ ASTDeclContextNameLookupTrait::ReadData(internal_key_type,
   return std::make_pair(Start, Start + NumDecls);
 }
 
+bool ASTReader::InflateDeclContextBlob(ModuleFile &M, StringRef &Blob,
+                                       uint64_t UncompressedSize) {
+  llvm::TimeRecord Start;
+  if (TimeStats)
+    Start = llvm::TimeRecord::getCurrentTime(/*Start=*/true);
+  SmallString<0> Uncompressed;
+  if (llvm::zlib::uncompress(Blob, Uncompressed, UncompressedSize) !=
+      llvm::zlib::StatusOK) {
+    Error("could not decompress a declaration context in AST file");
+    return true;
+  }
+  if (TimeStats) {
+    DeclContextDecompressionTime += llvm::TimeRecord::getCurrentTime(/*Start=*/false);
+    DeclContextDecompressionTime -= Start;
+  }
+  ++NumCompressedDeclContextsRead;
+  CompressedDeclContextBytesRead += Blob.size();
+  UncompressedDeclContextBytesRead += Uncompressed.size();
+
+  // The lexical declarations and the lookup table are read in place, so keep
+  // the inflated blob alive, and suitably aligned, for the module's lifetime.
+  M.InflatedDeclContextBlobs.push_back(
+      llvm::MemoryBuffer::getMemBufferCopy(Uncompressed));
+  Blob = M.InflatedDeclContextBlobs.back()->getBuffer();
+  return false;
+}
+
 bool ASTReader::ReadDeclContextStorage(ModuleFile &M,
                                        BitstreamCursor &Cursor,
                                    const std::pair<uint64_t, uint64_t> &Offsets,
@@ -972,7 +1000,10 @@ bool ASTReader::ReadDeclContextStorage(ModuleFile &M,
     StringRef Blob;
     unsigned Code = Cursor.ReadCode();
     unsigned RecCode = Cursor.readRecord(Code, Record, &Blob);
-    if (RecCode != DECL_CONTEXT_LEXICAL) {
+    if (RecCode == DECL_CONTEXT_LEXICAL_COMPRESSED && !Record.empty()) {
+      if (InflateDeclContextBlob(M, Blob, Record[0]))
+        return true;
+    } else if (RecCode != DECL_CONTEXT_LEXICAL) {
       Error("Expected lexical block");
       return true;
     }
@@ -989,7 +1020,10 @@ bool ASTReader::ReadDeclContextStorage(ModuleFile &M,
     StringRef Blob;
     unsigned Code = Cursor.ReadCode();
     unsigned RecCode = Cursor.readRecord(Code, Record, &Blob);
-    if (RecCode != DECL_CONTEXT_VISIBLE) {
+    if (RecCode == DECL_CONTEXT_VISIBLE_COMPRESSED && Record.size() > 1) {
+      if (InflateDeclContextBlob(M, Blob, Record[1]))
+        return true;
+    } else if (RecCode != DECL_CONTEXT_VISIBLE) {
       Error("Expected visible lookup table block");
       return true;
     }
@@ -1156,6 +1190,41 @@ resolveFileRelativeToOriginalDir(const std::string &Filename,
   return currPCHPath.str();
 }
 
+std::unique_ptr<llvm::MemoryBuffer>
+ASTReader::ReadSLocBufferBlob(BitstreamCursor &SLocEntryCursor,
+                              StringRef Name) {
+  RecordData Record;
+  StringRef Blob;
+  unsigned Code = SLocEntryCursor.ReadCode();
+  unsigned RecCode = SLocEntryCursor.readRecord(Code, Record, &Blob);
+
+  if (RecCode == SM_SLOC_BUFFER_BLOB)
+    return llvm::MemoryBuffer::getMemBuffer(Blob.drop_back(1), Name);
+
+  if (RecCode != SM_SLOC_BUFFER_BLOB_COMPRESSED || Record.empty()) {
+    Error("AST record has invalid code");
+    return nullptr;
+  }
+
+  llvm::TimeRecord Start;
+  if (TimeStats)
+    Start = llvm::TimeRecord::getCurrentTime(/*Start=*/true);
+  SmallString<0> Uncompressed;
+  if (llvm::zlib::uncompress(Blob, Uncompressed, Record[0]) !=
+      llvm::zlib::StatusOK) {
+    Error("could not decompress a buffer in AST file");
+    return nullptr;
+  }
+  if (TimeStats) {
+    BufferDecompressionTime += llvm::TimeRecord::getCurrentTime(/*Start=*/false);
+    BufferDecompressionTime -= Start;
+  }
+  ++NumCompressedBuffersRead;
+  CompressedBufferBytesRead += Blob.size();
+  UncompressedBufferBytesRead += Uncompressed.size();
+  return llvm::MemoryBuffer::getMemBufferCopy(Uncompressed, Name);
+}
+
 bool ASTReader::ReadSLocEntry(int ID) {
   if (ID == 0)
     return false;
@@ -1226,17 +1295,10 @@ bool ASTReader::ReadSLocEntry(int ID) {
                               /*isSystemFile=*/FileCharacter != SrcMgr::C_User);
     if (OverriddenBuffer && !ContentCache->BufferOverridden &&
         ContentCache->ContentsEntry == ContentCache->OrigEntry) {
-      unsigned Code = SLocEntryCursor.ReadCode();
-      Record.clear();
-      unsigned RecCode = SLocEntryCursor.readRecord(Code, Record, &Blob);
-      
-      if (RecCode != SM_SLOC_BUFFER_BLOB) {
-        Error("AST record has invalid code");
+      std::unique_ptr<llvm::MemoryBuffer> Buffer =
+          ReadSLocBufferBlob(SLocEntryCursor, File->getName());
+      if (!Buffer)
         return true;
-      }
-      
-      std::unique_ptr<llvm::MemoryBuffer> Buffer
-        = llvm::MemoryBuffer::getMemBuffer(Blob.drop_back(1), File->getName());
       SourceMgr.overrideFileContents(File, std::move(Buffer));
     }
 
@@ -1253,18 +1315,10 @@ bool ASTReader::ReadSLocEntry(int ID) {
         (F->Kind == MK_ImplicitModule || F->Kind == MK_ExplicitModule)) {
       IncludeLoc = getImportLocation(F);
     }
-    unsigned Code = SLocEntryCursor.ReadCode();
-    Record.clear();
-    unsigned RecCode
-      = SLocEntryCursor.readRecord(Code, Record, &Blob);
-
-    if (RecCode != SM_SLOC_BUFFER_BLOB) {
-      Error("AST record has invalid code");
-      return true;
-    }
-
     std::unique_ptr<llvm::MemoryBuffer> Buffer =
-        llvm::MemoryBuffer::getMemBuffer(Blob.drop_back(1), Name);
+        ReadSLocBufferBlob(SLocEntryCursor, Name);
+    if (!Buffer)
+      return true;
     SourceMgr.createFileID(std::move(Buffer), FileCharacter, ID,
                            BaseOffset + Offset, IncludeLoc);
     break;
@@ -1891,6 +1945,21 @@ InputFile ASTReader::getInputFile(ModuleFile &F, unsigned ID, bool Complain) {
   if (F.InputFilesLoaded[ID-1].isNotFound())
     return InputFile();
 
+  // Track the time spent finding and validating input files, for
+  // -print-stats.
+  struct ValidationTimer {
+    llvm::TimeRecord *Total;
+    explicit ValidationTimer(llvm::TimeRecord *Total) : Total(Total) {
+      if (Total)
+        *Total -= llvm::TimeRecord::getCurrentTime(/*Start=*/true);
+    }
+    ~ValidationTimer() {
+      if (Total)
+        *Total += llvm::TimeRecord::getCurrentTime(/*Start=*/false);
+    }
+  } Timer(TimeStats ? &InputFileValidationTime : nullptr);
+  ++NumInputFilesValidated;
+
   // Go find this input file.
   BitstreamCursor &Cursor = F.InputFilesCursor;
   SavedStreamPosition SavedPosition(Cursor);
@@ -2062,7 +2131,13 @@ ASTReader::ReadControlBlock(ModuleFile &F,
 
       // All user input files reside at the index range [0, NumUserInputs), and
       // system input files reside at [NumUserInputs, NumInputs).
-      if (!DisableValidation) {
+      //
+      // When validating lazily, each input file is validated when
+      // ReadSLocEntry first needs it instead, so the files a translation unit
+      // never looks into are never stat'ed. A file found to be out of date
+      // then can only be diagnosed, since the module can no longer be
+      // rebuilt.
+      if (!DisableValidation && !HSOpts.ModulesValidateInputFilesLazily) {
         bool Complain = (ClientLoadCapabilities & ARR_OutOfDate) == 0;
 
         // If we are reading a module, we will create a verification timestamp,
@@ -3414,6 +3489,12 @@ ASTReader::ASTReadResult ASTReader::ReadAST(const std::string &FileName,
       // SourceManager.
       SourceMgr.getLoadedSLocEntryByID(Index);
     }
+
+    // Map the ID of the file the AST file was built from into the source
+    // manager.
+    if (!F.OriginalSourceFileID.isInvalid())
+      F.OriginalSourceFileID = FileID::get(
+          F.SLocEntryBaseID + F.OriginalSourceFileID.getOpaqueValue() - 1);
   }
 
   // Setup the import locations and notify the module manager that we've
@@ -3486,10 +3567,6 @@ ASTReader::ASTReadResult ASTReader::ReadAST(const std::string &FileName,
 
   ModuleFile &PrimaryModule = ModuleMgr.getPrimaryModule();
   if (!PrimaryModule.OriginalSourceFileID.isInvalid()) {
-    PrimaryModule.OriginalSourceFileID 
-      = FileID::get(PrimaryModule.SLocEntryBaseID
-                    + PrimaryModule.OriginalSourceFileID.getOpaqueValue() - 1);
-
     // If this AST file is a precompiled preamble, then set the
     // preamble file ID of the source manager to the file source file
     // from which the preamble was built.
@@ -3508,9 +3585,10 @@ ASTReader::ASTReadResult ASTReader::ReadAST(const std::string &FileName,
                        PreviousGeneration);
   }
 
-  if (PP.getHeaderSearchInfo()
-          .getHeaderSearchOpts()
-          .ModulesValidateOncePerBuildSession) {
+  const HeaderSearchOptions &HSOpts =
+      PP.getHeaderSearchInfo().getHeaderSearchOpts();
+  if (HSOpts.ModulesValidateOncePerBuildSession &&
+      !HSOpts.ModulesValidateInputFilesLazily) {
     // Now we are certain that the module and all modules it depends on are
     // up to date.  Create or update timestamp files for modules that are
     // located in the module cache (not for PCH files that could be anywhere
@@ -6643,6 +6721,24 @@ void ASTReader::PrintStats() {
     std::fprintf(stderr, "  %u/%u source location entries read (%f%%)\n",
                  NumSLocEntriesRead, TotalNumSLocEntries,
                  ((float)NumSLocEntriesRead/TotalNumSLocEntries * 100));
+  if (NumCompressedBuffersRead)
+    std::fprintf(stderr, "  %u compressed buffers read: %llu bytes inflated "
+                         "to %llu bytes in %f seconds\n",
+                 NumCompressedBuffersRead,
+                 (unsigned long long)CompressedBufferBytesRead,
+                 (unsigned long long)UncompressedBufferBytesRead,
+                 BufferDecompressionTime.getWallTime());
+  if (NumCompressedDeclContextsRead)
+    std::fprintf(stderr, "  %u compressed declaration contexts read: %llu "
+                         "bytes inflated to %llu bytes in %f seconds\n",
+                 NumCompressedDeclContextsRead,
+                 (unsigned long long)CompressedDeclContextBytesRead,
+                 (unsigned long long)UncompressedDeclContextBytesRead,
+                 DeclContextDecompressionTime.getWallTime());
+  if (NumInputFilesValidated)
+    std::fprintf(stderr, "  %u input files validated in %f seconds\n",
+                 NumInputFilesValidated,
+                 InputFileValidationTime.getWallTime());
   if (!TypesLoaded.empty())
     std::fprintf(stderr, "  %u/%u types read (%f%%)\n",
                  NumTypesLoaded, (unsigned)TypesLoaded.size(),
@@ -8483,14 +8579,18 @@ ASTReader::ASTReader(Preprocessor &PP, ASTContext &Context,
       FileMgr(PP.getFileManager()), PCHContainerOps(PCHContainerOps),
       Diags(PP.getDiagnostics()), SemaObj(nullptr), PP(PP), Context(Context),
       Consumer(nullptr), ModuleMgr(PP.getFileManager(), PCHContainerOps),
-      ReadTimer(std::move(ReadTimer)),
+      ReadTimer(std::move(ReadTimer)), TimeStats(false),
       isysroot(isysroot), DisableValidation(DisableValidation),
       AllowASTWithCompilerErrors(AllowASTWithCompilerErrors),
       AllowConfigurationMismatch(AllowConfigurationMismatch),
       ValidateSystemInputs(ValidateSystemInputs),
       UseGlobalIndex(UseGlobalIndex), TriedLoadingGlobalIndex(false),
       CurrSwitchCaseStmts(&SwitchCaseStmts), NumSLocEntriesRead(0),
-      TotalNumSLocEntries(0), NumStatementsRead(0), TotalNumStatements(0),
+      TotalNumSLocEntries(0), NumInputFilesValidated(0),
+      NumCompressedBuffersRead(0), CompressedBufferBytesRead(0),
+      UncompressedBufferBytesRead(0), NumCompressedDeclContextsRead(0),
+      CompressedDeclContextBytesRead(0), UncompressedDeclContextBytesRead(0),
+      NumStatementsRead(0), TotalNumStatements(0),
       NumMacrosRead(0), TotalNumMacros(0), NumIdentifierLookups(0),
       NumIdentifierLookupHits(0), NumSelectorsRead(0),
       NumMethodPoolEntriesRead(0), NumMethodPoolLookups(0),
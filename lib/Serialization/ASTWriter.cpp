@@ -46,6 +46,7 @@
 #include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/Bitcode/BitstreamWriter.h"
+#include "llvm/Support/Compression.h"
 #include "llvm/Support/EndianStream.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
@@ -945,6 +946,7 @@ void ASTWriter::WriteBlockInfoBlock() {
   RECORD(SM_SLOC_FILE_ENTRY);
   RECORD(SM_SLOC_BUFFER_ENTRY);
   RECORD(SM_SLOC_BUFFER_BLOB);
+  RECORD(SM_SLOC_BUFFER_BLOB_COMPRESSED);
   RECORD(SM_SLOC_EXPANSION_ENTRY);
 
   // Preprocessor Block.
@@ -1024,6 +1026,8 @@ void ASTWriter::WriteBlockInfoBlock() {
   RECORD(DECL_BLOCK);
   RECORD(DECL_CONTEXT_LEXICAL);
   RECORD(DECL_CONTEXT_VISIBLE);
+  RECORD(DECL_CONTEXT_LEXICAL_COMPRESSED);
+  RECORD(DECL_CONTEXT_VISIBLE_COMPRESSED);
   RECORD(DECL_NAMESPACE);
   RECORD(DECL_NAMESPACE_ALIAS);
   RECORD(DECL_USING);
@@ -1592,6 +1596,18 @@ static unsigned CreateSLocBufferBlobAbbrev(llvm::BitstreamWriter &Stream) {
   return Stream.EmitAbbrev(Abbrev);
 }
 
+/// \brief Create an abbreviation for the SLocEntry that refers to a
+/// buffer's compressed blob.
+static unsigned
+CreateSLocBufferBlobCompressedAbbrev(llvm::BitstreamWriter &Stream) {
+  using namespace llvm;
+  BitCodeAbbrev *Abbrev = new BitCodeAbbrev();
+  Abbrev->Add(BitCodeAbbrevOp(SM_SLOC_BUFFER_BLOB_COMPRESSED));
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 8)); // Uncompressed size
+  Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob)); // Compressed blob
+  return Stream.EmitAbbrev(Abbrev);
+}
+
 /// \brief Create an abbreviation for the SLocEntry that refers to a macro
 /// expansion.
 static unsigned CreateSLocExpansionAbbrev(llvm::BitstreamWriter &Stream) {
@@ -1811,8 +1827,40 @@ void ASTWriter::WriteSourceManagerBlock(SourceManager &SourceMgr,
   unsigned SLocFileAbbrv = CreateSLocFileAbbrev(Stream);
   unsigned SLocBufferAbbrv = CreateSLocBufferAbbrev(Stream);
   unsigned SLocBufferBlobAbbrv = CreateSLocBufferBlobAbbrev(Stream);
+  unsigned SLocBufferBlobCompressedAbbrv =
+      CreateSLocBufferBlobCompressedAbbrev(Stream);
   unsigned SLocExpansionAbbrv = CreateSLocExpansionAbbrev(Stream);
 
+  // Emit the contents of a buffer, compressed if requested and if that makes
+  // it smaller. The reader only inflates a buffer when its source location
+  // entry is loaded, and most never are.
+  bool CompressBuffers =
+      PP.getHeaderSearchInfo().getHeaderSearchOpts().ModulesCompressBuffers &&
+      llvm::zlib::isAvailable();
+  auto EmitBufferBlob = [&](const llvm::MemoryBuffer *Buffer, bool Compress) {
+    StringRef Contents(Buffer->getBufferStart(), Buffer->getBufferSize());
+    RecordData BlobRecord;
+    if (CompressBuffers && Compress) {
+      SmallString<0> Compressed;
+      if (llvm::zlib::compress(Contents, Compressed) ==
+              llvm::zlib::StatusOK &&
+          Compressed.size() < Contents.size()) {
+        BlobRecord.push_back(SM_SLOC_BUFFER_BLOB_COMPRESSED);
+        BlobRecord.push_back(Contents.size());
+        Stream.EmitRecordWithBlob(SLocBufferBlobCompressedAbbrv, BlobRecord,
+                                  Compressed);
+        return;
+      }
+    }
+
+    // We add one to the size so that we capture the trailing NULL
+    // that is required by llvm::MemoryBuffer::getMemBuffer (on
+    // the reader side).
+    BlobRecord.push_back(SM_SLOC_BUFFER_BLOB);
+    Stream.EmitRecordWithBlob(SLocBufferBlobAbbrv, BlobRecord,
+                              StringRef(Contents.data(), Contents.size() + 1));
+  };
+
   // Write out the source location entry table. We skip the first
   // entry, which is always the same dummy entry.
   std::vector<uint32_t> SLocEntryOffsets;
@@ -1871,34 +1919,24 @@ void ASTWriter::WriteSourceManagerBlock(SourceManager &SourceMgr,
         
         Stream.EmitRecordWithAbbrev(SLocFileAbbrv, Record);
         
-        if (Content->BufferOverridden) {
-          Record.clear();
-          Record.push_back(SM_SLOC_BUFFER_BLOB);
-          const llvm::MemoryBuffer *Buffer
-            = Content->getBuffer(PP.getDiagnostics(), PP.getSourceManager());
-          Stream.EmitRecordWithBlob(SLocBufferBlobAbbrv, Record,
-                                    StringRef(Buffer->getBufferStart(),
-                                              Buffer->getBufferSize() + 1));          
-        }
+        if (Content->BufferOverridden)
+          EmitBufferBlob(Content->getBuffer(PP.getDiagnostics(),
+                                            PP.getSourceManager()),
+                         /*Compress=*/true);
       } else {
         // The source location entry is a buffer. The blob associated
         // with this entry contains the contents of the buffer.
-
-        // We add one to the size so that we capture the trailing NULL
-        // that is required by llvm::MemoryBuffer::getMemBuffer (on
-        // the reader side).
         const llvm::MemoryBuffer *Buffer
           = Content->getBuffer(PP.getDiagnostics(), PP.getSourceManager());
         const char *Name = Buffer->getBufferIdentifier();
         Stream.EmitRecordWithBlob(SLocBufferAbbrv, Record,
                                   StringRef(Name, strlen(Name) + 1));
-        Record.clear();
-        Record.push_back(SM_SLOC_BUFFER_BLOB);
-        Stream.EmitRecordWithBlob(SLocBufferBlobAbbrv, Record,
-                                  StringRef(Buffer->getBufferStart(),
-                                                  Buffer->getBufferSize() + 1));
+        // The predefines buffer is preloaded by every reader, so inflating
+        // it would cost each load without saving any I/O.
+        bool IsPredefines = strcmp(Name, "<built-in>") == 0;
+        EmitBufferBlob(Buffer, /*Compress=*/!IsPredefines);
 
-        if (strcmp(Name, "<built-in>") == 0) {
+        if (IsPredefines) {
           PreloadSLocs.push_back(SLocEntryOffsets.size());
         }
       }
@@ -2731,6 +2769,26 @@ void ASTWriter::WriteType(QualType T) {
 // Declaration Serialization
 //===----------------------------------------------------------------------===//
 
+/// \brief Compress the blob of a DECL_CONTEXT_LEXICAL or DECL_CONTEXT_VISIBLE
+/// record when -fmodules-compress-buffers is in effect.
+///
+/// The reader inflates such a blob when it deserializes the declaration
+/// context, so small blobs, which would cost more to inflate than they save,
+/// are left alone.
+///
+/// \returns true if \p Compressed holds the compressed blob.
+bool ASTWriter::CompressDeclContextBlob(StringRef Blob,
+                                        SmallVectorImpl<char> &Compressed) {
+  const unsigned MinCompressedBlobSize = 1024;
+  if (Blob.size() < MinCompressedBlobSize ||
+      !PP->getHeaderSearchInfo().getHeaderSearchOpts().ModulesCompressBuffers ||
+      !llvm::zlib::isAvailable())
+    return false;
+
+  return llvm::zlib::compress(Blob, Compressed) == llvm::zlib::StatusOK &&
+         Compressed.size() < Blob.size();
+}
+
 /// \brief Write the block containing all of the declaration IDs
 /// lexically declared within the given DeclContext.
 ///
@@ -2743,12 +2801,21 @@ uint64_t ASTWriter::WriteDeclContextLexicalBlock(ASTContext &Context,
 
   uint64_t Offset = Stream.GetCurrentBitNo();
   RecordData Record;
-  Record.push_back(DECL_CONTEXT_LEXICAL);
   SmallVector<KindDeclIDPair, 64> Decls;
   for (const auto *D : DC->decls())
     Decls.push_back(std::make_pair(D->getKind(), GetDeclRef(D)));
 
   ++NumLexicalDeclContexts;
+  SmallString<0> Compressed;
+  if (CompressDeclContextBlob(bytes(Decls), Compressed)) {
+    Record.push_back(DECL_CONTEXT_LEXICAL_COMPRESSED);
+    Record.push_back(bytes(Decls).size());
+    Stream.EmitRecordWithBlob(DeclContextLexicalCompressedAbbrev, Record,
+                              Compressed);
+    return Offset;
+  }
+
+  Record.push_back(DECL_CONTEXT_LEXICAL);
   Stream.EmitRecordWithBlob(DeclContextLexicalAbbrev, Record, bytes(Decls));
   return Offset;
 }
@@ -3711,11 +3778,21 @@ uint64_t ASTWriter::WriteDeclContextVisibleBlock(ASTContext &Context,
 
   // Write the lookup table
   RecordData Record;
+  ++NumVisibleDeclContexts;
+  SmallString<0> Compressed;
+  if (CompressDeclContextBlob(LookupTable, Compressed)) {
+    Record.push_back(DECL_CONTEXT_VISIBLE_COMPRESSED);
+    Record.push_back(BucketOffset);
+    Record.push_back(LookupTable.size());
+    Stream.EmitRecordWithBlob(DeclContextVisibleLookupCompressedAbbrev, Record,
+                              Compressed);
+    return Offset;
+  }
+
   Record.push_back(DECL_CONTEXT_VISIBLE);
   Record.push_back(BucketOffset);
   Stream.EmitRecordWithBlob(DeclContextVisibleLookupAbbrev, Record,
                             LookupTable);
-  ++NumVisibleDeclContexts;
   return Offset;
 }
 
@@ -4045,6 +4122,8 @@ ASTWriter::ASTWriter(llvm::BitstreamWriter &Stream)
       TypeExtQualAbbrev(0),
       TypeFunctionProtoAbbrev(0), DeclParmVarAbbrev(0),
       DeclContextLexicalAbbrev(0), DeclContextVisibleLookupAbbrev(0),
+      DeclContextLexicalCompressedAbbrev(0),
+      DeclContextVisibleLookupCompressedAbbrev(0),
       UpdateVisibleAbbrev(0), DeclRecordAbbrev(0), DeclTypedefAbbrev(0),
       DeclVarAbbrev(0), DeclFieldAbbrev(0), DeclEnumAbbrev(0),
       DeclObjCIvarAbbrev(0), DeclCXXMethodAbbrev(0), DeclRefExprAbbrev(0),
@@ -100,6 +100,27 @@ AnalyzerOptions::mayInlineCXXMemberFunction(CXXInlineableMemberKind K) {
   return CXXMemberInliningMode >= K;
 }
 
+ExplorationStrategyKind AnalyzerOptions::getExplorationStrategy() {
+  if (ExplorationStrategy == ESK_NotSet) {
+    // Note, we have to add the string to the Config map for the ConfigDumper
+    // checker to function properly.
+    StringRef StrategyStr =
+        Config.insert(std::make_pair("exploration-strategy", "dfs"))
+            .first->second;
+    ExplorationStrategy =
+        llvm::StringSwitch<ExplorationStrategyKind>(StrategyStr)
+            .Case("dfs", ESK_DFS)
+            .Case("bfs", ESK_BFS)
+            .Case("bfs-block-dfs-contents", ESK_BFSBlockDFSContents)
+            .Case("unexplored-first", ESK_UnexploredFirst)
+            .Default(ESK_NotSet);
+    assert(ExplorationStrategy != ESK_NotSet &&
+           "Exploration strategy is invalid.");
+  }
+
+  return ExplorationStrategy;
+}
+
 static StringRef toString(bool b) { return b ? "true" : "false"; }
 
 StringRef AnalyzerOptions::getCheckerOption(StringRef CheckerName,
@@ -289,6 +310,12 @@ unsigned AnalyzerOptions::getGraphTrimInterval() {
   return GraphTrimInterval.getValue();
 }
 
+bool AnalyzerOptions::shouldTrimGraphAggressively() {
+  return getBooleanOption(AggressiveGraphTrimming,
+                          "aggressive-graph-trimming",
+                          /* Default = */ false);
+}
+
 unsigned AnalyzerOptions::getMaxTimesInlineLarge() {
   if (!MaxTimesInlineLarge.hasValue())
     MaxTimesInlineLarge = getOptionAsInteger("max-times-inline-large", 32);
@@ -314,6 +341,18 @@ unsigned AnalyzerOptions::getMaxNodesPerTopLevelFunction() {
   return MaxNodesPerTopLevelFunction.getValue();
 }
 
+unsigned AnalyzerOptions::getAnalysisShardCount() {
+  if (!AnalysisShardCount.hasValue())
+    AnalysisShardCount = getOptionAsInteger("shard-count", 1);
+  return AnalysisShardCount.getValue();
+}
+
+unsigned AnalyzerOptions::getAnalysisShardIndex() {
+  if (!AnalysisShardIndex.hasValue())
+    AnalysisShardIndex = getOptionAsInteger("shard-index", 0);
+  return AnalysisShardIndex.getValue();
+}
+
 bool AnalyzerOptions::shouldSynthesizeBodies() {
   return getBooleanOption("faux-bodies", true);
 }
@@ -16,11 +16,15 @@
 #include "clang/AST/Expr.h"
 #include "clang/AST/ExprCXX.h"
 #include "clang/AST/StmtCXX.h"
+#include "clang/Analysis/Analyses/CFGReachabilityAnalysis.h"
+#include "clang/StaticAnalyzer/Core/AnalyzerOptions.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/AnalysisManager.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/ExprEngine.h"
+#include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Support/Casting.h"
+#include <algorithm>
 
 using namespace clang;
 using namespace ento;
@@ -33,6 +37,9 @@ STATISTIC(NumReachedMaxSteps,
             "The # of times we reached the max number of steps.");
 STATISTIC(NumPathsExplored,
             "The # of paths explored by the analyzer.");
+STATISTIC(NumBlocksPrioritized,
+            "The # of unvisited blocks prioritized by the unexplored-first "
+            "worklist.");
 
 //===----------------------------------------------------------------------===//
 // Worklist classes for exploration of reachable states.
@@ -157,10 +164,183 @@ WorkList* WorkList::makeBFSBlockDFSContents() {
   return new BFSBlockDFSContents();
 }
 
+namespace {
+  /// A worklist that steers exploration towards CFG blocks that have not been
+  /// visited yet.
+  ///
+  /// Each block entrance is ranked when it is enqueued: entering a block not
+  /// yet reached in its stack frame comes first, then entering a block from
+  /// which an unreached block is still reachable, then everything else.
+  /// Within a rank, entrances into blocks visited fewer times along their
+  /// path (according to the BlockCounter) are preferred, and ties are broken
+  /// depth-first. Work items inside a block keep the highest rank, so that
+  /// a block that was entered is processed to completion.
+  ///
+  /// Ranks are not updated once an item has been enqueued; they are a
+  /// heuristic, and exploration is still exhaustive given enough steps.
+  class UnexploredFirst : public WorkList {
+    enum Rank {
+      RK_Unexplored,
+      RK_LeadsToUnexplored,
+      RK_Explored
+    };
+
+    struct Item {
+      WorkListUnit U;
+      Rank R;
+      unsigned NumVisited;
+      unsigned Order;
+
+      Item(const WorkListUnit &U, Rank R, unsigned NumVisited, unsigned Order)
+        : U(U), R(R), NumVisited(NumVisited), Order(Order) {}
+
+      /// Orders items so that the one to dequeue next is at the top of a
+      /// max-heap.
+      bool operator<(const Item &RHS) const {
+        if (R != RHS.R)
+          return R > RHS.R;
+        if (NumVisited != RHS.NumVisited)
+          return NumVisited > RHS.NumVisited;
+        return Order < RHS.Order;
+      }
+    };
+
+    /// Coverage of the CFG of one stack frame.
+    struct FrameCoverage {
+      /// The blocks for which a block entrance has been enqueued.
+      llvm::BitVector Reached;
+      /// For each block, an unreached block known to be reachable from it,
+      /// NoWitness if there is none, or Unknown if not computed yet. Blocks
+      /// only ever become reached, so NoWitness is final.
+      std::vector<int> Witness;
+    };
+    enum { Unknown = -1, NoWitness = -2 };
+
+    std::vector<Item> Heap;
+    llvm::DenseMap<const StackFrameContext *, FrameCoverage> Coverage;
+    unsigned NextOrder;
+
+    FrameCoverage &getCoverage(const StackFrameContext *SF) {
+      FrameCoverage &FC = Coverage[SF];
+      if (FC.Witness.empty()) {
+        const CFG *C = SF->getCFG();
+        FC.Reached.resize(C->getNumBlockIDs());
+        FC.Witness.resize(C->getNumBlockIDs(), Unknown);
+        // There is never a block entrance for the entry and exit blocks.
+        FC.Reached.set(C->getEntry().getBlockID());
+        FC.Reached.set(C->getExit().getBlockID());
+      }
+      return FC;
+    }
+
+    bool leadsToUnexplored(const StackFrameContext *SF, FrameCoverage &FC,
+                           const CFGBlock *B) {
+      int &W = FC.Witness[B->getBlockID()];
+      if (W == NoWitness)
+        return false;
+      if (W != Unknown && !FC.Reached.test(W))
+        return true;
+
+      CFGReverseBlockReachabilityAnalysis *CRA =
+          SF->getAnalysisDeclContext()->getCFGReachablityAnalysis();
+      if (!CRA)
+        return false;
+
+      const CFG *C = SF->getCFG();
+      for (CFG::const_iterator I = C->begin(), E = C->end(); I != E; ++I) {
+        const CFGBlock *Dst = *I;
+        if (FC.Reached.test(Dst->getBlockID()))
+          continue;
+        if (CRA->isReachable(B, Dst)) {
+          W = Dst->getBlockID();
+          return true;
+        }
+      }
+      W = NoWitness;
+      return false;
+    }
+
+  public:
+    UnexploredFirst() : NextOrder(0) {}
+
+    bool hasWork() const override {
+      return !Heap.empty();
+    }
+
+    void enqueue(const WorkListUnit& U) override {
+      const ExplodedNode *N = U.getNode();
+      Rank R = RK_Unexplored;
+      unsigned NumVisited = 0;
+
+      if (Optional<BlockEntrance> BE =
+              N->getLocation().getAs<BlockEntrance>()) {
+        const CFGBlock *B = BE->getBlock();
+        const StackFrameContext *SF =
+            N->getLocationContext()->getCurrentStackFrame();
+        FrameCoverage &FC = getCoverage(SF);
+
+        if (!FC.Reached.test(B->getBlockID())) {
+          FC.Reached.set(B->getBlockID());
+          NumBlocksPrioritized++;
+        } else {
+          R = leadsToUnexplored(SF, FC, B) ? RK_LeadsToUnexplored
+                                           : RK_Explored;
+          NumVisited = U.getBlockCounter().getNumVisited(SF,
+                                                         B->getBlockID());
+        }
+      }
+
+      Heap.push_back(Item(U, R, NumVisited, NextOrder++));
+      std::push_heap(Heap.begin(), Heap.end());
+    }
+
+    WorkListUnit dequeue() override {
+      assert(!Heap.empty());
+      std::pop_heap(Heap.begin(), Heap.end());
+      WorkListUnit U = Heap.back().U;
+      Heap.pop_back();
+      return U;
+    }
+
+    bool visitItemsInWorkList(Visitor &V) override {
+      for (std::vector<Item>::iterator I = Heap.begin(), E = Heap.end();
+           I != E; ++I) {
+        if (V.visit(I->U))
+          return true;
+      }
+      return false;
+    }
+  };
+} // end anonymous namespace
+
+WorkList *WorkList::makeUnexploredFirst() {
+  return new UnexploredFirst();
+}
+
 //===----------------------------------------------------------------------===//
 // Core analysis engine.
 //===----------------------------------------------------------------------===//
 
+static WorkList *generateWorkList(AnalyzerOptions &Opts) {
+  switch (Opts.getExplorationStrategy()) {
+  case ESK_BFS:
+    return WorkList::makeBFS();
+  case ESK_BFSBlockDFSContents:
+    return WorkList::makeBFSBlockDFSContents();
+  case ESK_UnexploredFirst:
+    return WorkList::makeUnexploredFirst();
+  case ESK_NotSet:
+  case ESK_DFS:
+    break;
+  }
+  return WorkList::makeDFS();
+}
+
+CoreEngine::CoreEngine(SubEngine &subengine, FunctionSummariesTy *FS,
+                       AnalyzerOptions &Opts)
+    : SubEng(subengine), WList(generateWorkList(Opts)),
+      BCounterFactory(G.getAllocator()), FunctionSummaries(FS) {}
+
 /// ExecuteWorkList - Run the worklist algorithm for a maximum number of steps.
 bool CoreEngine::ExecuteWorkList(const LocationContext *L, unsigned Steps,
                                    ProgramStateRef InitState) {
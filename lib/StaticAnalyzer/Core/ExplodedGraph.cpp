@@ -21,11 +21,20 @@
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/Statistic.h"
+#include "llvm/Support/AlignOf.h"
+#include <algorithm>
 #include <vector>
 
 using namespace clang;
 using namespace ento;
 
+#define DEBUG_TYPE "ExplodedGraph"
+
+STATISTIC(NumNodesReclaimed, "The # of exploded nodes reclaimed.");
+STATISTIC(NumPurgeNodesReclaimed,
+          "The # of exploded nodes for ineffective purges of dead symbols "
+          "reclaimed.");
+
 //===----------------------------------------------------------------------===//
 // Node auditing.
 //===----------------------------------------------------------------------===//
@@ -48,7 +57,8 @@ void ExplodedNode::SetAuditor(ExplodedNode::Auditor* A) {
 //===----------------------------------------------------------------------===//
 
 ExplodedGraph::ExplodedGraph()
-  : NumNodes(0), ReclaimNodeInterval(0) {}
+  : NumNodes(0), ReclaimNodeInterval(0), CleanupTag(nullptr),
+    GroupStorageBytes(0) {}
 
 ExplodedGraph::~ExplodedGraph() {}
 
@@ -80,6 +90,16 @@ bool ExplodedGraph::shouldCollect(const ExplodedNode *node) {
   //
   // (a) PreStmtPurgeDeadSymbols
   //
+  // If aggressive reclamation is enabled, we also discard nodes where *all*
+  // of the following conditions apply (see isIneffectivePurge()):
+  //
+  // (b) The ProgramPoint is a PreStmtPurgeDeadSymbols or a
+  //     PostStmtPurgeDeadSymbols.
+  // (c) The 'tag' is the one ExprEngine uses for its cleanup nodes.
+  // (d) The ProgramState is the same as the predecessor.
+  // (e) The LocationContext is the same as the predecessor.
+  // (f) Condition 10 below.
+  //
   // We then discard all other nodes where *all* of the following conditions
   // apply:
   //
@@ -110,6 +130,10 @@ bool ExplodedGraph::shouldCollect(const ExplodedNode *node) {
   // Now reclaim any nodes that are (by definition) not essential to
   // analysis history and are not consulted by any client code.
   ProgramPoint progPoint = node->getLocation();
+  if (isIneffectivePurge(node, pred, succ)) {
+    ++NumPurgeNodesReclaimed;
+    return true;
+  }
   if (progPoint.getAs<PreStmtPurgeDeadSymbols>())
     return !progPoint.getTag();
 
@@ -149,16 +173,38 @@ bool ExplodedGraph::shouldCollect(const ExplodedNode *node) {
     return false;
 
   // Condition 10.
-  const ProgramPoint SuccLoc = succ->getLocation();
-  if (Optional<StmtPoint> SP = SuccLoc.getAs<StmtPoint>())
+  return !isCallPoint(succ->getLocation());
+}
+
+bool ExplodedGraph::isCallPoint(const ProgramPoint &Loc) {
+  if (Optional<StmtPoint> SP = Loc.getAs<StmtPoint>())
     if (CallEvent::isCallStmt(SP->getStmt()))
-      return false;
+      return true;
+
+  return Loc.getAs<CallEnter>() || Loc.getAs<PreImplicitCall>();
+}
+
+bool ExplodedGraph::isIneffectivePurge(const ExplodedNode *node,
+                                       const ExplodedNode *pred,
+                                       const ExplodedNode *succ) const {
+  if (!CleanupTag)
+    return false;
+
+  // Conditions b and c.
+  ProgramPoint progPoint = node->getLocation();
+  if (!progPoint.getAs<PreStmtPurgeDeadSymbols>() &&
+      !progPoint.getAs<PostStmtPurgeDeadSymbols>())
+    return false;
+  if (progPoint.getTag() != CleanupTag)
+    return false;
 
-  // Condition 10, continuation.
-  if (SuccLoc.getAs<CallEnter>() || SuccLoc.getAs<PreImplicitCall>())
+  // Conditions d and e.
+  if (node->getState() != pred->getState() ||
+      progPoint.getLocationContext() != pred->getLocationContext())
     return false;
 
-  return true;
+  // Condition f.
+  return !isCallPoint(succ->getLocation());
 }
 
 void ExplodedGraph::collectNode(ExplodedNode *node) {
@@ -174,10 +220,21 @@ void ExplodedGraph::collectNode(ExplodedNode *node) {
   FreeNodes.push_back(node);
   Nodes.RemoveNode(node);
   --NumNodes;
+  ++NumNodesReclaimed;
   node->~ExplodedNode();  
 }
 
 void ExplodedGraph::reclaimRecentlyAllocatedNodes() {
+  // No NodeGroup is being iterated over at this point, so the storage that
+  // groups have outgrown can be reused.
+  for (unsigned i = 0, e = PendingGroupStorage.size(); i != e; ++i) {
+    unsigned SizeClass = PendingGroupStorage[i].second;
+    if (SizeClass >= FreeGroupStorage.size())
+      FreeGroupStorage.resize(SizeClass + 1);
+    FreeGroupStorage[SizeClass].push_back(PendingGroupStorage[i].first);
+  }
+  PendingGroupStorage.clear();
+
   if (ChangedNodes.empty())
     return;
 
@@ -203,17 +260,58 @@ void ExplodedGraph::reclaimRecentlyAllocatedNodes() {
 //===----------------------------------------------------------------------===//
 
 // An NodeGroup's storage type is actually very much like a TinyPtrVector:
-// it can be either a pointer to a single ExplodedNode, or a pointer to a
-// BumpVector allocated with the ExplodedGraph's allocator. This allows the
-// common case of single-node NodeGroups to be implemented with no extra memory.
+// it can be either a pointer to a single ExplodedNode, or a pointer to an
+// ExplodedNodeList allocated with the ExplodedGraph's allocator. This allows
+// the common case of single-node NodeGroups to be implemented with no extra
+// memory.
 //
 // Consequently, each of the NodeGroup methods have up to four cases to handle:
 // 1. The flag is set and this group does not actually contain any nodes.
 // 2. The group is empty, in which case the storage value is null.
 // 3. The group contains a single node.
 // 4. The group contains more than one node.
-typedef BumpVector<ExplodedNode *> ExplodedNodeVector;
-typedef llvm::PointerUnion<ExplodedNode *, ExplodedNodeVector *> GroupStorage;
+namespace {
+/// Out-of-line storage for a NodeGroup with more than one node.
+///
+/// The nodes immediately follow the header in the same allocation, which
+/// has room for (1 << SizeClass) nodes. When a list outgrows its storage,
+/// the old storage is handed back to the ExplodedGraph for reuse by other
+/// groups, rather than being abandoned in the bump allocator.
+struct ExplodedNodeList {
+  unsigned Size;
+  unsigned SizeClass;
+
+  unsigned capacity() const { return 1U << SizeClass; }
+
+  ExplodedNode **begin() {
+    return reinterpret_cast<ExplodedNode **>(this + 1);
+  }
+  ExplodedNode **end() { return begin() + Size; }
+
+  static size_t getAllocSize(unsigned SizeClass) {
+    return sizeof(ExplodedNodeList) + (sizeof(ExplodedNode *) << SizeClass);
+  }
+};
+} // end anonymous namespace
+
+typedef llvm::PointerUnion<ExplodedNode *, ExplodedNodeList *> GroupStorage;
+
+void *ExplodedGraph::allocateGroupStorage(unsigned SizeClass) {
+  if (SizeClass < FreeGroupStorage.size() &&
+      !FreeGroupStorage[SizeClass].empty()) {
+    void *Storage = FreeGroupStorage[SizeClass].back();
+    FreeGroupStorage[SizeClass].pop_back();
+    return Storage;
+  }
+
+  size_t Size = ExplodedNodeList::getAllocSize(SizeClass);
+  GroupStorageBytes += Size;
+  return getAllocator().Allocate(Size, llvm::alignOf<ExplodedNode *>());
+}
+
+void ExplodedGraph::releaseGroupStorage(void *Storage, unsigned SizeClass) {
+  PendingGroupStorage.push_back(std::make_pair(Storage, SizeClass));
+}
 
 void ExplodedNode::addPredecessor(ExplodedNode *V, ExplodedGraph &G) {
   assert (!V->isSink());
@@ -243,23 +341,36 @@ void ExplodedNode::NodeGroup::addNode(ExplodedNode *N, ExplodedGraph &G) {
     return;
   }
 
-  ExplodedNodeVector *V = Storage.dyn_cast<ExplodedNodeVector *>();
+  ExplodedNodeList *L = Storage.dyn_cast<ExplodedNodeList *>();
 
-  if (!V) {
-    // Switch from single-node to multi-node representation.
+  if (!L) {
+    // Switch from single-node to multi-node representation. Most such groups
+    // are the two successors of a branch.
     ExplodedNode *Old = Storage.get<ExplodedNode *>();
 
-    BumpVectorContext &Ctx = G.getNodeAllocator();
-    V = G.getAllocator().Allocate<ExplodedNodeVector>();
-    new (V) ExplodedNodeVector(Ctx, 4);
-    V->push_back(Old, Ctx);
+    L = static_cast<ExplodedNodeList *>(G.allocateGroupStorage(1));
+    L->Size = 1;
+    L->SizeClass = 1;
+    L->begin()[0] = Old;
 
-    Storage = V;
+    Storage = L;
+    assert(!getFlag());
+    assert(Storage.is<ExplodedNodeList *>());
+  } else if (L->Size == L->capacity()) {
+    ExplodedNodeList *NewL = static_cast<ExplodedNodeList *>(
+        G.allocateGroupStorage(L->SizeClass + 1));
+    NewL->Size = L->Size;
+    NewL->SizeClass = L->SizeClass + 1;
+    std::copy(L->begin(), L->end(), NewL->begin());
+    G.releaseGroupStorage(L, L->SizeClass);
+
+    L = NewL;
+    Storage = L;
     assert(!getFlag());
-    assert(Storage.is<ExplodedNodeVector *>());
   }
 
-  V->push_back(N, G.getNodeAllocator());
+  *L->end() = N;
+  ++L->Size;
 }
 
 unsigned ExplodedNode::NodeGroup::size() const {
@@ -269,8 +380,8 @@ unsigned ExplodedNode::NodeGroup::size() const {
   const GroupStorage &Storage = reinterpret_cast<const GroupStorage &>(P);
   if (Storage.isNull())
     return 0;
-  if (ExplodedNodeVector *V = Storage.dyn_cast<ExplodedNodeVector *>())
-    return V->size();
+  if (ExplodedNodeList *L = Storage.dyn_cast<ExplodedNodeList *>())
+    return L->Size;
   return 1;
 }
 
@@ -281,8 +392,8 @@ ExplodedNode * const *ExplodedNode::NodeGroup::begin() const {
   const GroupStorage &Storage = reinterpret_cast<const GroupStorage &>(P);
   if (Storage.isNull())
     return nullptr;
-  if (ExplodedNodeVector *V = Storage.dyn_cast<ExplodedNodeVector *>())
-    return V->begin();
+  if (ExplodedNodeList *L = Storage.dyn_cast<ExplodedNodeList *>())
+    return L->begin();
   return Storage.getAddrOfPtr1();
 }
 
@@ -293,8 +404,8 @@ ExplodedNode * const *ExplodedNode::NodeGroup::end() const {
   const GroupStorage &Storage = reinterpret_cast<const GroupStorage &>(P);
   if (Storage.isNull())
     return nullptr;
-  if (ExplodedNodeVector *V = Storage.dyn_cast<ExplodedNodeVector *>())
-    return V->end();
+  if (ExplodedNodeList *L = Storage.dyn_cast<ExplodedNodeList *>())
+    return L->end();
   return Storage.getAddrOfPtr1() + 1;
 }
 
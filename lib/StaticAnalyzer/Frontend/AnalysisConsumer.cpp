@@ -37,6 +37,7 @@
 #include "clang/StaticAnalyzer/Core/PathSensitive/ExprEngine.h"
 #include "clang/StaticAnalyzer/Frontend/CheckerRegistration.h"
 #include "llvm/ADT/DepthFirstIterator.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/PostOrderIterator.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/Statistic.h"
@@ -45,6 +46,7 @@
 #include "llvm/Support/Program.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 #include <memory>
 #include <queue>
 
@@ -62,8 +64,21 @@ STATISTIC(NumFunctionsAnalyzed,
                       "with inlining turned on).");
 STATISTIC(NumBlocksInAnalyzedFunctions,
                       "The # of basic blocks in the analyzed functions.");
+STATISTIC(NumVisitedBlocksInAnalyzedFunctions,
+                      "The # of visited basic blocks in the analyzed functions.");
 STATISTIC(PercentReachableBlocks, "The % of reachable basic blocks.");
 STATISTIC(MaxCFGSize, "The maximum number of basic blocks in a function.");
+STATISTIC(MaxNodeKB,
+          "The maximum # of KB used for exploded nodes while analyzing "
+          "a top level function.");
+STATISTIC(MaxStateKB,
+          "The maximum # of KB used for program states while analyzing "
+          "a top level function.");
+STATISTIC(MaxStoreKB,
+          "The maximum # of KB used for stores, environments and other "
+          "state data while analyzing a top level function.");
+STATISTIC(NumFunctionsInOtherShards,
+                      "The # of top level functions left to other shards.");
 
 //===----------------------------------------------------------------------===//
 // Special PathDiagnosticConsumers.
@@ -153,6 +168,12 @@ class AnalysisConsumer : public AnalysisASTConsumer,
   AnalysisMode RecVisitorMode;
   /// Bug Reporter to use while recursively visiting Decls.
   BugReporter *RecVisitorBR;
+  /// When the analysis is sharded and path-sensitive analysis is done while
+  /// recursively visiting Decls, the number of shards, the shard of this
+  /// process, and the number of bodies visited so far that needed it.
+  unsigned RecVisitorNumShards;
+  unsigned RecVisitorShard;
+  unsigned RecVisitorNumPathBodies;
 
 public:
   ASTContext *Ctx;
@@ -190,7 +211,8 @@ public:
                    AnalyzerOptionsRef opts,
                    ArrayRef<std::string> plugins,
                    CodeInjector *injector)
-    : RecVisitorMode(0), RecVisitorBR(nullptr), Ctx(nullptr), PP(pp),
+    : RecVisitorMode(0), RecVisitorBR(nullptr), RecVisitorNumShards(1),
+      RecVisitorShard(0), RecVisitorNumPathBodies(0), Ctx(nullptr), PP(pp),
       OutDir(outdir), Opts(opts), Plugins(plugins), Injector(injector) {
     DigestAnalyzerOptions();
     if (Opts->PrintStats) {
@@ -352,7 +374,7 @@ public:
     if (FD->isThisDeclarationADefinition() &&
         !FD->isDependentContext()) {
       assert(RecVisitorMode == AM_Syntax || Mgr->shouldInlineCall() == false);
-      HandleCode(FD, RecVisitorMode);
+      HandleCode(FD, getRecVisitorModeForBody(FD));
     }
     return true;
   }
@@ -360,7 +382,7 @@ public:
   bool VisitObjCMethodDecl(ObjCMethodDecl *MD) {
     if (MD->isThisDeclarationADefinition()) {
       assert(RecVisitorMode == AM_Syntax || Mgr->shouldInlineCall() == false);
-      HandleCode(MD, RecVisitorMode);
+      HandleCode(MD, getRecVisitorModeForBody(MD));
     }
     return true;
   }
@@ -368,11 +390,24 @@ public:
   bool VisitBlockDecl(BlockDecl *BD) {
     if (BD->hasBody()) {
       assert(RecVisitorMode == AM_Syntax || Mgr->shouldInlineCall() == false);
-      HandleCode(BD, RecVisitorMode);
+      HandleCode(BD, getRecVisitorModeForBody(BD));
     }
     return true;
   }
 
+  /// Returns the mode to analyze a body visited by the RecursiveASTVisitor
+  /// with. Without inlining, the bodies to analyze path-sensitively are
+  /// divided between the shards in turn, in the order they are visited.
+  AnalysisMode getRecVisitorModeForBody(Decl *D) {
+    AnalysisMode Mode = RecVisitorMode;
+    if (RecVisitorNumShards > 1 && (getModeForDecl(D, Mode) & AM_Path) &&
+        RecVisitorNumPathBodies++ % RecVisitorNumShards != RecVisitorShard) {
+      NumFunctionsInOtherShards++;
+      Mode &= ~AM_Path;
+    }
+    return Mode;
+  }
+
   void AddDiagnosticConsumer(PathDiagnosticConsumer *Consumer) override {
     PathConsumers.push_back(Consumer);
   }
@@ -450,6 +485,73 @@ AnalysisConsumer::getInliningModeForFunction(const Decl *D,
   return ExprEngine::Inline_Regular;
 }
 
+/// Returns the representative of the call graph component containing \p N.
+static const CallGraphNode *
+findComponentLeader(llvm::DenseMap<const CallGraphNode *,
+                                   const CallGraphNode *> &Leader,
+                    const CallGraphNode *N) {
+  const CallGraphNode *Root = N;
+  for (;;) {
+    auto I = Leader.find(Root);
+    if (I == Leader.end() || I->second == Root)
+      break;
+    Root = I->second;
+  }
+
+  // Compress the path to the representative.
+  while (N != Root) {
+    auto I = Leader.find(N);
+    N = I->second;
+    I->second = Root;
+  }
+  return Root;
+}
+
+/// Assign the functions in \p Order (a reverse post-order of the call graph)
+/// to \p NumShards shards. All the functions in one connected component of
+/// the call graph go to the same shard, so a function is always analyzed in
+/// the same shard as the functions it may be inlined into. Components are
+/// assigned greedily, in order, to the shard with the fewest functions.
+static void
+assignShards(ArrayRef<CallGraphNode *> Order, const CallGraphNode *Root,
+             unsigned NumShards,
+             llvm::DenseMap<const CallGraphNode *, unsigned> &ShardOf) {
+  llvm::DenseMap<const CallGraphNode *, const CallGraphNode *> Leader;
+  for (const CallGraphNode *N : Order) {
+    if (N == Root)
+      continue;
+    for (const CallGraphNode *Callee : *N) {
+      const CallGraphNode *A = findComponentLeader(Leader, N);
+      const CallGraphNode *B = findComponentLeader(Leader, Callee);
+      if (A != B)
+        Leader[B] = A;
+    }
+  }
+
+  llvm::DenseMap<const CallGraphNode *, unsigned> ComponentSize;
+  for (const CallGraphNode *N : Order)
+    if (N != Root)
+      ++ComponentSize[findComponentLeader(Leader, N)];
+
+  SmallVector<unsigned, 8> Load(NumShards, 0);
+  llvm::DenseMap<const CallGraphNode *, unsigned> ComponentShard;
+  for (const CallGraphNode *N : Order) {
+    if (N == Root)
+      continue;
+    const CallGraphNode *L = findComponentLeader(Leader, N);
+    auto I = ComponentShard.find(L);
+    if (I == ComponentShard.end()) {
+      unsigned Best = 0;
+      for (unsigned S = 1; S != NumShards; ++S)
+        if (Load[S] < Load[Best])
+          Best = S;
+      Load[Best] += ComponentSize[L];
+      I = ComponentShard.insert(std::make_pair(L, Best)).first;
+    }
+    ShardOf[N] = I->second;
+  }
+}
+
 void AnalysisConsumer::HandleDeclsCallGraph(const unsigned LocalTUDeclsSize) {
   // Build the Call Graph by adding all the top level declarations to the graph.
   // Note: CallGraph can trigger deserialization of more items from a pch
@@ -469,6 +571,18 @@ void AnalysisConsumer::HandleDeclsCallGraph(const unsigned LocalTUDeclsSize) {
   SetOfConstDecls Visited;
   SetOfConstDecls VisitedAsTopLevel;
   llvm::ReversePostOrderTraversal<clang::CallGraph*> RPOT(&CG);
+
+  // When the analysis is split into shards, only analyze the functions
+  // assigned to this shard.
+  llvm::DenseMap<const CallGraphNode *, unsigned> ShardOf;
+  unsigned NumShards = Mgr->options.getAnalysisShardCount();
+  unsigned Shard = 0;
+  if (NumShards > 1) {
+    Shard = Mgr->options.getAnalysisShardIndex();
+    SmallVector<CallGraphNode *, 32> Order(RPOT.begin(), RPOT.end());
+    assignShards(Order, CG.getRoot(), NumShards, ShardOf);
+  }
+
   for (llvm::ReversePostOrderTraversal<clang::CallGraph*>::rpo_iterator
          I = RPOT.begin(), E = RPOT.end(); I != E; ++I) {
     NumFunctionTopLevel++;
@@ -480,6 +594,12 @@ void AnalysisConsumer::HandleDeclsCallGraph(const unsigned LocalTUDeclsSize) {
     if (!D)
       continue;
 
+    // Skip the functions analyzed by other shards.
+    if (NumShards > 1 && ShardOf.lookup(N) != Shard) {
+      NumFunctionsInOtherShards++;
+      continue;
+    }
+
     // Skip the functions which have been processed already or previously
     // inlined.
     if (shouldSkipFunction(D, Visited, VisitedAsTopLevel))
@@ -517,12 +637,22 @@ void AnalysisConsumer::HandleTranslationUnit(ASTContext &C) {
     // Introduce a scope to destroy BR before Mgr.
     BugReporter BR(*Mgr);
     TranslationUnitDecl *TU = C.getTranslationUnitDecl();
-    checkerMgr->runCheckersOnASTDecl(TU, *Mgr, BR);
+
+    // When the analysis is sharded, everything but the path-sensitive
+    // analysis is done by the first shard only.
+    RecVisitorNumShards = std::max(Mgr->options.getAnalysisShardCount(), 1u);
+    RecVisitorShard =
+        RecVisitorNumShards > 1 ? Mgr->options.getAnalysisShardIndex() : 0;
+    RecVisitorNumPathBodies = 0;
+    bool IsFirstShard = RecVisitorShard == 0;
+
+    if (IsFirstShard)
+      checkerMgr->runCheckersOnASTDecl(TU, *Mgr, BR);
 
     // Run the AST-only checks using the order in which functions are defined.
     // If inlining is not turned on, use the simplest function order for path
     // sensitive analyzes as well.
-    RecVisitorMode = AM_Syntax;
+    RecVisitorMode = IsFirstShard ? AM_Syntax : AM_None;
     if (!Mgr->shouldInlineCall())
       RecVisitorMode |= AM_Path;
     RecVisitorBR = &BR;
@@ -534,15 +664,18 @@ void AnalysisConsumer::HandleTranslationUnit(ASTContext &C) {
     // random access.  By doing so, we automatically compensate for iterators
     // possibly being invalidated, although this is a bit slower.
     const unsigned LocalTUDeclsSize = LocalTUDecls.size();
-    for (unsigned i = 0 ; i < LocalTUDeclsSize ; ++i) {
-      TraverseDecl(LocalTUDecls[i]);
+    if (RecVisitorMode != AM_None) {
+      for (unsigned i = 0 ; i < LocalTUDeclsSize ; ++i) {
+        TraverseDecl(LocalTUDecls[i]);
+      }
     }
 
     if (Mgr->shouldInlineCall())
       HandleDeclsCallGraph(LocalTUDeclsSize);
 
     // After all decls handled, run checkers on the entire TranslationUnit.
-    checkerMgr->runCheckersOnEndOfTranslationUnit(TU, *Mgr, BR);
+    if (IsFirstShard)
+      checkerMgr->runCheckersOnEndOfTranslationUnit(TU, *Mgr, BR);
 
     RecVisitorBR = nullptr;
   }
@@ -557,9 +690,11 @@ void AnalysisConsumer::HandleTranslationUnit(ASTContext &C) {
 
   // Count how many basic blocks we have not covered.
   NumBlocksInAnalyzedFunctions = FunctionSummaries.getTotalNumBasicBlocks();
+  NumVisitedBlocksInAnalyzedFunctions =
+      FunctionSummaries.getTotalNumVisitedBasicBlocks();
   if (NumBlocksInAnalyzedFunctions > 0)
     PercentReachableBlocks =
-      (FunctionSummaries.getTotalNumVisitedBasicBlocks() * 100) /
+      (NumVisitedBlocksInAnalyzedFunctions * 100) /
         NumBlocksInAnalyzedFunctions;
 
 }
@@ -663,6 +798,25 @@ void AnalysisConsumer::ActionExprEngine(Decl *D, bool ObjCGCEnabled,
   // created BugReporter.
   ExplodedNode::SetAuditor(nullptr);
 
+  // Break down the memory used by the exploded graph. Nodes, states and the
+  // data they refer to all come from the graph's allocator, which only
+  // grows, so this is the peak usage for this function. Statistics are 32
+  // bits wide, so report kilobytes, rounded up, to keep large graphs from
+  // wrapping.
+  if (Mgr->options.PrintStats) {
+    const ExplodedGraph &G = Eng.getGraph();
+    uint64_t NodeBytes = G.getNodeBytesAllocated();
+    uint64_t StateBytes = Eng.getStateManager().getStateBytesAllocated();
+    uint64_t TotalBytes =
+        Eng.getStateManager().getAllocator().getBytesAllocated();
+    uint64_t StoreBytes = TotalBytes > NodeBytes + StateBytes
+                              ? TotalBytes - NodeBytes - StateBytes
+                              : 0;
+    MaxNodeKB = std::max<uint64_t>(MaxNodeKB, (NodeBytes + 1023) / 1024);
+    MaxStateKB = std::max<uint64_t>(MaxStateKB, (StateBytes + 1023) / 1024);
+    MaxStoreKB = std::max<uint64_t>(MaxStoreKB, (StoreBytes + 1023) / 1024);
+  }
+
   // Visualize the exploded graph.
   if (Mgr->options.visualizeExplodedGraphWithGraphViz)
     Eng.ViewGraph(Mgr->options.TrimGraph);
@@ -29,7 +29,13 @@
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Host.h"
+#include "llvm/Support/MutexGuard.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#if LLVM_ENABLE_THREADS
+#include <mutex>
+#include <thread>
+#endif
 
 // For chdir, see the comment in ClangTool::run for more information.
 #ifdef LLVM_ON_WIN32
@@ -282,7 +288,8 @@ ClangTool::ClangTool(const CompilationDatabase &Compilations,
                      std::shared_ptr<PCHContainerOperations> PCHContainerOps)
     : Compilations(Compilations), SourcePaths(SourcePaths),
       PCHContainerOps(PCHContainerOps),
-      Files(new FileManager(FileSystemOptions())), DiagConsumer(nullptr) {
+      Files(new FileManager(FileSystemOptions())), DiagConsumer(nullptr),
+      NumThreads(1) {
   appendArgumentsAdjuster(getClangStripOutputAdjuster());
   appendArgumentsAdjuster(getClangSyntaxOnlyAdjuster());
 }
@@ -304,6 +311,12 @@ void ClangTool::clearArgumentsAdjusters() {
   ArgsAdjuster = nullptr;
 }
 
+void ClangTool::setSharedStatCache(
+    IntrusiveRefCntPtr<SharedFileSystemStatCache> Cache) {
+  SharedStatCache = Cache;
+  Files->setSharedStatCache(Cache);
+}
+
 int ClangTool::run(ToolAction *Action) {
   // Exists solely for the purpose of lookup of the resource path.
   // This just needs to be some symbol in the binary.
@@ -316,6 +329,9 @@ int ClangTool::run(ToolAction *Action) {
   std::string MainExecutable =
       llvm::sys::fs::getMainExecutable("clang_tool", &StaticSymbol);
 
+  if (NumThreads > 1)
+    return runInParallel(Action, MainExecutable);
+
   llvm::SmallString<128> InitialDirectory;
   if (std::error_code EC = llvm::sys::fs::current_path(InitialDirectory))
     llvm::report_fatal_error("Cannot detect current path: " +
@@ -381,10 +397,172 @@ int ClangTool::run(ToolAction *Action) {
   return ProcessingFailed ? 1 : 0;
 }
 
+#if LLVM_ENABLE_THREADS
+namespace {
+/// \brief Forwards diagnostics to another consumer while holding a lock, so
+/// that a single consumer can be shared by concurrent invocations.
+class LockedDiagnosticConsumer : public DiagnosticConsumer {
+public:
+  explicit LockedDiagnosticConsumer(DiagnosticConsumer &Target)
+      : Target(Target) {}
+
+  void BeginSourceFile(const LangOptions &LangOpts,
+                       const Preprocessor *PP) override {
+    std::lock_guard<std::mutex> Guard(Lock);
+    Target.BeginSourceFile(LangOpts, PP);
+  }
+
+  void EndSourceFile() override {
+    std::lock_guard<std::mutex> Guard(Lock);
+    Target.EndSourceFile();
+  }
+
+  bool IncludeInDiagnosticCounts() const override {
+    return Target.IncludeInDiagnosticCounts();
+  }
+
+  void HandleDiagnostic(DiagnosticsEngine::Level DiagLevel,
+                        const Diagnostic &Info) override {
+    std::lock_guard<std::mutex> Guard(Lock);
+    DiagnosticConsumer::HandleDiagnostic(DiagLevel, Info);
+    Target.HandleDiagnostic(DiagLevel, Info);
+  }
+
+private:
+  DiagnosticConsumer &Target;
+  std::mutex Lock;
+};
+}
+#endif
+
+int ClangTool::runInParallel(ToolAction *Action,
+                             const std::string &MainExecutable) {
+  // Collect all compile commands up front: getCompileCommands may change the
+  // state of the file system (see the FIXME in run()), which must not happen
+  // while other commands are being processed.
+  struct Job {
+    std::string File;
+    std::string Directory;
+    std::vector<std::string> CommandLine;
+  };
+  std::vector<Job> Jobs;
+  for (const auto &SourcePath : SourcePaths) {
+    std::string File(getAbsolutePath(SourcePath));
+    std::vector<CompileCommand> CompileCommandsForFile =
+        Compilations.getCompileCommands(File);
+    if (CompileCommandsForFile.empty()) {
+      llvm::errs() << "Skipping " << File << ". Compile command not found.\n";
+      continue;
+    }
+    for (CompileCommand &CompileCommand : CompileCommandsForFile) {
+      std::vector<std::string> CommandLine = CompileCommand.CommandLine;
+      if (ArgsAdjuster)
+        CommandLine = ArgsAdjuster(CommandLine);
+      assert(!CommandLine.empty());
+      CommandLine[0] = MainExecutable;
+      // Resolve relative paths against the command's directory without
+      // touching the process-wide working directory.
+      CommandLine.insert(CommandLine.begin() + 1,
+                         "-working-directory=" + CompileCommand.Directory);
+      Job J = { File, CompileCommand.Directory, std::move(CommandLine) };
+      Jobs.push_back(std::move(J));
+    }
+  }
+
+#if LLVM_ENABLE_THREADS
+  // The consumer may be referenced by the results of the action (e.g. the
+  // ASTUnits of buildASTs), so it lives as long as the tool.
+  if (DiagConsumer)
+    LockedDiagConsumer.reset(new LockedDiagnosticConsumer(*DiagConsumer));
+  else
+    LockedDiagConsumer.reset();
+
+  std::mutex Lock;
+  unsigned NextJob = 0;
+  bool ProcessingFailed = false;
+
+  auto Worker = [&] {
+    for (;;) {
+      unsigned I;
+      {
+        std::lock_guard<std::mutex> Guard(Lock);
+        if (NextJob == Jobs.size())
+          return;
+        I = NextJob++;
+      }
+      Job &J = Jobs[I];
+
+      FileSystemOptions FileSystemOpts;
+      FileSystemOpts.WorkingDir = J.Directory;
+      IntrusiveRefCntPtr<FileManager> JobFiles(new FileManager(FileSystemOpts));
+      if (SharedStatCache)
+        JobFiles->setSharedStatCache(SharedStatCache);
+
+      // Without a consumer, collect this command's diagnostics and print them
+      // in one piece once it is done.
+      std::string DiagOutput;
+      llvm::raw_string_ostream DiagStream(DiagOutput);
+      IntrusiveRefCntPtr<DiagnosticOptions> DiagOpts = new DiagnosticOptions();
+      TextDiagnosticPrinter DiagnosticPrinter(DiagStream, &*DiagOpts);
+
+      DEBUG({
+        std::lock_guard<std::mutex> Guard(Lock);
+        llvm::dbgs() << "Processing: " << J.File << ".\n";
+      });
+      ToolInvocation Invocation(std::move(J.CommandLine), Action,
+                                JobFiles.get(), PCHContainerOps);
+      Invocation.setDiagnosticConsumer(
+          LockedDiagConsumer ? LockedDiagConsumer.get() : &DiagnosticPrinter);
+      for (const auto &MappedFile : MappedFileContents)
+        Invocation.mapVirtualFile(MappedFile.first, MappedFile.second);
+      bool Success = Invocation.run();
+
+      std::lock_guard<std::mutex> Guard(Lock);
+      llvm::errs() << DiagStream.str();
+      if (!Success) {
+        // FIXME: Diagnostics should be used instead.
+        llvm::errs() << "Error while processing " << J.File << ".\n";
+        ProcessingFailed = true;
+      }
+    }
+  };
+
+  std::vector<std::thread> Threads;
+  unsigned NumWorkers = std::min<size_t>(NumThreads, Jobs.size());
+  for (unsigned I = 0; I != NumWorkers; ++I)
+    Threads.push_back(std::thread(Worker));
+  for (std::thread &T : Threads)
+    T.join();
+  return ProcessingFailed ? 1 : 0;
+#else
+  bool ProcessingFailed = false;
+  for (Job &J : Jobs) {
+    FileSystemOptions FileSystemOpts;
+    FileSystemOpts.WorkingDir = J.Directory;
+    IntrusiveRefCntPtr<FileManager> JobFiles(new FileManager(FileSystemOpts));
+    if (SharedStatCache)
+      JobFiles->setSharedStatCache(SharedStatCache);
+    ToolInvocation Invocation(std::move(J.CommandLine), Action, JobFiles.get(),
+                              PCHContainerOps);
+    Invocation.setDiagnosticConsumer(DiagConsumer);
+    for (const auto &MappedFile : MappedFileContents)
+      Invocation.mapVirtualFile(MappedFile.first, MappedFile.second);
+    if (!Invocation.run()) {
+      // FIXME: Diagnostics should be used instead.
+      llvm::errs() << "Error while processing " << J.File << ".\n";
+      ProcessingFailed = true;
+    }
+  }
+  return ProcessingFailed ? 1 : 0;
+#endif
+}
+
 namespace {
 
 class ASTBuilderAction : public ToolAction {
   std::vector<std::unique_ptr<ASTUnit>> &ASTs;
+  // Guards ASTs when the tool runs on several threads.
+  llvm::sys::Mutex ASTsLock;
 
 public:
   ASTBuilderAction(std::vector<std::unique_ptr<ASTUnit>> &ASTs) : ASTs(ASTs) {}
@@ -401,6 +579,7 @@ public:
     if (!AST)
       return false;
 
+    llvm::MutexGuard Guard(ASTsLock);
     ASTs.push_back(std::move(AST));
     return true;
   }
@@ -0,0 +1,29 @@
+// REQUIRES: asserts
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-stats \
+// RUN:   -analyzer-config graph-trim-interval=4 %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=DEFAULT %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core -analyzer-stats \
+// RUN:   -analyzer-config graph-trim-interval=4 \
+// RUN:   -analyzer-config aggressive-graph-trimming=true %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=AGGRESSIVE %s
+
+// Dead symbols are purged before each declaration, but there is never
+// anything to purge. Only aggressive trimming reclaims the nodes that these
+// purges leave behind.
+void declarations() {
+  int a;
+  int b;
+  int c;
+  int d;
+  int e;
+  int f;
+  int g;
+  int h;
+}
+
+// DEFAULT: ... Statistics Collected ...
+// DEFAULT-NOT: ineffective purges
+
+// AGGRESSIVE: ... Statistics Collected ...
+// AGGRESSIVE: {{[1-9][0-9]*}} ExplodedGraph - The # of exploded nodes for ineffective purges of dead symbols reclaimed.
+// AGGRESSIVE: {{[1-9][0-9]*}} ExplodedGraph - The # of exploded nodes reclaimed.
@@ -0,0 +1,52 @@
+// RUN: %clang_cc1 -analyze -analyzer-checker=debug.ExprInspection \
+// RUN:   -analyzer-config shard-count=2,shard-index=0 %s 2>&1 \
+// RUN:   | grep REACHABLE > %t.shard0
+// RUN: %clang_cc1 -analyze -analyzer-checker=debug.ExprInspection \
+// RUN:   -analyzer-config shard-count=2,shard-index=1 %s 2>&1 \
+// RUN:   | grep REACHABLE > %t.shard1
+// RUN: %clang_cc1 -analyze -analyzer-checker=debug.ExprInspection %s 2>&1 \
+// RUN:   | grep REACHABLE | sort > %t.all
+//
+// Both shards get some of the work...
+// RUN: FileCheck -check-prefix=SHARD -input-file=%t.shard0 %s
+// RUN: FileCheck -check-prefix=SHARD -input-file=%t.shard1 %s
+// SHARD: warning: REACHABLE
+//
+// ...and together produce exactly the results of an unsharded analysis: a
+// callee is analyzed in the same shard as its callers, so it is neither
+// skipped nor reanalyzed as a top level function.
+// RUN: cat %t.shard0 %t.shard1 | sort | diff - %t.all
+//
+// Without inlining, the functions are divided between the shards in the
+// order they are defined.
+// RUN: %clang_cc1 -analyze -analyzer-checker=debug.ExprInspection \
+// RUN:   -analyzer-config ipa=none,shard-count=2,shard-index=0 %s 2>&1 \
+// RUN:   | grep REACHABLE > %t.noipa.shard0
+// RUN: %clang_cc1 -analyze -analyzer-checker=debug.ExprInspection \
+// RUN:   -analyzer-config ipa=none,shard-count=2,shard-index=1 %s 2>&1 \
+// RUN:   | grep REACHABLE > %t.noipa.shard1
+// RUN: %clang_cc1 -analyze -analyzer-checker=debug.ExprInspection \
+// RUN:   -analyzer-config ipa=none %s 2>&1 \
+// RUN:   | grep REACHABLE | sort > %t.noipa.all
+// RUN: FileCheck -check-prefix=SHARD -input-file=%t.noipa.shard0 %s
+// RUN: FileCheck -check-prefix=SHARD -input-file=%t.noipa.shard1 %s
+// RUN: cat %t.noipa.shard0 %t.noipa.shard1 | sort | diff - %t.noipa.all
+//
+// A shard index that is not below the shard count is rejected.
+// RUN: not %clang_cc1 -analyze -analyzer-checker=debug.ExprInspection \
+// RUN:   -analyzer-config shard-count=2,shard-index=2 %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=RANGE %s
+// RANGE: error: analyzer-config option 'shard-index=2' is out of range for 'shard-count=2'
+
+void clang_analyzer_warnIfReached();
+
+static void helper(int x) {
+  if (x)
+    clang_analyzer_warnIfReached();
+}
+
+void a() { clang_analyzer_warnIfReached(); }
+void b() { clang_analyzer_warnIfReached(); }
+void c() { helper(1); }
+void d() { helper(2); clang_analyzer_warnIfReached(); }
+void e() { clang_analyzer_warnIfReached(); }
@@ -0,0 +1,75 @@
+// RUN: %clang_cc1 -analyze -analyzer-checker=core,debug.ExprInspection -verify %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core,debug.ExprInspection -analyzer-config exploration-strategy=dfs -verify %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core,debug.ExprInspection -analyzer-config exploration-strategy=bfs -verify %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core,debug.ExprInspection -analyzer-config exploration-strategy=bfs-block-dfs-contents -verify %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core,debug.ExprInspection -analyzer-config exploration-strategy=unexplored-first -verify %s
+
+// With a tight node budget, only the unexplored-first strategy gets to the
+// null dereferences in budget().
+// RUN: %clang_cc1 -analyze -analyzer-checker=core,debug.ExprInspection -analyzer-config exploration-strategy=dfs,max-nodes=1000 %s 2>&1 | FileCheck -check-prefix=DFS %s
+// RUN: %clang_cc1 -analyze -analyzer-checker=core,debug.ExprInspection -analyzer-config exploration-strategy=unexplored-first,max-nodes=1000 %s 2>&1 | FileCheck -check-prefix=UNEXPLORED %s
+// DFS-NOT: Dereference of null pointer
+// UNEXPLORED: warning: Dereference of null pointer
+
+// Every strategy explores the whole function when the node budget allows it.
+
+void clang_analyzer_warnIfReached();
+void clang_analyzer_eval(int);
+int coin();
+
+void branches(int x) {
+  if (x > 0) {
+    if (coin())
+      clang_analyzer_warnIfReached(); // expected-warning{{REACHABLE}}
+    else
+      clang_analyzer_warnIfReached(); // expected-warning{{REACHABLE}}
+  } else {
+    clang_analyzer_warnIfReached(); // expected-warning{{REACHABLE}}
+  }
+}
+
+void loop() {
+  int i = 0;
+  while (coin())
+    ++i;
+  if (i == 1)
+    clang_analyzer_warnIfReached(); // expected-warning{{REACHABLE}}
+}
+
+int helper(int x) {
+  if (x)
+    return 1;
+  return 0;
+}
+
+void inlined() {
+  clang_analyzer_eval(helper(1) == 1); // expected-warning{{TRUE}}
+  clang_analyzer_eval(helper(0) == 0); // expected-warning{{TRUE}}
+}
+
+// Whichever branch depth-first search takes first, it goes through the 1024
+// paths that follow it, each with a distinct value of n, before getting to a
+// dereference. The unexplored-first strategy enters both branches right away.
+void budget(int a, int b) {
+  int *p = 0;
+  int n = 0;
+  if (a) {
+    if (b)
+      ++n;
+    else
+      *p = 1; // expected-warning{{Dereference of null pointer (loaded from variable 'p')}}
+  } else if (b) {
+    *p = 1; // expected-warning{{Dereference of null pointer (loaded from variable 'p')}}
+  }
+  if (coin()) n |= 2;
+  if (coin()) n |= 4;
+  if (coin()) n |= 8;
+  if (coin()) n |= 16;
+  if (coin()) n |= 32;
+  if (coin()) n |= 64;
+  if (coin()) n |= 128;
+  if (coin()) n |= 256;
+  if (coin()) n |= 512;
+  if (coin()) n |= 1024;
+  clang_analyzer_eval(n < 2048); // expected-warning{{TRUE}}
+}
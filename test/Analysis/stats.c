@@ -5,5 +5,9 @@ void foo() {
   int x;
 }
 // CHECK: ... Statistics Collected ...
+// CHECK:3 AnalysisConsumer - The # of visited basic blocks in the analyzed functions.
 // CHECK:100 AnalysisConsumer - The % of reachable basic blocks.
+// CHECK:{{[0-9]+}} AnalysisConsumer - The maximum # of KB used for exploded nodes while analyzing a top level function.
+// CHECK:{{[0-9]+}} AnalysisConsumer - The maximum # of KB used for program states while analyzing a top level function.
+// CHECK:{{[0-9]+}} AnalysisConsumer - The maximum # of KB used for stores, environments and other state data while analyzing a top level function.
 // CHECK:The # of times RemoveDeadBindings is called
@@ -434,3 +434,18 @@
 // CHECK-WCHAR2: -fshort-wchar
 // CHECK-WCHAR2-NOT: -fno-short-wchar
 // DELIMITERS: {{^ *"}}
+
+// RUN: %clang -### -S -ftime-trace -ftime-trace-granularity=100 %s 2>&1 | FileCheck -check-prefix=CHECK-TIME-TRACE %s
+// RUN: %clang -### -S %s 2>&1 | FileCheck -check-prefix=CHECK-NO-TIME-TRACE %s
+// CHECK-TIME-TRACE: "-ftime-trace"
+// CHECK-TIME-TRACE: "-ftime-trace-granularity=100"
+// CHECK-NO-TIME-TRACE-NOT: -ftime-trace
+
+// RUN: %clang -### -S -ftemplate-instantiation-report=%t.json %s 2>&1 | FileCheck -check-prefix=CHECK-INST-REPORT %s
+// CHECK-INST-REPORT: "-ftemplate-instantiation-report={{.*}}.json"
+
+// RUN: %clang -### -S -finclude-guard-database=%t.guards %s 2>&1 | FileCheck -check-prefix=CHECK-GUARD-DB %s
+// CHECK-GUARD-DB: "-finclude-guard-database={{.*}}.guards"
+
+// RUN: %clang -### -S -fheader-search-index=%t.index %s 2>&1 | FileCheck -check-prefix=CHECK-SEARCH-INDEX %s
+// CHECK-SEARCH-INDEX: "-fheader-search-index={{.*}}.index"
@@ -33,6 +33,15 @@
 // RUN: %clang -fmodules-validate-system-headers -### %s 2>&1 | FileCheck -check-prefix=MODULES_VALIDATE_SYSTEM_HEADERS %s
 // MODULES_VALIDATE_SYSTEM_HEADERS: -fmodules-validate-system-headers
 
+// RUN: %clang -fmodules-validate-input-files-lazily -### %s 2>&1 | FileCheck -check-prefix=MODULES_VALIDATE_LAZILY %s
+// MODULES_VALIDATE_LAZILY: -fmodules-validate-input-files-lazily
+
+// RUN: %clang -fmodules-build-jobs=4 -### %s 2>&1 | FileCheck -check-prefix=MODULES_BUILD_JOBS %s
+// MODULES_BUILD_JOBS: -fmodules-build-jobs=4
+
+// RUN: %clang -fmodules-compress-buffers -### %s 2>&1 | FileCheck -check-prefix=MODULES_COMPRESS_BUFFERS %s
+// MODULES_COMPRESS_BUFFERS: -fmodules-compress-buffers
+
 // RUN: %clang -fmodules -fmodule-map-file=foo.map -fmodule-map-file=bar.map -### %s 2>&1 | FileCheck -check-prefix=CHECK-MODULE-MAP-FILES %s
 // CHECK-MODULE-MAP-FILES: "-fmodules"
 // CHECK-MODULE-MAP-FILES: "-fmodule-map-file=foo.map"
@@ -0,0 +1,21 @@
+// Diagnostics from jobs run in parallel are reported in job order.
+// RUN: %clang -fsyntax-only -j 2 %s %S/Inputs/parallel-jobs-second.c 2>&1 \
+// RUN:   | FileCheck %s
+// CHECK: parallel-jobs.c:[[@LINE+3]]:2: warning: first input
+// CHECK: parallel-jobs-second.c:{{[0-9]+}}:2: warning: second input
+
+#warning first input
+
+// A failing job does not prevent independent jobs from running.
+// RUN: not %clang -fsyntax-only -j 2 -DFAIL %s \
+// RUN:   %S/Inputs/parallel-jobs-second.c 2>&1 \
+// RUN:   | FileCheck -check-prefix=FAIL %s
+// FAIL: parallel-jobs.c:{{[0-9]+}}:2: error: failing input
+// FAIL: parallel-jobs-second.c:{{[0-9]+}}:2: warning: second input
+#ifdef FAIL
+#error failing input
+#endif
+
+// RUN: not %clang -fsyntax-only -j0 %s 2>&1 \
+// RUN:   | FileCheck -check-prefix=INVALID %s
+// INVALID: invalid integral value '0' in '-j0'
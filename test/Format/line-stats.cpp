@@ -0,0 +1,7 @@
+// RUN: clang-format -style="{BasedOnStyle: LLVM, ColumnLimit: 30}" -print-line-stats -lines=7:7 %s 2>&1 >/dev/null | FileCheck %s
+// RUN: clang-format -style="{BasedOnStyle: LLVM, ColumnLimit: 30, MaxLineBreakingStates: 2}" -print-line-stats -lines=7:7 %s 2>&1 >/dev/null | FileCheck -check-prefix=LIMITED %s
+
+// CHECK: line-stats.cpp:7: {{[0-9]+}} states analyzed{{$}}
+// LIMITED: line-stats.cpp:7: {{[0-9]+}} states analyzed, completed greedily
+// CHECK-NOT: states analyzed
+int x = f(aaaaaaaaaa, bbbbbbbbbb, cccccccccc);
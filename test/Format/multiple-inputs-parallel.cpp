@@ -0,0 +1,19 @@
+// RUN: cp %s %t-1.cpp
+// RUN: sed 's/i1  ;/i2  ;/' %s > %t-2.cpp
+// RUN: sed 's/i1  ;/i3  ;/' %s > %t-3.cpp
+// RUN: clang-format -style=LLVM -j 2 %t-1.cpp %t-2.cpp %t-3.cpp | FileCheck -strict-whitespace %s
+// RUN: clang-format -style=LLVM -j 2 -i %t-1.cpp %t-2.cpp %t-3.cpp
+// RUN: FileCheck -strict-whitespace -input-file=%t-1.cpp -check-prefix=INPLACE %s
+// RUN: FileCheck -strict-whitespace -input-file=%t-3.cpp -check-prefix=INPLACE %s
+// RUN: clang-format -style=LLVM -j 2 -print-times %t-1.cpp %t-2.cpp %t-3.cpp 2>&1 >/dev/null | FileCheck -check-prefix=TIMES %s
+
+// The files are written in order.
+// CHECK: {{^int\ \*i1;}}
+// CHECK: {{^int\ \*i2;}}
+// CHECK: {{^int\ \*i3;}}
+// INPLACE: {{^int\ \*i[13];}}
+// TIMES: Time per file (3 files,
+// TIMES-DAG: ms {{.*}}-1.cpp
+// TIMES-DAG: ms {{.*}}-2.cpp
+// TIMES-DAG: ms {{.*}}-3.cpp
+ int   *  i1  ;
@@ -0,0 +1,33 @@
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -std=c++11 -fsyntax-only -ftemplate-instantiation-report=%t.json %s
+// RUN: FileCheck < %t.json %s
+
+// CHECK: {"file":"{{.*}}ftemplate-instantiation-report.cpp","specializations":[
+// CHECK-DAG: {"name":"Outer<int>","kind":"class","pattern":"{{.*}}ftemplate-instantiation-report.cpp:[[@LINE+11]]","depth":1,"time_us":{{[0-9]+}},"self_time_us":{{[0-9]+}},"nodes":{{[1-9][0-9]*}},"self_nodes":{{[0-9]+}}}
+// CHECK-DAG: {"name":"Inner<int>","kind":"class","pattern":"{{.*}}ftemplate-instantiation-report.cpp:[[@LINE+9]]","depth":2,
+// CHECK-DAG: {"name":"Outer<int>::get","kind":"function","pattern":"{{.*}}","depth":1,
+// CHECK-DAG: {"name":"twice<long>","kind":"function","pattern":"{{.*}}","depth":1,
+// CHECK-DAG: {"name":"Counter<char>::count","kind":"variable","pattern":"{{.*}}","depth":1,
+// CHECK-NOT: "name":"{{Unused|declared}}
+// CHECK: ]}
+
+// Only definitions are instantiated, and so reported.
+
+template <typename T> struct Inner { T t; };
+template <typename T> struct Outer {
+  Inner<T> in;
+  T get() const { return in.t; }
+};
+template <typename T> struct Unused { T t; };
+template <typename T> T twice(T t) { return t + t; }
+template <typename T> struct Counter { static int count; };
+template <typename T> int Counter<T>::count = sizeof(T);
+
+int use() {
+  Outer<int> o = {{1}};
+  Unused<int> *p = nullptr;
+  return o.get() + twice(2L) + Counter<char>::count + (p != nullptr);
+}
+
+// Nor is a function template that is never defined.
+template <typename T> T declared(T t);
+int useDeclared() { return declared(1); }
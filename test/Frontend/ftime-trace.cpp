@@ -0,0 +1,27 @@
+// RUN: cd %S
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -ftime-trace -ftime-trace-granularity=0 -emit-llvm -o %t.ll %s
+// RUN: FileCheck < %t.json %s
+
+// CHECK: {"traceEvents":[
+// CHECK-DAG: "name":"Source","args":{"detail":"{{.*}}test.h"}
+// CHECK-DAG: "name":"Source","args":{"detail":"{{.*}}test2.h"}
+// CHECK-DAG: "name":"ParseTopLevelDecl","args":{"detail":"{{.*}}ftime-trace.cpp:
+// CHECK-DAG: "name":"ParseFunctionDefinition","args":{"detail":"g"}
+// CHECK-DAG: "name":"InstantiateClass","args":{"detail":"S<int>"}
+// CHECK-DAG: "name":"InstantiateFunction","args":{"detail":"f<int>"}
+// CHECK-DAG: "name":"EmitTopLevelDecl","args":{"detail":"g"}
+// CHECK-DAG: "name":"Backend"
+// CHECK-DAG: "name":"ExecuteCompiler"
+// CHECK-DAG: "name":"Total InstantiateClass","args":{"count":"1"}
+// CHECK: "name":"process_name"
+// CHECK-NEXT: ]}
+
+#include "Inputs/test.h"
+
+template <typename T> struct S { T t; };
+template <typename T> T f(T t) { return t; }
+
+int g() {
+  S<int> s = { x };
+  return f(s.t);
+}
@@ -0,0 +1,4 @@
+#define CONFIG_WIDE
+#include "skip-indexed-headers-config.h"
+
+void use(Wide &w);
@@ -0,0 +1,10 @@
+#ifndef SKIP_INDEXED_HEADERS_CONFIG_H
+#define SKIP_INDEXED_HEADERS_CONFIG_H
+
+#ifdef CONFIG_WIDE
+struct Wide { long value; };
+#else
+struct Narrow { int value; };
+#endif
+
+#endif
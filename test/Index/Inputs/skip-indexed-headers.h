@@ -0,0 +1,9 @@
+#ifndef SKIP_INDEXED_HEADERS_H
+#define SKIP_INDEXED_HEADERS_H
+
+struct Shared {
+  int field;
+  void method() { field = 0; }
+};
+
+#endif
@@ -0,0 +1,3 @@
+#include "symbol-index.h"
+
+void user() { shared_func(); }
@@ -0,0 +1,4 @@
+#ifndef SYMBOL_INDEX_H
+#define SYMBOL_INDEX_H
+void shared_func();
+#endif
@@ -0,0 +1,32 @@
+#include "preamble.h"
+
+int wibble(int);
+
+void f(int x) {
+  x = wibble(x);
+}
+
+// The first process precompiles the preamble and stores it in the cache; the
+// second one loads it from the cache on its very first parse.
+// RUN: rm -rf %t.cache
+// RUN: env CINDEXTEST_EDITING=1 LIBCLANG_TIMING=1 LIBCLANG_PREAMBLE_CACHE=%t.cache c-index-test -test-load-source-reparse 2 local -I %S/Inputs %s > %t.out1.txt 2> %t.err1.txt
+// RUN: FileCheck -check-prefix=CHECK-BUILD %s < %t.err1.txt
+// RUN: env CINDEXTEST_EDITING=1 LIBCLANG_TIMING=1 LIBCLANG_PREAMBLE_CACHE=%t.cache c-index-test -test-load-source-reparse 2 local -I %S/Inputs %s > %t.out2.txt 2> %t.err2.txt
+// RUN: FileCheck -check-prefix=CHECK-LOAD %s < %t.err2.txt
+// RUN: FileCheck %s < %t.out2.txt
+// RUN: diff %t.out1.txt %t.out2.txt
+// RUN: ls %t.cache | FileCheck -check-prefix=CHECK-FILES %s
+
+// CHECK-BUILD: Precompiling preamble
+// CHECK-BUILD: preamble.h:4:7:{4:9-4:13}: warning: incompatible pointer types assigning to 'int *' from 'float *'
+
+// CHECK-LOAD-NOT: Precompiling preamble
+// CHECK-LOAD: Loading cached preamble
+// CHECK-LOAD-NOT: Precompiling preamble
+// CHECK-LOAD: preamble.h:4:7:{4:9-4:13}: warning: incompatible pointer types assigning to 'int *' from 'float *'
+
+// CHECK: preamble.h:1:12: FunctionDecl=bar:1:12 (Definition) Extent=[1:1 - 6:2]
+// CHECK: preamble-cache.c:3:5: FunctionDecl=wibble:3:5 Extent=[3:1 - 3:16]
+
+// CHECK-FILES: {{[0-9a-f]+}}.meta
+// CHECK-FILES: {{[0-9a-f]+}}.pch
@@ -0,0 +1,21 @@
+#include "prefix.h"
+#include "preamble.h"
+
+int wibble(int);
+
+// The first reparse precompiles the preamble in two parts; once an #include
+// has been appended, only the part after "prefix.h" is precompiled again.
+// RUN: env CINDEXTEST_EDITING=1 CINDEXTEST_CHAINED_PREAMBLE=1 LIBCLANG_TIMING=1 CINDEXTEST_REMAP_AFTER_TRIAL=1 c-index-test -test-load-source-reparse 3 local "-remap-file=%s,%s.remap" -I %S/Inputs %s > %t.out.txt 2> %t.err.txt
+// RUN: FileCheck -check-prefix=CHECK-TIMING %s < %t.err.txt
+// RUN: FileCheck %s < %t.out.txt
+
+// CHECK-TIMING: Precompiling preamble:
+// CHECK-TIMING-NOT: Precompiling preamble
+// CHECK-TIMING: Precompiling preamble suffix:
+// CHECK-TIMING-NOT: Precompiling preamble
+// CHECK-TIMING: preamble.h:4:7:{4:9-4:13}: warning: incompatible pointer types assigning to 'int *' from 'float *'
+
+// CHECK: prefix.h:3:5: FunctionDecl=foo:3:5 Extent=[3:1 - 3:13]
+// CHECK: preamble.h:1:12: FunctionDecl=bar:1:12 (Definition) Extent=[1:1 - 6:2]
+// CHECK: b.h:1:15: TypedefDecl=B:1:15 (Definition) Extent=[1:1 - 1:16]
+// CHECK: preamble-chained.c:5:3: FunctionDecl=wibble:5:3 Extent=[5:1 - 5:14]
@@ -0,0 +1,32 @@
+#define UNRELATED
+#include "skip-indexed-headers-config.h"
+
+void use(Narrow &n);
+
+// A header is only skipped if the macros it tests are defined as they were
+// when it was indexed.
+// RUN: rm -f %t.headers
+// RUN: env CINDEXTEST_SKIP_INDEXED_HEADERS=1 CINDEXTEST_INDEXED_HEADERS_FILE=%t.headers \
+// RUN:   c-index-test -index-file %s -I%S/Inputs | FileCheck -check-prefix=NARROW %s
+// RUN: env CINDEXTEST_SKIP_INDEXED_HEADERS=1 CINDEXTEST_INDEXED_HEADERS_FILE=%t.headers \
+// RUN:   c-index-test -index-file %S/Inputs/skip-indexed-headers-config-wide.cpp -I%S/Inputs \
+// RUN:   | FileCheck -check-prefix=WIDE %s
+// RUN: env CINDEXTEST_SKIP_INDEXED_HEADERS=1 CINDEXTEST_INDEXED_HEADERS_FILE=%t.headers \
+// RUN:   c-index-test -index-file %s -I%S/Inputs | FileCheck -check-prefix=SKIPPED %s
+// RUN: env CINDEXTEST_SKIP_INDEXED_HEADERS=1 CINDEXTEST_INDEXED_HEADERS_FILE=%t.headers \
+// RUN:   c-index-test -index-file %S/Inputs/skip-indexed-headers-config-wide.cpp -I%S/Inputs \
+// RUN:   | FileCheck -check-prefix=SKIPPED %s
+
+// NARROW:      [ppIncludedFile]: {{.*}}skip-indexed-headers-config.h
+// NARROW-NOT:  already indexed
+// NARROW:      [indexDeclaration]: kind: struct | name: Narrow
+// NARROW:      [skippedHeaders]: 0
+
+// WIDE:      [ppIncludedFile]: {{.*}}skip-indexed-headers-config.h
+// WIDE-NOT:  already indexed
+// WIDE:      [indexDeclaration]: kind: struct | name: Wide
+// WIDE:      [skippedHeaders]: 0
+
+// SKIPPED:     [ppIncludedFile]: {{.*}}skip-indexed-headers-config.h {{.*}} | already indexed
+// SKIPPED-NOT: [indexDeclaration]: kind: struct
+// SKIPPED:     [skippedHeaders]: 1
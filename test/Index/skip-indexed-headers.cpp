@@ -0,0 +1,23 @@
+#include "skip-indexed-headers.h"
+
+void use(Shared &s) { s.method(); }
+
+// RUN: rm -f %t.headers
+// RUN: env CINDEXTEST_SKIP_INDEXED_HEADERS=1 CINDEXTEST_INDEXED_HEADERS_FILE=%t.headers \
+// RUN:   c-index-test -index-file %s -I%S/Inputs | FileCheck -check-prefix=FIRST %s
+// RUN: env CINDEXTEST_SKIP_INDEXED_HEADERS=1 CINDEXTEST_INDEXED_HEADERS_FILE=%t.headers \
+// RUN:   c-index-test -index-file %s -I%S/Inputs | FileCheck -check-prefix=SECOND %s
+// RUN: env CINDEXTEST_SKIP_INDEXED_HEADERS=1 CINDEXTEST_INDEXED_HEADERS_FILE=%t.headers \
+// RUN:   c-index-test -index-file %s -I%S/Inputs -DOTHER_CONTEXT | FileCheck -check-prefix=FIRST %s
+
+// FIRST:      [ppIncludedFile]: {{.*}}skip-indexed-headers.h | name: "skip-indexed-headers.h" | hash loc: 1:1 | isImport: 0 | isAngled: 0 | isModule: 0
+// FIRST-NOT:  already indexed
+// FIRST:      [indexDeclaration]: kind: struct | name: Shared
+// FIRST:      [indexDeclaration]: kind: function | name: use
+// FIRST:      [skippedHeaders]: 0
+
+// SECOND:      [ppIncludedFile]: {{.*}}skip-indexed-headers.h | name: "skip-indexed-headers.h" | hash loc: 1:1 | isImport: 0 | isAngled: 0 | isModule: 0 | already indexed
+// SECOND-NOT:  [indexDeclaration]: kind: struct | name: Shared
+// SECOND:      [indexDeclaration]: kind: function | name: use
+// SECOND-NEXT: [indexEntityReference]: kind: struct | name: Shared
+// SECOND:      [skippedHeaders]: 1
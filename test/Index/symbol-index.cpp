@@ -0,0 +1,31 @@
+#include "symbol-index.h"
+#ifndef DROP_DEFINITION
+void shared_func() {}
+#endif
+
+// RUN: rm -f %t.idx
+// RUN: c-index-test -write-symbol-index %t.idx %s -I%S/Inputs
+// RUN: c-index-test -write-symbol-index %t.idx %S/Inputs/symbol-index-user.cpp -I%S/Inputs
+// RUN: c-index-test -find-symbol-occurrences %t.idx c:@F@shared_func# c:@F@user# -file=%S/Inputs/symbol-index.h \
+// RUN:   | FileCheck %s
+
+// CHECK:      [symbolIndex]: files: 3 | symbols: 2 | occurrences: 4
+// CHECK-NEXT: [usr]: c:@F@shared_func#
+// CHECK-NEXT: c:@F@shared_func# | {{.*}}symbol-index-user.cpp:3:15 | ref
+// CHECK-NEXT: c:@F@shared_func# | {{.*}}symbol-index.h:3:6 | decl
+// CHECK-NEXT: c:@F@shared_func# | {{.*}}symbol-index.cpp:3:6 | decl def
+// CHECK-NEXT: [usr]: c:@F@user#
+// CHECK-NEXT: c:@F@user# | {{.*}}symbol-index-user.cpp:3:6 | decl def
+// CHECK-NEXT: [file]: {{.*}}symbol-index.h
+// CHECK-NEXT: c:@F@shared_func# | {{.*}}symbol-index.h:3:6 | decl
+
+// Indexing this file again replaces only its own occurrences.
+// RUN: c-index-test -write-symbol-index %t.idx %s -I%S/Inputs -DDROP_DEFINITION
+// RUN: c-index-test -find-symbol-occurrences %t.idx c:@F@shared_func# \
+// RUN:   | FileCheck -check-prefix=UPDATED %s
+
+// UPDATED:      [symbolIndex]: files: 3 | symbols: 2 | occurrences: 3
+// UPDATED-NEXT: [usr]: c:@F@shared_func#
+// UPDATED-NEXT: c:@F@shared_func# | {{.*}}symbol-index-user.cpp:3:15 | ref
+// UPDATED-NEXT: c:@F@shared_func# | {{.*}}symbol-index.h:3:6 | decl
+// UPDATED-NOT:  symbol-index.cpp
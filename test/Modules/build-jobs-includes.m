@@ -0,0 +1,43 @@
+// RUN: rm -rf %t
+// RUN: mkdir %t
+// RUN: echo '#include "B.h"' > %t/A.h
+// RUN: echo '#import "C.h"' >> %t/A.h
+// RUN: echo '#include <D.h>' > %t/B.h
+// RUN: echo 'int b;' >> %t/B.h
+// RUN: echo '@import D;' > %t/C.h
+// RUN: echo 'int c;' >> %t/C.h
+// RUN: echo 'int d;' > %t/D.h
+// RUN: echo 'int e;' > %t/E.h
+// RUN: echo 'module A { header "A.h" }' > %t/module.modulemap
+// RUN: echo 'module B { header "B.h" }' >> %t/module.modulemap
+// RUN: echo 'module C { header "C.h" }' >> %t/module.modulemap
+// RUN: echo 'module D { header "D.h" }' >> %t/module.modulemap
+// RUN: echo 'module E { header "E.h" }' >> %t/module.modulemap
+
+// Without 'use' declarations, the modules are found from the directives in
+// the headers. E, which the translation unit includes after importing A, is
+// built alongside the modules A uses.
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t \
+// RUN:   -fsyntax-only %s -I %t -fmodules-build-jobs=4 -Rmodule-build 2>&1 \
+// RUN:   | FileCheck %s
+
+// CHECK: building module 'D'
+// CHECK: building module 'E'
+// CHECK-DAG: building module 'B'
+// CHECK-DAG: building module 'C'
+// CHECK-DAG: finished building module 'D'
+// CHECK-DAG: finished building module 'E'
+// CHECK-DAG: finished building module 'B'
+// CHECK-DAG: finished building module 'C'
+// CHECK: building module 'A'
+// CHECK: finished building module 'A'
+// CHECK-NOT: building module
+
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t \
+// RUN:   -fsyntax-only %s -I %t -fmodules-build-jobs=4 -Rmodule-build -verify
+
+// expected-no-diagnostics
+@import A;
+#include "E.h"
+
+int *pointers[] = { &b, &c, &d, &e };
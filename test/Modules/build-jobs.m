@@ -0,0 +1,36 @@
+// RUN: rm -rf %t
+// RUN: mkdir %t
+// RUN: echo '#include "B.h"' > %t/A.h
+// RUN: echo '#include "C.h"' >> %t/A.h
+// RUN: echo '#include "D.h"' > %t/B.h
+// RUN: echo 'int b;' >> %t/B.h
+// RUN: echo '#include "D.h"' > %t/C.h
+// RUN: echo 'int c;' >> %t/C.h
+// RUN: echo 'int d;' > %t/D.h
+// RUN: echo 'module A { header "A.h" use B use C }' > %t/module.modulemap
+// RUN: echo 'module B { header "B.h" use D }' >> %t/module.modulemap
+// RUN: echo 'module C { header "C.h" use D }' >> %t/module.modulemap
+// RUN: echo 'module D { header "D.h" }' >> %t/module.modulemap
+
+// The modules A uses are built first, B and C at the same time.
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t \
+// RUN:   -fsyntax-only %s -I %t -fmodules-build-jobs=4 -Rmodule-build 2>&1 \
+// RUN:   | FileCheck %s
+
+// CHECK: building module 'D'
+// CHECK: finished building module 'D'
+// CHECK-DAG: building module 'B'
+// CHECK-DAG: building module 'C'
+// CHECK-DAG: finished building module 'B'
+// CHECK-DAG: finished building module 'C'
+// CHECK: building module 'A'
+// CHECK: finished building module 'A'
+
+// The modules are not built again.
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t \
+// RUN:   -fsyntax-only %s -I %t -fmodules-build-jobs=4 -Rmodule-build -verify
+
+// expected-no-diagnostics
+@import A;
+
+int *pointers[] = { &b, &c, &d };
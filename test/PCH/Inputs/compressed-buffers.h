@@ -0,0 +1,11 @@
+#define HEADER_MACRO 1
+int header_value;
+
+#define FIELDS4(x) int x##0, x##1, x##2, x##3;
+#define FIELDS16(x) FIELDS4(x##0) FIELDS4(x##1) FIELDS4(x##2) FIELDS4(x##3)
+#define FIELDS64(x) FIELDS16(x##0) FIELDS16(x##1) FIELDS16(x##2) FIELDS16(x##3)
+#define FIELDS256(x) FIELDS64(x##0) FIELDS64(x##1) FIELDS64(x##2) FIELDS64(x##3)
+
+struct Wide {
+  FIELDS256(f)
+};
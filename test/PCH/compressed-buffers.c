@@ -0,0 +1,24 @@
+// RUN: %clang_cc1 -x c-header %S/Inputs/compressed-buffers.h -emit-pch \
+// RUN:   -o %t.pch -fmodules-compress-buffers
+// RUN: %clang_cc1 %s -include-pch %t.pch -fsyntax-only -verify
+// RUN: %clang_cc1 %s -include-pch %t.pch -fsyntax-only -print-stats 2>&1 \
+// RUN:   | FileCheck %s
+// RUN: %clang_cc1 -x c-header %S/Inputs/compressed-buffers.h -emit-pch \
+// RUN:   -o %t-uncompressed.pch
+// RUN: %clang_cc1 %s -include-pch %t-uncompressed.pch -fsyntax-only \
+// RUN:   -print-stats 2>&1 | FileCheck -check-prefix=UNCOMPRESSED %s
+
+// Header contents are referenced from disk rather than embedded, and the
+// predefines buffer, which every load reads, is stored uncompressed.
+// CHECK-NOT: compressed buffers read
+// The lexical and visible declarations of struct Wide are inflated when it
+// is deserialized.
+// CHECK: 2 compressed declaration contexts read: {{[0-9]+}} bytes inflated to {{[0-9]+}} bytes in {{.*}} seconds
+
+// UNCOMPRESSED-NOT: compressed
+
+// expected-no-diagnostics
+int main_value = HEADER_MACRO;
+int *header_pointer = &header_value;
+int wide_value(struct Wide *W) { return W->f0000 + W->f3333; }
+// REQUIRES: zlib
@@ -0,0 +1,32 @@
+// RUN: rm -rf %t.dir
+// RUN: mkdir -p %t.dir
+// RUN: echo '#include "header2.h"' > %t.dir/header1.h
+// RUN: echo 'int header_value;' > %t.dir/header2.h
+// RUN: %clang_cc1 -x c-header %t.dir/header1.h -emit-pch -o %t.pch
+// RUN: %clang_cc1 %s -include-pch %t.pch -fsyntax-only -print-stats 2>&1 \
+// RUN:   | FileCheck -check-prefix=STATS %s
+// RUN: echo >> %t.dir/header2.h
+// RUN: not %clang_cc1 %s -include-pch %t.pch -fsyntax-only 2>&1 \
+// RUN:   | FileCheck -check-prefix=EAGER %s
+
+// The modified header is never looked into, so it is not validated.
+// RUN: %clang_cc1 %s -include-pch %t.pch -fsyntax-only -verify \
+// RUN:   -fmodules-validate-input-files-lazily
+
+// A diagnostic that points into the modified header looks into it, which
+// validates it.
+// RUN: not %clang_cc1 %s -include-pch %t.pch -fsyntax-only -DREDECLARE \
+// RUN:   -fmodules-validate-input-files-lazily 2>&1 \
+// RUN:   | FileCheck -check-prefix=LAZY %s
+
+// expected-no-diagnostics
+int main_value;
+
+#ifdef REDECLARE
+float header_value;
+#endif
+
+// STATS: 2 input files validated in {{.*}} seconds
+// EAGER: fatal error: file {{.*}}header2.h has been modified since the precompiled header {{.*}} was built
+// LAZY: fatal error: file {{.*}}header2.h has been modified since the precompiled header {{.*}} was built
+// REQUIRES: shell
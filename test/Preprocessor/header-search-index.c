@@ -0,0 +1,31 @@
+// RUN: rm -rf %t && mkdir -p %t/a %t/b %t/c
+// RUN: echo "int from_c;" > %t/c/found.h
+// RUN: touch -t 200001010000 %t/a %t/b %t/c
+
+// The first compilation snapshots each directory it searches, and so need
+// not probe the directories that lack the header.
+// RUN: %clang_cc1 -E -fheader-search-index=%t/index -I %t/a -I %t/b -I %t/c %s -o %t/out1 -print-stats 2>&1 | FileCheck -check-prefix=FIRST %s
+// RUN: FileCheck -check-prefix=FIRST-OUT %s < %t/out1
+// RUN: FileCheck -check-prefix=INDEX %s < %t/index
+// FIRST-OUT: int from_c;
+// FIRST: 0 header search index snapshots reused, 3 taken.
+// FIRST-NEXT: 2 directory probes avoided.
+// INDEX: clang-header-search-index 1
+
+// A later one reuses the snapshots.
+// RUN: %clang_cc1 -E -fheader-search-index=%t/index -I %t/a -I %t/b -I %t/c %s -o %t/out2 -print-stats 2>&1 | FileCheck -check-prefix=SECOND %s
+// RUN: FileCheck -check-prefix=SECOND-OUT %s < %t/out2
+// SECOND-OUT: int from_c;
+// SECOND: 3 header search index snapshots reused, 0 taken.
+// SECOND-NEXT: 2 directory probes avoided.
+
+// Adding a header to a directory invalidates its snapshot.
+// RUN: echo "int from_a;" > %t/a/found.h
+// RUN: %clang_cc1 -E -fheader-search-index=%t/index -I %t/a -I %t/b -I %t/c %s -o %t/out3 -print-stats 2>&1 | FileCheck -check-prefix=ADDED %s
+// RUN: FileCheck -check-prefix=ADDED-OUT %s < %t/out3
+// ADDED-OUT-NOT: from_c
+// ADDED-OUT: int from_a;
+// ADDED: 0 header search index snapshots reused, 1 taken.
+// ADDED-NEXT: 0 directory probes avoided.
+
+#include "found.h"
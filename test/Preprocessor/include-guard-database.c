@@ -0,0 +1,26 @@
+// RUN: rm -rf %t && mkdir -p %t
+// RUN: cp %S/Inputs/include-guard-database/guarded.h %t/guarded.h
+
+// The first compilation enters the header and records its guard.
+// RUN: %clang_cc1 -E -finclude-guard-database=%t/guards -I %t %s | FileCheck -check-prefix=ENTERED %s
+// RUN: FileCheck -check-prefix=DB %s < %t/guards
+// ENTERED: int guarded_content;
+// DB: clang-include-guard-database 1
+// DB-NEXT: {{^[0-9]+ [0-9]+ GUARDED_H .*guarded.h$}}
+
+// A later one with the guard already defined does not open the header, but
+// still lists it as a dependency.
+// RUN: %clang_cc1 -E -DGUARDED_H -finclude-guard-database=%t/guards -I %t %s -dependency-file %t/deps -MT out -print-stats 2>&1 | FileCheck -check-prefix=SKIPPED %s
+// RUN: FileCheck -check-prefix=DEPS %s < %t/deps
+// SKIPPED-NOT: guarded_content
+// SKIPPED: 1 #includes skipped due to the include guard database.
+// DEPS: out:
+// DEPS: guarded.h
+
+// Once the header changes, its entry no longer applies.
+// RUN: echo "int unguarded_content;" >> %t/guarded.h
+// RUN: %clang_cc1 -E -DGUARDED_H -finclude-guard-database=%t/guards -I %t %s | FileCheck -check-prefix=CHANGED %s
+// CHANGED-NOT: int guarded_content
+// CHANGED: int unguarded_content;
+
+#include "guarded.h"
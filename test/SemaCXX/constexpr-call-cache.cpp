@@ -0,0 +1,53 @@
+// RUN: %clang_cc1 -std=c++1y -fsyntax-only -verify -fconstexpr-depth 16 -print-stats %s 2>&1 | FileCheck %s
+// RUN: %clang_cc1 -std=c++1y -fsyntax-only -verify -fconstexpr-depth 16 -fconstexpr-cache-size 0 %s
+// RUN: %clang_cc1 -std=c++1y -fsyntax-only -verify -fconstexpr-depth 16 -fconstexpr-cache-size 2 %s
+
+constexpr unsigned fib(unsigned n) {
+  return n < 2 ? n : fib(n - 1) + fib(n - 2);
+}
+static_assert(fib(12) == 144, "");
+static_assert(fib(12) == 144, "");
+
+// The key must be computed before the call modifies its parameters.
+constexpr int countdown(int n) {
+  int k = 0;
+  while (n) {
+    --n;
+    ++k;
+  }
+  return k;
+}
+static_assert(countdown(5) == 5, "");
+static_assert(countdown(5) == 5, "");
+static_assert(countdown(0) == 0, "");
+
+struct Pair { int a, b; };
+constexpr int diff(Pair p) { return p.a - p.b; }
+static_assert(diff({3, 1}) == 2, "");
+static_assert(diff({1, 3}) == -2, "");
+static_assert(diff({3, 1}) == 2, "");
+
+// Calls through references are not memoized.
+constexpr int twice(const int &n) { return 2 * n; }
+constexpr int one = 1, two = 2;
+static_assert(twice(one) == 2, "");
+static_assert(twice(two) == 4, "");
+
+// A memoized call must still respect the depth limit.
+constexpr int depth(int n) { return n ? depth(n - 1) + 1 : 0; } // expected-note {{exceeded maximum depth of 16 calls}} expected-note +{{}}
+constexpr int deep(int n) { return n ? deep(n - 1) : depth(10); } // expected-note 0+{{}}
+static_assert(deep(2) == 10, "");
+static_assert(deep(8) == 10, ""); // expected-error {{not an integral constant expression}} expected-note {{in call to 'deep(8)'}}
+
+// A call that hits the cache is as deep as the call it stands for, also for
+// the calls enclosing it whose results are memoized.
+constexpr int depth2(int n) { return n ? depth2(n - 1) + 1 : 0; } // expected-note {{exceeded maximum depth of 16 calls}} expected-note +{{}}
+constexpr int wrap(int n) { return n ? wrap(n - 1) : depth2(5); } // expected-note 0+{{}}
+constexpr int outer(int n) { return n ? outer(n - 1) : wrap(2); } // expected-note 0+{{}}
+static_assert(depth2(5) == 5, "");
+static_assert(wrap(2) == 5, "");
+static_assert(outer(2) == 5, "");
+static_assert(outer(8) == 5, ""); // expected-error {{not an integral constant expression}} expected-note {{in call to 'outer(8)'}}
+
+// CHECK: *** Constexpr Call Cache Stats:
+// CHECK-NEXT: {{[1-9][0-9]*}}/{{[0-9]+}} lookups hit the cache
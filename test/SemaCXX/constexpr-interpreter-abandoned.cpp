@@ -0,0 +1,12 @@
+// RUN: %clang_cc1 -std=c++1y -fsyntax-only -verify -fconstexpr-steps 100 -fconstexpr-cache-size 0 -fexperimental-new-constant-interpreter -print-stats %s 2>&1 | FileCheck %s
+
+// The interpreter gives up on the outermost call only once it has reached the
+// step limit at the bottom of the recursion. The tree-walking evaluator then
+// evaluates the call to diagnose it, and does not hand the calls it makes back
+// to the interpreter, which would give up on each of them in the same way.
+constexpr int sum(int n) { return n ? sum(n - 1) + 1 : 0; } // expected-note {{maximum step limit}} expected-note +{{}}
+static_assert(sum(10) == 10, "");
+static_assert(sum(200) == 200, ""); // expected-error {{not an integral constant expression}} expected-note {{in call to 'sum(200)'}}
+
+// CHECK: *** Constexpr Interpreter Stats:
+// CHECK: {{^}}  {{[0-9]+}} calls interpreted, {{[1-9]}} abandoned{{$}}
@@ -0,0 +1,104 @@
+// RUN: %clang_cc1 -std=c++1y -fsyntax-only -verify -fconstexpr-depth 16 -fconstexpr-steps 1000 %s
+// RUN: %clang_cc1 -std=c++1y -fsyntax-only -verify -fconstexpr-depth 16 -fconstexpr-steps 1000 -fconstexpr-cache-size 0 -fexperimental-new-constant-interpreter -print-stats %s 2>&1 | FileCheck %s
+
+// CHECK: *** Constexpr Interpreter Stats:
+// CHECK-NEXT: {{[1-9][0-9]*}} functions compiled to bytecode, {{[1-9][0-9]*}} left to the evaluator
+// CHECK-NEXT: {{[1-9][0-9]*}} calls interpreted, {{[1-9][0-9]*}} abandoned
+
+enum Color { Red = 1, Green = 2, Blue = 4 };
+constexpr int Offset = 10;
+
+constexpr unsigned fib(unsigned n) {
+  return n < 2 ? n : fib(n - 1) + fib(n - 2);
+}
+static_assert(fib(12) == 144, "");
+
+constexpr long long factorial(int n) {
+  long long r = 1;
+  for (int i = 2; i <= n; ++i)
+    r *= i;
+  return r;
+}
+static_assert(factorial(20) == 2432902008176640000LL, "");
+
+constexpr int collatz(unsigned long long n) {
+  int steps = 0;
+  do {
+    if (n == 1)
+      break;
+    n = n % 2 ? 3 * n + 1 : n / 2;
+    ++steps;
+  } while (true);
+  return steps;
+}
+static_assert(collatz(27) == 111, "");
+
+constexpr int sumOdd(int n) {
+  int sum = 0, i = 0;
+  while (i < n) {
+    if (i++ % 2 == 0)
+      continue;
+    sum += i - 1;
+  }
+  return sum;
+}
+static_assert(sumOdd(10) == 25, "");
+
+constexpr int bits(Color c, bool b, char ch) {
+  int r = (c | Blue) << 1;
+  r ^= ~0u >> 28;
+  r -= -Offset;
+  return b && ch == 'x' ? r + sizeof(long) : -r;
+}
+static_assert(bits(Red, true, 'x') == (((1 | 4) << 1) ^ 15) + 10 + sizeof(long), "");
+static_assert(bits(Green, false, 'x') == -((((2 | 4) << 1) ^ 15) + 10), "");
+
+constexpr short narrow(short s) {
+  s += 30000;
+  unsigned char c = 200;
+  c += 100;
+  return s + c;
+}
+static_assert(narrow(10000) == -25536 + 44, "");
+
+template<int N> constexpr int scaled(int x, int k = 3) { return N * x + k; }
+static_assert(scaled<4>(5) == 23, "");
+
+// Calls which overflow or divide by zero produce the same diagnostics either
+// way.
+constexpr int add(int a, int b) { return a + b; } // expected-note {{value 2147483648 is outside the range}}
+constexpr int addAll(int n) { return n ? add(addAll(n - 1), 1 << 30) : 0; } // expected-note {{in call to 'add(}}
+static_assert(addAll(1) == 1 << 30, "");
+static_assert(addAll(2), ""); // expected-error {{not an integral constant expression}} expected-note {{in call to}}
+
+constexpr int quotient(int a, int b) { return a / b; } // expected-note {{division by zero}}
+static_assert(quotient(7, 2) == 3, "");
+static_assert(quotient(-7, 2) == -3, "");
+static_assert(quotient(7, 0), ""); // expected-error {{not an integral constant expression}} expected-note {{in call to}}
+
+constexpr int shift(int a, int b) { return a << b; } // expected-note {{shift count 32 >= width}}
+static_assert(shift(1, 30) == 1 << 30, "");
+static_assert(shift(1, 32), ""); // expected-error {{not an integral constant expression}} expected-note {{in call to}}
+
+// The depth and step limits apply exactly as they do to the tree-walking
+// evaluator.
+constexpr int depth(int n) { return n > 1 ? depth(n - 1) : 0; } // expected-note {{exceeded maximum depth of 16 calls}} expected-note +{{}}
+static_assert(depth(16) == 0, "");
+static_assert(depth(17) == 0, ""); // expected-error {{not an integral constant expression}} expected-note {{in call to 'depth(}}
+
+// One step each for the body, the declaration, the loop and the return, and
+// one per iteration.
+constexpr int count(int n) {
+  int k = 0;
+  while (k != n)
+    ++k;
+  return k; // expected-note {{maximum step limit}}
+}
+static_assert(count(996) == 996, "");
+static_assert(count(997) == 997, ""); // expected-error {{not an integral constant expression}} expected-note {{in call to}}
+
+// Functions on other types are left to the tree-walking evaluator.
+struct S { int n; };
+constexpr int get(S s) { return s.n; }
+constexpr int viaStruct(int n) { return get(S{n}) + 1; }
+static_assert(viaStruct(2) == 3, "");
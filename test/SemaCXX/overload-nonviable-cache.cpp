@@ -0,0 +1,58 @@
+// RUN: %clang_cc1 -fsyntax-only -verify %s
+// RUN: %clang_cc1 -fsyntax-only -print-stats %s 2>&1 | FileCheck %s
+
+// CHECK: *** Semantic Analysis Stats:
+// CHECK: {{[1-9][0-9]*}} overload candidates considered, {{[1-9][0-9]*}} viable.
+// CHECK-NEXT: {{[1-9][0-9]*}} candidates rejected by a known non-viable conversion, {{[1-9][0-9]*}} such conversions known.
+
+struct Stream {
+  Stream &operator<<(int);
+  Stream &operator<<(double);
+  Stream &operator<<(const void *);
+};
+
+struct Point { int x, y; };
+Stream &operator<<(Stream &, const Point &);
+
+struct Name {};
+typedef Name Alias;
+
+void print(Stream &s, Point p, const Point &q, Point *pp) {
+  // Each of these rejects the member candidates for a Point argument; all
+  // but the first find that out from the earlier attempts.
+  s << p;
+  s << q;
+  s << p << q << 1;
+  s << pp;
+}
+
+// Rejected candidates are diagnosed the same way whether or not they were
+// rejected before, and with the argument types as written.
+void f(int); // expected-note 2{{no known conversion from 'Name' to 'int'}} expected-note {{no known conversion from 'Alias' (aka 'Name') to 'int'}}
+void f(double); // expected-note 2{{no known conversion from 'Name' to 'double'}} expected-note {{no known conversion from 'Alias' (aka 'Name') to 'double'}}
+
+void g(Name n, Alias a) {
+  f(n); // expected-error {{no matching function for call to 'f'}}
+  f(n); // expected-error {{no matching function for call to 'f'}}
+  f(a); // expected-error {{no matching function for call to 'f'}}
+}
+
+// A class that is only declared at the first call may gain a conversion by
+// the second.
+struct Later;
+void h(int); // expected-note {{candidate function not viable}}
+void h(const char *); // expected-note {{candidate function not viable}}
+void useLater(Later &l) {
+  h(l); // expected-error {{no matching function for call to 'h'}}
+}
+struct Later { operator int(); };
+void useLaterAgain(Later &l) { h(l); }
+
+// An integer argument may or may not be a null pointer constant.
+struct FromPointer { FromPointer(const int *); };
+void k(FromPointer); // expected-note {{no known conversion from 'int' to 'FromPointer'}}
+void useNull(int n) {
+  k(0);
+  k(n); // expected-error {{no matching function for call to 'k'}}
+  k(0);
+}
@@ -76,6 +76,10 @@ static unsigned getDefaultParsingOptions() {
     options |= CXTranslationUnit_SkipFunctionBodies;
   if (getenv("CINDEXTEST_COMPLETION_BRIEF_COMMENTS"))
     options |= CXTranslationUnit_IncludeBriefCommentsInCodeCompletion;
+  if (getenv("CINDEXTEST_BACKGROUND_PREAMBLE"))
+    options |= CXTranslationUnit_BuildPreambleInBackground;
+  if (getenv("CINDEXTEST_CHAINED_PREAMBLE"))
+    options |= CXTranslationUnit_ChainedPreamble;
   
   return options;
 }
@@ -2898,6 +2902,8 @@ static CXIdxClientFile index_ppIncludedFile(CXClientData client_data,
     printf(" | module: %s", cstr);
     clang_disposeString(str);
   }
+  if (info->isAlreadyIndexed)
+    printf(" | already indexed");
 
   printf("\n");
 
@@ -3085,10 +3091,30 @@ static unsigned getIndexOptions(void) {
     index_opts |= CXIndexOpt_IndexFunctionLocalSymbols;
   if (!getenv("CINDEXTEST_DISABLE_SKIPPARSEDBODIES"))
     index_opts |= CXIndexOpt_SkipParsedBodiesInSession;
+  if (getenv("CINDEXTEST_SKIP_INDEXED_HEADERS"))
+    index_opts |= CXIndexOpt_SkipIndexedHeaders;
 
   return index_opts;
 }
 
+static CXIndexAction createIndexAction(CXIndex Idx) {
+  CXIndexAction idxAction;
+  const char *indexed_headers;
+
+  idxAction = clang_IndexAction_create(Idx);
+  indexed_headers = getenv("CINDEXTEST_INDEXED_HEADERS_FILE");
+  if (indexed_headers)
+    clang_IndexAction_setIndexedHeadersFile(idxAction, indexed_headers);
+  return idxAction;
+}
+
+static void disposeIndexAction(CXIndexAction idxAction) {
+  if (getIndexOptions() & CXIndexOpt_SkipIndexedHeaders)
+    printf("[skippedHeaders]: %u\n",
+           clang_IndexAction_getNumSkippedHeaders(idxAction));
+  clang_IndexAction_dispose(idxAction);
+}
+
 static int index_compile_args(int num_args, const char **args,
                               CXIndexAction idxAction,
                               ImportedASTFilesData *importedASTs,
@@ -3181,7 +3207,7 @@ static int index_file(int argc, const char **argv, int full) {
     fprintf(stderr, "Could not create Index\n");
     return 1;
   }
-  idxAction = clang_IndexAction_create(Idx);
+  idxAction = createIndexAction(Idx);
   importedASTs = 0;
   if (full)
     importedASTs = importedASTs_create();
@@ -3200,7 +3226,7 @@ static int index_file(int argc, const char **argv, int full) {
 
 finished:
   importedASTs_dispose(importedASTs);
-  clang_IndexAction_dispose(idxAction);
+  disposeIndexAction(idxAction);
   clang_disposeIndex(Idx);
   return result;
 }
@@ -3225,12 +3251,12 @@ static int index_tu(int argc, const char **argv) {
     fprintf(stderr, "Could not create Index\n");
     return 1;
   }
-  idxAction = clang_IndexAction_create(Idx);
+  idxAction = createIndexAction(Idx);
 
   result = index_ast_file(argv[0], Idx, idxAction,
                           /*importedASTs=*/0, check_prefix);
 
-  clang_IndexAction_dispose(idxAction);
+  disposeIndexAction(idxAction);
   clang_disposeIndex(Idx);
   return result;
 }
@@ -3260,7 +3286,7 @@ static int index_compile_db(int argc, const char **argv) {
     fprintf(stderr, "Could not create Index\n");
     return 1;
   }
-  idxAction = clang_IndexAction_create(Idx);
+  idxAction = createIndexAction(Idx);
 
   {
     const char *database = argv[0];
@@ -3353,11 +3379,174 @@ static int index_compile_db(int argc, const char **argv) {
 
   }
 
-  clang_IndexAction_dispose(idxAction);
+  disposeIndexAction(idxAction);
   clang_disposeIndex(Idx);
   return errorCode;
 }
 
+/******************************************************************************/
+/* Symbol index testing.                                                      */
+/******************************************************************************/
+
+static void symbol_index_beginFile(CXSymbolIndexBuilder builder,
+                                   CXFile file) {
+  CXString filename;
+
+  if (!file)
+    return;
+  filename = clang_getFileName(file);
+  clang_SymbolIndexBuilder_beginFile(builder, clang_getCString(filename));
+  clang_disposeString(filename);
+}
+
+static CXIdxClientFile
+symbol_index_enteredMainFile(CXClientData client_data, CXFile file,
+                             void *reserved) {
+  symbol_index_beginFile((CXSymbolIndexBuilder)client_data, file);
+  return (CXIdxClientFile)file;
+}
+
+static CXIdxClientFile
+symbol_index_ppIncludedFile(CXClientData client_data,
+                            const CXIdxIncludedFileInfo *info) {
+  /* The occurrences of a file already indexed are not reported, so keep
+     those the index has for it. */
+  if (!info->isAlreadyIndexed)
+    symbol_index_beginFile((CXSymbolIndexBuilder)client_data, info->file);
+  return (CXIdxClientFile)info->file;
+}
+
+static void symbol_index_addOccurrence(CXClientData client_data,
+                                       const CXIdxEntityInfo *entity,
+                                       CXIdxLoc loc, unsigned roles) {
+  CXFile file;
+  unsigned line, column;
+  CXString filename;
+
+  if (!entity || !entity->USR || !*entity->USR)
+    return;
+  clang_indexLoc_getFileLocation(loc, 0, &file, &line, &column, 0);
+  if (!file)
+    return;
+  filename = clang_getFileName(file);
+  clang_SymbolIndexBuilder_addOccurrence((CXSymbolIndexBuilder)client_data,
+                                         entity->USR,
+                                         clang_getCString(filename),
+                                         line, column, roles);
+  clang_disposeString(filename);
+}
+
+static void symbol_index_indexDeclaration(CXClientData client_data,
+                                          const CXIdxDeclInfo *info) {
+  unsigned roles;
+
+  roles = CXSymbolIndexRole_Declaration;
+  if (info->isDefinition)
+    roles |= CXSymbolIndexRole_Definition;
+  symbol_index_addOccurrence(client_data, info->entityInfo, info->loc, roles);
+}
+
+static void symbol_index_indexEntityReference(CXClientData client_data,
+                                              const CXIdxEntityRefInfo *info) {
+  symbol_index_addOccurrence(client_data, info->referencedEntity, info->loc,
+                             CXSymbolIndexRole_Reference);
+}
+
+static IndexerCallbacks SymbolIndexCB = {
+  0, /*abortQuery*/
+  0, /*diagnostic*/
+  symbol_index_enteredMainFile,
+  symbol_index_ppIncludedFile,
+  0, /*importedASTFile*/
+  0, /*startedTranslationUnit*/
+  symbol_index_indexDeclaration,
+  symbol_index_indexEntityReference
+};
+
+static int write_symbol_index(int argc, const char **argv) {
+  const char *index_path;
+  CXIndex Idx;
+  CXIndexAction idxAction;
+  CXSymbolIndexBuilder builder;
+  int result;
+
+  index_path = argv[0];
+  ++argv;
+  --argc;
+  if (argc == 0) {
+    fprintf(stderr, "no compiler arguments\n");
+    return -1;
+  }
+
+  if (!(Idx = clang_createIndex(/* excludeDeclsFromPCH */ 1,
+                                /* displayDiagnostics=*/1))) {
+    fprintf(stderr, "Could not create Index\n");
+    return 1;
+  }
+  idxAction = createIndexAction(Idx);
+  builder = clang_SymbolIndexBuilder_create(0);
+
+  result = clang_indexSourceFile(idxAction, builder,
+                                 &SymbolIndexCB, sizeof(SymbolIndexCB),
+                                 getIndexOptions(), 0, argv, argc, 0, 0, 0,
+                                 getDefaultParsingOptions());
+  if (result != CXError_Success)
+    describeLibclangFailure(result);
+  else if (clang_SymbolIndexBuilder_write(builder, index_path)) {
+    fprintf(stderr, "Unable to write symbol index '%s'\n", index_path);
+    result = -1;
+  }
+
+  clang_SymbolIndexBuilder_dispose(builder);
+  disposeIndexAction(idxAction);
+  clang_disposeIndex(Idx);
+  return result;
+}
+
+static enum CXVisitorResult
+print_symbol_occurrence(void *context, const CXSymbolOccurrence *occurrence) {
+  printf("%s | %s:%u:%u |", occurrence->usr, occurrence->filename,
+         occurrence->line, occurrence->column);
+  if (occurrence->roles & CXSymbolIndexRole_Declaration)
+    printf(" decl");
+  if (occurrence->roles & CXSymbolIndexRole_Definition)
+    printf(" def");
+  if (occurrence->roles & CXSymbolIndexRole_Reference)
+    printf(" ref");
+  printf("\n");
+  return CXVisit_Continue;
+}
+
+static int find_symbol_occurrences(int argc, const char **argv) {
+  CXSymbolIndex index;
+  int i;
+
+  if (!(index = clang_SymbolIndex_load(argv[0]))) {
+    fprintf(stderr, "Unable to load symbol index '%s'\n", argv[0]);
+    return 1;
+  }
+
+  printf("[symbolIndex]: files: %u | symbols: %u | occurrences: %u\n",
+         clang_SymbolIndex_getNumFiles(index),
+         clang_SymbolIndex_getNumSymbols(index),
+         clang_SymbolIndex_getNumOccurrences(index));
+  for (i = 1; i < argc; ++i) {
+    if (strstr(argv[i], "-file=") == argv[i]) {
+      printf("[file]: %s\n", argv[i] + strlen("-file="));
+      clang_SymbolIndex_findOccurrencesInFile(index,
+                                              argv[i] + strlen("-file="),
+                                              print_symbol_occurrence, 0);
+    } else {
+      printf("[usr]: %s\n", argv[i]);
+      clang_SymbolIndex_findOccurrences(index, argv[i],
+                                        print_symbol_occurrence, 0);
+    }
+  }
+
+  clang_SymbolIndex_dispose(index);
+  return 0;
+}
+
 int perform_token_annotation(int argc, const char **argv) {
   const char *input = argv[1];
   char *filename = 0;
@@ -4029,6 +4218,8 @@ static void print_usage(void) {
     "       c-index-test -index-file-full [-check-prefix=<FileCheck prefix>] <compiler arguments>\n"
     "       c-index-test -index-tu [-check-prefix=<FileCheck prefix>] <AST file>\n"
     "       c-index-test -index-compile-db [-check-prefix=<FileCheck prefix>] <compilation database>\n"
+    "       c-index-test -write-symbol-index <index file> <compiler arguments>\n"
+    "       c-index-test -find-symbol-occurrences <index file> {<USR> | -file=<filename>}*\n"
     "       c-index-test -test-file-scan <AST file> <source file> "
           "[FileCheck prefix]\n");
   fprintf(stderr,
@@ -4098,6 +4289,10 @@ int cindextest_main(int argc, const char **argv) {
     return index_tu(argc - 2, argv + 2);
   if (argc > 2 && strcmp(argv[1], "-index-compile-db") == 0)
     return index_compile_db(argc - 2, argv + 2);
+  if (argc > 2 && strcmp(argv[1], "-write-symbol-index") == 0)
+    return write_symbol_index(argc - 2, argv + 2);
+  if (argc > 2 && strcmp(argv[1], "-find-symbol-occurrences") == 0)
+    return find_symbol_occurrences(argc - 2, argv + 2);
   else if (argc >= 4 && strncmp(argv[1], "-test-load-tu", 13) == 0) {
     CXCursorVisitor I = GetVisitor(argv[1] + 13);
     if (I)
@@ -21,10 +21,19 @@
 #include "clang/Format/Format.h"
 #include "clang/Rewrite/Core/Rewriter.h"
 #include "llvm/ADT/StringMap.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/Signals.h"
+#include "llvm/Support/Timer.h"
+#include <algorithm>
+#if LLVM_ENABLE_THREADS
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
 
 using namespace llvm;
 
@@ -97,6 +106,23 @@ static cl::opt<unsigned>
                     "clang-format from an editor integration"),
            cl::init(0), cl::cat(ClangFormatCategory));
 
+static cl::opt<unsigned>
+    NumThreads("j", cl::desc("Format up to <N> files in parallel. The output\n"
+                             "is written in the order of the files."),
+               cl::value_desc("N"), cl::init(1),
+               cl::cat(ClangFormatCategory));
+static cl::opt<bool>
+    PrintTimes("print-times",
+               cl::desc("Print the time taken to format each file to\n"
+                        "stderr, slowest first."),
+               cl::cat(ClangFormatCategory));
+static cl::opt<bool>
+    PrintLineStats("print-line-stats",
+                   cl::desc("Print the number of states analyzed to find the\n"
+                            "line breaks of each line that needed it to\n"
+                            "stderr."),
+                   cl::cat(ClangFormatCategory));
+
 static cl::list<std::string> FileNames(cl::Positional, cl::desc("[<file> ...]"),
                                        cl::cat(ClangFormatCategory));
 
@@ -123,21 +149,22 @@ static bool parseLineRange(StringRef Input, unsigned &FromLine,
 
 static bool fillRanges(SourceManager &Sources, FileID ID,
                        const MemoryBuffer *Code,
-                       std::vector<CharSourceRange> &Ranges) {
+                       std::vector<CharSourceRange> &Ranges,
+                       raw_ostream &Errs) {
   if (!LineRanges.empty()) {
     if (!Offsets.empty() || !Lengths.empty()) {
-      llvm::errs() << "error: cannot use -lines with -offset/-length\n";
+      Errs << "error: cannot use -lines with -offset/-length\n";
       return true;
     }
 
     for (unsigned i = 0, e = LineRanges.size(); i < e; ++i) {
       unsigned FromLine, ToLine;
       if (parseLineRange(LineRanges[i], FromLine, ToLine)) {
-        llvm::errs() << "error: invalid <start line>:<end line> pair\n";
+        Errs << "error: invalid <start line>:<end line> pair\n";
         return true;
       }
       if (FromLine > ToLine) {
-        llvm::errs() << "error: start line should be less than end line\n";
+        Errs << "error: start line should be less than end line\n";
         return true;
       }
       SourceLocation Start = Sources.translateLineCol(ID, FromLine, 1);
@@ -149,28 +176,29 @@ static bool fillRanges(SourceManager &Sources, FileID ID,
     return false;
   }
 
-  if (Offsets.empty())
-    Offsets.push_back(0);
-  if (Offsets.size() != Lengths.size() &&
-      !(Offsets.size() == 1 && Lengths.empty())) {
-    llvm::errs()
-        << "error: number of -offset and -length arguments must match.\n";
+  // Copy the offsets rather than adding the default one to the option, which
+  // is shared by all the files being formatted with -j.
+  std::vector<unsigned> Starts(Offsets.begin(), Offsets.end());
+  if (Starts.empty())
+    Starts.push_back(0);
+  if (Starts.size() != Lengths.size() &&
+      !(Starts.size() == 1 && Lengths.empty())) {
+    Errs << "error: number of -offset and -length arguments must match.\n";
     return true;
   }
-  for (unsigned i = 0, e = Offsets.size(); i != e; ++i) {
-    if (Offsets[i] >= Code->getBufferSize()) {
-      llvm::errs() << "error: offset " << Offsets[i]
-                   << " is outside the file\n";
+  for (unsigned i = 0, e = Starts.size(); i != e; ++i) {
+    if (Starts[i] >= Code->getBufferSize()) {
+      Errs << "error: offset " << Starts[i] << " is outside the file\n";
       return true;
     }
     SourceLocation Start =
-        Sources.getLocForStartOfFile(ID).getLocWithOffset(Offsets[i]);
+        Sources.getLocForStartOfFile(ID).getLocWithOffset(Starts[i]);
     SourceLocation End;
     if (i < Lengths.size()) {
-      if (Offsets[i] + Lengths[i] > Code->getBufferSize()) {
-        llvm::errs() << "error: invalid length " << Lengths[i]
-                     << ", offset + length (" << Offsets[i] + Lengths[i]
-                     << ") is outside the file.\n";
+      if (Starts[i] + Lengths[i] > Code->getBufferSize()) {
+        Errs << "error: invalid length " << Lengths[i]
+             << ", offset + length (" << Starts[i] + Lengths[i]
+             << ") is outside the file.\n";
         return true;
       }
       End = Start.getLocWithOffset(Lengths[i]);
@@ -182,28 +210,28 @@ static bool fillRanges(SourceManager &Sources, FileID ID,
   return false;
 }
 
-static void outputReplacementXML(StringRef Text) {
+static void outputReplacementXML(StringRef Text, raw_ostream &OS) {
   size_t From = 0;
   size_t Index;
   while ((Index = Text.find_first_of("\n\r", From)) != StringRef::npos) {
-    llvm::outs() << Text.substr(From, Index - From);
+    OS << Text.substr(From, Index - From);
     switch (Text[Index]) {
     case '\n':
-      llvm::outs() << "&#10;";
+      OS << "&#10;";
       break;
     case '\r':
-      llvm::outs() << "&#13;";
+      OS << "&#13;";
       break;
     default:
       llvm_unreachable("Unexpected character encountered!");
     }
     From = Index + 1;
   }
-  llvm::outs() << Text.substr(From);
+  OS << Text.substr(From);
 }
 
-// Returns true on error.
-static bool format(StringRef FileName) {
+// Writes the result to OS and any errors to Errs. Returns true on error.
+static bool format(StringRef FileName, raw_ostream &OS, raw_ostream &Errs) {
   FileManager Files((FileSystemOptions()));
   DiagnosticsEngine Diagnostics(
       IntrusiveRefCntPtr<DiagnosticIDs>(new DiagnosticIDs),
@@ -212,7 +240,7 @@ static bool format(StringRef FileName) {
   ErrorOr<std::unique_ptr<MemoryBuffer>> CodeOrErr =
       MemoryBuffer::getFileOrSTDIN(FileName);
   if (std::error_code EC = CodeOrErr.getError()) {
-    llvm::errs() << EC.message() << "\n";
+    Errs << EC.message() << "\n";
     return true;
   }
   std::unique_ptr<llvm::MemoryBuffer> Code = std::move(CodeOrErr.get());
@@ -220,53 +248,162 @@ static bool format(StringRef FileName) {
     return false; // Empty files are formatted correctly.
   FileID ID = createInMemoryFile(FileName, Code.get(), Sources, Files);
   std::vector<CharSourceRange> Ranges;
-  if (fillRanges(Sources, ID, Code.get(), Ranges))
+  if (fillRanges(Sources, ID, Code.get(), Ranges, Errs))
     return true;
 
-  FormatStyle FormatStyle = getStyle(
-      Style, (FileName == "-") ? AssumeFilename : FileName, FallbackStyle);
+  FormatStyle FormatStyle =
+      getStyle(Style, (FileName == "-") ? AssumeFilename : FileName,
+               FallbackStyle, Errs);
   bool IncompleteFormat = false;
+  std::vector<LineBreakingStats> Stats;
   tooling::Replacements Replaces =
-      reformat(FormatStyle, Sources, ID, Ranges, &IncompleteFormat);
+      reformat(FormatStyle, Sources, ID, Ranges, &IncompleteFormat,
+               PrintLineStats ? &Stats : nullptr);
+  for (const LineBreakingStats &S : Stats) {
+    PresumedLoc PLoc = Sources.getPresumedLoc(S.Loc);
+    Errs << PLoc.getFilename() << ":" << PLoc.getLine() << ": " << S.States
+         << " states analyzed" << (S.Greedy ? ", completed greedily" : "")
+         << "\n";
+  }
   if (OutputXML) {
-    llvm::outs() << "<?xml version='1.0'?>\n<replacements "
-                    "xml:space='preserve' incomplete_format='"
-                 << (IncompleteFormat ? "true" : "false") << "'>\n";
+    OS << "<?xml version='1.0'?>\n<replacements "
+          "xml:space='preserve' incomplete_format='"
+       << (IncompleteFormat ? "true" : "false") << "'>\n";
     if (Cursor.getNumOccurrences() != 0)
-      llvm::outs() << "<cursor>"
-                   << tooling::shiftedCodePosition(Replaces, Cursor)
-                   << "</cursor>\n";
+      OS << "<cursor>" << tooling::shiftedCodePosition(Replaces, Cursor)
+         << "</cursor>\n";
 
     for (tooling::Replacements::const_iterator I = Replaces.begin(),
                                                E = Replaces.end();
          I != E; ++I) {
-      llvm::outs() << "<replacement "
-                   << "offset='" << I->getOffset() << "' "
-                   << "length='" << I->getLength() << "'>";
-      outputReplacementXML(I->getReplacementText());
-      llvm::outs() << "</replacement>\n";
+      OS << "<replacement "
+         << "offset='" << I->getOffset() << "' "
+         << "length='" << I->getLength() << "'>";
+      outputReplacementXML(I->getReplacementText(), OS);
+      OS << "</replacement>\n";
     }
-    llvm::outs() << "</replacements>\n";
+    OS << "</replacements>\n";
   } else {
     Rewriter Rewrite(Sources, LangOptions());
     tooling::applyAllReplacements(Replaces, Rewrite);
     if (Inplace) {
       if (FileName == "-")
-        llvm::errs() << "error: cannot use -i when reading from stdin.\n";
+        Errs << "error: cannot use -i when reading from stdin.\n";
       else if (Rewrite.overwriteChangedFiles())
         return true;
     } else {
       if (Cursor.getNumOccurrences() != 0)
-        outs() << "{ \"Cursor\": "
-               << tooling::shiftedCodePosition(Replaces, Cursor)
-               << ", \"IncompleteFormat\": "
-               << (IncompleteFormat ? "true" : "false") << " }\n";
-      Rewrite.getEditBuffer(ID).write(outs());
+        OS << "{ \"Cursor\": "
+           << tooling::shiftedCodePosition(Replaces, Cursor)
+           << ", \"IncompleteFormat\": "
+           << (IncompleteFormat ? "true" : "false") << " }\n";
+      Rewrite.getEditBuffer(ID).write(OS);
     }
   }
   return false;
 }
 
+static double getWallTime() {
+  return TimeRecord::getCurrentTime(/*Start=*/true).getWallTime();
+}
+
+// Formats each of FileNames, on up to -j threads, writing their output in the
+// order they are given and recording the time each one took in Seconds.
+// Returns true on error.
+static bool formatFiles(ArrayRef<std::string> FileNames,
+                        MutableArrayRef<double> Seconds) {
+  bool Error = false;
+#if LLVM_ENABLE_THREADS
+  unsigned NumWorkers = std::min<size_t>(NumThreads, FileNames.size());
+  if (NumWorkers > 1) {
+    // Each file gets its own buffers, which are written out as soon as the
+    // files before it are done.
+    struct Result {
+      std::string Output, Errors;
+      bool Error;
+      bool Done;
+    };
+    std::vector<Result> Results(FileNames.size());
+    std::mutex Lock;
+    std::condition_variable FileDone;
+    unsigned NextFile = 0;
+
+    auto Worker = [&] {
+      for (;;) {
+        unsigned I;
+        {
+          std::lock_guard<std::mutex> Guard(Lock);
+          if (NextFile == FileNames.size())
+            return;
+          I = NextFile++;
+        }
+        Result &R = Results[I];
+        double Start = getWallTime();
+        bool FileError;
+        {
+          raw_string_ostream OS(R.Output), Errs(R.Errors);
+          FileError = format(FileNames[I], OS, Errs);
+        }
+        Seconds[I] = getWallTime() - Start;
+
+        std::lock_guard<std::mutex> Guard(Lock);
+        R.Error = FileError;
+        R.Done = true;
+        FileDone.notify_all();
+      }
+    };
+
+    std::vector<std::thread> Threads;
+    for (unsigned I = 0; I != NumWorkers; ++I)
+      Threads.push_back(std::thread(Worker));
+    for (unsigned I = 0, E = FileNames.size(); I != E; ++I) {
+      Result &R = Results[I];
+      {
+        std::unique_lock<std::mutex> Guard(Lock);
+        FileDone.wait(Guard, [&] { return R.Done; });
+      }
+      outs() << R.Output;
+      errs() << R.Errors;
+      Error |= R.Error;
+      std::string().swap(R.Output);
+      std::string().swap(R.Errors);
+    }
+    for (std::thread &T : Threads)
+      T.join();
+    return Error;
+  }
+#endif
+
+  for (unsigned I = 0, E = FileNames.size(); I != E; ++I) {
+    double Start = getWallTime();
+    Error |= format(FileNames[I], outs(), errs());
+    Seconds[I] = getWallTime() - Start;
+  }
+  return Error;
+}
+
+// Prints the time taken by each file, slowest first, for -print-times.
+static void printTimes(ArrayRef<std::string> FileNames,
+                       ArrayRef<double> Seconds) {
+  std::vector<unsigned> Order(FileNames.size());
+  for (unsigned I = 0, E = Order.size(); I != E; ++I)
+    Order[I] = I;
+  std::stable_sort(Order.begin(), Order.end(), [&](unsigned A, unsigned B) {
+    return Seconds[A] > Seconds[B];
+  });
+
+  double Total = 0;
+  for (double S : Seconds)
+    Total += S;
+  errs() << "===-------------------------------------------------------===\n"
+         << "  Time per file (" << FileNames.size() << " files, "
+         << llvm::format("%.3f", Total) << " s)\n"
+         << "===-------------------------------------------------------===\n";
+  for (unsigned I : Order)
+    errs() << llvm::format("%10.3f ms  ", Seconds[I] * 1000)
+           << (FileNames[I] == "-" ? "<stdin>" : FileNames[I]) << '\n';
+}
+
 }  // namespace format
 }  // namespace clang
 
@@ -302,23 +439,23 @@ int main(int argc, const char **argv) {
     return 0;
   }
 
-  bool Error = false;
-  switch (FileNames.size()) {
-  case 0:
-    Error = clang::format::format("-");
-    break;
-  case 1:
-    Error = clang::format::format(FileNames[0]);
-    break;
-  default:
-    if (!Offsets.empty() || !Lengths.empty() || !LineRanges.empty()) {
-      llvm::errs() << "error: -offset, -length and -lines can only be used for "
-                      "single file.\n";
-      return 1;
-    }
-    for (unsigned i = 0; i < FileNames.size(); ++i)
-      Error |= clang::format::format(FileNames[i]);
-    break;
+  if (FileNames.size() > 1 &&
+      (!Offsets.empty() || !Lengths.empty() || !LineRanges.empty())) {
+    llvm::errs() << "error: -offset, -length and -lines can only be used for "
+                    "single file.\n";
+    return 1;
+  }
+  if (NumThreads == 0) {
+    llvm::errs() << "error: -j must be at least 1.\n";
+    return 1;
   }
+
+  std::vector<std::string> Inputs(FileNames.begin(), FileNames.end());
+  if (Inputs.empty())
+    Inputs.push_back("-");
+  std::vector<double> Seconds(Inputs.size());
+  bool Error = clang::format::formatFiles(Inputs, Seconds);
+  if (PrintTimes)
+    clang::format::printTimes(Inputs, Seconds);
   return Error ? 1 : 0;
 }
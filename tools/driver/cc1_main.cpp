@@ -14,6 +14,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Option/Arg.h"
+#include "clang/Basic/TimeTrace.h"
 #include "clang/CodeGen/ObjectFilePCHContainerOperations.h"
 #include "clang/Driver/DriverDiagnostic.h"
 #include "clang/Driver/Options.h"
@@ -29,7 +30,9 @@
 #include "llvm/Option/ArgList.h"
 #include "llvm/Option/OptTable.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/Path.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/Support/Timer.h"
@@ -58,6 +61,29 @@ static void LLVMErrorHandler(void *UserData, const std::string &Message,
   exit(GenCrashDiag ? 70 : 1);
 }
 
+/// \brief Write the time trace recorded for -ftime-trace next to the output
+/// file, with its extension replaced by ".json". When there is no output
+/// file, write it to the current directory, named after the input file.
+static void writeTimeTrace(CompilerInstance &Clang) {
+  const FrontendOptions &Opts = Clang.getFrontendOpts();
+  SmallString<128> Path(Opts.OutputFile);
+  if (Path.empty() || Path == "-") {
+    if (Opts.Inputs.empty())
+      return;
+    Path = llvm::sys::path::filename(Opts.Inputs[0].getFile());
+  }
+  llvm::sys::path::replace_extension(Path, "json");
+
+  std::error_code EC;
+  llvm::raw_fd_ostream OS(Path, EC, llvm::sys::fs::F_Text);
+  if (EC) {
+    Clang.getDiagnostics().Report(diag::err_fe_unable_to_open_output)
+        << Path.str() << EC.message();
+    return;
+  }
+  timeTraceProfilerWrite(OS);
+}
+
 #ifdef LINK_POLLY_INTO_TOOLS
 namespace polly {
 void initializePollyPasses(llvm::PassRegistry &Registry);
@@ -108,8 +134,19 @@ int cc1_main(ArrayRef<const char *> Argv, const char *Argv0, void *MainAddr) {
   if (!Success)
     return 1;
 
+  if (Clang->getFrontendOpts().TimeTrace)
+    timeTraceProfilerInitialize(Clang->getFrontendOpts().TimeTraceGranularity);
+
   // Execute the frontend actions.
-  Success = ExecuteCompilerInvocation(Clang.get());
+  {
+    TimeTraceScope TimeScope("ExecuteCompiler");
+    Success = ExecuteCompilerInvocation(Clang.get());
+  }
+
+  if (timeTraceProfilerEnabled()) {
+    writeTimeTrace(*Clang);
+    timeTraceProfilerCleanup();
+  }
 
   // If any timers were active but haven't been destroyed yet, print their
   // results now.  This happens in -disable-free mode.
@@ -27,12 +27,14 @@
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/DiagnosticCategories.h"
 #include "clang/Basic/DiagnosticIDs.h"
+#include "clang/Basic/FileSystemStatCache.h"
 #include "clang/Basic/TargetInfo.h"
 #include "clang/Basic/Version.h"
 #include "clang/CodeGen/ObjectFilePCHContainerOperations.h"
 #include "clang/Frontend/ASTUnit.h"
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/Frontend/FrontendDiagnostic.h"
+#include "clang/Frontend/PreambleCache.h"
 #include "clang/Index/CommentToXML.h"
 #include "clang/Lex/HeaderSearch.h"
 #include "clang/Lex/Lexer.h"
@@ -2891,6 +2893,22 @@ CXIndex clang_createIndex(int excludeDeclarationsFromPCH,
   if (displayDiagnostics)
     CIdxr->setDisplayDiagnostics();
 
+  // Share stat results between all the translation units of this process.
+  if (getenv("LIBCLANG_SHARED_STAT_CACHE") &&
+      !SharedFileSystemStatCache::getDefault())
+    SharedFileSystemStatCache::setDefault(new SharedFileSystemStatCache());
+
+  // Share precompiled preambles with other processes through an on-disk
+  // cache. The size limit is given in megabytes.
+  if (const char *Dir = getenv("LIBCLANG_PREAMBLE_CACHE")) {
+    if (!PreambleCache::getDefault()) {
+      uint64_t MaxSizeMB = 1024;
+      if (const char *Size = getenv("LIBCLANG_PREAMBLE_CACHE_SIZE"))
+        StringRef(Size).getAsInteger(10, MaxSizeMB);
+      PreambleCache::setDefault(new PreambleCache(Dir, MaxSizeMB << 20));
+    }
+  }
+
   if (getenv("LIBCLANG_BGPRIO_INDEX"))
     CIdxr->setCXGlobalOptFlags(CIdxr->getCXGlobalOptFlags() |
                                CXGlobalOpt_ThreadBackgroundPriorityForIndexing);
@@ -2982,6 +3000,15 @@ clang_createTranslationUnitFromSourceFile(CXIndex CIdx,
                                     Options);
 }
 
+/// \brief Have the process-wide stat cache, if any, check each cached file
+/// again the next time it is looked up, so that a parse sees the files as
+/// they are now without re-stat'ing the files no parse uses.
+static void revalidateSharedStatCache() {
+  if (IntrusiveRefCntPtr<SharedFileSystemStatCache> Cache =
+          SharedFileSystemStatCache::getDefault())
+    Cache->revalidate();
+}
+
 struct ParseTranslationUnitInfo {
   CXIndex CIdx;
   const char *source_filename;
@@ -3017,6 +3044,8 @@ static void clang_parseTranslationUnit_Impl(void *UserData) {
   if (CXXIdx->isOptEnabled(CXGlobalOpt_ThreadBackgroundPriorityForIndexing))
     setThreadBackgroundPriority();
 
+  revalidateSharedStatCache();
+
   bool PrecompilePreamble = options & CXTranslationUnit_PrecompiledPreamble;
   // FIXME: Add a flag for modules.
   TranslationUnitKind TUKind
@@ -3027,6 +3056,9 @@ static void clang_parseTranslationUnit_Impl(void *UserData) {
     = options & CXTranslationUnit_IncludeBriefCommentsInCodeCompletion;
   bool SkipFunctionBodies = options & CXTranslationUnit_SkipFunctionBodies;
   bool ForSerialization = options & CXTranslationUnit_ForSerialization;
+  bool BuildPreambleInBackground =
+      options & CXTranslationUnit_BuildPreambleInBackground;
+  bool ChainPreambles = options & CXTranslationUnit_ChainedPreamble;
 
   // Configure the diagnostics.
   IntrusiveRefCntPtr<DiagnosticsEngine>
@@ -3117,6 +3149,10 @@ static void clang_parseTranslationUnit_Impl(void *UserData) {
   if (isASTReadError(Unit ? Unit.get() : ErrUnit.get())) {
     PTUI->result = CXError_ASTReadError;
   } else {
+    if (Unit) {
+      Unit->setBuildPreambleInBackground(BuildPreambleInBackground);
+      Unit->setChainPreambles(ChainPreambles);
+    }
     *PTUI->out_TU = MakeCXTranslationUnit(CXXIdx, Unit.release());
     PTUI->result = *PTUI->out_TU ? CXError_Success : CXError_Failure;
   }
@@ -3308,7 +3344,6 @@ static void clang_reparseTranslationUnit_Impl(void *UserData) {
       static_cast<ReparseTranslationUnitInfo *>(UserData);
   CXTranslationUnit TU = RTUI->TU;
   unsigned options = RTUI->options;
-  (void) options;
 
   // Check arguments.
   if (isNotUsableTU(TU)) {
@@ -3325,6 +3360,8 @@ static void clang_reparseTranslationUnit_Impl(void *UserData) {
   if (CXXIdx->isOptEnabled(CXGlobalOpt_ThreadBackgroundPriorityForEditing))
     setThreadBackgroundPriority();
 
+  revalidateSharedStatCache();
+
   ASTUnit *CXXUnit = cxtu::getASTUnit(TU);
   ASTUnit::ConcurrencyCheck Check(*CXXUnit);
 
@@ -3341,6 +3378,9 @@ static void clang_reparseTranslationUnit_Impl(void *UserData) {
     RemappedFiles->push_back(std::make_pair(UF.Filename, MB.release()));
   }
 
+  if (options & CXReparse_WaitForBackgroundPreamble)
+    CXXUnit->waitForBackgroundPreamble();
+
   if (!CXXUnit->Reparse(CXXIdx->getPCHContainerOperations(),
                         *RemappedFiles.get()))
     RTUI->result = CXError_Success;
@@ -0,0 +1,136 @@
+//===- CXSymbolIndex.cpp - On-disk index of symbol occurrences ------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the libclang interface to the symbol index.
+//
+//===----------------------------------------------------------------------===//
+
+#include "CLog.h"
+#include "clang-c/Index.h"
+#include "clang/Index/SymbolIndex.h"
+#include "llvm/Support/CBindingWrapping.h"
+
+using namespace clang;
+using namespace clang::index;
+
+DEFINE_SIMPLE_CONVERSION_FUNCTIONS(SymbolIndexBuilder, CXSymbolIndexBuilder)
+DEFINE_SIMPLE_CONVERSION_FUNCTIONS(SymbolIndex, CXSymbolIndex)
+
+CXSymbolIndexBuilder clang_SymbolIndexBuilder_create(unsigned) {
+  return wrap(new SymbolIndexBuilder());
+}
+
+enum CXErrorCode
+clang_SymbolIndexBuilder_beginFile(CXSymbolIndexBuilder Builder,
+                                   const char *filename) {
+  if (!Builder || !filename || !*filename)
+    return CXError_InvalidArguments;
+  unwrap(Builder)->beginFile(filename);
+  return CXError_Success;
+}
+
+enum CXErrorCode
+clang_SymbolIndexBuilder_addOccurrence(CXSymbolIndexBuilder Builder,
+                                       const char *usr, const char *filename,
+                                       unsigned line, unsigned column,
+                                       unsigned roles) {
+  if (!Builder || !usr || !*usr || !filename || !*filename)
+    return CXError_InvalidArguments;
+  unwrap(Builder)->addOccurrence(usr, filename, line, column, roles);
+  return CXError_Success;
+}
+
+enum CXErrorCode clang_SymbolIndexBuilder_write(CXSymbolIndexBuilder Builder,
+                                                const char *path) {
+  if (!Builder || !path)
+    return CXError_InvalidArguments;
+  std::string Error;
+  if (!unwrap(Builder)->write(path, Error)) {
+    LOG_FUNC_SECTION {
+      *Log << Error;
+    }
+    return CXError_Failure;
+  }
+  return CXError_Success;
+}
+
+void clang_SymbolIndexBuilder_dispose(CXSymbolIndexBuilder Builder) {
+  delete unwrap(Builder);
+}
+
+CXSymbolIndex clang_SymbolIndex_load(const char *path) {
+  if (!path)
+    return nullptr;
+  std::string Error;
+  std::unique_ptr<SymbolIndex> Index = SymbolIndex::load(path, Error);
+  if (!Index) {
+    LOG_FUNC_SECTION {
+      *Log << Error;
+    }
+    return nullptr;
+  }
+  return wrap(Index.release());
+}
+
+unsigned clang_SymbolIndex_getNumFiles(CXSymbolIndex Index) {
+  return Index ? unwrap(Index)->getNumFiles() : 0;
+}
+
+unsigned clang_SymbolIndex_getNumSymbols(CXSymbolIndex Index) {
+  return Index ? unwrap(Index)->getNumSymbols() : 0;
+}
+
+unsigned clang_SymbolIndex_getNumOccurrences(CXSymbolIndex Index) {
+  return Index ? unwrap(Index)->getNumOccurrences() : 0;
+}
+
+namespace {
+/// \brief Passes each occurrence found to a CXSymbolOccurrenceVisitor.
+class OccurrenceVisitor {
+  CXSymbolOccurrenceVisitor Visitor;
+  void *Context;
+
+public:
+  OccurrenceVisitor(CXSymbolOccurrenceVisitor Visitor, void *Context)
+    : Visitor(Visitor), Context(Context) {}
+
+  bool operator()(const SymbolOccurrence &Occurrence) const {
+    // The strings in the index are null-terminated.
+    CXSymbolOccurrence Info = { Occurrence.USR.data(),
+                                Occurrence.FilePath.data(), Occurrence.Line,
+                                Occurrence.Column, Occurrence.Roles };
+    return Visitor(Context, &Info) != CXVisit_Break;
+  }
+};
+}
+
+unsigned clang_SymbolIndex_findOccurrences(CXSymbolIndex Index,
+                                           const char *usr,
+                                           CXSymbolOccurrenceVisitor visitor,
+                                           void *context) {
+  if (!Index || !usr || !visitor)
+    return 0;
+  return !unwrap(Index)->forEachOccurrence(
+      usr, OccurrenceVisitor(visitor, context));
+}
+
+unsigned
+clang_SymbolIndex_findOccurrencesInFile(CXSymbolIndex Index,
+                                        const char *filename,
+                                        CXSymbolOccurrenceVisitor visitor,
+                                        void *context) {
+  if (!Index || !filename || !visitor)
+    return 0;
+  return !unwrap(Index)->forEachOccurrenceInFile(
+      filename, OccurrenceVisitor(visitor, context));
+}
+
+void clang_SymbolIndex_dispose(CXSymbolIndex Index) {
+  delete unwrap(Index);
+}
@@ -340,6 +340,12 @@ void IndexingContext::indexTopLevelDecl(const Decl *D) {
   if (isa<ObjCMethodDecl>(D))
     return; // Wait for the objc container.
 
+  // Headers are often included inside a namespace or linkage specification,
+  // so look inside those for the declarations of files still to be indexed.
+  if (!isa<NamespaceDecl>(D) && !isa<LinkageSpecDecl>(D) &&
+      isInAlreadyIndexedFile(D->getLocation()))
+    return;
+
   indexDecl(D);
 }
 
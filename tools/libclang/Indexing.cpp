@@ -17,21 +17,28 @@
 #include "CXTranslationUnit.h"
 #include "clang/AST/ASTConsumer.h"
 #include "clang/AST/DeclVisitor.h"
+#include "clang/Basic/Version.h"
 #include "clang/Frontend/ASTUnit.h"
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/Frontend/CompilerInvocation.h"
 #include "clang/Frontend/FrontendAction.h"
 #include "clang/Frontend/Utils.h"
 #include "clang/Lex/HeaderSearch.h"
+#include "clang/Lex/HeaderSearchOptions.h"
 #include "clang/Lex/PPCallbacks.h"
 #include "clang/Lex/PPConditionalDirectiveRecord.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Sema/SemaConsumer.h"
+#include "llvm/ADT/StringSet.h"
 #include "llvm/Support/CrashRecoveryContext.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Mutex.h"
 #include "llvm/Support/MutexGuard.h"
+#include "llvm/Support/raw_ostream.h"
 #include <cstdio>
+#include <map>
 
 using namespace clang;
 using namespace cxtu;
@@ -240,6 +247,361 @@ private:
 
 #endif
 
+//===----------------------------------------------------------------------===//
+// Skip Indexed Headers
+//===----------------------------------------------------------------------===//
+
+/// \brief The headers indexed during an indexing session, each identified by
+/// a key naming the file, its size and modification time, and the context it
+/// was indexed in, along with the definitions of the macros it used each time
+/// it was indexed; optionally shared with other sessions through a file.
+class SessionIndexedHeaders {
+  llvm::sys::Mutex Mux;
+  std::string Path;
+  llvm::StringMap<llvm::StringSet<> > Headers;
+  bool HasNewHeaders;
+  unsigned NumSkipped;
+
+  static void read(StringRef Path,
+                   llvm::StringMap<llvm::StringSet<> > &Headers);
+
+public:
+  SessionIndexedHeaders()
+    : Mux(/*recursive=*/false), HasNewHeaders(false), NumSkipped(0) {}
+
+  void setPath(StringRef path) {
+    llvm::MutexGuard MG(Mux);
+    Path = path;
+    read(Path, Headers);
+  }
+
+  /// \brief Whether the header with the given key was indexed with macros
+  /// for which \p MacrosMatch returns true.
+  bool isIndexed(StringRef Key,
+                 llvm::function_ref<bool(StringRef Macros)> MacrosMatch) {
+    llvm::MutexGuard MG(Mux);
+    llvm::StringMap<llvm::StringSet<> >::iterator I = Headers.find(Key);
+    if (I == Headers.end())
+      return false;
+    for (llvm::StringSet<>::iterator M = I->second.begin(),
+                                     E = I->second.end();
+         M != E; ++M) {
+      if (MacrosMatch(M->getKey())) {
+        ++NumSkipped;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  unsigned getNumSkipped() {
+    llvm::MutexGuard MG(Mux);
+    return NumSkipped;
+  }
+
+  /// \brief Record headers as indexed, each given by its key and the
+  /// macros it used.
+  void update(ArrayRef<std::pair<std::string, std::string> > Indexed);
+};
+
+/// \brief The first line of every file of indexed headers, naming its
+/// format.
+static const char IndexedHeadersSignature[] = "clang-indexed-headers 2";
+
+/// \brief The macros field of a header that used no macros.
+static const char NoMacrosUsed[] = "-";
+
+void SessionIndexedHeaders::read(
+    StringRef Path, llvm::StringMap<llvm::StringSet<> > &Headers) {
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer =
+      llvm::MemoryBuffer::getFile(Path, -1, /*RequiresNullTerminator=*/false);
+  if (!Buffer)
+    return;
+
+  StringRef Line, Rest = (*Buffer)->getBuffer();
+  std::tie(Line, Rest) = Rest.split('\n');
+  if (Line != IndexedHeadersSignature)
+    return;
+
+  // Each line holds the size, the modification time, the context, the
+  // macros and the path. A line cut short by a failed write only loses its
+  // own header, since it ends with the path of the file.
+  while (!Rest.empty()) {
+    std::tie(Line, Rest) = Rest.split('\n');
+    size_t MacrosBegin = 0;
+    for (unsigned Field = 0; Field != 3 && MacrosBegin != StringRef::npos;
+         ++Field) {
+      MacrosBegin = Line.find(' ', MacrosBegin);
+      if (MacrosBegin != StringRef::npos)
+        ++MacrosBegin;
+    }
+    if (MacrosBegin == StringRef::npos)
+      continue;
+    size_t MacrosEnd = Line.find(' ', MacrosBegin);
+    if (MacrosEnd == StringRef::npos)
+      continue;
+    std::string Key = Line.substr(0, MacrosBegin);
+    Key += Line.substr(MacrosEnd + 1);
+    Headers[Key].insert(Line.slice(MacrosBegin, MacrosEnd));
+  }
+}
+
+void SessionIndexedHeaders::update(
+    ArrayRef<std::pair<std::string, std::string> > Indexed) {
+  llvm::MutexGuard MG(Mux);
+  for (const auto &KeyAndMacros : Indexed)
+    if (Headers[KeyAndMacros.first].insert(KeyAndMacros.second).second)
+      HasNewHeaders = true;
+  if (Path.empty() || !HasNewHeaders)
+    return;
+
+  // Merge with what is in the file now, which picks up the headers other
+  // processes have indexed since we read it, and replace the file atomically,
+  // so that readers never see a partial file. If that fails, try again after
+  // the next translation unit.
+  read(Path, Headers);
+  if (writeFileAtomically(Path, [&](raw_ostream &OS) {
+        OS << IndexedHeadersSignature << '\n';
+        for (llvm::StringMap<llvm::StringSet<> >::iterator
+                 I = Headers.begin(), E = Headers.end();
+             I != E; ++I) {
+          // The key is "size mtime context path"; the macros go before the
+          // path.
+          StringRef Key = I->getKey();
+          size_t PathBegin = 0;
+          for (unsigned Field = 0; Field != 3; ++Field)
+            PathBegin = Key.find(' ', PathBegin) + 1;
+          for (llvm::StringSet<>::iterator M = I->second.begin(),
+                                           ME = I->second.end();
+               M != ME; ++M)
+            OS << Key.substr(0, PathBegin) << M->getKey() << ' '
+               << Key.substr(PathBegin) << '\n';
+        }
+      }))
+    return;
+  HasNewHeaders = false;
+}
+
+/// \brief Returns a string identifying the definition of a macro, or its
+/// absence if \p MI is null.
+static std::string getMacroSignature(Preprocessor &PP, const MacroInfo *MI) {
+  if (!MI)
+    return "u";
+
+  llvm::MD5 Hash;
+  if (MI->isFunctionLike()) {
+    Hash.update("(");
+    for (const IdentifierInfo *Arg : MI->args()) {
+      Hash.update(Arg->getName());
+      Hash.update(",");
+    }
+    Hash.update(MI->isVariadic() ? "...)" : ")");
+  }
+  for (const Token &Tok : MI->tokens()) {
+    Hash.update(Tok.hasLeadingSpace() ? " " : "");
+    Hash.update(PP.getSpelling(Tok));
+    Hash.update(StringRef("", 1));
+  }
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+  SmallString<32> Signature;
+  llvm::MD5::stringifyResult(Result, Signature);
+  return Signature.str();
+}
+
+class TUIndexedHeadersControl {
+  SessionIndexedHeaders &SessionData;
+  Preprocessor &PP;
+
+  /// \brief A hash of everything besides its own contents and the macros it
+  /// uses that can change what is reported for a header.
+  SmallString<32> Context;
+
+  /// \brief The headers included so far, and whether each was already
+  /// indexed.
+  llvm::DenseMap<const FileEntry *, bool> Included;
+
+  /// \brief The headers entered, and so indexed, in this translation unit.
+  llvm::DenseSet<const FileEntry *> Entered;
+
+  /// \brief The macros used by a file being entered.
+  struct EnteredFile {
+    const FileEntry *FE;
+    /// \brief The definition each macro had when the file first tested or
+    /// expanded it, sorted by name.
+    std::map<std::string, std::string> MacrosUsed;
+    /// \brief The macros defined or undefined since the file was entered.
+    llvm::StringSet<> MacrosChanged;
+
+    explicit EnteredFile(const FileEntry *FE) : FE(FE) {}
+  };
+
+  /// \brief The files being entered, innermost last.
+  std::vector<EnteredFile> EnteredStack;
+
+  /// \brief The macros used by the headers left so far, in the form
+  /// recorded with their keys.
+  llvm::DenseMap<const FileEntry *, std::string> MacrosUsed;
+
+public:
+  TUIndexedHeadersControl(SessionIndexedHeaders &sessionData,
+                          Preprocessor &pp, unsigned indexOptions)
+    : SessionData(sessionData), PP(pp) {
+    llvm::MD5 Hash;
+    Hash.update(getClangFullRepositoryVersion());
+    Hash.update(StringRef(reinterpret_cast<const char *>(&indexOptions),
+                          sizeof(indexOptions)));
+    Hash.update(PP.getPredefines());
+    const HeaderSearchOptions &HSOpts =
+        PP.getHeaderSearchInfo().getHeaderSearchOpts();
+    Hash.update(HSOpts.Sysroot);
+    for (const HeaderSearchOptions::Entry &E : HSOpts.UserEntries) {
+      Hash.update(StringRef(reinterpret_cast<const char *>(&E.Group),
+                            sizeof(E.Group)));
+      Hash.update(E.Path);
+      Hash.update(StringRef("", 1));
+    }
+    llvm::MD5::MD5Result Result;
+    Hash.final(Result);
+    llvm::MD5::stringifyResult(Result, Context);
+  }
+
+  /// \brief Whether \p FE, about to be included, was already indexed with
+  /// the macros it uses defined as they are now.
+  bool isAlreadyIndexed(const FileEntry *FE) {
+    if (!FE)
+      return false;
+    std::pair<llvm::DenseMap<const FileEntry *, bool>::iterator, bool> Res =
+        Included.insert(std::make_pair(FE, false));
+    if (!Res.second)
+      return Res.first->second;
+
+    std::string Key;
+    if (getKey(FE, Key) &&
+        SessionData.isIndexed(Key, [this](StringRef Macros) {
+          return macrosMatch(Macros);
+        }))
+      Res.first->second = true;
+    return Res.first->second;
+  }
+
+  void enteredFile(const FileEntry *FE) {
+    if (FE)
+      Entered.insert(FE);
+    EnteredStack.push_back(EnteredFile(FE));
+  }
+
+  void exitedFile() {
+    if (EnteredStack.empty())
+      return;
+    EnteredFile &File = EnteredStack.back();
+    if (File.FE && !MacrosUsed.count(File.FE)) {
+      std::string &Macros = MacrosUsed[File.FE];
+      for (const auto &NameAndSignature : File.MacrosUsed) {
+        if (!Macros.empty())
+          Macros += ',';
+        Macros += NameAndSignature.first;
+        Macros += ':';
+        Macros += NameAndSignature.second;
+      }
+      if (Macros.empty())
+        Macros = NoMacrosUsed;
+    }
+    EnteredStack.pop_back();
+  }
+
+  /// \brief Called when the file being entered tests or expands a macro.
+  void macroUsed(const IdentifierInfo *II, const MacroInfo *MI) {
+    if (EnteredStack.empty() || !EnteredStack.back().FE)
+      return;
+    // What a macro the file defined itself stands for does not depend on
+    // where the file is included.
+    EnteredFile &File = EnteredStack.back();
+    if (File.MacrosChanged.count(II->getName()))
+      return;
+    File.MacrosUsed.insert(
+        std::make_pair(II->getName(), getMacroSignature(PP, MI)));
+  }
+
+  /// \brief Called for each identifier in an \#if or \#elif condition, which
+  /// may test a macro that is not defined.
+  void identifierTested(StringRef Name) {
+    IdentifierInfo *II = PP.getIdentifierInfo(Name);
+    macroUsed(II, PP.getMacroDefinition(II).getMacroInfo());
+  }
+
+  void macroChanged(const IdentifierInfo *II) {
+    for (EnteredFile &File : EnteredStack)
+      File.MacrosChanged.insert(II->getName());
+  }
+
+  void finished() {
+    // A header's declarations may be missing after an error, so don't let
+    // them stand for the header in other translation units.
+    if (PP.getDiagnostics().hasErrorOccurred())
+      return;
+
+    HeaderSearch &HS = PP.getHeaderSearchInfo();
+    std::vector<std::pair<std::string, std::string> > Indexed;
+    for (const FileEntry *FE : Entered) {
+      llvm::DenseMap<const FileEntry *, bool>::iterator I = Included.find(FE);
+      if (I == Included.end() || I->second)
+        continue;
+      // A header without a guard can mean something different each time it
+      // is included, even within one translation unit.
+      if (!HS.isFileMultipleIncludeGuarded(FE))
+        continue;
+      llvm::DenseMap<const FileEntry *, std::string>::iterator M =
+          MacrosUsed.find(FE);
+      if (M == MacrosUsed.end())
+        continue;
+      std::string Key;
+      if (getKey(FE, Key))
+        Indexed.push_back(std::make_pair(std::move(Key), M->second));
+    }
+    SessionData.update(Indexed);
+  }
+
+private:
+  /// \brief Whether the macros recorded for a header are defined as they
+  /// were when it was indexed.
+  bool macrosMatch(StringRef Macros) {
+    if (Macros == NoMacrosUsed)
+      return true;
+    SmallVector<StringRef, 8> Uses;
+    Macros.split(Uses, ",");
+    for (StringRef Use : Uses) {
+      StringRef Name, Signature;
+      std::tie(Name, Signature) = Use.split(':');
+      IdentifierInfo *II = PP.getIdentifierInfo(Name);
+      if (getMacroSignature(PP, PP.getMacroDefinition(II).getMacroInfo()) !=
+          Signature)
+        return false;
+    }
+    return true;
+  }
+
+  bool getKey(const FileEntry *FE, std::string &Key) {
+    // The contents of a remapped file are not those on disk.
+    SourceManager &SM = PP.getSourceManager();
+    if (SM.isFileOverridden(FE))
+      return false;
+
+    SmallString<256> FilePath(FE->getName());
+    SM.getFileManager().FixupRelativePath(FilePath);
+    if (llvm::sys::fs::make_absolute(FilePath) ||
+        FilePath.find('\n') != StringRef::npos)
+      return false;
+
+    llvm::raw_string_ostream OS(Key);
+    OS << FE->getSize() << ' '
+       << static_cast<long long>(FE->getModificationTime()) << ' ' << Context
+       << ' ' << FilePath;
+    OS.flush();
+    return true;
+  }
+};
+
 //===----------------------------------------------------------------------===//
 // IndexPPCallbacks
 //===----------------------------------------------------------------------===//
@@ -247,18 +609,25 @@ private:
 class IndexPPCallbacks : public PPCallbacks {
   Preprocessor &PP;
   IndexingContext &IndexCtx;
+  TUIndexedHeadersControl *IHCtrl;
   bool IsMainFileEntered;
 
 public:
-  IndexPPCallbacks(Preprocessor &PP, IndexingContext &indexCtx)
-    : PP(PP), IndexCtx(indexCtx), IsMainFileEntered(false) { }
+  IndexPPCallbacks(Preprocessor &PP, IndexingContext &indexCtx,
+                   TUIndexedHeadersControl *ihCtrl)
+    : PP(PP), IndexCtx(indexCtx), IHCtrl(ihCtrl), IsMainFileEntered(false) { }
 
   void FileChanged(SourceLocation Loc, FileChangeReason Reason,
                  SrcMgr::CharacteristicKind FileType, FileID PrevFID) override {
-    if (IsMainFileEntered)
+    SourceManager &SM = PP.getSourceManager();
+    if (IsMainFileEntered) {
+      if (IHCtrl && Reason == PPCallbacks::EnterFile)
+        IHCtrl->enteredFile(SM.getFileEntryForID(SM.getFileID(Loc)));
+      else if (IHCtrl && Reason == PPCallbacks::ExitFile)
+        IHCtrl->exitedFile();
       return;
+    }
 
-    SourceManager &SM = PP.getSourceManager();
     SourceLocation MainFileLoc = SM.getLocForStartOfFile(SM.getMainFileID());
 
     if (Loc == MainFileLoc && Reason == PPCallbacks::EnterFile) {
@@ -274,26 +643,87 @@ public:
                           const Module *Imported) override {
     bool isImport = (IncludeTok.is(tok::identifier) &&
             IncludeTok.getIdentifierInfo()->getPPKeywordID() == tok::pp_import);
+    bool isAlreadyIndexed = IHCtrl && IHCtrl->isAlreadyIndexed(File);
     IndexCtx.ppIncludedFile(HashLoc, FileName, File, isImport, IsAngled,
-                            Imported);
+                            Imported, isAlreadyIndexed);
   }
 
   /// MacroDefined - This hook is called whenever a macro definition is seen.
-  void MacroDefined(const Token &Id, const MacroDirective *MD) override {}
+  void MacroDefined(const Token &Id, const MacroDirective *MD) override {
+    if (IHCtrl)
+      IHCtrl->macroChanged(Id.getIdentifierInfo());
+  }
 
   /// MacroUndefined - This hook is called whenever a macro #undef is seen.
   /// MI is released immediately following this callback.
   void MacroUndefined(const Token &MacroNameTok,
-                      const MacroDefinition &MD) override {}
+                      const MacroDefinition &MD) override {
+    if (IHCtrl)
+      IHCtrl->macroChanged(MacroNameTok.getIdentifierInfo());
+  }
 
   /// MacroExpands - This is called by when a macro invocation is found.
   void MacroExpands(const Token &MacroNameTok, const MacroDefinition &MD,
-                    SourceRange Range, const MacroArgs *Args) override {}
+                    SourceRange Range, const MacroArgs *Args) override {
+    if (IHCtrl)
+      IHCtrl->macroUsed(MacroNameTok.getIdentifierInfo(), MD.getMacroInfo());
+  }
+
+  void Defined(const Token &MacroNameTok, const MacroDefinition &MD,
+               SourceRange Range) override {
+    if (IHCtrl)
+      IHCtrl->macroUsed(MacroNameTok.getIdentifierInfo(), MD.getMacroInfo());
+  }
+
+  void Ifdef(SourceLocation Loc, const Token &MacroNameTok,
+             const MacroDefinition &MD) override {
+    if (IHCtrl)
+      IHCtrl->macroUsed(MacroNameTok.getIdentifierInfo(), MD.getMacroInfo());
+  }
+
+  void Ifndef(SourceLocation Loc, const Token &MacroNameTok,
+              const MacroDefinition &MD) override {
+    if (IHCtrl)
+      IHCtrl->macroUsed(MacroNameTok.getIdentifierInfo(), MD.getMacroInfo());
+  }
+
+  void If(SourceLocation Loc, SourceRange ConditionRange,
+          ConditionValueKind ConditionValue) override {
+    if (IHCtrl)
+      conditionTested(ConditionRange);
+  }
+
+  void Elif(SourceLocation Loc, SourceRange ConditionRange,
+            ConditionValueKind ConditionValue, SourceLocation IfLoc) override {
+    if (IHCtrl)
+      conditionTested(ConditionRange);
+  }
 
   /// SourceRangeSkipped - This hook is called when a source range is skipped.
   /// \param Range The SourceRange that was skipped. The range begins at the
   /// #if/#else directive and ends after the #endif/#else directive.
   void SourceRangeSkipped(SourceRange Range) override {}
+
+private:
+  /// \brief Report the identifiers of a condition, so that those which are
+  /// not macros are recorded as undefined macros.
+  void conditionTested(SourceRange ConditionRange) {
+    SourceManager &SM = PP.getSourceManager();
+    bool Invalid = false;
+    StringRef Condition = Lexer::getSourceText(
+        CharSourceRange::getCharRange(ConditionRange), SM, PP.getLangOpts(),
+        &Invalid);
+    if (Invalid)
+      return;
+    Lexer TheLexer(SourceLocation(), PP.getLangOpts(), Condition.begin(),
+                   Condition.begin(), Condition.end());
+    Token Tok;
+    do {
+      TheLexer.LexFromRawLexer(Tok);
+      if (Tok.is(tok::raw_identifier))
+        IHCtrl->identifierTested(Tok.getRawIdentifier());
+    } while (Tok.isNot(tok::eof));
+  }
 };
 
 //===----------------------------------------------------------------------===//
@@ -303,10 +733,12 @@ public:
 class IndexingConsumer : public ASTConsumer {
   IndexingContext &IndexCtx;
   TUSkipBodyControl *SKCtrl;
+  TUIndexedHeadersControl *IHCtrl;
 
 public:
-  IndexingConsumer(IndexingContext &indexCtx, TUSkipBodyControl *skCtrl)
-    : IndexCtx(indexCtx), SKCtrl(skCtrl) { }
+  IndexingConsumer(IndexingContext &indexCtx, TUSkipBodyControl *skCtrl,
+                   TUIndexedHeadersControl *ihCtrl)
+    : IndexCtx(indexCtx), SKCtrl(skCtrl), IHCtrl(ihCtrl) { }
 
   // ASTConsumer Implementation
 
@@ -318,6 +750,8 @@ public:
   void HandleTranslationUnit(ASTContext &Ctx) override {
     if (SKCtrl)
       SKCtrl->finished();
+    if (IHCtrl)
+      IHCtrl->finished();
   }
 
   bool HandleTopLevelDecl(DeclGroupRef DG) override {
@@ -353,13 +787,19 @@ public:
   }
 
   bool shouldSkipFunctionBody(Decl *D) override {
-    if (!SKCtrl) {
+    if (!SKCtrl && !IHCtrl) {
       // Always skip bodies.
       return true;
     }
 
+    // Nothing in the body of a function in an already indexed header would
+    // be reported.
     const SourceManager &SM = IndexCtx.getASTContext().getSourceManager();
     SourceLocation Loc = D->getLocation();
+    if (IndexCtx.isInAlreadyIndexedFile(Loc))
+      return true;
+    if (!SKCtrl)
+      return false;
     if (Loc.isMacroID())
       return false;
     if (SM.isInSystemHeader(Loc))
@@ -405,14 +845,20 @@ class IndexingFrontendAction : public ASTFrontendAction {
   SessionSkipBodyData *SKData;
   std::unique_ptr<TUSkipBodyControl> SKCtrl;
 
+  unsigned IndexOptions;
+  SessionIndexedHeaders *IHData;
+  std::unique_ptr<TUIndexedHeadersControl> IHCtrl;
+
 public:
   IndexingFrontendAction(CXClientData clientData,
                          IndexerCallbacks &indexCallbacks,
                          unsigned indexOptions,
                          CXTranslationUnit cxTU,
-                         SessionSkipBodyData *skData)
+                         SessionSkipBodyData *skData,
+                         SessionIndexedHeaders *ihData)
     : IndexCtx(clientData, indexCallbacks, indexOptions, cxTU),
-      CXTU(cxTU), SKData(skData) { }
+      CXTU(cxTU), SKData(skData), IndexOptions(indexOptions),
+      IHData(ihData) { }
 
   std::unique_ptr<ASTConsumer> CreateASTConsumer(CompilerInstance &CI,
                                                  StringRef InFile) override {
@@ -425,7 +871,11 @@ public:
 
     IndexCtx.setASTContext(CI.getASTContext());
     Preprocessor &PP = CI.getPreprocessor();
-    PP.addPPCallbacks(llvm::make_unique<IndexPPCallbacks>(PP, IndexCtx));
+    if (IHData)
+      IHCtrl = llvm::make_unique<TUIndexedHeadersControl>(*IHData, PP,
+                                                          IndexOptions);
+    PP.addPPCallbacks(
+        llvm::make_unique<IndexPPCallbacks>(PP, IndexCtx, IHCtrl.get()));
     IndexCtx.setPreprocessor(PP);
 
     if (SKData) {
@@ -434,7 +884,8 @@ public:
       SKCtrl = llvm::make_unique<TUSkipBodyControl>(*SKData, *PPRec, PP);
     }
 
-    return llvm::make_unique<IndexingConsumer>(IndexCtx, SKCtrl.get());
+    return llvm::make_unique<IndexingConsumer>(IndexCtx, SKCtrl.get(),
+                                               IHCtrl.get());
   }
 
   void EndSourceFileAction() override {
@@ -457,9 +908,11 @@ public:
 struct IndexSessionData {
   CXIndex CIdx;
   std::unique_ptr<SessionSkipBodyData> SkipBodyData;
+  std::unique_ptr<SessionIndexedHeaders> IndexedHeaders;
 
   explicit IndexSessionData(CXIndex cIdx)
-    : CIdx(cIdx), SkipBodyData(new SessionSkipBodyData) {}
+    : CIdx(cIdx), SkipBodyData(new SessionSkipBodyData),
+      IndexedHeaders(new SessionIndexedHeaders) {}
 };
 
 struct IndexSourceFileInfo {
@@ -608,13 +1061,15 @@ static void clang_indexSourceFile_Impl(void *UserData) {
   // revisited.
   bool SkipBodies = (index_options & CXIndexOpt_SkipParsedBodiesInSession) &&
       CInvok->getLangOpts()->CPlusPlus;
-  if (SkipBodies)
+  bool SkipHeaders = index_options & CXIndexOpt_SkipIndexedHeaders;
+  if (SkipBodies || (SkipHeaders && CInvok->getLangOpts()->CPlusPlus))
     CInvok->getFrontendOpts().SkipFunctionBodies = true;
 
   std::unique_ptr<IndexingFrontendAction> IndexAction;
   IndexAction.reset(new IndexingFrontendAction(client_data, CB,
                                                index_options, CXTU->getTU(),
-                        SkipBodies ? IdxSession->SkipBodyData.get() : nullptr));
+                        SkipBodies ? IdxSession->SkipBodyData.get() : nullptr,
+                  SkipHeaders ? IdxSession->IndexedHeaders.get() : nullptr));
 
   // Recover resources if we crash before exiting this method.
   llvm::CrashRecoveryContextCleanupRegistrar<IndexingFrontendAction>
@@ -947,6 +1402,21 @@ void clang_IndexAction_dispose(CXIndexAction idxAction) {
     delete static_cast<IndexSessionData *>(idxAction);
 }
 
+void clang_IndexAction_setIndexedHeadersFile(CXIndexAction idxAction,
+                                             const char *path) {
+  if (!idxAction || !path)
+    return;
+  IndexSessionData *IdxSession = static_cast<IndexSessionData *>(idxAction);
+  IdxSession->IndexedHeaders->setPath(path);
+}
+
+unsigned clang_IndexAction_getNumSkippedHeaders(CXIndexAction idxAction) {
+  if (!idxAction)
+    return 0;
+  IndexSessionData *IdxSession = static_cast<IndexSessionData *>(idxAction);
+  return IdxSession->IndexedHeaders->getNumSkipped();
+}
+
 int clang_indexSourceFile(CXIndexAction idxAction,
                           CXClientData client_data,
                           IndexerCallbacks *index_callbacks,
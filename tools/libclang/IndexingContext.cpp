@@ -244,7 +244,11 @@ void IndexingContext::ppIncludedFile(SourceLocation hashLoc,
                                      StringRef filename,
                                      const FileEntry *File,
                                      bool isImport, bool isAngled,
-                                     bool isModuleImport) {
+                                     bool isModuleImport,
+                                     bool isAlreadyIndexed) {
+  if (isAlreadyIndexed)
+    AlreadyIndexedFiles.insert(File);
+
   if (!CB.ppIncludedFile)
     return;
 
@@ -253,7 +257,8 @@ void IndexingContext::ppIncludedFile(SourceLocation hashLoc,
                                  SA.toCStr(filename),
                                  static_cast<CXFile>(
                                    const_cast<FileEntry *>(File)),
-                                 isImport, isAngled, isModuleImport };
+                                 isImport, isAngled, isModuleImport,
+                                 isAlreadyIndexed };
   CXIdxClientFile idxFile = CB.ppIncludedFile(ClientData, &Info);
   FileMap[File] = idxFile;
 }
@@ -314,6 +319,8 @@ bool IndexingContext::handleDecl(const NamedDecl *D,
     return false;
   if (D->isImplicit() && shouldIgnoreIfImplicit(D))
     return false;
+  if (isInAlreadyIndexedFile(Loc))
+    return false;
 
   ScratchAlloc SA(*this);
   getEntityInfo(D, DInfo.EntInfo, SA);
@@ -682,6 +689,8 @@ bool IndexingContext::handleReference(const NamedDecl *D, SourceLocation Loc,
     return false;
   if (D->isImplicit() && shouldIgnoreIfImplicit(D))
     return false;
+  if (isInAlreadyIndexedFile(Loc))
+    return false;
 
   if (shouldSuppressRefs()) {
     if (markEntityOccurrenceInFile(D, Loc))
@@ -718,6 +727,14 @@ bool IndexingContext::isNotFromSourceFile(SourceLocation Loc) const {
   return SM.getFileEntryForID(FID) == nullptr;
 }
 
+bool IndexingContext::isInAlreadyIndexedFile(SourceLocation Loc) const {
+  if (AlreadyIndexedFiles.empty() || Loc.isInvalid())
+    return false;
+  SourceManager &SM = Ctx->getSourceManager();
+  FileID FID = SM.getFileID(SM.getFileLoc(Loc));
+  return AlreadyIndexedFiles.count(SM.getFileEntryForID(FID));
+}
+
 void IndexingContext::addContainerInMap(const DeclContext *DC,
                                         CXIdxClientContainer container) {
   if (!DC)
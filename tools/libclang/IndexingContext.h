@@ -292,6 +292,10 @@ class IndexingContext {
   typedef std::pair<const FileEntry *, const Decl *> RefFileOccurrence;
   llvm::DenseSet<RefFileOccurrence> RefFileOccurrences;
 
+  /// \brief The files whose declarations and references are not reported,
+  /// because they were already indexed elsewhere.
+  llvm::DenseSet<const FileEntry *> AlreadyIndexedFiles;
+
   std::deque<DeclGroupRef> TUDeclsInObjCContainer;
   
   llvm::BumpPtrAllocator StrScratch;
@@ -367,7 +371,8 @@ public:
 
   void ppIncludedFile(SourceLocation hashLoc,
                       StringRef filename, const FileEntry *File,
-                      bool isImport, bool isAngled, bool isModuleImport);
+                      bool isImport, bool isAngled, bool isModuleImport,
+                      bool isAlreadyIndexed = false);
 
   void importedModule(const ImportDecl *ImportD);
   void importedPCH(const FileEntry *File);
@@ -445,6 +450,10 @@ public:
 
   bool isNotFromSourceFile(SourceLocation Loc) const;
 
+  /// \brief Determine whether \p Loc is in a file that was reported as
+  /// already indexed, and so should not be indexed again.
+  bool isInAlreadyIndexedFile(SourceLocation Loc) const;
+
   void indexTopLevelDecl(const Decl *D);
   void indexTUDeclsInObjCContainer();
   void indexDeclGroupRef(DeclGroupRef DG);
@@ -12,6 +12,9 @@
 #include "clang/Basic/FileSystemStatCache.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/Config/llvm-config.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
 #include "gtest/gtest.h"
 
 using namespace llvm;
@@ -248,4 +251,73 @@ TEST_F(FileManagerTest, addRemoveStatCache) {
 
 #endif  // !LLVM_ON_WIN32
 
+// A shared stat cache answers repeated lookups from different FileManagers
+// and notices files that changed on disk once it is revalidated.
+TEST(SharedFileSystemStatCacheTest, SharedBetweenFileManagers) {
+  SmallString<128> Prefix, Dir;
+  llvm::sys::path::system_temp_directory(/*erasedOnReboot=*/true, Prefix);
+  llvm::sys::path::append(Prefix, "shared-stat-cache");
+  ASSERT_FALSE(llvm::sys::fs::createUniqueDirectory(Prefix, Dir));
+  llvm::sys::fs::make_absolute(Dir);
+  SmallString<128> Path(Dir);
+  llvm::sys::path::append(Path, "a.h");
+  {
+    std::error_code EC;
+    llvm::raw_fd_ostream OS(Path, EC, llvm::sys::fs::F_None);
+    ASSERT_FALSE(EC);
+    OS << "int x;\n";
+  }
+
+  IntrusiveRefCntPtr<SharedFileSystemStatCache> Cache(
+      new SharedFileSystemStatCache());
+  {
+    FileManager First((FileSystemOptions()));
+    First.setSharedStatCache(Cache);
+    const FileEntry *File = First.getFile(Path);
+    ASSERT_TRUE(File != nullptr);
+    EXPECT_EQ(7, File->getSize());
+  }
+  // Both the file and its directory were stat'ed.
+  EXPECT_EQ(0u, Cache->getNumHits());
+  EXPECT_EQ(2u, Cache->getNumMisses());
+  EXPECT_EQ(2u, Cache->size());
+
+  {
+    FileManager Second((FileSystemOptions()));
+    Second.setSharedStatCache(Cache);
+    ASSERT_TRUE(Second.getFile(Path) != nullptr);
+    // Failed lookups are not cached by default.
+    SmallString<128> Missing(Dir);
+    llvm::sys::path::append(Missing, "missing.h");
+    EXPECT_EQ(nullptr, Second.getFile(Missing));
+  }
+  EXPECT_EQ(2u, Cache->getNumHits());
+  EXPECT_EQ(2u, Cache->size());
+
+  {
+    std::error_code EC;
+    llvm::raw_fd_ostream OS(Path, EC, llvm::sys::fs::F_Append);
+    ASSERT_FALSE(EC);
+    OS << "int y;\n";
+  }
+  // Revalidating only starts a new generation; the change is noticed when
+  // the file is next looked up.
+  Cache->revalidate();
+  EXPECT_EQ(0u, Cache->getNumInvalidated());
+  {
+    FileManager Third((FileSystemOptions()));
+    Third.setSharedStatCache(Cache);
+    const FileEntry *File = Third.getFile(Path);
+    ASSERT_TRUE(File != nullptr);
+    EXPECT_EQ(14, File->getSize());
+  }
+  // The file changed; its unchanged directory was checked again as well.
+  EXPECT_EQ(1u, Cache->getNumInvalidated());
+  EXPECT_EQ(2u, Cache->getNumHits());
+  EXPECT_EQ(2u, Cache->size());
+
+  llvm::sys::fs::remove(Path);
+  llvm::sys::fs::remove(Dir);
+}
+
 } // anonymous namespace
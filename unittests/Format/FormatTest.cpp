@@ -3669,6 +3669,30 @@ TEST_F(FormatTest, MemoizationTests) {
   verifyFormat(input, OnePerLine);
 }
 
+TEST_F(FormatTest, LimitsLineBreakingStates) {
+  // Past the limit, the line is completed greedily, which still keeps it
+  // within the column limit.
+  FormatStyle Style = getLLVMStyleWithColumns(40);
+  Style.MaxLineBreakingStates = 10;
+  std::string Code = "int x = f(aaaaaaaaaa, g(bbbbbbbbbb, cccccccccc),\n"
+                     "          h(dddddddddd, eeeeeeeeee), iiiiiiiiii);";
+  std::string Result = format(Code, Style);
+  SmallVector<StringRef, 8> Lines;
+  StringRef(Result).split(Lines, "\n");
+  for (StringRef Line : Lines)
+    EXPECT_LE(Line.size(), 40u) << Result;
+
+  // Only whitespace changes.
+  std::string Expected, Actual;
+  for (char C : Code)
+    if (C != ' ' && C != '\n')
+      Expected += C;
+  for (char C : Result)
+    if (C != ' ' && C != '\n')
+      Actual += C;
+  EXPECT_EQ(Expected, Actual);
+}
+
 TEST_F(FormatTest, BreaksAsHighAsPossible) {
   verifyFormat(
       "void f() {\n"
@@ -9172,6 +9196,7 @@ TEST_F(FormatTest, ParsesConfiguration) {
   CHECK_PARSE("ObjCBlockIndentWidth: 1234", ObjCBlockIndentWidth, 1234u);
   CHECK_PARSE("ColumnLimit: 1234", ColumnLimit, 1234u);
   CHECK_PARSE("MaxEmptyLinesToKeep: 1234", MaxEmptyLinesToKeep, 1234u);
+  CHECK_PARSE("MaxLineBreakingStates: 1234", MaxLineBreakingStates, 1234u);
   CHECK_PARSE("PenaltyBreakBeforeFirstCallParameter: 1234",
               PenaltyBreakBeforeFirstCallParameter, 1234u);
   CHECK_PARSE("PenaltyExcessCharacter: 1234", PenaltyExcessCharacter, 1234u);
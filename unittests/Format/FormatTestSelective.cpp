@@ -403,6 +403,37 @@ TEST_F(FormatTestSelective, ReformatRegionAdjustsIndent) {
                    11, 0));
 }
 
+TEST_F(FormatTestSelective, FormatsOnlyTheBlocksAroundTheRange) {
+  // Only the lines from the last outermost declaration before the range
+  // are looked at, which still gives the indent of the enclosing block.
+  EXPECT_EQ("int  x;\n"
+            "\n"
+            "void f() {\n"
+            "    int  a;\n"
+            "    int b;\n"
+            "}\n"
+            "\n"
+            "int  y;",
+            format("int  x;\n"
+                   "\n"
+                   "void f() {\n"
+                   "    int  a;\n"
+                   "    int   b;\n"
+                   "}\n"
+                   "\n"
+                   "int  y;",
+                   36, 0));
+  EXPECT_EQ("   int  a;\n"
+            "\n"
+            "   int  b;\n"
+            "   int c;",
+            format("   int  a;\n"
+                   "\n"
+                   "   int  b;\n"
+                   "   int   c;",
+                   26, 0));
+}
+
 TEST_F(FormatTestSelective, UnderstandsTabs) {
   Style.IndentWidth = 8;
   Style.UseTab = FormatStyle::UT_Always;
@@ -20,7 +20,12 @@
 #include "clang/Lex/ModuleLoader.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Lex/PreprocessorOptions.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
 #include "gtest/gtest.h"
+#include <chrono>
+#include <cstdlib>
 
 using namespace llvm;
 using namespace clang;
@@ -358,4 +363,90 @@ TEST_F(LexerTest, LexAPI) {
   EXPECT_EQ("N", Lexer::getImmediateMacroName(idLoc4, SourceMgr, LangOpts));
 }
 
+TEST_F(LexerTest, LongRunsOfCharacters) {
+  // Identifiers, whitespace and line comments long enough to be scanned in
+  // blocks, ending at every kind of character that can follow them.
+  std::string Source =
+      "  \t    \t          \t   int an_identifier_with_DIGITS_0123456789_x;\n"
+      "// a line comment that goes on for well over sixteen characters\n"
+      "                              second_identifier_after_a_comment\r\n"
+      "// a comment continued by an escaped newline, \\\n"
+      "   which makes this line part of it too\n"
+      "                  \f       third // with a trailing comment\n"
+      "identifier_at_the_end_of_the_buffer";
+  std::vector<tok::TokenKind> ExpectedTokens;
+  ExpectedTokens.push_back(tok::kw_int);
+  ExpectedTokens.push_back(tok::identifier);
+  ExpectedTokens.push_back(tok::semi);
+  ExpectedTokens.push_back(tok::identifier);
+  ExpectedTokens.push_back(tok::identifier);
+  ExpectedTokens.push_back(tok::identifier);
+
+  std::vector<Token> toks = CheckLex(Source, ExpectedTokens);
+  ASSERT_EQ(6U, toks.size());
+  EXPECT_EQ("an_identifier_with_DIGITS_0123456789_x",
+            toks[1].getIdentifierInfo()->getName());
+  EXPECT_EQ("second_identifier_after_a_comment",
+            toks[3].getIdentifierInfo()->getName());
+  EXPECT_EQ("third", toks[4].getIdentifierInfo()->getName());
+  EXPECT_EQ("identifier_at_the_end_of_the_buffer",
+            toks[5].getIdentifierInfo()->getName());
+  for (unsigned I : {0, 3, 4, 5})
+    EXPECT_TRUE(toks[I].isAtStartOfLine());
+  for (unsigned I : {0, 1, 3, 4})
+    EXPECT_TRUE(toks[I].hasLeadingSpace());
+  EXPECT_FALSE(toks[2].hasLeadingSpace());
+  EXPECT_FALSE(toks[5].hasLeadingSpace());
+}
+
+// Reports how fast the raw lexer gets through a large header. This is a
+// benchmark rather than a test, so it only runs when asked to with
+// --gtest_also_run_disabled_tests. Set CLANG_LEXER_BENCHMARK_FILE to the
+// path of a header to lex that instead of a generated one.
+TEST_F(LexerTest, DISABLED_RawLexerThroughput) {
+  std::unique_ptr<MemoryBuffer> Buf;
+  if (const char *Path = ::getenv("CLANG_LEXER_BENCHMARK_FILE")) {
+    ErrorOr<std::unique_ptr<MemoryBuffer>> File = MemoryBuffer::getFile(Path);
+    ASSERT_TRUE(bool(File)) << "cannot read " << Path;
+    Buf = std::move(*File);
+  } else {
+    std::string Source;
+    for (unsigned I = 0; I != 20000; ++I)
+      Source +=
+          "  /// Returns the number of elements between \\p first and\n"
+          "  /// \\p last, counting each of them exactly once.\n"
+          "  template <typename InputIterator, typename Allocator>\n"
+          "  static inline unsigned long long count_elements_in_range(\n"
+          "      InputIterator first, InputIterator last,\n"
+          "      const Allocator &alloc) noexcept; // Never throws.\n"
+          "\n";
+    Buf = MemoryBuffer::getMemBufferCopy(Source, "generated.h");
+  }
+  const MemoryBuffer *Input = Buf.get();
+  FileID FID = SourceMgr.createFileID(std::move(Buf));
+
+  LangOptions Opts;
+  Opts.CPlusPlus = Opts.CPlusPlus11 = Opts.LineComment = true;
+
+  typedef std::chrono::steady_clock Clock;
+  const unsigned Iterations = 10;
+  uint64_t Tokens = 0;
+  Clock::time_point Start = Clock::now();
+  for (unsigned I = 0; I != Iterations; ++I) {
+    Lexer L(FID, Input, SourceMgr, Opts);
+    Token Tok;
+    do {
+      L.LexFromRawLexer(Tok);
+      ++Tokens;
+    } while (Tok.isNot(tok::eof));
+  }
+  double Seconds = std::chrono::duration<double>(Clock::now() - Start).count();
+
+  double MB = double(Input->getBufferSize()) * Iterations / (1 << 20);
+  llvm::outs() << format("Lexed %.1f MB, %llu tokens, in %.3f s: "
+                         "%.0f tokens/s, %.1f MB/s\n",
+                         MB, (unsigned long long)Tokens, Seconds,
+                         Tokens / Seconds, MB / Seconds);
+}
+
 } // anonymous namespace
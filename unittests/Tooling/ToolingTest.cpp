@@ -329,6 +329,24 @@ TEST(ClangToolTest, InjectDiagnosticConsumer) {
   EXPECT_EQ(1u, Consumer.NumDiagnosticsSeen);
 }
 
+TEST(ClangToolTest, RunOnMultipleThreads) {
+  FixedCompilationDatabase Compilations("/", std::vector<std::string>());
+  std::vector<std::string> Sources;
+  for (const char *Name : {"/a.cc", "/b.cc", "/c.cc", "/d.cc"})
+    Sources.push_back(Name);
+  ClangTool Tool(Compilations, Sources);
+  for (const std::string &Source : Sources)
+    Tool.mapVirtualFile(Source, "int x = undeclared;");
+  Tool.setNumThreads(3);
+
+  TestDiagnosticConsumer Consumer;
+  Tool.setDiagnosticConsumer(&Consumer);
+  std::vector<std::unique_ptr<ASTUnit>> ASTs;
+  Tool.buildASTs(ASTs);
+  EXPECT_EQ(4u, ASTs.size());
+  EXPECT_EQ(4u, Consumer.NumDiagnosticsSeen);
+}
+
 TEST(ClangToolTest, InjectDiagnosticConsumerInBuildASTs) {
   FixedCompilationDatabase Compilations("/", std::vector<std::string>());
   ClangTool Tool(Compilations, std::vector<std::string>(1, "/a.cc"));
@@ -8,13 +8,17 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang-c/Index.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
 #include "gtest/gtest.h"
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <set>
+#include <vector>
 #define DEBUG_TYPE "libclang-test"
 
 TEST(libclang, clang_parseTranslationUnit2_InvalidArgs) {
@@ -349,6 +353,66 @@ TEST(libclang, ModuleMapDescriptor) {
   clang_ModuleMapDescriptor_dispose(MMD);
 }
 
+static enum CXVisitorResult
+CollectSymbolOccurrence(void *Context, const CXSymbolOccurrence *Occurrence) {
+  std::string Str;
+  llvm::raw_string_ostream OS(Str);
+  OS << Occurrence->filename << ':' << Occurrence->line << ':'
+     << Occurrence->column << ':' << Occurrence->roles;
+  static_cast<std::vector<std::string> *>(Context)->push_back(OS.str());
+  return CXVisit_Continue;
+}
+
+TEST(libclang, SymbolIndex) {
+  llvm::SmallString<256> Path;
+  ASSERT_FALSE(llvm::sys::fs::createTemporaryFile("libclang-test", "idx",
+                                                  Path));
+  llvm::sys::fs::remove(Path);
+
+  CXSymbolIndexBuilder Builder = clang_SymbolIndexBuilder_create(0);
+  clang_SymbolIndexBuilder_addOccurrence(Builder, "c:@F@f#", "b.cpp", 3, 1,
+                                         CXSymbolIndexRole_Reference);
+  clang_SymbolIndexBuilder_addOccurrence(Builder, "c:@F@f#", "a.h", 1, 6,
+                                         CXSymbolIndexRole_Declaration);
+  clang_SymbolIndexBuilder_addOccurrence(Builder, "c:@F@f#", "a.h", 1, 6,
+                                         CXSymbolIndexRole_Definition);
+  clang_SymbolIndexBuilder_addOccurrence(Builder, "c:@F@g#", "b.cpp", 2, 6,
+                                         CXSymbolIndexRole_Declaration);
+  EXPECT_EQ(CXError_Success,
+            clang_SymbolIndexBuilder_write(Builder, Path.c_str()));
+  clang_SymbolIndexBuilder_dispose(Builder);
+
+  // Replace the occurrences in b.cpp, keeping those in a.h.
+  Builder = clang_SymbolIndexBuilder_create(0);
+  clang_SymbolIndexBuilder_beginFile(Builder, "b.cpp");
+  clang_SymbolIndexBuilder_addOccurrence(Builder, "c:@F@f#", "b.cpp", 4, 2,
+                                         CXSymbolIndexRole_Reference);
+  EXPECT_EQ(CXError_Success,
+            clang_SymbolIndexBuilder_write(Builder, Path.c_str()));
+  clang_SymbolIndexBuilder_dispose(Builder);
+
+  CXSymbolIndex Index = clang_SymbolIndex_load(Path.c_str());
+  ASSERT_TRUE(Index != nullptr);
+  EXPECT_EQ(2U, clang_SymbolIndex_getNumFiles(Index));
+  EXPECT_EQ(1U, clang_SymbolIndex_getNumSymbols(Index));
+  EXPECT_EQ(2U, clang_SymbolIndex_getNumOccurrences(Index));
+
+  std::vector<std::string> Occurrences;
+  EXPECT_EQ(0U, clang_SymbolIndex_findOccurrences(
+                    Index, "c:@F@f#", CollectSymbolOccurrence, &Occurrences));
+  ASSERT_EQ(2U, Occurrences.size());
+  EXPECT_EQ("a.h:1:6:3", Occurrences[0]);
+  EXPECT_EQ("b.cpp:4:2:4", Occurrences[1]);
+
+  Occurrences.clear();
+  clang_SymbolIndex_findOccurrences(Index, "c:@F@g#", CollectSymbolOccurrence,
+                                    &Occurrences);
+  EXPECT_TRUE(Occurrences.empty());
+
+  clang_SymbolIndex_dispose(Index);
+  llvm::sys::fs::remove(Path);
+}
+
 class LibclangReparseTest : public ::testing::Test {
   std::set<std::string> Files;
 public:
@@ -391,9 +455,11 @@ public:
       clang_disposeDiagnostic(Diag);
     }
   }
-  bool ReparseTU(unsigned num_unsaved_files, CXUnsavedFile* unsaved_files) {
+  bool ReparseTU(unsigned num_unsaved_files, CXUnsavedFile* unsaved_files,
+                 unsigned options = CXReparse_None) {
     if (clang_reparseTranslationUnit(ClangTU, num_unsaved_files, unsaved_files,
-                                     clang_defaultReparseOptions(ClangTU))) {
+                                     clang_defaultReparseOptions(ClangTU) |
+                                         options)) {
       DEBUG(llvm::dbgs() << "Reparse failed\n");
       return false;
     }
@@ -431,6 +497,44 @@ TEST_F(LibclangReparseTest, Reparse) {
   EXPECT_EQ(0U, clang_getNumDiagnostics(ClangTU));
 }
 
+#ifndef _WIN32
+TEST_F(LibclangReparseTest, ReparseWithSharedStatCache) {
+  // Recreate the index with the process-wide stat cache enabled.
+  clang_disposeIndex(Index);
+  ::setenv("LIBCLANG_SHARED_STAT_CACHE", "1", /*overwrite=*/1);
+  Index = clang_createIndex(0, 0);
+  ::unsetenv("LIBCLANG_SHARED_STAT_CACHE");
+
+  const char *HeaderTop = "#ifndef H\n#define H\nstruct Foo { int bar;";
+  const char *HeaderBottom = "\n};\n#endif\n";
+  const char *CppFile = "#include \"HeaderFile.h\"\nint main() {"
+                         " Foo foo; foo.bar = 7; foo.baz = 8; }\n";
+  std::string HeaderName = "HeaderFile.h";
+  std::string CppName = "CppFile.cpp";
+  WriteFile(CppName, CppFile);
+  WriteFile(HeaderName, std::string(HeaderTop) + HeaderBottom);
+
+  ClangTU = clang_parseTranslationUnit(Index, CppName.c_str(), nullptr, 0,
+                                       nullptr, 0, TUFlags);
+  EXPECT_EQ(1U, clang_getNumDiagnostics(ClangTU));
+  ASSERT_TRUE(ReparseTU(0, nullptr /* No unsaved files. */));
+  EXPECT_EQ(1U, clang_getNumDiagnostics(ClangTU));
+
+  // The cached size of the header is stale after the edit; reparsing must
+  // not read the new contents with it.
+  std::string NewHeaderContents =
+      std::string(HeaderTop) + "int baz;" + HeaderBottom;
+  WriteFile(HeaderName, NewHeaderContents);
+  ASSERT_TRUE(ReparseTU(0, nullptr /* No unsaved files. */));
+  EXPECT_EQ(0U, clang_getNumDiagnostics(ClangTU));
+
+  // And again, back to the original header.
+  WriteFile(HeaderName, std::string(HeaderTop) + HeaderBottom);
+  ASSERT_TRUE(ReparseTU(0, nullptr /* No unsaved files. */));
+  EXPECT_EQ(1U, clang_getNumDiagnostics(ClangTU));
+}
+#endif
+
 TEST_F(LibclangReparseTest, ReparseWithModule) {
   const char *HeaderTop = "#ifndef H\n#define H\nstruct Foo { int bar;";
   const char *HeaderBottom = "\n};\n#endif\n";
@@ -465,3 +569,121 @@ TEST_F(LibclangReparseTest, ReparseWithModule) {
   ASSERT_TRUE(ReparseTU(0, nullptr /* No unsaved files. */));
   EXPECT_EQ(0U, clang_getNumDiagnostics(ClangTU));
 }
+
+#if LLVM_ENABLE_THREADS
+TEST_F(LibclangReparseTest, ReparseWithBackgroundPreamble) {
+  const char *HeaderTop = "#ifndef H\n#define H\nstruct Foo { int bar;";
+  const char *HeaderBottom = "\n};\n#endif\n";
+  const char *CppFile = "#include \"HeaderFile.h\"\nint main() {"
+                         " Foo foo; foo.bar = 7; foo.baz = 8; }\n";
+  std::string HeaderName = "HeaderFile.h";
+  std::string CppName = "CppFile.cpp";
+  WriteFile(CppName, CppFile);
+  WriteFile(HeaderName, std::string(HeaderTop) + HeaderBottom);
+
+  ClangTU = clang_parseTranslationUnit(
+      Index, CppName.c_str(), nullptr, 0, nullptr, 0,
+      TUFlags | CXTranslationUnit_BuildPreambleInBackground);
+  EXPECT_EQ(1U, clang_getNumDiagnostics(ClangTU));
+
+  // Build the first preamble.
+  ASSERT_TRUE(ReparseTU(0, nullptr /* No unsaved files. */));
+  EXPECT_EQ(1U, clang_getNumDiagnostics(ClangTU));
+
+  std::string NewHeaderContents =
+      std::string(HeaderTop) + "int baz;" + HeaderBottom;
+  WriteFile(HeaderName, NewHeaderContents);
+
+  // The stale preamble is still used while the new one is being built.
+  ASSERT_TRUE(ReparseTU(0, nullptr /* No unsaved files. */));
+  EXPECT_EQ(1U, clang_getNumDiagnostics(ClangTU));
+
+  // Once it has been built, the new preamble is swapped in.
+  ASSERT_TRUE(ReparseTU(0, nullptr /* No unsaved files. */,
+                        CXReparse_WaitForBackgroundPreamble));
+  EXPECT_EQ(0U, clang_getNumDiagnostics(ClangTU));
+}
+
+static unsigned countTopLevelDecls(CXTranslationUnit TU, const char *Name) {
+  struct Count {
+    const char *Name;
+    unsigned N;
+  } C = { Name, 0 };
+  clang_visitChildren(clang_getTranslationUnitCursor(TU),
+                      [](CXCursor Cursor, CXCursor, CXClientData Data) {
+                        Count *C = static_cast<Count *>(Data);
+                        CXString Spelling = clang_getCursorSpelling(Cursor);
+                        if (!strcmp(clang_getCString(Spelling), C->Name))
+                          ++C->N;
+                        clang_disposeString(Spelling);
+                        return CXChildVisit_Continue;
+                      },
+                      &C);
+  return C.N;
+}
+
+TEST_F(LibclangReparseTest, ReparseWithBackgroundPreambleUndoneEdit) {
+  const char *HeaderFile = "#warning in header\nstruct Foo { int bar; };\n";
+  const char *CppFile = "#include \"HeaderFile.h\"\nint main() {}\n";
+  const char *EditedCppFile =
+      "#define EDITED\n#include \"HeaderFile.h\"\nint main() {}\n";
+  std::string HeaderName = "HeaderFile.h";
+  std::string CppName = "CppFile.cpp";
+  WriteFile(CppName, CppFile);
+  WriteFile(HeaderName, HeaderFile);
+
+  // Only list the top-level declarations tracked by the ASTUnit.
+  clang_disposeIndex(Index);
+  Index = clang_createIndex(/*excludeDeclarationsFromPCH=*/1, 0);
+  ClangTU = clang_parseTranslationUnit(
+      Index, CppName.c_str(), nullptr, 0, nullptr, 0,
+      TUFlags | CXTranslationUnit_BuildPreambleInBackground);
+  EXPECT_EQ(1U, clang_getNumDiagnostics(ClangTU));
+
+  // Build the first preamble.
+  ASSERT_TRUE(ReparseTU(0, nullptr /* No unsaved files. */));
+  EXPECT_EQ(1U, clang_getNumDiagnostics(ClangTU));
+  EXPECT_EQ(1U, countTopLevelDecls(ClangTU, "Foo"));
+
+  // Edit the preamble itself, then undo the edit.
+  WriteFile(CppName, EditedCppFile);
+  ASSERT_TRUE(ReparseTU(0, nullptr /* No unsaved files. */));
+  EXPECT_EQ(1U, clang_getNumDiagnostics(ClangTU));
+  WriteFile(CppName, CppFile);
+  ASSERT_TRUE(ReparseTU(0, nullptr /* No unsaved files. */));
+  ASSERT_TRUE(ReparseTU(0, nullptr /* No unsaved files. */,
+                        CXReparse_WaitForBackgroundPreamble));
+
+  // The declarations and diagnostics of the preamble are still there.
+  EXPECT_EQ(1U, clang_getNumDiagnostics(ClangTU));
+  EXPECT_EQ(1U, countTopLevelDecls(ClangTU, "Foo"));
+}
+
+TEST_F(LibclangReparseTest, ReparseWithBackgroundPreambleGrown) {
+  const char *HeaderFile = "#warning in header\nstruct Foo { int bar; };\n";
+  const char *CppFile = "#include \"HeaderFile.h\"\nint main() {}\n";
+  const char *GrownCppFile = "#include \"HeaderFile.h\"\n"
+                             "#include \"OtherFile.h\"\nint main() {}\n";
+  std::string HeaderName = "HeaderFile.h";
+  std::string OtherName = "OtherFile.h";
+  std::string CppName = "CppFile.cpp";
+  WriteFile(CppName, CppFile);
+  WriteFile(HeaderName, HeaderFile);
+  WriteFile(OtherName, "struct Bar {};\n");
+
+  clang_disposeIndex(Index);
+  Index = clang_createIndex(/*excludeDeclarationsFromPCH=*/1, 0);
+  ClangTU = clang_parseTranslationUnit(
+      Index, CppName.c_str(), nullptr, 0, nullptr, 0,
+      TUFlags | CXTranslationUnit_BuildPreambleInBackground);
+  ASSERT_TRUE(ReparseTU(0, nullptr /* No unsaved files. */));
+
+  // The old preamble is a prefix of the new one, so it keeps being used and
+  // only the added #include is parsed.
+  WriteFile(CppName, GrownCppFile);
+  ASSERT_TRUE(ReparseTU(0, nullptr /* No unsaved files. */));
+  EXPECT_EQ(1U, clang_getNumDiagnostics(ClangTU));
+  EXPECT_EQ(1U, countTopLevelDecls(ClangTU, "Foo"));
+  EXPECT_EQ(1U, countTopLevelDecls(ClangTU, "Bar"));
+}
+#endif
@@ -0,0 +1,153 @@
+#!/usr/bin/env python
+
+"""
+Aggregate the reports written by -ftemplate-instantiation-report across many
+translation units.
+
+The same specialization is usually instantiated in every translation unit
+that uses it. This script adds up what each specialization cost across the
+whole build, counts the translation units that instantiated it (the
+candidates for an explicit instantiation declaration), and totals the cost
+by the header the templates are defined in.
+
+Usage: analyze-template-instantiations.py [options] report.json...
+"""
+
+from __future__ import print_function
+
+import json
+import optparse
+import sys
+
+
+class Specialization(object):
+    def __init__(self, name, kind, pattern):
+        self.name = name
+        self.kind = kind
+        self.pattern = pattern
+        self.units = 0
+        self.time = 0
+        self.self_time = 0
+        self.nodes = 0
+        self.self_nodes = 0
+        self.depth = 0
+
+    def add(self, entry):
+        self.units += 1
+        self.time += entry['time_us']
+        self.self_time += entry['self_time_us']
+        self.nodes += entry['nodes']
+        self.self_nodes += entry['self_nodes']
+        self.depth = max(self.depth, entry['depth'])
+
+    def to_json(self):
+        return {'name': self.name, 'kind': self.kind,
+                'pattern': self.pattern, 'units': self.units,
+                'time_us': self.time, 'self_time_us': self.self_time,
+                'nodes': self.nodes, 'self_nodes': self.self_nodes,
+                'depth': self.depth}
+
+
+class Header(object):
+    def __init__(self, path):
+        self.path = path
+        self.specializations = 0
+        self.instantiations = 0
+        self.self_time = 0
+        self.self_nodes = 0
+
+    def to_json(self):
+        return {'file': self.path, 'specializations': self.specializations,
+                'instantiations': self.instantiations,
+                'self_time_us': self.self_time,
+                'self_nodes': self.self_nodes}
+
+
+def pattern_file(pattern):
+    """Strip the line number from a "file:line" pattern location."""
+    path, sep, line = pattern.rpartition(':')
+    if sep and line.isdigit():
+        return path
+    return pattern
+
+
+def aggregate(paths):
+    specializations = {}
+    for path in paths:
+        with open(path) as f:
+            report = json.load(f)
+        for entry in report['specializations']:
+            key = (entry['name'], entry['kind'])
+            spec = specializations.get(key)
+            if spec is None:
+                spec = Specialization(entry['name'], entry['kind'],
+                                      entry['pattern'])
+                specializations[key] = spec
+            spec.add(entry)
+
+    headers = {}
+    for spec in specializations.values():
+        path = pattern_file(spec.pattern)
+        header = headers.get(path)
+        if header is None:
+            header = headers[path] = Header(path)
+        header.specializations += 1
+        header.instantiations += spec.units
+        header.self_time += spec.self_time
+        header.self_nodes += spec.self_nodes
+
+    by_cost = lambda x: (-x.self_time, -x.self_nodes)
+    return (sorted(specializations.values(), key=by_cost),
+            sorted(headers.values(), key=by_cost))
+
+
+def main():
+    parser = optparse.OptionParser(
+        usage='%prog [options] report.json...', description=__doc__.strip())
+    parser.add_option('-n', '--top', type='int', default=25,
+                      help='show the N most expensive entries (default 25; '
+                           '0 shows all)')
+    parser.add_option('--min-units', type='int', default=1,
+                      help='only show specializations instantiated in at '
+                           'least this many translation units')
+    parser.add_option('--json', action='store_true',
+                      help='write the aggregated report as JSON')
+    opts, args = parser.parse_args()
+    if not args:
+        parser.error('no reports given')
+
+    specializations, headers = aggregate(args)
+    specializations = [s for s in specializations
+                       if s.units >= opts.min_units]
+    if opts.top:
+        specializations = specializations[:opts.top]
+        headers = headers[:opts.top]
+
+    if opts.json:
+        json.dump({'units': len(args),
+                   'specializations': [s.to_json() for s in specializations],
+                   'headers': [h.to_json() for h in headers]},
+                  sys.stdout, indent=1, sort_keys=True)
+        print()
+        return
+
+    print('Headers, by time spent instantiating their templates:')
+    print('%12s %10s %8s %8s  %s' % ('self ms', 'self nodes', 'specs',
+                                     'insts', 'file'))
+    for h in headers:
+        print('%12.1f %10d %8d %8d  %s' % (h.self_time / 1000.0, h.self_nodes,
+                                           h.specializations,
+                                           h.instantiations, h.path))
+    print()
+    print('Specializations, by time spent instantiating them across %d '
+          'translation units:' % len(args))
+    print('%12s %10s %6s %6s  %s' % ('self ms', 'self nodes', 'units',
+                                     'depth', 'specialization'))
+    for s in specializations:
+        print('%12.1f %10d %6d %6d  %s %s (%s)' % (
+            s.self_time / 1000.0, s.self_nodes, s.units, s.depth, s.kind,
+            s.name, s.pattern))
+
+
+if __name__ == '__main__':
+    main()